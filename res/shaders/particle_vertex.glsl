@@ -14,6 +14,7 @@ layout(location = 1) in vec4 inParticleParams;  // halfSize, rotZ, lifeRatio, un
 layout(location = 2) in vec4 inStartColor;
 layout(location = 3) in vec4 inEndColor;
 layout(location = 4) in vec4 inUVBounds;  // minX, minY, maxX, maxY
+layout(location = 5) in vec4 inImageUV;   // UV rect of the whole image, past inUVBounds when trimmed
 
 layout(location = 0) out vec2 fragTexCoord;
 layout(location = 1) out vec4 fragColor;
@@ -53,13 +54,13 @@ void main() {
     gl_Position = vec4(pos.x / aspect, -pos.y, 0.0, 1.0);
 
     if (cornerIndex == 0) {
-        fragTexCoord = vec2(inUVBounds.x, inUVBounds.w);
+        fragTexCoord = vec2(inImageUV.x, inImageUV.w);
     } else if (cornerIndex == 1) {
-        fragTexCoord = vec2(inUVBounds.z, inUVBounds.w);
+        fragTexCoord = vec2(inImageUV.z, inImageUV.w);
     } else if (cornerIndex == 2) {
-        fragTexCoord = vec2(inUVBounds.z, inUVBounds.y);
+        fragTexCoord = vec2(inImageUV.z, inImageUV.y);
     } else {
-        fragTexCoord = vec2(inUVBounds.x, inUVBounds.y);
+        fragTexCoord = vec2(inImageUV.x, inImageUV.y);
     }
 
     fragColor = mix(inStartColor, inEndColor, lifeRatio);
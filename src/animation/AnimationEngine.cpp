@@ -4,14 +4,18 @@
 #include "../vulkan/VulkanRenderer.h"
 #include <cassert>
 
-AnimationEngine::AnimationEngine(MemoryAllocator* allocator, SceneLayerManager* layerManager, ConsoleBuffer* consoleBuffer, VulkanRenderer* renderer)
+AnimationEngine::AnimationEngine(MemoryAllocator* allocator, MemoryAllocator* frameAllocator, SceneLayerManager* layerManager,
+                                 ConsoleBuffer* consoleBuffer, VulkanRenderer* renderer)
     : allocator_(allocator)
+    , frameAllocator_(frameAllocator)
     , layerManager_(layerManager)
     , consoleBuffer_(consoleBuffer)
     , renderer_(renderer)
+    , animationPool_(*allocator, "AnimationEngine::animationPool_")
     , animations_(*allocator, "AnimationEngine::animations_")
     , nextAnimationId_(1) {
     assert(allocator != nullptr);
+    assert(frameAllocator != nullptr);
     assert(layerManager != nullptr);
     assert(consoleBuffer != nullptr);
     assert(renderer != nullptr);
@@ -32,9 +36,7 @@ int AnimationEngine::startAnimation(int targetId, AnimationPropertyType property
     assert(valueCount > 0 && valueCount <= 8);
     assert(duration > 0.0f);
 
-    Animation* anim = static_cast<Animation*>(allocator_->allocate(sizeof(Animation), "AnimationEngine::startAnimation"));
-    assert(anim != nullptr);
-    new (anim) Animation();
+    Animation* anim = animationPool_.create();
 
     anim->targetId = targetId;
     anim->propertyType = propertyType;
@@ -49,6 +51,7 @@ int AnimationEngine::startAnimation(int targetId, AnimationPropertyType property
     }
 
     int animationId = nextAnimationId_++;
+    anim->animationId = animationId;
     animations_.insert(animationId, anim);
 
     consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE,
@@ -66,9 +69,7 @@ int AnimationEngine::startSplineAnimation(int targetId, AnimationPropertyType pr
     assert(valueCount > 0 && valueCount <= 8);
     assert(duration > 0.0f);
 
-    Animation* anim = static_cast<Animation*>(allocator_->allocate(sizeof(Animation), "AnimationEngine::startSplineAnimation"));
-    assert(anim != nullptr);
-    new (anim) Animation();
+    Animation* anim = animationPool_.create();
 
     anim->targetId = targetId;
     anim->propertyType = propertyType;
@@ -86,6 +87,7 @@ int AnimationEngine::startSplineAnimation(int targetId, AnimationPropertyType pr
     }
 
     int animationId = nextAnimationId_++;
+    anim->animationId = animationId;
     animations_.insert(animationId, anim);
 
     consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE,
@@ -102,8 +104,7 @@ void AnimationEngine::stopAnimation(int animationId) {
         Animation* anim = *animPtr;
         assert(anim != nullptr);
 
-        anim->~Animation();
-        allocator_->free(anim);
+        animationPool_.destroy(anim);
 
         animations_.remove(animationId);
         consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE,
@@ -129,8 +130,7 @@ void AnimationEngine::stopAnimationsForTarget(int targetId, AnimationPropertyTyp
         Animation* anim = *animPtr;
         assert(anim != nullptr);
 
-        anim->~Animation();
-        allocator_->free(anim);
+        animationPool_.destroy(anim);
 
         animations_.remove(animId);
     }
@@ -147,23 +147,22 @@ void AnimationEngine::update(float deltaTime) {
         return;
     }
 
-    Vector<int> completedAnimations(*allocator_, "AnimationEngine::completedAnimations");
+    Vector<int> completedAnimations(*frameAllocator_, "AnimationEngine::completedAnimations");
 
-    for (auto it = animations_.begin(); it != animations_.end(); ++it) {
-        Animation* anim = it.value();
-        assert(anim != nullptr);
-        anim->elapsedTime += deltaTime;
+    // Walk the pool rather than the table so animations are visited in memory order
+    for (Animation& anim : animationPool_) {
+        anim.elapsedTime += deltaTime;
 
-        float t = anim->elapsedTime / anim->duration;
+        float t = anim.elapsedTime / anim.duration;
 
         if (t >= 1.0f) {
             // Animation complete - apply final values
             t = 1.0f;
-            applyAnimation(*anim, t);
-            completedAnimations.push_back(it.key());
+            applyAnimation(anim, t);
+            completedAnimations.push_back(anim.animationId);
         } else {
             // Animation in progress
-            applyAnimation(*anim, t);
+            applyAnimation(anim, t);
         }
     }
 
@@ -178,8 +177,7 @@ void AnimationEngine::update(float deltaTime) {
         Animation* anim = *animPtr;
         assert(anim != nullptr);
 
-        anim->~Animation();
-        allocator_->free(anim);
+        animationPool_.destroy(anim);
 
         animations_.remove(animId);
     }
@@ -192,8 +190,7 @@ void AnimationEngine::clear() {
     for (auto it = animations_.begin(); it != animations_.end(); ++it) {
         Animation* anim = it.value();
         assert(anim != nullptr);
-        anim->~Animation();
-        allocator_->free(anim);
+        animationPool_.destroy(anim);
     }
 
     animations_.clear();
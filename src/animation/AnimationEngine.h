@@ -3,6 +3,7 @@
 #include "../core/Vector.h"
 #include "../core/HashTable.h"
 #include "../memory/MemoryAllocator.h"
+#include "../memory/ObjectPool.h"
 
 class SceneLayerManager;
 class ConsoleBuffer;
@@ -30,7 +31,7 @@ enum AnimationPropertyType {
 
 // Animation definition
 struct Animation {
-    Animation() : targetId(-1), propertyType(PROPERTY_LAYER_SCALE), interpolationType(INTERPOLATION_LINEAR),
+    Animation() : animationId(0), targetId(-1), propertyType(PROPERTY_LAYER_SCALE), interpolationType(INTERPOLATION_LINEAR),
                   elapsedTime(0.0f), duration(0.0f), valueCount(0) {
         for (int i = 0; i < 8; ++i) {
             startValues[i] = 0.0f;
@@ -39,6 +40,7 @@ struct Animation {
         }
     }
 
+    int animationId;                    // ID returned by startAnimation/startSplineAnimation
     int targetId;                       // Target object ID (e.g., layer ID)
     AnimationPropertyType propertyType; // Property being animated
     InterpolationType interpolationType; // Interpolation method
@@ -53,7 +55,8 @@ struct Animation {
 // Animation engine manages all active animations
 class AnimationEngine {
 public:
-    AnimationEngine(MemoryAllocator* allocator, SceneLayerManager* layerManager, ConsoleBuffer* consoleBuffer, VulkanRenderer* renderer);
+    AnimationEngine(MemoryAllocator* allocator, MemoryAllocator* frameAllocator, SceneLayerManager* layerManager,
+                    ConsoleBuffer* consoleBuffer, VulkanRenderer* renderer);
     ~AnimationEngine();
 
     // Start a new animation and return its ID
@@ -92,9 +95,11 @@ private:
     float catmullRomInterpolate(float t, float p0, float p1, float p2, float p3) const;
 
     MemoryAllocator* allocator_;
+    MemoryAllocator* frameAllocator_;  // Per-frame temporaries, reset after each frame
     SceneLayerManager* layerManager_;
     ConsoleBuffer* consoleBuffer_;
     VulkanRenderer* renderer_;
+    ObjectPool<Animation> animationPool_;    // Owns every active Animation; update() walks it densely. Unsynchronised, main thread only
     HashTable<int, Animation*> animations_;  // animationId -> Animation*
     int nextAnimationId_;
 };
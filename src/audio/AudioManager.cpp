@@ -2,6 +2,7 @@
 #include <SDL3/SDL.h>
 #include "../debug/ConsoleBuffer.h"
 #include "../debug/ThreadProfiler.h"
+#include "../resources/resource.h"
 #include <AL/al.h>
 #include <AL/alc.h>
 #include <AL/alext.h>
@@ -45,15 +46,16 @@ static LPALDELETEAUXILIARYEFFECTSLOTS alDeleteAuxiliaryEffectSlots = nullptr;
 static LPALISAUXILIARYEFFECTSLOT alIsAuxiliaryEffectSlot = nullptr;
 static LPALAUXILIARYEFFECTSLOTI alAuxiliaryEffectSloti = nullptr;
 
-AudioManager::AudioManager(MemoryAllocator* allocator, ConsoleBuffer* consoleBuffer)
+AudioManager::AudioManager(MemoryAllocator* allocator, ConsoleBuffer* consoleBuffer, PakResource* pakResource)
     : device(nullptr), context(nullptr), bufferCount(0),
       efxSupported(false), effectSlot(0), effect(0), filter(0),
       currentEffect(AUDIO_EFFECT_NONE), currentEffectIntensity(1.0f),
-      ima4Supported_(false), allocator_(allocator), consoleBuffer_(consoleBuffer),
+      ima4Supported_(false), allocator_(allocator), consoleBuffer_(consoleBuffer), pakResource_(pakResource),
       musicWorkerThread_(nullptr), musicMutex_(nullptr), musicCondition_(nullptr),
       musicWorkerRunning_(true)
 {
     assert(allocator_ != nullptr);
+    assert(pakResource_ != nullptr);
     consoleBuffer_->log(SDL_LOG_PRIORITY_TRACE, "AudioManager: Using shared memory allocator");
 
     // Initialize arrays
@@ -883,6 +885,8 @@ int AudioManager::loadMusicTrack(
         // Create the buffer pool for this layer.
         alGenBuffers(MUSIC_STREAM_BUFFERS, layer.buffers);
         layer.buffersCreated = true;
+        layer.resourceId = uniqueLayers[i].resourceId;
+        pakResource_->pinResource(layer.resourceId);
         layer.active = true;
 
         consoleBuffer_->log(SDL_LOG_PRIORITY_DEBUG,
@@ -1154,6 +1158,7 @@ void AudioManager::releaseMusicLayer(MusicLayerStream& layer) {
 
     // Clear stream state (does NOT free the pak buffer — it's owned by the resource system)
     layer.glaState.valid = false;
+    pakResource_->unpinResource(layer.resourceId);
 
     layer.active = false;
     layer.volume = 0.0f;
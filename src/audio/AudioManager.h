@@ -64,6 +64,7 @@ struct GlaStreamState {
 // One streamed GLA layer within a music track
 struct MusicLayerStream {
     GlaStreamState glaState;                     // GLA stream state (nullptr-equivalent = invalid)
+    Uint64         resourceId;                   // Pak resource streamed from (pinned while active)
     ALuint         source;                       // Dedicated OpenAL source
     ALuint         buffers[MUSIC_STREAM_BUFFERS];// Buffer pool
     float          volume;                       // Current rendered volume
@@ -95,11 +96,12 @@ struct MusicTrackState {
 
 class MemoryAllocator;
 class ConsoleBuffer;
+class PakResource;
 
 // Data needed to initialise one GLA layer stream
 struct MusicLayerInitData {
     Uint64               resourceId;  // Resource ID of the GLA file
-    const unsigned char* data;        // Pointer into pak buffer (stays valid while pak is loaded)
+    const unsigned char* data;        // Pointer into pak buffer (AudioManager pins it while the layer is active)
     Uint64               size;
 };
 
@@ -112,7 +114,7 @@ struct MusicIntensityInitData {
 
 class AudioManager {
 public:
-    AudioManager(MemoryAllocator* allocator, ConsoleBuffer* consoleBuffer);
+    AudioManager(MemoryAllocator* allocator, ConsoleBuffer* consoleBuffer, PakResource* pakResource);
     ~AudioManager();
 
     // Initialize the audio system
@@ -259,6 +261,10 @@ private:
     // Console buffer for logging (optional, may be nullptr)
     ConsoleBuffer* consoleBuffer_;
 
+    // Music layers stream straight out of pak resource memory, which is pinned
+    // so the resource cache can't evict it mid-playback
+    PakResource* pakResource_;
+
     // ========================================================================
     // Music streaming internals
     // ========================================================================
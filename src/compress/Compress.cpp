@@ -32,13 +32,55 @@
 // MINMATCH = 4  (minimum encoded back-reference length)
 // Max back-reference offset = 65535 bytes
 //
+// ─── Chunked stream format ───────────────────────────────────────────────────
+//
+//   Offset  Size  Field
+//   ──────  ────  ───────────────────────────────────────────────────────────
+//   0       4     Magic = 0x4B504D43  ('C','M','P','K' in memory, LE)
+//   4       4     origSize   (uint32 LE)
+//   8       4     chunkSize  (uint32 LE, uncompressed bytes per chunk; the
+//                             last chunk holds the remainder)
+//   12      4     chunkCount (uint32 LE) = ceil(origSize / chunkSize)
+//   16      4*N   Chunk end offsets (uint32 LE), relative to the first
+//                 chunk's sequences; chunk i spans [end[i-1], end[i])
+//   …       …     Sequences of each chunk, back to back
+//
+//   Each chunk is an independent block in the sequence format above whose
+//   back-references stay within the chunk, so chunks can be decoded in any
+//   order and on different threads.
+//
+// ─── Dictionary stream format ────────────────────────────────────────────────
+//
+//   Offset  Size  Field
+//   ──────  ────  ───────────────────────────────────────────────────────────
+//   0       4     Magic = 0x44504D43  ('C','M','P','D' in memory, LE)
+//   4       4     origSize  (uint32 LE)
+//   8       8     dictId    (uint64 LE, chosen by the compressing side)
+//   16      …     Sequences, as above
+//
+//   Back-references may reach past the start of the output into the end of
+//   the dictionary, as if it had been decoded just before the stream.
+//
 // ─────────────────────────────────────────────────────────────────────────────
 
 #include "Compress.h"
 
+// Intrinsic headers only declare inline functions; nothing here pulls in libc
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace {
 
 static const uint32_t MAGIC    = 0x52504D43u;  // 'CMPR'
+static const uint32_t CHUNKED_MAGIC = 0x4B504D43u;  // 'CMPK'
+static const size_t   CHUNKED_HEADER_SIZE = 16u;
+static const uint32_t DICT_MAGIC = 0x44504D43u;  // 'CMPD'
+static const size_t   DICT_HEADER_SIZE = 16u;
 static const uint32_t MINMATCH = 4u;
 static const uint32_t HASHLOG  = 16u;
 static const uint32_t HTSIZE   = 1u << HASHLOG;  // 65 536 entries
@@ -54,8 +96,12 @@ static inline uint16_t load16(const uint8_t* p) {
 static inline uint32_t load32(const uint8_t* p) {
     uint32_t v; __builtin_memcpy(&v, p, 4); return v;
 }
+static inline uint64_t load64(const uint8_t* p) {
+    uint64_t v; __builtin_memcpy(&v, p, 8); return v;
+}
 static inline void store16(uint8_t* p, uint16_t v) { __builtin_memcpy(p, &v, 2); }
 static inline void store32(uint8_t* p, uint32_t v) { __builtin_memcpy(p, &v, 4); }
+static inline void store64(uint8_t* p, uint64_t v) { __builtin_memcpy(p, &v, 8); }
 
 // ── Hash ─────────────────────────────────────────────────────────────────────
 // Knuth multiplicative hash maps any 4-byte value uniformly into [0, HTSIZE).
@@ -85,59 +131,130 @@ static inline void fillN(uint8_t* d, uint8_t v, size_t n) {
     while (n--)    { *d++ = v; }
 }
 
-} // anonymous namespace
-
-// ─────────────────────────────────────────────────────────────────────────────
-namespace Compress {
-
-// ── maxSize ───────────────────────────────────────────────────────────────────
-
-size_t maxSize(size_t n) {
-    // 8-byte header + worst-case literal overhead (1 extra byte per 255 of
-    // input, for the length-extension encoding) + a small fixed margin.
-    return 8 + n + (n / 255) + 16;
+// ── Wide copies for the decoder fast path ────────────────────────────────────
+// copyChunk / fillChunk move exactly CHUNK bytes with one (AVX2) or one/two
+// (SSE2, NEON, portable) vector loads and stores. The wild variants round the
+// length up to a whole number of chunks, so callers must guarantee CHUNK bytes
+// of slack past the end of both ranges; the overshoot is overwritten later.
+
+#if defined(__AVX2__)
+static const size_t CHUNK = 32;
+static inline void copyChunk(uint8_t* d, const uint8_t* s) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d),
+                        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s)));
 }
+static inline void fillChunk(uint8_t* d, uint8_t v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d), _mm256_set1_epi8(static_cast<char>(v)));
+}
+#elif defined(__SSE2__)
+static const size_t CHUNK = 16;
+static inline void copyChunk(uint8_t* d, const uint8_t* s) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(d),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+}
+static inline void fillChunk(uint8_t* d, uint8_t v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_set1_epi8(static_cast<char>(v)));
+}
+#elif defined(__ARM_NEON)
+static const size_t CHUNK = 16;
+static inline void copyChunk(uint8_t* d, const uint8_t* s) {
+    vst1q_u8(d, vld1q_u8(s));
+}
+static inline void fillChunk(uint8_t* d, uint8_t v) {
+    vst1q_u8(d, vdupq_n_u8(v));
+}
+#else
+static const size_t CHUNK = 16;
+static inline void copyChunk(uint8_t* d, const uint8_t* s) {
+    // Two loads before the stores, so a source 8 bytes behind d reads old data
+    uint64_t a, b;
+    __builtin_memcpy(&a, s, 8);
+    __builtin_memcpy(&b, s + 8, 8);
+    __builtin_memcpy(d, &a, 8);
+    __builtin_memcpy(d + 8, &b, 8);
+}
+static inline void fillChunk(uint8_t* d, uint8_t v) {
+    const uint64_t vv = (uint64_t)v * 0x0101010101010101ULL;
+    __builtin_memcpy(d, &vv, 8);
+    __builtin_memcpy(d + 8, &vv, 8);
+}
+#endif
 
-// ── compress ─────────────────────────────────────────────────────────────────
-
-size_t compress(const void* vsrc, size_t srcLen, void* vdst, size_t dstCap) {
-    if (!vsrc || !vdst || dstCap < 8) return 0;
-
-    const uint8_t* src = static_cast<const uint8_t*>(vsrc);
-    uint8_t*       dst = static_cast<uint8_t*>(vdst);
+// Slack the fast path needs past a literal run or match: a wild copy may write
+// up to CHUNK - 1 extra bytes, and growing a short match period up to 2 * CHUNK - 2.
+static const size_t WILD_SLACK = 2 * CHUNK;
 
-    store32(dst,     MAGIC);
-    store32(dst + 4, static_cast<uint32_t>(srcLen));
+// Copy at least n bytes in whole chunks; d and s must not overlap.
+static inline void wildCopy(uint8_t* __restrict__ d,
+                            const uint8_t* __restrict__ s, size_t n) {
+    uint8_t* const end = d + n;
+    do { copyChunk(d, s); d += CHUNK; s += CHUNK; } while (d < end);
+}
 
-    if (srcLen == 0) return 8;
-    if (dstCap < maxSize(srcLen)) return 0;
+// Reproduce a back-reference of matchLen bytes at distance offset, writing up
+// to WILD_SLACK bytes past the end. Output is identical to a byte-by-byte
+// forward copy for any offset, including offsets shorter than the match.
+static inline void wildMatchCopy(uint8_t* d, size_t offset, size_t matchLen) {
+    uint8_t* const end = d + matchLen;
+    if (offset == 1u) {
+        const uint8_t v = d[-1];
+        do { fillChunk(d, v); d += CHUNK; } while (d < end);
+        return;
+    }
+    // Grow the distance to at least one chunk by copying the bytes already in
+    // place onto themselves; each copy is non-overlapping and a whole number of
+    // periods, so the repeating pattern is preserved.
+    size_t dist = offset;
+    while (dist < CHUNK) {
+        copyN(d, d - dist, dist);
+        d += dist;
+        dist *= 2;
+    }
+    // Every chunk now reads bytes that are already final
+    while (d < end) { copyChunk(d, d - dist); d += CHUNK; }
+}
 
-    // Hash table: slot h holds the most-recent src offset whose 4-byte prefix
-    // hashes to h, or 0xFFFF'FFFF when empty.
+// ── Sequence blocks ──────────────────────────────────────────────────────────
+// A block is the sequence data of one CMPR stream, or of one chunk of a
+// chunked stream. Back-references never reach before the start of the block,
+// so chunks decode independently of each other.
+
+// Encode srcLen bytes as one block at op, which must have room for
+// maxSize(srcLen) - 8 bytes. Returns the end of the encoded block.
+// The dictLen bytes before src, if any, are a dictionary that matches may
+// reach back into.
+static uint8_t* encodeBlock(const uint8_t* src, size_t srcLen, uint8_t* op, size_t dictLen = 0) {
+    // Hash table: slot h holds the most-recent offset from base whose 4-byte
+    // prefix hashes to h, or 0xFFFF'FFFF when empty.
     // At HTSIZE = 65536 this is a 256 KiB stack frame — acceptable in a packer
     // / build-tool context; the game binary never calls compress().
     uint32_t ht[HTSIZE];
     for (uint32_t i = 0; i < HTSIZE; ++i) ht[i] = 0xFFFFFFFFu;
 
+    const uint8_t* const base = src - dictLen;
     const uint8_t* ip     = src;
     const uint8_t* anchor = src;
     const uint8_t* const srcEnd     = src + srcLen;
     // Last position from which a MINMATCH-byte match can start.
     const uint8_t* const matchLimit = srcEnd - MINMATCH;
 
-    uint8_t* op = dst + 8;
-
     if (srcLen >= MINMATCH) {
-        ht[hash4(ip)] = 0u;
-        ++ip;
+        if (dictLen == 0) {
+            ht[hash4(ip)] = 0u;
+            ++ip;
+        } else {
+            // Only the last 64 KiB of the dictionary are within reach
+            size_t p = dictLen > 65535u ? dictLen - 65535u : 0u;
+            for (; p + MINMATCH <= dictLen; ++p) ht[hash4(base + p)] = static_cast<uint32_t>(p);
+        }
 
         while (ip <= matchLimit) {
             const uint32_t h       = hash4(ip);
             const uint32_t prevPos = ht[h];
-            ht[h] = static_cast<uint32_t>(ip - src);
+            ht[h] = static_cast<uint32_t>(ip - base);
 
             if (prevPos != 0xFFFFFFFFu) {
-                const uint8_t* matchPtr = src + prevPos;
+                const uint8_t* matchPtr = base + prevPos;
                 const uint32_t offset   = static_cast<uint32_t>(ip - matchPtr);
 
                 if (offset > 0u && offset <= 65535u &&
@@ -185,9 +302,11 @@ size_t compress(const void* vsrc, size_t srcLen, void* vdst, size_t dstCap) {
 
                     // Seed a couple of fresh hash entries from within the
                     // match to give future positions more coverage.
-                    if (matchLen >= 6u) {
-                        ht[hash4(ip + 2)]  = static_cast<uint32_t>(ip + 2 - src);
-                        ht[hash4(mf  - 3)] = static_cast<uint32_t>(mf  - 3 - src);
+                    // A match running to the end of the input ends the loop anyway,
+                    // and hashing mf - 3 there would read past srcEnd.
+                    if (matchLen >= 6u && mf < srcEnd) {
+                        ht[hash4(ip + 2)]  = static_cast<uint32_t>(ip + 2 - base);
+                        ht[hash4(mf  - 3)] = static_cast<uint32_t>(mf  - 3 - base);
                     }
 
                     ip     = mf;
@@ -215,15 +334,163 @@ size_t compress(const void* vsrc, size_t srcLen, void* vdst, size_t dstCap) {
     copyN(op, anchor, litLen);
     op += litLen;
 
-    return static_cast<size_t>(op - dst);
+
+    return op;
 }
 
-// ── decompress ───────────────────────────────────────────────────────────────
-// Core design goals:
+// ── High-compression block encoder ───────────────────────────────────────────
+// Hash chains link every position to the previous one with the same 4-byte
+// hash, back to the edge of the 64 KiB window. Each position walks up to
+// HC_MAX_ATTEMPTS links for its longest match, and lazy evaluation defers a
+// match by one literal whenever the next position has a longer one. Several
+// times slower than encodeBlock(), for the same sequence format.
+
+static const uint32_t HC_HASHLOG      = 15u;
+static const uint32_t HC_MAX_ATTEMPTS = 256u;
+static const uint32_t HC_NONE         = 0xFFFFFFFFu;
+static const uint32_t MAX_DISTANCE    = 65535u;
+
+struct HCState {
+    uint32_t head[1u << HC_HASHLOG];  // Latest position per hash, or HC_NONE
+    uint16_t chain[65536];            // Distance back to the previous position with the same hash, 0 = none
+    uint32_t nextToInsert;            // Positions below this are linked in
+};
+
+static inline uint32_t hashHC(const uint8_t* p) {
+    return (load32(p) * 2654435761u) >> (32u - HC_HASHLOG);
+}
+
+static inline void hcInsert(HCState& state, const uint8_t* src, uint32_t target) {
+    while (state.nextToInsert < target) {
+        const uint32_t pos  = state.nextToInsert++;
+        const uint32_t h    = hashHC(src + pos);
+        const uint32_t prev = state.head[h];
+        const uint32_t dist = prev == HC_NONE ? 0u : pos - prev;
+        state.chain[pos & 0xFFFFu] = static_cast<uint16_t>(dist > MAX_DISTANCE ? 0u : dist);
+        state.head[h] = pos;
+    }
+}
+
+// Longest match for base + pos against earlier positions; pos must leave
+// MINMATCH bytes before srcEnd. Returns 0 when there is none.
+static size_t hcFindMatch(HCState& state, const uint8_t* base, const uint8_t* srcEnd,
+                          uint32_t pos, uint32_t& outOffset) {
+    hcInsert(state, base, pos);
+
+    const uint8_t* const ip = base + pos;
+    size_t best = 0;
+    uint32_t candidate = state.head[hashHC(ip)];
+    for (uint32_t attempts = 0; attempts < HC_MAX_ATTEMPTS; ++attempts) {
+        if (candidate == HC_NONE || pos - candidate > MAX_DISTANCE) break;
+        const uint8_t* const m = base + candidate;
+        // Only a match that also agrees one byte past the current best can beat it
+        if ((best == 0 || m[best] == ip[best]) && load32(m) == load32(ip)) {
+            size_t len = MINMATCH;
+            while (ip + len < srcEnd && m[len] == ip[len]) ++len;
+            if (len > best) {
+                best      = len;
+                outOffset = pos - candidate;
+                if (ip + len == srcEnd) break;  // cannot get any longer
+            }
+        }
+        const uint16_t dist = state.chain[candidate & 0xFFFFu];
+        if (dist == 0u) break;
+        candidate -= dist;
+    }
+    return best;
+}
+
+// Append one literal run + match sequence.
+static inline uint8_t* writeSequence(uint8_t* op, const uint8_t* literals, size_t litLen,
+                                     uint32_t offset, size_t matchLen) {
+    const size_t extraML = matchLen - MINMATCH;
+    const uint8_t litNib  = litLen  >= 15u ? 15u : static_cast<uint8_t>(litLen);
+    const uint8_t mlenNib = extraML >= 15u ? 15u : static_cast<uint8_t>(extraML);
+    *op++ = static_cast<uint8_t>((litNib << 4) | mlenNib);
+
+    if (litLen >= 15u) {
+        size_t r = litLen - 15u;
+        while (r >= 255u) { *op++ = 255; r -= 255u; }
+        *op++ = static_cast<uint8_t>(r);
+    }
+    copyN(op, literals, litLen);
+    op += litLen;
+
+    store16(op, static_cast<uint16_t>(offset));
+    op += 2;
+
+    if (extraML >= 15u) {
+        size_t r = extraML - 15u;
+        while (r >= 255u) { *op++ = 255; r -= 255u; }
+        *op++ = static_cast<uint8_t>(r);
+    }
+    return op;
+}
+
+// Append the final literal-only sequence.
+static inline uint8_t* writeLastLiterals(uint8_t* op, const uint8_t* literals, size_t litLen) {
+    const uint8_t litNib = litLen >= 15u ? 15u : static_cast<uint8_t>(litLen);
+    *op++ = static_cast<uint8_t>(litNib << 4);
+    if (litLen >= 15u) {
+        size_t r = litLen - 15u;
+        while (r >= 255u) { *op++ = 255; r -= 255u; }
+        *op++ = static_cast<uint8_t>(r);
+    }
+    copyN(op, literals, litLen);
+    return op + litLen;
+}
+
+// High-compression counterpart of encodeBlock(); same contract.
+static uint8_t* encodeBlockHC(const uint8_t* src, size_t srcLen, uint8_t* op, size_t dictLen = 0) {
+    // 256 KiB, like the encodeBlock() hash table; packer-only as well
+    HCState state;
+    for (uint32_t i = 0; i < (1u << HC_HASHLOG); ++i) state.head[i] = HC_NONE;
+    // Positions are relative to the start of the dictionary, of which only
+    // the last 64 KiB are within reach
+    const uint8_t* const base = src - dictLen;
+    state.nextToInsert = dictLen > MAX_DISTANCE ? static_cast<uint32_t>(dictLen - MAX_DISTANCE) : 0u;
+
+    const uint8_t* const srcEnd = src + srcLen;
+    const uint8_t* anchor = src;
+
+    if (srcLen >= MINMATCH) {
+        const uint32_t lastMatchPos = static_cast<uint32_t>(dictLen + srcLen - MINMATCH);
+        uint32_t pos = dictLen > 0 ? static_cast<uint32_t>(dictLen) : 1u;
+        while (pos <= lastMatchPos) {
+            uint32_t offset = 0;
+            size_t matchLen = hcFindMatch(state, base, srcEnd, pos, offset);
+            if (matchLen == 0) {
+                ++pos;
+                continue;
+            }
+
+            // Lazy evaluation: emit a literal instead if the next byte starts a longer match
+            while (pos < lastMatchPos) {
+                uint32_t nextOffset = 0;
+                const size_t nextLen = hcFindMatch(state, base, srcEnd, pos + 1, nextOffset);
+                if (nextLen <= matchLen) break;
+                ++pos;
+                matchLen = nextLen;
+                offset   = nextOffset;
+            }
+
+            op = writeSequence(op, anchor, static_cast<size_t>(base + pos - anchor), offset, matchLen);
+            pos += static_cast<uint32_t>(matchLen);
+            anchor = base + pos;
+        }
+    }
+
+    return writeLastLiterals(op, anchor, static_cast<size_t>(srcEnd - anchor));
+}
+
+// Decode one block into exactly [op, opEnd). Core design goals:
 //   • Zero dynamic allocation.
 //   • No implicit memcpy / memset calls (safe under -nostdlib).
-//   • Match copies use a forward-copy strategy that correctly reconstructs
-//     overlapping (RLE-like) back-references:
+//   • Literal runs and matches more than WILD_SLACK bytes from the end of the
+//     output are copied in whole SSE2/AVX2/NEON chunks (wildCopy,
+//     wildMatchCopy); short match distances are first grown to a chunk.
+//   • Near the end, match copies use an exact forward-copy strategy that
+//     correctly reconstructs overlapping (RLE-like) back-references:
 //       offset >= matchLen  → non-overlapping: copyN()
 //       offset == 1         → RLE fill: fillN()
 //       offset in [2, 3]    → 2/3-byte period pattern: byte-by-byte loop
@@ -232,22 +499,10 @@ size_t compress(const void* vsrc, size_t srcLen, void* vdst, size_t dstCap) {
 //     pointer advances into data we just wrote, naturally reproducing any
 //     repeating pattern with period <= offset.
 
-size_t decompress(const void* vsrc, size_t srcLen, void* vdst, size_t dstCap) {
-    if (!vsrc || !vdst || srcLen < 8) return 0;
-
-    const uint8_t* ip     = static_cast<const uint8_t*>(vsrc);
-    const uint8_t* ipEnd  = ip + srcLen;
-    uint8_t*       op     = static_cast<uint8_t*>(vdst);
-    const uint8_t* opBase = op;
-
-    if (load32(ip) != MAGIC) return 0;
-    const uint32_t origSize = load32(ip + 4);
-    ip += 8;
-
-    if (origSize == 0) return 0;
-    if (dstCap < static_cast<size_t>(origSize)) return 0;
-
-    uint8_t* const opEnd = op + origSize;
+static bool decodeBlock(const uint8_t* ip, const uint8_t* const ipEnd,
+                        uint8_t* op, uint8_t* const opEnd,
+                        const uint8_t* const dictEnd = nullptr, size_t dictLen = 0) {
+    const uint8_t* const opBase = op;
 
     while (ip < ipEnd) {
         const uint8_t token = *ip++;
@@ -257,50 +512,75 @@ size_t decompress(const void* vsrc, size_t srcLen, void* vdst, size_t dstCap) {
         if (litLen == 15u) {
             uint8_t b;
             do {
-                if (ip >= ipEnd) return 0;
+                if (ip >= ipEnd) return false;
                 b = *ip++;
                 litLen += b;
             } while (b == 255);
         }
 
-        if (static_cast<size_t>(ipEnd - ip) < litLen) return 0;
-        if (static_cast<size_t>(opEnd - op) < litLen) return 0;
+        if (static_cast<size_t>(ipEnd - ip) < litLen) return false;
+        if (static_cast<size_t>(opEnd - op) < litLen) return false;
 
         // ── Copy literals ─────────────────────────────────────────────────────
-        copyN(op, ip, litLen);
+        // Away from the ends of both buffers, copy in whole vector chunks
+        if (static_cast<size_t>(opEnd - op) - litLen >= WILD_SLACK &&
+            static_cast<size_t>(ipEnd - ip) - litLen >= WILD_SLACK) {
+            if (litLen > 0) wildCopy(op, ip, litLen);
+        } else {
+            copyN(op, ip, litLen);
+        }
         ip += litLen;
         op += litLen;
 
         if (op == opEnd) break;  // last sequence — no match follows
 
         // ── Match offset ──────────────────────────────────────────────────────
-        if (ip + 2 > ipEnd) return 0;
+        if (ip + 2 > ipEnd) return false;
         const uint16_t offset = load16(ip);
         ip += 2;
 
-        if (offset == 0u) return 0;
+        if (offset == 0u) return false;
 
-        const uint8_t* matchPtr = op - offset;
-        if (matchPtr < opBase) return 0;  // back-reference out of range
+        const size_t produced = static_cast<size_t>(op - opBase);
+        if (offset > produced + dictLen) return false;  // back-reference out of range
 
         // ── Match length ──────────────────────────────────────────────────────
         size_t matchLen = static_cast<size_t>(token & 0xFu) + MINMATCH;
         if ((token & 0xFu) == 15u) {
             uint8_t b;
             do {
-                if (ip >= ipEnd) return 0;
+                if (ip >= ipEnd) return false;
                 b = *ip++;
                 matchLen += b;
             } while (b == 255);
         }
 
-        if (static_cast<size_t>(opEnd - op) < matchLen) return 0;
+        if (static_cast<size_t>(opEnd - op) < matchLen) return false;
+
+        // ── Dictionary part ───────────────────────────────────────────────────
+        // A match that starts in the dictionary is copied from there up to the
+        // start of the output; the rest is an ordinary back-reference.
+        if (offset > produced) {
+            const size_t fromDict = static_cast<size_t>(offset) - produced;
+            const size_t n = fromDict < matchLen ? fromDict : matchLen;
+            copyN(op, dictEnd - fromDict, n);
+            op += n;
+            matchLen -= n;
+            if (matchLen == 0) continue;
+        }
 
         // ── Copy match ────────────────────────────────────────────────────────
-        // Always forward copy: correctly reconstructs repeated patterns when
-        // offset < matchLen (source and destination overlap).
+        if (static_cast<size_t>(opEnd - op) - matchLen >= WILD_SLACK) {
+            wildMatchCopy(op, offset, matchLen);
+            op += matchLen;
+            continue;
+        }
+
+        // Near the end of the output: exact forward copy, which correctly
+        // reconstructs repeated patterns when offset < matchLen (source and
+        // destination overlap).
         uint8_t*       d   = op;
-        const uint8_t* s   = matchPtr;
+        const uint8_t* s   = op - offset;
         const uint8_t* end = op + matchLen;
 
         if (static_cast<size_t>(offset) >= matchLen) {
@@ -327,7 +607,217 @@ size_t decompress(const void* vsrc, size_t srcLen, void* vdst, size_t dstCap) {
         op += matchLen;
     }
 
-    if (op != opEnd) return 0;  // truncated or corrupt stream
+    return op == opEnd;  // false if truncated or corrupt
+}
+
+// ── Chunked streams ──────────────────────────────────────────────────────────
+
+struct ChunkedStream {
+    uint32_t origSize;
+    uint32_t chunkSize;
+    uint32_t chunkCount;
+    const uint8_t* chunkEnds;  // uint32 LE per chunk, relative to data
+    const uint8_t* data;       // First chunk's block
+    size_t dataLen;
+};
+
+// Validate a chunked stream header and chunk table
+static bool parseChunked(const uint8_t* p, size_t srcLen, ChunkedStream& out) {
+    if (srcLen < CHUNKED_HEADER_SIZE || load32(p) != CHUNKED_MAGIC) return false;
+    out.origSize   = load32(p + 4);
+    out.chunkSize  = load32(p + 8);
+    out.chunkCount = load32(p + 12);
+    if (out.origSize == 0 || out.chunkSize == 0) return false;
+    if (out.chunkCount != (out.origSize - 1u) / out.chunkSize + 1u) return false;
+
+    const size_t tableSize = static_cast<size_t>(out.chunkCount) * 4u;
+    if (srcLen - CHUNKED_HEADER_SIZE < tableSize) return false;
+    out.chunkEnds = p + CHUNKED_HEADER_SIZE;
+    out.data      = out.chunkEnds + tableSize;
+    out.dataLen   = srcLen - CHUNKED_HEADER_SIZE - tableSize;
+    return load32(out.chunkEnds + tableSize - 4u) <= out.dataLen;
+}
+
+// Decode chunk index of a parsed stream into its slot of the output buffer
+static size_t decodeChunk(const ChunkedStream& stream, uint32_t index, uint8_t* dst) {
+    if (index >= stream.chunkCount) return 0;
+    const uint32_t begin = index > 0 ? load32(stream.chunkEnds + (index - 1u) * 4u) : 0u;
+    const uint32_t end   = load32(stream.chunkEnds + index * 4u);
+    if (begin > end || end > stream.dataLen) return 0;
+
+    const size_t outBegin = static_cast<size_t>(index) * stream.chunkSize;
+    size_t outLen = stream.origSize - outBegin;
+    if (outLen > stream.chunkSize) outLen = stream.chunkSize;
+
+    if (!decodeBlock(stream.data + begin, stream.data + end, dst + outBegin, dst + outBegin + outLen)) return 0;
+    return outLen;
+}
+
+} // anonymous namespace
+
+// ─────────────────────────────────────────────────────────────────────────────
+namespace Compress {
+
+// ── maxSize ───────────────────────────────────────────────────────────────────
+
+size_t maxSize(size_t n) {
+    // 8-byte header + worst-case literal overhead (1 extra byte per 255 of
+    // input, for the length-extension encoding) + a small fixed margin.
+    return 8 + n + (n / 255) + 16;
+}
+
+// ── compress ─────────────────────────────────────────────────────────────────
+
+size_t compress(const void* vsrc, size_t srcLen, void* vdst, size_t dstCap, Level level) {
+    if (!vsrc || !vdst || dstCap < 8) return 0;
+
+    const uint8_t* src = static_cast<const uint8_t*>(vsrc);
+    uint8_t*       dst = static_cast<uint8_t*>(vdst);
+
+    store32(dst,     MAGIC);
+    store32(dst + 4, static_cast<uint32_t>(srcLen));
+
+    if (srcLen == 0) return 8;
+    if (dstCap < maxSize(srcLen)) return 0;
+
+    uint8_t* const end = level == LEVEL_HIGH ? encodeBlockHC(src, srcLen, dst + 8)
+                                             : encodeBlock(src, srcLen, dst + 8);
+    return static_cast<size_t>(end - dst);
+}
+
+// ── decompress ───────────────────────────────────────────────────────────────
+
+size_t decompress(const void* vsrc, size_t srcLen, void* vdst, size_t dstCap) {
+    if (!vsrc || !vdst || srcLen < 8) return 0;
+
+    const uint8_t* ip = static_cast<const uint8_t*>(vsrc);
+    uint8_t*       op = static_cast<uint8_t*>(vdst);
+
+    if (load32(ip) == CHUNKED_MAGIC) {
+        ChunkedStream stream;
+        if (!parseChunked(ip, srcLen, stream)) return 0;
+        if (dstCap < static_cast<size_t>(stream.origSize)) return 0;
+        for (uint32_t i = 0; i < stream.chunkCount; ++i) {
+            if (decodeChunk(stream, i, op) == 0) return 0;
+        }
+        return static_cast<size_t>(stream.origSize);
+    }
+
+    if (load32(ip) != MAGIC) return 0;
+    const uint32_t origSize = load32(ip + 4);
+
+    if (origSize == 0) return 0;
+    if (dstCap < static_cast<size_t>(origSize)) return 0;
+
+    if (!decodeBlock(ip + 8, ip + srcLen, op, op + origSize)) return 0;
+    return static_cast<size_t>(origSize);
+}
+
+// ── Chunked streams ──────────────────────────────────────────────────────────
+
+size_t maxSizeChunked(size_t n, size_t chunkSize) {
+    if (chunkSize == 0) return 0;
+    const size_t chunks = n == 0 ? 0 : (n - 1) / chunkSize + 1;
+    // Header + chunk table + per-block worst case (see maxSize); the per-chunk
+    // rounding of the length-extension overhead adds at most 1 byte per chunk.
+    return CHUNKED_HEADER_SIZE + chunks * (4 + 16 + 1) + n + (n / 255);
+}
+
+size_t compressChunked(const void* vsrc, size_t srcLen, void* vdst, size_t dstCap, size_t chunkSize, Level level) {
+    if (!vsrc || !vdst || srcLen == 0 || chunkSize == 0) return 0;
+    if (srcLen > 0xFFFFFFFFu || chunkSize > 0xFFFFFFFFu) return 0;
+    if (dstCap < maxSizeChunked(srcLen, chunkSize)) return 0;
+
+    const uint8_t* src = static_cast<const uint8_t*>(vsrc);
+    uint8_t*       dst = static_cast<uint8_t*>(vdst);
+    const uint32_t chunks = static_cast<uint32_t>((srcLen - 1) / chunkSize + 1);
+
+    store32(dst,      CHUNKED_MAGIC);
+    store32(dst + 4,  static_cast<uint32_t>(srcLen));
+    store32(dst + 8,  static_cast<uint32_t>(chunkSize));
+    store32(dst + 12, chunks);
+
+    uint8_t* const table = dst + CHUNKED_HEADER_SIZE;
+    uint8_t* const data  = table + static_cast<size_t>(chunks) * 4u;
+    uint8_t* op = data;
+    for (uint32_t i = 0; i < chunks; ++i) {
+        const size_t begin = static_cast<size_t>(i) * chunkSize;
+        const size_t len   = srcLen - begin < chunkSize ? srcLen - begin : chunkSize;
+        op = level == LEVEL_HIGH ? encodeBlockHC(src + begin, len, op)
+                                 : encodeBlock(src + begin, len, op);
+        if (static_cast<size_t>(op - data) > 0xFFFFFFFFu) return 0;
+        store32(table + i * 4u, static_cast<uint32_t>(op - data));
+    }
+    return static_cast<size_t>(op - dst);
+}
+
+uint32_t chunkCount(const void* vsrc, size_t srcLen) {
+    if (!vsrc || srcLen < 8) return 0u;
+    const uint8_t* p = static_cast<const uint8_t*>(vsrc);
+    if (load32(p) == MAGIC || load32(p) == DICT_MAGIC) return load32(p + 4) != 0u ? 1u : 0u;
+    ChunkedStream stream;
+    return parseChunked(p, srcLen, stream) ? stream.chunkCount : 0u;
+}
+
+size_t decompressChunk(const void* vsrc, size_t srcLen, uint32_t index, void* vdst, size_t dstCap) {
+    if (!vsrc || !vdst || srcLen < 8) return 0;
+    const uint8_t* p = static_cast<const uint8_t*>(vsrc);
+    if (load32(p) == MAGIC) {
+        return index == 0 ? decompress(vsrc, srcLen, vdst, dstCap) : 0;
+    }
+    ChunkedStream stream;
+    if (!parseChunked(p, srcLen, stream)) return 0;
+    if (dstCap < static_cast<size_t>(stream.origSize)) return 0;
+    return decodeChunk(stream, index, static_cast<uint8_t*>(vdst));
+}
+
+// ── Dictionary streams ───────────────────────────────────────────────────────
+
+size_t maxSizeWithDict(size_t n) {
+    return maxSize(n) + (DICT_HEADER_SIZE - 8);
+}
+
+size_t compressWithDict(const void* vsrc, size_t srcLen, size_t dictLen, uint64_t dictId,
+                        void* vdst, size_t dstCap, Level level) {
+    if (!vsrc || !vdst || dictId == 0 || srcLen > 0xFFFFFFFFu) return 0;
+    if (dstCap < maxSizeWithDict(srcLen)) return 0;
+
+    const uint8_t* src = static_cast<const uint8_t*>(vsrc);
+    uint8_t*       dst = static_cast<uint8_t*>(vdst);
+
+    store32(dst,     DICT_MAGIC);
+    store32(dst + 4, static_cast<uint32_t>(srcLen));
+    store64(dst + 8, dictId);
+    if (srcLen == 0) return DICT_HEADER_SIZE;
+
+    uint8_t* const end = level == LEVEL_HIGH ? encodeBlockHC(src, srcLen, dst + DICT_HEADER_SIZE, dictLen)
+                                             : encodeBlock(src, srcLen, dst + DICT_HEADER_SIZE, dictLen);
+    return static_cast<size_t>(end - dst);
+}
+
+uint64_t dictionaryId(const void* vsrc, size_t srcLen) {
+    if (!vsrc || srcLen < DICT_HEADER_SIZE) return 0u;
+    const uint8_t* p = static_cast<const uint8_t*>(vsrc);
+    return load32(p) == DICT_MAGIC ? load64(p + 8) : 0u;
+}
+
+size_t decompressWithDict(const void* vsrc, size_t srcLen, const void* vdict, size_t dictLen,
+                          void* vdst, size_t dstCap) {
+    if (!vsrc || !vdst || srcLen < 8) return 0;
+
+    const uint8_t* ip = static_cast<const uint8_t*>(vsrc);
+    if (load32(ip) != DICT_MAGIC) {
+        return decompress(vsrc, srcLen, vdst, dstCap);
+    }
+    if (srcLen < DICT_HEADER_SIZE || (!vdict && dictLen > 0)) return 0;
+
+    const uint32_t origSize = load32(ip + 4);
+    if (origSize == 0) return 0;
+    if (dstCap < static_cast<size_t>(origSize)) return 0;
+
+    uint8_t* op = static_cast<uint8_t*>(vdst);
+    const uint8_t* dictEnd = static_cast<const uint8_t*>(vdict) + dictLen;
+    if (!decodeBlock(ip + DICT_HEADER_SIZE, ip + srcLen, op, op + origSize, dictEnd, dictLen)) return 0;
     return static_cast<size_t>(origSize);
 }
 
@@ -336,7 +826,8 @@ size_t decompress(const void* vsrc, size_t srcLen, void* vdst, size_t dstCap) {
 uint32_t originalSize(const void* vsrc, size_t srcLen) {
     if (!vsrc || srcLen < 8) return 0u;
     const uint8_t* p = static_cast<const uint8_t*>(vsrc);
-    if (load32(p) != MAGIC) return 0u;
+    const uint32_t magic = load32(p);
+    if (magic != MAGIC && magic != CHUNKED_MAGIC && magic != DICT_MAGIC) return 0u;
     return load32(p + 4);
 }
 
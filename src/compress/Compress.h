@@ -9,7 +9,8 @@
 // Compressed streams are self-describing: an 8-byte header stores the magic
 // value and the original (uncompressed) size. The algorithm is an LZ77
 // hash-chain compressor with a 16-bit back-reference window, producing the
-// same sequence format as LZ4 block data.
+// same sequence format as LZ4 block data. Large inputs can instead be split
+// into a chunked stream of independently compressed blocks.
 
 namespace Compress {
 
@@ -17,10 +18,18 @@ namespace Compress {
 // Pass this value (or larger) as dstCapacity to compress().
 size_t maxSize(size_t srcLen);
 
+// Encoder effort. Both produce the same stream format and decode at the same
+// speed; LEVEL_HIGH searches deeper hash chains with lazy matching for a
+// smaller output at several times the encoding time.
+enum Level {
+    LEVEL_FAST = 0,
+    LEVEL_HIGH = 1
+};
+
 // Compress srcLen bytes from src into dst.
 // dst must point to at least maxSize(srcLen) writable bytes.
 // Returns the number of bytes written to dst, or 0 on failure.
-size_t compress(const void* src, size_t srcLen, void* dst, size_t dstCapacity);
+size_t compress(const void* src, size_t srcLen, void* dst, size_t dstCapacity, Level level = LEVEL_FAST);
 
 // Decompress a CMPR stream from src into dst.
 // Returns the number of bytes written (equal to the stored original size),
@@ -32,4 +41,56 @@ size_t decompress(const void* src, size_t srcLen, void* dst, size_t dstCapacity)
 // performing any decompression. Returns 0 if the header is absent or invalid.
 uint32_t originalSize(const void* src, size_t srcLen);
 
+// ── Chunked streams ──────────────────────────────────────────────────────────
+// A chunked stream splits the input into chunkSize blocks that are compressed
+// independently and indexed by a chunk table, so one large resource can be
+// decoded by several threads at once, or consumed chunk by chunk as each one
+// finishes. decompress() and originalSize() accept both stream kinds.
+
+static const size_t DEFAULT_CHUNK_SIZE = 256 * 1024;
+
+// Upper bound on compressChunked() output for srcLen bytes of input.
+size_t maxSizeChunked(size_t srcLen, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+// Compress srcLen (> 0) bytes from src into a chunked stream.
+// dst must point to at least maxSizeChunked(srcLen, chunkSize) writable bytes.
+// Returns the number of bytes written to dst, or 0 on failure.
+size_t compressChunked(const void* src, size_t srcLen, void* dst, size_t dstCapacity,
+                       size_t chunkSize = DEFAULT_CHUNK_SIZE, Level level = LEVEL_FAST);
+
+// Number of independently decodable chunks in a stream: 1 for a plain CMPR
+// stream, 0 if the header or chunk table is invalid.
+uint32_t chunkCount(const void* src, size_t srcLen);
+
+// Decompress one chunk of a stream. dst is the output buffer of the whole
+// stream (dstCapacity >= originalSize()); the chunk is written at its own
+// offset, index * chunkSize, and nothing outside it is touched, so different
+// chunks may be decoded into the same buffer concurrently.
+// Returns the number of bytes written, or 0 on failure.
+size_t decompressChunk(const void* src, size_t srcLen, uint32_t index, void* dst, size_t dstCapacity);
+
+// ── Dictionary streams ───────────────────────────────────────────────────────
+// Small inputs have too little history of their own for LZ matching to find
+// much. A dictionary stream may also reference a dictionary of typical
+// content shared by many such inputs; only its last 64 KiB are within reach.
+// decompress() rejects these streams, as it has no dictionary to offer.
+
+// Upper bound on compressWithDict() output for srcLen bytes of input.
+size_t maxSizeWithDict(size_t srcLen);
+
+// Compress srcLen bytes from src, which must directly follow the dictLen
+// bytes of dictionary in memory. dictId (non-zero) is stored in the stream
+// so the decompressing side can find the same dictionary.
+// Returns the number of bytes written to dst, or 0 on failure.
+size_t compressWithDict(const void* src, size_t srcLen, size_t dictLen, uint64_t dictId,
+                        void* dst, size_t dstCapacity, Level level = LEVEL_FAST);
+
+// dictId of a dictionary stream, or 0 for streams that need no dictionary.
+uint64_t dictionaryId(const void* src, size_t srcLen);
+
+// decompress() for dictionary streams, given the dictionary they were
+// compressed with. Streams that need no dictionary are decoded as usual.
+size_t decompressWithDict(const void* src, size_t srcLen, const void* dict, size_t dictLen,
+                          void* dst, size_t dstCapacity);
+
 } // namespace Compress
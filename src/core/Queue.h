@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Vector.h"
+#include "../memory/MemoryAllocator.h"
+#include <cassert>
+
+// FIFO queue adapter using Vector as underlying container
+// Pops advance a head index instead of shifting elements; the consumed
+// prefix is compacted away once it makes up half of the storage.
+// K = Element type
+template<typename K>
+class Queue {
+public:
+    // Constructor with custom allocator and allocation ID
+    explicit Queue(MemoryAllocator& allocator, const char* callerId)
+        : data_(allocator, callerId)
+        , head_(0)
+    {
+    }
+
+    ~Queue() {
+        // Vector destructor handles cleanup
+    }
+
+    // Disable copy constructor and assignment
+    Queue(const Queue&) = delete;
+    Queue& operator=(const Queue&) = delete;
+
+    // Add element to the back of the queue
+    void push(const K& value) {
+        data_.push_back(value);
+    }
+
+    // Remove front element from queue
+    void pop() {
+        assert(!empty() && "Queue::pop() called on empty queue");
+        head_++;
+        if (head_ == data_.size()) {
+            data_.clear();
+            head_ = 0;
+        } else if (head_ >= COMPACT_THRESHOLD && head_ * 2 >= data_.size()) {
+            compact();
+        }
+    }
+
+    // Get reference to front element
+    K& front() {
+        assert(!empty() && "Queue::front() called on empty queue");
+        return data_[head_];
+    }
+
+    // Get const reference to front element
+    const K& front() const {
+        assert(!empty() && "Queue::front() called on empty queue");
+        return data_[head_];
+    }
+
+    // Access queued element by position from the front
+    K& operator[](Uint64 index) {
+        assert(index < size());
+        return data_[head_ + index];
+    }
+
+    // Check if queue is empty
+    bool empty() const {
+        return head_ == data_.size();
+    }
+
+    // Get number of elements in queue
+    Uint64 size() const {
+        return data_.size() - head_;
+    }
+
+    // Clear all elements
+    void clear() {
+        data_.clear();
+        head_ = 0;
+    }
+
+private:
+    static const Uint64 COMPACT_THRESHOLD = 32;
+
+    void compact() {
+        Uint64 remaining = data_.size() - head_;
+        for (Uint64 i = 0; i < remaining; i++) {
+            data_[i] = static_cast<K&&>(data_[head_ + i]);
+        }
+        data_.resize(remaining);
+        head_ = 0;
+    }
+
+    Vector<K> data_;
+    Uint64 head_;
+};
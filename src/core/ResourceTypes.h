@@ -3,6 +3,7 @@
 #include <SDL3/SDL_stdinc.h>
 
 #define VERSION_1_0        1
+#define VERSION_2_0        2  //ResourcePtrs sorted by ascending id so the index can be binary-searched in place
 
 #define f32_t float
 #define f64_t double
@@ -12,11 +13,11 @@
 //------------------------------------
 typedef struct
 {
-    char sig[4];        //PAKC in big endian for current version
-    Uint32 version;    //VERSION_1_0 for current version of the game
+    char sig[4];        //PAKC in big endian for current version, PAKO for an overlay pak
+    Uint32 version;    //VERSION_2_0 for current version of the game (VERSION_1_0 is still readable)
     Uint32 numResources;
-    Uint32 pad;
-    //Followed by numResources ResourcePtrs
+    Uint32 pad;         //Overlay paks: low 32 bits of hashBytes() over the base pak's ResourcePtr table
+    //Followed by numResources ResourcePtrs (sorted by id from VERSION_2_0 on)
 } PakFileHeader;
 
 
@@ -36,7 +37,7 @@ typedef struct
 // Compressed data
 //--------------------------------------------------------------
 #define COMPRESSION_FLAGS_UNCOMPRESSED    0
-#define COMPRESSION_FLAGS_CMPR            1
+#define COMPRESSION_FLAGS_CMPR            1  //CMPR stream; a dictionary stream names the pak id of its RESOURCE_TYPE_CMPR_DICTIONARY
 
 typedef struct
 {
@@ -64,7 +65,34 @@ typedef struct
 #define RESOURCE_TYPE_VECTOR_SHAPE  14  //Vector shape (analytic SDF, cubic Bezier curves)
 #define RESOURCE_TYPE_DIALOGUE      15  //Binary dialogue resource
 #define RESOURCE_TYPE_CHARACTER     16  //Binary character definition resource
+#define RESOURCE_TYPE_SCENE_MANIFEST 17 //Per-scene resource dependency lists
+#define RESOURCE_TYPE_ATLAS_UV_TABLE 18 //UVs and sizes of every atlased texture
+#define RESOURCE_TYPE_CMPR_DICTIONARY 19 //Shared CMPR dictionary of one resource type, stored uncompressed
+#define RESOURCE_TYPE_SPRITE_MESH_TABLE 20 //Trim rects and outlines of trimmed sprites
 //#define RESOURCE_TYPE_
+
+// Display name of a RESOURCE_TYPE_* value, for tool and debug output
+static inline const char* resourceTypeName(Uint32 type) {
+    switch (type) {
+        case RESOURCE_TYPE_IMAGE: return "texture";
+        case RESOURCE_TYPE_IMAGE_ATLAS: return "atlas";
+        case RESOURCE_TYPE_SOUND: return "sound";
+        case RESOURCE_TYPE_MUSIC_TRACK: return "music";
+        case RESOURCE_TYPE_FONT: return "font";
+        case RESOURCE_TYPE_LUA: return "lua";
+        case RESOURCE_TYPE_IMAGE_NO_ATLAS: return "image";
+        case RESOURCE_TYPE_SHADER: return "shader";
+        case RESOURCE_TYPE_TRIG_TABLE: return "trig table";
+        case RESOURCE_TYPE_VECTOR_SHAPE: return "vector shape";
+        case RESOURCE_TYPE_DIALOGUE: return "dialogue";
+        case RESOURCE_TYPE_CHARACTER: return "character";
+        case RESOURCE_TYPE_SCENE_MANIFEST: return "scene manifest";
+        case RESOURCE_TYPE_ATLAS_UV_TABLE: return "atlas uv table";
+        case RESOURCE_TYPE_CMPR_DICTIONARY: return "dictionary";
+        case RESOURCE_TYPE_SPRITE_MESH_TABLE: return "sprite mesh table";
+        default: return "other";
+    }
+}
 //etc
 
 
@@ -73,36 +101,128 @@ typedef struct
 //--------------------------------------------------------------
 typedef struct //Structure for texture atlas data
 {
-    Uint16 format;        //Image format (see IMAGE_FORMAT_* constants below)
+    Uint8 format;         //Image format (see IMAGE_FORMAT_* constants below)
+    Uint8 mipLevels;      //Mip levels stored, base image included (0 = base image only)
     Uint16 width;         //Width of atlas in pixels
     Uint16 height;        //Height of atlas in pixels
     Uint16 numEntries;    //Number of images packed into this atlas
     //Followed by numEntries AtlasEntry structures
-    //Followed by compressed image data
+    //Followed by compressed image data, one mip level after another
 } AtlasHeader;
 
 typedef struct //Structure for individual image entry in atlas
 {
     Uint64 originalId;    //Original resource ID of the packed image
-    Uint16 x;             //X position in atlas (pixels)
+    Uint16 x;             //X position in atlas (pixels), ATLAS_ENTRY_ROTATED in the high bit
     Uint16 y;             //Y position in atlas (pixels)
-    Uint16 width;         //Width of image in atlas (pixels)
-    Uint16 height;        //Height of image in atlas (pixels)
+    Uint16 width;         //Width of image in atlas (pixels, after trimming)
+    Uint16 height;        //Height of image in atlas (pixels, after trimming)
 } AtlasEntry;
 
+// Set in AtlasEntry.x when the packer stored the image turned 90 degrees
+// clockwise; it then covers height x width texels. width and height stay the
+// stored image's own size.
+#define ATLAS_ENTRY_ROTATED 0x8000
+#define ATLAS_ENTRY_X_MASK  0x7fff
+
 typedef struct //Structure for image indices into the atlas AtlasHeader
 {
     Uint64 atlasId;    //ID of AtlasHeader
     f32_t coordinates[8];    //UV texture coordinates for the image in the atlas
 } TextureHeader;
 
+// Packer-generated table of every texture packed into an atlas, so UV and size
+// lookups need neither the TextureHeader nor the atlas resource. With
+// --trim-sprites the atlas region holds only the trim rect of the image (its
+// non-transparent pixels plus a one pixel transparent margin).
+// Binary layout:
+//   AtlasUVTableHeader
+//   Uint64 textureIds[numTextures]             -- ascending
+//   AtlasUVTableEntry entries[numTextures]     -- in textureIds order
+#define ATLAS_UV_TABLE_PATH "res/atlas_uv_table.bin"
+
+typedef struct
+{
+    Uint32 numTextures;
+    Uint32 pad;
+} AtlasUVTableHeader;
+
+typedef struct
+{
+    Uint64 atlasId;       //ID of AtlasHeader
+    f32_t u0, v0;         //Top-left corner of the image's atlas region
+    f32_t u1, v1;         //Bottom-right corner of the image's atlas region
+    Uint16 width;         //Original image width
+    Uint16 height;        //Original image height
+    Uint32 flags;         //ATLAS_UV_* flags
+    Uint16 trimX, trimY;  //Top-left pixel of the part of the image held by the region
+    Uint16 trimWidth;     //Size of that part (AtlasEntry.width/height); equal to
+    Uint16 trimHeight;    //width and height for an untrimmed image
+} AtlasUVTableEntry;
+
+#define ATLAS_UV_ROTATED 1  //Image is stored rotated (ATLAS_ENTRY_ROTATED)
+#define ATLAS_UV_TRIMMED 2  //Region holds only the trim rect of the image
+
+// Atlas UV of the point (s, t) of an atlased image, with s running 0..1 left to
+// right and t 0..1 top to bottom across the image. u0, v0 and u1, v1 are the
+// top-left and bottom-right corners of its atlas region, which holds the image
+// turned 90 degrees clockwise when rotated is set.
+static inline void atlasImageUV(f32_t u0, f32_t v0, f32_t u1, f32_t v1, bool rotated,
+                                f32_t s, f32_t t, f32_t& u, f32_t& v) {
+    if (rotated) {
+        u = u0 + (1.0f - t) * (u1 - u0);
+        v = v0 + s * (v1 - v0);
+    } else {
+        u = u0 + s * (u1 - u0);
+        v = v0 + t * (v1 - v0);
+    }
+}
+
+// Position of the image point (s, t) relative to the trim rect s0..s1 x t0..t1
+// (fractions of the image) that the atlas region actually holds, for passing on
+// to atlasImageUV(). Not clamped: points outside the trim map outside the region
+// and the sprite shaders' UV bounds clamp them onto its transparent margin.
+static inline void atlasTrimST(const f32_t trim[4], f32_t s, f32_t t, f32_t& ts, f32_t& tt) {
+    ts = (s - trim[0]) / (trim[2] - trim[0]);
+    tt = (t - trim[1]) / (trim[3] - trim[1]);
+}
+
+// Packer-generated table of every image trimmed by --trim-sprites, with the
+// convex outline of its opaque pixels where --sprite-hulls found one that covers
+// clearly less than the trim rect. Drawing that outline instead of a quad
+// skips most of the transparent pixels.
+// Binary layout:
+//   SpriteMeshTableHeader
+//   Uint64 textureIds[numSprites]              -- ascending
+//   SpriteMeshEntry entries[numSprites]        -- in textureIds order
+#define SPRITE_MESH_TABLE_PATH "res/sprite_mesh_table.bin"
+#define SPRITE_MESH_MAX_VERTICES 8
+
+typedef struct
+{
+    Uint32 numSprites;
+    Uint32 pad;
+} SpriteMeshTableHeader;
+
+typedef struct
+{
+    Uint16 width;         //Original image width
+    Uint16 height;        //Original image height
+    Uint16 trimX, trimY;  //Part of the image stored in the atlas (AtlasUVTableEntry trim)
+    Uint16 trimWidth;
+    Uint16 trimHeight;
+    Uint32 numVertices;   //0 (draw the trim rect) or 3..SPRITE_MESH_MAX_VERTICES
+    f32_t points[SPRITE_MESH_MAX_VERTICES * 2];  //Outline as s, t pairs (fractions of the
+                                                 //image, t down), counter-clockwise drawn y-up
+} SpriteMeshEntry;
+
 typedef struct //Structure for (non-atlased) image data
 {
     Uint16 format;        //Image format (see IMAGE_FORMAT_* constants below)
     Uint16 width;         //Width of image
     Uint16 height;        //Height of image
-    Uint16 pad;
-                           //Followed by image data
+    Uint16 mipLevels;     //Mip levels stored, base image included (0 = base image only)
+                           //Followed by image data, one mip level after another
 } ImageHeader;
 
 // Image format constants for ImageHeader.format
@@ -115,6 +235,24 @@ typedef struct //Structure for (non-atlased) image data
 #define IMAGE_FORMAT_ETC2           5   // ETC2 compression (RGBA with alpha, 1 byte per pixel)
 #define IMAGE_FORMAT_ASTC_4x4       6   // ASTC 4x4 compression (RGBA with alpha, 1 byte per pixel)
 
+// Mip level i of a width x height image is max(1, width >> i) x max(1, height >> i).
+// Returns the bytes one level of a block-compressed image takes, partial 4x4
+// blocks at its edges included, or 0 for an uncompressed format.
+static inline Uint64 compressedImageLevelSize(Uint16 format, Uint32 width, Uint32 height) {
+    Uint64 blocks = (Uint64)((width + 3) / 4) * ((height + 3) / 4);
+    switch (format) {
+        case IMAGE_FORMAT_BC1_DXT1:
+        case IMAGE_FORMAT_ETC1:
+            return blocks * 8;
+        case IMAGE_FORMAT_BC3_DXT5:
+        case IMAGE_FORMAT_ETC2:
+        case IMAGE_FORMAT_ASTC_4x4:
+            return blocks * 16;
+        default:
+            return 0;
+    }
+}
+
 // Default maximum atlas texture size (can be overridden at pack time)
 // Most desktop GPUs support at least 4096x4096 textures
 #define DEFAULT_ATLAS_MAX_SIZE      4096
@@ -320,6 +458,33 @@ typedef struct
     // Followed by numEntries floats for cos values
 } TrigTableHeader;
 
+//--------------------------------------------------------------
+// Scene manifests
+//--------------------------------------------------------------
+// Generated by the packer from the resource paths referenced by each scene
+// script under res/scenes/ and, transitively, by the scripts and data files it
+// references. Other scene scripts are not followed.
+// Binary layout:
+//   SceneManifestHeader
+//   SceneManifestEntry[numScenes]   -- sorted by sceneId
+//   Uint64 resourceIds[numResourceIds]
+#define SCENE_MANIFEST_PATH "res/scene_manifests.bin"
+
+typedef struct
+{
+    Uint32 numScenes;
+    Uint32 numResourceIds;
+    //Followed by numScenes SceneManifestEntry structs
+    //Followed by numResourceIds Uint64 resource IDs
+} SceneManifestHeader;
+
+typedef struct
+{
+    Uint64 sceneId;           //Resource ID of the scene script
+    Uint32 firstResource;     //Index of the scene's first ID in the resourceIds array
+    Uint32 numResources;      //Scene script first, then its dependencies in discovery order
+} SceneManifestEntry;
+
 //--------------------------------------------------------------
 // GLA audio data (RESOURCE_TYPE_SOUND)
 // Custom IMA ADPCM audio format for zero-decode-cost playback via AL_EXT_IMA4.
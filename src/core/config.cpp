@@ -344,12 +344,16 @@ Config loadConfig() {
             config.gpuIndex = manager.getInt("Graphics", "gpu_index", -1);
             const char* presentMode = manager.getString("Graphics", "present_mode", "");
             config.presentMode = parsePresentModeEnum(presentMode);
+            config.textureMipSkip = manager.getInt("Graphics", "texture_mip_skip", 0);
             const char* logLevel = manager.getString("Logging", "log_level", "");
             if (logLevel[0] != '\0') {
                 config.logLevel = parseLogLevelEnum(logLevel);
             }
             const char* language = manager.getString("Language", "language", "en");
             SDL_strlcpy(config.language, language, sizeof(config.language));
+            config.pakMmap = manager.getInt("Resources", "pak_mmap", 1);
+            config.resourceWorkers = manager.getInt("Resources", "worker_threads", 0);
+            config.resourceCacheMB = manager.getInt("Resources", "cache_budget_mb", 0);
         }
     }
     setCurrentLanguage(config.language);
@@ -369,11 +373,19 @@ void saveConfig(const Config& config) {
         manager.setInt("Graphics", "gpu_index", config.gpuIndex);
         manager.setString("Graphics", "present_mode", getActivePresentModeString(config.presentMode));
         manager.setKeyComment("Graphics", "present_mode", "; Vulkan present mode: fifo (vsync), mailbox (triple-buffered uncapped fps), immediate (no buffering), fifo_relaxed (good for low spec)");
+        manager.setInt("Graphics", "texture_mip_skip", config.textureMipSkip);
+        manager.setKeyComment("Graphics", "texture_mip_skip", "; Largest mip levels of each texture to leave out, saving GPU memory on low-memory systems (0 = full resolution, each level quarters it)");
         manager.setString("Logging", "log_level", getLogLevelString(config.logLevel));
         manager.setKeyComment("Logging", "log_level", "; Log level: verbose, debug, info, warn, error, critical");
         setCurrentLanguage(config.language);
         manager.setString("Language", "language", config.language);
         manager.setKeyComment("Language", "language", "; ISO 639-1 language code for dialogue text (e.g. en, fr, es, de, ja)");
+        manager.setInt("Resources", "pak_mmap", config.pakMmap);
+        manager.setKeyComment("Resources", "pak_mmap", "; 1 = memory-map res.pak and page resources in on demand, 0 = read the whole pak into memory at startup");
+        manager.setInt("Resources", "worker_threads", config.resourceWorkers);
+        manager.setKeyComment("Resources", "worker_threads", "; Pak decompression threads, 0 = one per CPU core minus one");
+        manager.setInt("Resources", "cache_budget_mb", config.resourceCacheMB);
+        manager.setKeyComment("Resources", "cache_budget_mb", "; Decompressed resource cache budget in MB, least recently used resources are evicted beyond it (0 = unlimited)");
         manager.save();
     }
 }
@@ -37,6 +37,14 @@ struct Config {
 #endif
     // ISO 639-1 language code used for dialogue text selection (e.g. "en", "fr", "es").
     char language[MAX_LANGUAGE_CODE] = "en";
+    // Load res.pak through a memory mapping (1) or read the whole file into memory (0)
+    int pakMmap = 1;
+    // Number of pak decompression worker threads; 0 sizes the pool from the CPU core count
+    int resourceWorkers = 0;
+    // Budget for decompressed pak resources in MB; 0 keeps everything resident
+    int resourceCacheMB = 0;
+    // Largest mip levels of each mipmapped texture to leave out of GPU memory; 0 uploads full resolution
+    int textureMipSkip = 0;
 };
 
 // Config manager for INI-style configuration files
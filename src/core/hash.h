@@ -10,3 +10,14 @@ static Uint64 hashCString(const char* str) {
     }
     return hash;
 }
+
+// FNV-1a hash of a byte range. Pass an earlier result as seed to hash
+// several ranges as if they were one.
+static Uint64 hashBytes(const char* data, Uint64 size, Uint64 seed = 14695981039346656037ULL) {
+    Uint64 hash = seed;
+    for (Uint64 i = 0; i < size; i++) {
+        hash ^= (Uint64)(unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
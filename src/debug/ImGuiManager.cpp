@@ -25,7 +25,9 @@ ImGuiManager::ImGuiManager(MemoryAllocator* allocator, ConsoleBuffer* consoleBuf
     , imguiTextureCache_(*allocator, "ImGuiManager::imguiTextureCache_")
     , stringAllocator_(allocator)
     , consoleBuffer_(consoleBuffer)
-    , trigLookup_(trigLookup) {
+    , trigLookup_(trigLookup)
+    , lastSmallAllocateCalls_(0)
+    , lastLargeAllocateCalls_(0) {
     assert(stringAllocator_ != nullptr);
     assert(consoleBuffer_ != nullptr);
     assert(trigLookup_ != nullptr);
@@ -1742,7 +1744,7 @@ String ImGuiManager::truncateTextureName(const char* fullName, float maxWidth) {
     return ellipsis;
 }
 
-void ImGuiManager::showMemoryAllocatorWindow(MemoryAllocator* smallAllocator, MemoryAllocator* largeAllocator, float currentTime) {
+void ImGuiManager::showMemoryAllocatorWindow(MemoryAllocator* smallAllocator, MemoryAllocator* largeAllocator, PakResource* pakResource, float currentTime) {
     if (!initialized_) {
         return;
     }
@@ -1755,6 +1757,14 @@ void ImGuiManager::showMemoryAllocatorWindow(MemoryAllocator* smallAllocator, Me
     small->updateMemoryHistory(currentTime);
     large->updateMemoryHistory(currentTime);
 
+    // Allocator calls made since the previous frame, taken even while the window is collapsed
+    Uint32 smallAllocateCalls = small->getAllocateCallCount();
+    Uint64 largeAllocateCalls = large->getAllocateCallCount();
+    Uint32 smallFrameAllocations = smallAllocateCalls - lastSmallAllocateCalls_;
+    Uint64 largeFrameAllocations = largeAllocateCalls - lastLargeAllocateCalls_;
+    lastSmallAllocateCalls_ = smallAllocateCalls;
+    lastLargeAllocateCalls_ = largeAllocateCalls;
+
     // Create memory allocator window
     ImGui::SetNextWindowSize(ImVec2(900, 700), ImGuiCond_FirstUseEver);
     ImGui::SetNextWindowPos(ImVec2(100, 100), ImGuiCond_FirstUseEver);
@@ -1777,6 +1787,7 @@ void ImGuiManager::showMemoryAllocatorWindow(MemoryAllocator* smallAllocator, Me
             ImGui::Text("Used Memory: %zu bytes (%.2f KB)", usedMem, usedMem / 1024.0f);
             ImGui::Text("Free Memory: %zu bytes (%.2f KB)", freeMem, freeMem / 1024.0f);
             ImGui::Text("Active Allocations: %zu", allocCount);
+            ImGui::Text("Allocations Last Frame: %u", smallFrameAllocations);
 
             float usagePercent = totalMem > 0 ? (float)usedMem / totalMem * 100.0f : 0.0f;
             ImGui::ProgressBar(usedMem / (float)totalMem, ImVec2(-1, 0), nullptr);
@@ -1921,6 +1932,7 @@ void ImGuiManager::showMemoryAllocatorWindow(MemoryAllocator* smallAllocator, Me
             ImGui::Text("Total Memory: %zu bytes (%.2f MB)", totalMem, totalMem / (1024.0f * 1024.0f));
             ImGui::Text("Used Memory: %zu bytes (%.2f MB)", usedMem, usedMem / (1024.0f * 1024.0f));
             ImGui::Text("Free Memory: %zu bytes (%.2f MB)", freeMem, freeMem / (1024.0f * 1024.0f));
+            ImGui::Text("Allocations Last Frame: %zu", largeFrameAllocations);
 
             float usagePercent = totalMem > 0 ? (float)usedMem / totalMem * 100.0f : 0.0f;
             ImGui::ProgressBar(usedMem / (float)totalMem, ImVec2(-1, 0), nullptr);
@@ -2055,6 +2067,32 @@ void ImGuiManager::showMemoryAllocatorWindow(MemoryAllocator* smallAllocator, Me
             ImGui::EndTabItem();
         }
 
+        // Decompressed pak resource cache tab
+        if (pakResource && ImGui::BeginTabItem("Resource Cache")) {
+            ResourceCacheStats stats = pakResource->getCacheStats();
+
+            ImGui::Text("Cached: %u resources, %.2f MB", stats.cachedCount, stats.cachedBytes / (1024.0f * 1024.0f));
+            if (stats.budgetBytes > 0) {
+                ImGui::Text("Budget: %.2f MB", stats.budgetBytes / (1024.0f * 1024.0f));
+                ImGui::ProgressBar(stats.cachedBytes / (float)stats.budgetBytes, ImVec2(-1, 0), nullptr);
+            } else {
+                ImGui::Text("Budget: unlimited");
+            }
+            ImGui::Text("Pinned: %u", stats.pinnedCount);
+
+            ImGui::Spacing();
+            ImGui::Separator();
+
+            Uint64 lookups = stats.hits + stats.misses;
+            float hitRate = lookups > 0 ? (float)stats.hits / lookups * 100.0f : 0.0f;
+            ImGui::Text("Hits: %llu", (unsigned long long)stats.hits);
+            ImGui::Text("Misses (decompressions): %llu", (unsigned long long)stats.misses);
+            ImGui::Text("Hit rate: %.1f%%", hitRate);
+            ImGui::Text("Evictions: %llu (%.2f MB)", (unsigned long long)stats.evictions, stats.evictedBytes / (1024.0f * 1024.0f));
+
+            ImGui::EndTabItem();
+        }
+
         // Allocation Summary Tab
         if (ImGui::BeginTabItem("Allocation Summary")) {
             // Calculate and display total allocated memory
@@ -125,7 +125,7 @@ public:
     void showConsoleWindow();
 
     // Show memory allocator window
-    void showMemoryAllocatorWindow(MemoryAllocator* smallAllocator, MemoryAllocator* largeAllocator, float currentTime);
+    void showMemoryAllocatorWindow(MemoryAllocator* smallAllocator, MemoryAllocator* largeAllocator, PakResource* pakResource, float currentTime);
 
     // Show thread profiler window
     void showThreadProfilerWindow();
@@ -168,6 +168,10 @@ private:
     // Trig lookup table for fast sin/cos calculations
     TrigLookup* trigLookup_;
 
+    // Allocator call counts at the previous showMemoryAllocatorWindow(), which runs once a frame
+    Uint32 lastSmallAllocateCalls_;
+    Uint64 lastLargeAllocateCalls_;
+
     // Initialize particle editor state with defaults
     void initializeParticleEditorDefaults();
 
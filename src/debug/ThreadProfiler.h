@@ -136,7 +136,12 @@ public:
     }
 
     // Update thread state (call from within the thread)
-    void updateThreadState(ThreadState newState) {
+    // Returns the state the thread was in, so a short wait can restore it
+    ThreadState updateThreadState(ThreadState newState) {
+        if (allocator_ == nullptr) {
+            return newState;
+        }
+
         SDL_ThreadID threadId = SDL_GetCurrentThreadID();
         Uint64 currentTime = SDL_GetTicksNS();
 
@@ -145,15 +150,16 @@ public:
         SDL_UnlockMutex(globalMutex_);
 
         if (statsPtr == nullptr || *statsPtr == nullptr) {
-            return; // Thread not registered
+            return newState; // Thread not registered
         }
 
         ThreadStats* stats = *statsPtr;
         SDL_LockMutex(stats->statsMutex);
 
-        if (stats->currentState == newState) {
+        ThreadState previousState = stats->currentState;
+        if (previousState == newState) {
             SDL_UnlockMutex(stats->statsMutex);
-            return;
+            return previousState;
         }
 
         // Accumulate time in previous state
@@ -165,6 +171,7 @@ public:
         stats->stateStartTime = currentTime;
 
         SDL_UnlockMutex(stats->statsMutex);
+        return previousState;
     }
 
     // Call once per frame to finalize frame data
@@ -249,3 +256,16 @@ private:
     SDL_Mutex* globalMutex_;
     Uint64 frameNumber_;
 };
+
+// Lock a mutex, counting the thread as waiting for as long as another thread
+// holds it. For hot locks such as the allocators', whose contention would
+// otherwise show up as busy time.
+inline void lockMutexProfiled(SDL_Mutex* mutex) {
+    if (SDL_TryLockMutex(mutex)) {
+        return;
+    }
+    ThreadProfiler& profiler = ThreadProfiler::instance();
+    ThreadState previousState = profiler.updateThreadState(THREAD_STATE_WAITING);
+    SDL_LockMutex(mutex);
+    profiler.updateThreadState(previousState);
+}
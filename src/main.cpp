@@ -13,6 +13,7 @@
 #include "scene/LuaInterface.h"
 #include "memory/SmallMemoryAllocator.h"
 #include "memory/LargeMemoryAllocator.h"
+#include "memory/FrameArena.h"
 #include "physics/Box2DPhysics.h"
 #include "scene/SceneLayer.h"
 #include "audio/AudioManager.h"
@@ -30,6 +31,7 @@
 
 #define LUA_SCRIPT_ID 16891582414721442785ULL
 #define PAK_FILE "res.pak"
+#define PAK_OVERLAY_FILE "res_overlay.pak"
 
 // Convert screen coordinates to world coordinates
 // World coordinates are -aspect to aspect in x, -1 to 1 in y (aspect = width/height)
@@ -87,6 +89,49 @@ static float calculateTouchDistance(const TrackedFinger& a, const TrackedFinger&
     return SDL_sqrtf(dx * dx + dy * dy);
 }
 
+// Resident set size of this process in KB, read from /proc/self/statm (in 4 KB pages).
+// Returns 0 on platforms without procfs.
+static Uint64 getResidentSetKB()
+{
+    SDL_IOStream *statm = SDL_IOFromFile("/proc/self/statm", "r");
+    if (!statm)
+    {
+        return 0;
+    }
+    char buffer[128];
+    size_t bytesRead = SDL_ReadIO(statm, buffer, sizeof(buffer) - 1);
+    SDL_CloseIO(statm);
+    buffer[bytesRead] = '\0';
+
+    // Fields: size resident shared text lib data dt
+    char *cursor = buffer;
+    SDL_strtoull(cursor, &cursor, 10);
+    Uint64 residentPages = SDL_strtoull(cursor, nullptr, 10);
+    return residentPages * 4;
+}
+
+// Resource ticket callback that pushes the default scene once its script has loaded
+struct InitialSceneLoad
+{
+    SceneManager *sceneManager;
+    ConsoleBuffer *consoleBuffer;
+    bool pending;
+};
+
+static void onInitialSceneLoaded(bool loaded, void *userData)
+{
+    InitialSceneLoad *initialScene = static_cast<InitialSceneLoad *>(userData);
+    initialScene->pending = false;
+    if (!loaded)
+    {
+        // With no scene on the stack the main loop ends on its next iteration
+        initialScene->consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Failed to load initial scene script %llu",
+                                         (unsigned long long)LUA_SCRIPT_ID);
+        return;
+    }
+    initialScene->sceneManager->pushScene(LUA_SCRIPT_ID);
+}
+
 #ifdef HAS_IMGUI
 // Structure to pass data to the hot-reload thread
 struct HotReloadData
@@ -142,7 +187,7 @@ static int hotReloadThread(void *data)
         // Use SDL_Log directly to avoid console buffer from background thread
         SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Hot-reloading resources in background thread...");
 
-        // Rebuild shaders and pak file using make
+        // Rebuild shaders, then pack what changed since res.pak into an overlay pak
         int result = -1;
         const char *shadersArgs[] = {"make", "shaders", nullptr};
         SDL_Process *shadersProc = SDL_CreateProcess(shadersArgs, false);
@@ -153,7 +198,7 @@ static int hotReloadThread(void *data)
             SDL_DestroyProcess(shadersProc);
             if (exitCode == 0)
             {
-                const char *pakArgs[] = {"make", "res_pak", nullptr};
+                const char *pakArgs[] = {"make", "res_pak_overlay", nullptr};
                 SDL_Process *pakProc = SDL_CreateProcess(pakArgs, false);
                 if (pakProc)
                 {
@@ -223,6 +268,8 @@ static void customLogOutput(void* userdata, int category, SDL_LogPriority priori
 
 extern "C" int app_main()
 {
+    Uint64 startupStartNS = SDL_GetTicksNS();
+
     // Set custom log output function before SDL_Init so init-time messages are captured.
     // SDL_SetLogOutputFunction only stores a pointer and does not touch the properties
     // system, so it is safe to call before SDL_Init.
@@ -324,24 +371,27 @@ extern "C" int app_main()
     PakResource *pakResource = static_cast<PakResource *>(
         smallAllocator->allocate(sizeof(PakResource), "main::PakResource"));
     assert(pakResource != nullptr);
-    new (pakResource) PakResource(largeAllocator, consoleBuffer);
-    if (!pakResource->load(PAK_FILE))
+    new (pakResource) PakResource(largeAllocator, consoleBuffer, config.resourceWorkers);
+    pakResource->setCacheBudget((Uint64)config.resourceCacheMB * 1024 * 1024);
+    Uint64 pakLoadStartNS = SDL_GetTicksNS();
+    if (!pakResource->load(PAK_FILE, config.pakMmap ? PAK_LOAD_MODE_MMAP : PAK_LOAD_MODE_READ))
     {
         consoleBuffer->log(SDL_LOG_PRIORITY_CRITICAL, "Failed to load resource pak: %s", PAK_FILE);
         assert(false);
     }
+    Uint64 pakLoadNS = SDL_GetTicksNS() - pakLoadStartNS;
+    const char *pakLoadModeName = pakResource->isMapped() ? "mmap" : "read";
+    consoleBuffer->log(SDL_LOG_PRIORITY_INFO, "Loaded %s (%s) in %.2f ms, RSS %llu KB",
+                       PAK_FILE, pakLoadModeName, pakLoadNS / 1000000.0, (unsigned long long)getResidentSetKB());
 
     consoleBuffer->log(SDL_LOG_PRIORITY_DEBUG, "Preloading all pak resources asynchronously...");
     pakResource->preloadAllResourcesAsync();
 
     // Ensure trig table is available for engine bootstrap while remaining resources keep streaming
     Uint64 trigTableId = hashCString("res/trig_table.bin");
-    pakResource->requestResourceAsync(trigTableId);
-    while (!pakResource->isResourceReady(trigTableId))
-    {
-        ThreadProfiler::instance().updateThreadState(THREAD_STATE_IDLE);
-        SDL_Delay(1);
-    }
+    ResourceTicket trigTableTicket = pakResource->requestResourceTicket(&trigTableId, 1);
+    ThreadProfiler::instance().updateThreadState(THREAD_STATE_IDLE);
+    pakResource->waitForResourceTicket(trigTableTicket);
     ThreadProfiler::instance().updateThreadState(THREAD_STATE_BUSY);
 
     // Load trig lookup table
@@ -374,7 +424,7 @@ extern "C" int app_main()
     AudioManager *audioManager = static_cast<AudioManager *>(
         largeAllocator->allocate(sizeof(AudioManager), "main::AudioManager"));
     assert(audioManager != nullptr);
-    new (audioManager) AudioManager(smallAllocator, consoleBuffer);
+    new (audioManager) AudioManager(smallAllocator, consoleBuffer, pakResource);
     *consoleBuffer << SDL_LOG_PRIORITY_VERBOSE << "Created AudioManager" << ConsoleBuffer::endl;
 
     // Allocate ParticleSystemManager
@@ -391,17 +441,24 @@ extern "C" int app_main()
     new (waterEffectManager) WaterEffectManager();
     *consoleBuffer << SDL_LOG_PRIORITY_VERBOSE << "Created WaterEffectManager" << ConsoleBuffer::endl;
 
+    // Scratch arena for the main thread's per-frame temporaries, reset at the end of every frame
+    FrameArena *frameArena = static_cast<FrameArena *>(
+        smallAllocator->allocate(sizeof(FrameArena), "main::FrameArena"));
+    assert(frameArena != nullptr);
+    new (frameArena) FrameArena(largeAllocator, 256 * 1024, "main::FrameArena::memory");
+
     // Allocate VulkanRenderer
     VulkanRenderer *renderer = static_cast<VulkanRenderer *>(
         smallAllocator->allocate(sizeof(VulkanRenderer), "main::VulkanRenderer"));
     assert(renderer != nullptr);
-    new (renderer) VulkanRenderer(smallAllocator, largeAllocator, consoleBuffer);
+    new (renderer) VulkanRenderer(smallAllocator, largeAllocator, frameArena, consoleBuffer);
     *consoleBuffer << SDL_LOG_PRIORITY_VERBOSE << "Created VulkanRenderer" << ConsoleBuffer::endl;
 
     renderer->initialize(window, config.gpuIndex, config.presentMode);
 
     // Update config with the selected GPU index
     config.gpuIndex = renderer->getSelectedGpuIndex();
+    renderer->setTextureMipSkip((Uint32)SDL_max(0, config.textureMipSkip));
 
     // Allocate VibrationManager
     VibrationManager *vibrationManager = static_cast<VibrationManager *>(
@@ -414,7 +471,7 @@ extern "C" int app_main()
     AnimationEngine *animationEngine = static_cast<AnimationEngine *>(
         smallAllocator->allocate(sizeof(AnimationEngine), "main::AnimationEngine"));
     assert(animationEngine != nullptr);
-    new (animationEngine) AnimationEngine(smallAllocator, layerManager, consoleBuffer, renderer);
+    new (animationEngine) AnimationEngine(smallAllocator, frameArena, layerManager, consoleBuffer, renderer);
     *consoleBuffer << SDL_LOG_PRIORITY_VERBOSE << "Created AnimationEngine" << ConsoleBuffer::endl;
 
     // Create LuaInterface without SceneManager (will be set after SceneManager is created)
@@ -430,7 +487,7 @@ extern "C" int app_main()
     SceneManager *sceneManager = static_cast<SceneManager *>(
         smallAllocator->allocate(sizeof(SceneManager), "main::SceneManager"));
     assert(sceneManager != nullptr);
-    new (sceneManager) SceneManager(smallAllocator, *pakResource, *renderer, physics, layerManager,
+    new (sceneManager) SceneManager(smallAllocator, largeAllocator, frameArena, *pakResource, *renderer, physics, layerManager,
                                     audioManager, particleManager, waterEffectManager, luaInterface, consoleBuffer, trigLookup, animationEngine);
 
     // Set SceneManager pointer in LuaInterface after SceneManager is created
@@ -481,9 +538,12 @@ extern "C" int app_main()
         SDL_free(joysticks);
     }
 
-    // Initial scene is deferred until all resources finish async preload
-    bool initialScenePending = true;
+    // Initial scene is pushed from a ticket callback once its script has loaded
+    Uint64 initialSceneId = LUA_SCRIPT_ID;
+    InitialSceneLoad initialScene = {sceneManager, consoleBuffer, true};
+    pakResource->requestResourceTicket(&initialSceneId, 1, RESOURCE_PRIORITY_IMMEDIATE, onInitialSceneLoaded, &initialScene);
     bool preloadCompleteLogged = false;
+    bool firstFrameLogged = false;
 
 #ifdef HAS_IMGUI
     bool pendingHotReloadSceneApply = false;
@@ -899,17 +959,19 @@ extern "C" int app_main()
             }
         }
 
+        // Unpinned data taken from the pak last frame may be freed from here on
+        pakResource->trimCache();
+
         if (!preloadCompleteLogged && pakResource->areAllResourcesReady())
         {
-            consoleBuffer->log(SDL_LOG_PRIORITY_DEBUG, "Pak resource preload complete");
+            consoleBuffer->log(SDL_LOG_PRIORITY_INFO, "Pak resource preload complete (%s) at %.2f ms, RSS %llu KB",
+                               pakLoadModeName, (SDL_GetTicksNS() - startupStartNS) / 1000000.0,
+                               (unsigned long long)getResidentSetKB());
             preloadCompleteLogged = true;
         }
 
-        if (initialScenePending && pakResource->isResourceReady(LUA_SCRIPT_ID))
-        {
-            sceneManager->pushScene(LUA_SCRIPT_ID);
-            initialScenePending = false;
-        }
+        // Fires ticket callbacks, e.g. pushing the initial scene
+        pakResource->dispatchResourceTickets();
 
 #ifdef HAS_IMGUI
         if (pendingHotReloadSceneApply && pakResource->areAllResourcesReady())
@@ -955,7 +1017,7 @@ extern "C" int app_main()
                                         sceneManager->getCameraOffsetY(),
                                         sceneManager->getCameraZoom());
 
-        bool waitingForResources = initialScenePending;
+        bool waitingForResources = initialScene.pending;
     #ifdef HAS_IMGUI
         waitingForResources = waitingForResources || pendingHotReloadSceneApply;
     #endif
@@ -972,8 +1034,20 @@ extern "C" int app_main()
             if (SDL_GetAtomicInt(&reloadData.reloadSuccess) == 1)
             {
                 *consoleBuffer << SDL_LOG_PRIORITY_INFO << "Hot-reload complete, applying changes..." << ConsoleBuffer::endl;
-                // Reload pak
-                pakResource->reload(PAK_FILE);
+                // Mount the overlay so only changed resources are reloaded. It is
+                // stamped against res.pak on disk, so if that was rebuilt since it
+                // was loaded, reload it and mount the overlay on top.
+                if (!pakResource->mountOverlay(PAK_OVERLAY_FILE))
+                {
+                    pakResource->reload(PAK_FILE);
+                    if (!pakResource->mountOverlay(PAK_OVERLAY_FILE))
+                    {
+                        *consoleBuffer << SDL_LOG_PRIORITY_ERROR
+                                       << "Overlay pak does not match " PAK_FILE ", changes not applied; run make res_pak"
+                                       << ConsoleBuffer::endl;
+                    }
+                }
+                // Everything still cached is ready, so this queues just the invalidated resources
                 pakResource->preloadAllResourcesAsync();
                 pendingHotReloadSceneApply = true;
             }
@@ -996,7 +1070,7 @@ extern "C" int app_main()
         imguiManager->showConsoleWindow();
 
         // Show memory allocator window
-        imguiManager->showMemoryAllocatorWindow(smallAllocator, largeAllocator, currentTime);
+        imguiManager->showMemoryAllocatorWindow(smallAllocator, largeAllocator, pakResource, currentTime);
 
         // Show thread profiler window
         imguiManager->showThreadProfilerWindow();
@@ -1039,6 +1113,15 @@ extern "C" int app_main()
             renderer->render(currentTime);
         }
 
+        // Startup benchmark: switch [Resources] pak_mmap in config.ini to compare load modes
+        if (!firstFrameLogged && !initialScene.pending && !isInBackground)
+        {
+            consoleBuffer->log(SDL_LOG_PRIORITY_INFO, "Time to first frame (%s): %.2f ms, RSS %llu KB",
+                               pakLoadModeName, (SDL_GetTicksNS() - startupStartNS) / 1000000.0,
+                               (unsigned long long)getResidentSetKB());
+            firstFrameLogged = true;
+        }
+
         // Recreate swapchain if render signalled VK_ERROR_OUT_OF_DATE_KHR
         if (!isInBackground && renderer->needsSwapchainRecreation())
         {
@@ -1048,6 +1131,9 @@ extern "C" int app_main()
 
         // End profiler frame (finalize statistics)
         ThreadProfiler::instance().endFrame();
+
+        // Per-frame temporaries are dead by now
+        frameArena->reset();
     }
 
     // Save current fullscreen state and display to config
@@ -1119,6 +1205,11 @@ extern "C" int app_main()
     smallAllocator->free(renderer);
     *consoleBuffer << SDL_LOG_PRIORITY_VERBOSE << "Destroyed VulkanRenderer" << ConsoleBuffer::endl;
 
+    // Destroy FrameArena
+    frameArena->~FrameArena();
+    smallAllocator->free(frameArena);
+    *consoleBuffer << SDL_LOG_PRIORITY_VERBOSE << "Destroyed FrameArena" << ConsoleBuffer::endl;
+
     // Destroy WaterEffectManager
     waterEffectManager->~WaterEffectManager();
     largeAllocator->free(waterEffectManager);
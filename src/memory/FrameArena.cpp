@@ -0,0 +1,88 @@
+#include "FrameArena.h"
+#include <cassert>
+
+FrameArena::FrameArena(MemoryAllocator* backingAllocator, Uint64 capacity, const char* allocationId)
+    : backingAllocator_(backingAllocator)
+    , allocationId_(allocationId)
+    , memory_(nullptr)
+    , capacity_(capacity)
+    , offset_(0)
+    , overflow_(nullptr)
+    , overflowBytes_(0)
+{
+    assert(backingAllocator_ != nullptr);
+    assert(capacity_ > 0);
+    memory_ = (char*)backingAllocator_->allocate(capacity_, allocationId_);
+    assert(memory_ != nullptr);
+}
+
+FrameArena::~FrameArena() {
+    reset();
+    backingAllocator_->free(memory_);
+}
+
+void* FrameArena::allocate(Uint64 size, const char* allocationId) {
+    assert(size > 0);
+    assert(allocationId != nullptr);
+
+    // Align the address rather than the offset, as the backing allocator
+    // may only guarantee 8 bytes
+    Uint64 base = (Uint64)(uintptr_t)memory_;
+    Uint64 start = ((base + offset_ + ALIGNMENT - 1) & ~(ALIGNMENT - 1)) - base;
+    if (start + size <= capacity_) {
+        offset_ = start + size;
+        return memory_ + start;
+    }
+
+    // Spill to the backing allocator until the next reset
+    OverflowBlock* block = (OverflowBlock*)backingAllocator_->allocate(sizeof(OverflowBlock) + size, allocationId);
+    assert(block != nullptr);
+    block->next = overflow_;
+    overflow_ = block;
+    overflowBytes_ += size + ALIGNMENT;
+    return (char*)block + sizeof(OverflowBlock);
+}
+
+void FrameArena::free(void* ptr) {
+    (void)ptr;
+}
+
+Uint64 FrameArena::defragment() {
+    return 0;
+}
+
+void FrameArena::reset() {
+    while (overflow_) {
+        OverflowBlock* next = overflow_->next;
+        backingAllocator_->free(overflow_);
+        overflow_ = next;
+    }
+
+    // Grow so a frame like this one fits in the block next time
+    if (overflowBytes_ > 0) {
+        Uint64 needed = offset_ + overflowBytes_;
+        while (capacity_ < needed) {
+            capacity_ *= 2;
+        }
+        backingAllocator_->free(memory_);
+        memory_ = (char*)backingAllocator_->allocate(capacity_, allocationId_);
+        assert(memory_ != nullptr);
+    }
+
+    offset_ = 0;
+    overflowBytes_ = 0;
+}
+
+#ifdef DEBUG
+Uint64 FrameArena::getTotalMemory() const {
+    return capacity_ + overflowBytes_;
+}
+
+Uint64 FrameArena::getUsedMemory() const {
+    return offset_ + overflowBytes_;
+}
+
+Uint64 FrameArena::getFreeMemory() const {
+    return capacity_ - offset_;
+}
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "MemoryAllocator.h"
+#include <SDL3/SDL.h>
+
+// Bump-pointer scratch allocator for containers that live within one frame
+// - allocate() advances an offset into one block taken from the backing
+//   allocator; free() does nothing
+// - reset() releases everything at once at the owner's frame boundary
+// - A frame that outgrows the block spills into separate backing
+//   allocations, and the next reset() grows the block to cover it, so a
+//   steady frame makes no backing allocations at all
+// - Not thread-safe: each thread that needs scratch memory owns its arena
+// - No STL dependencies
+
+class FrameArena : public MemoryAllocator {
+public:
+    FrameArena(MemoryAllocator* backingAllocator, Uint64 capacity, const char* allocationId);
+    ~FrameArena() override;
+
+    void* allocate(Uint64 size, const char* allocationId) override;
+
+    // Memory is only reclaimed by reset()
+    void free(void* ptr) override;
+
+    // Nothing to compact; returns 0
+    Uint64 defragment() override;
+
+    // Release every allocation made since the last reset. Containers still
+    // holding arena memory must not be used afterwards.
+    void reset();
+
+#ifdef DEBUG
+    Uint64 getTotalMemory() const override;
+    Uint64 getUsedMemory() const override;
+    Uint64 getFreeMemory() const override;
+#endif
+
+private:
+    // Header of an allocation that did not fit in the block
+    struct alignas(16) OverflowBlock {
+        OverflowBlock* next;
+    };
+
+    static const Uint64 ALIGNMENT = 16;
+
+    MemoryAllocator* backingAllocator_;
+    const char* allocationId_;  // Id of the arena's own backing allocations
+    char* memory_;
+    Uint64 capacity_;
+    Uint64 offset_;
+    OverflowBlock* overflow_;
+    Uint64 overflowBytes_;      // Bytes spilled since the last reset
+};
@@ -1,5 +1,6 @@
 #include "LargeMemoryAllocator.h"
 #include "../debug/ConsoleBuffer.h"
+#include "../debug/ThreadProfiler.h"
 #include <cassert>
 
 static const Uint64 MIN_BLOCK_SIZE = 64;
@@ -12,14 +13,17 @@ static Uint64 alignSize(Uint64 size) {
 }
 
 LargeMemoryAllocator::LargeMemoryAllocator()
-    : m_chunks(nullptr), m_chunkSize(0), m_totalPoolSize(0), m_usedMemory(0), m_allocationCount(0), m_freeList(nullptr) {
+    : m_chunks(nullptr), m_emptyChunks(nullptr), m_chunkSize(0), m_totalPoolSize(0), m_usedMemory(0), m_allocationCount(0), m_flBitmap(0) {
     m_mutex = SDL_CreateMutex();
     assert(m_mutex != nullptr);
+    SDL_memset(m_freeLists, 0, sizeof(m_freeLists));
+    SDL_memset(m_slBitmap, 0, sizeof(m_slBitmap));
 #ifdef DEBUG
     historyIndex_ = 0;
     historyCount_ = 0;
     lastSampleTime_ = 0.0f;
     SDL_memset(usageHistory_, 0, sizeof(usageHistory_));
+    allocateCalls_ = 0;
 #endif
     m_chunkSize = alignSize(DEFAULT_CHUNK_SIZE);
     addChunk(m_chunkSize);
@@ -29,20 +33,13 @@ LargeMemoryAllocator::~LargeMemoryAllocator() {
     if (m_allocationCount > 0) {
         MemoryChunk* chunk = m_chunks;
         while (chunk) {
-            BlockHeader* current = (BlockHeader*)chunk->memory;
-            char* chunkEnd = chunk->memory + chunk->size;
-
-            while ((char*)current < chunkEnd) {
+            BlockHeader* current = chunk->firstBlock;
+            while (current) {
                 if (!current->isFree) {
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Leaked block: size=%zu, allocationId=%s",
                                     current->size, current->allocationId ? current->allocationId : "unknown");
                 }
-
-                BlockHeader* next = (BlockHeader*)((char*)current + sizeof(BlockHeader) + current->size);
-                if ((char*)next >= chunkEnd) {
-                    break;
-                }
-                current = next;
+                current = nextPhysical(current);
             }
             chunk = chunk->next;
         }
@@ -90,34 +87,40 @@ void LargeMemoryAllocator::addChunk(Uint64 size) {
 
     newChunk->size = chunkSize;
     newChunk->next = m_chunks;
+    newChunk->prev = nullptr;
+    if (m_chunks) {
+        m_chunks->prev = newChunk;
+    }
     m_chunks = newChunk;
     m_totalPoolSize += chunkSize;
+    newChunk->isEmpty = false;
+    setChunkEmpty(newChunk, true);
 
     BlockHeader* block = (BlockHeader*)newChunk->memory;
     block->size = chunkSize - sizeof(BlockHeader);
     block->isFree = true;
-    block->next = m_freeList;
-    block->prev = nullptr;
+    block->prevPhysical = nullptr;
     block->chunk = newChunk;
     block->allocationId = nullptr;
-
-    if (m_freeList) {
-        m_freeList->prev = block;
-    }
-    m_freeList = block;
     newChunk->firstBlock = block;
+    insertFreeBlock(block);
 }
 
 void* LargeMemoryAllocator::allocate(Uint64 size, const char* allocationId) {
-    SDL_LockMutex(m_mutex);
+    lockMutexProfiled(m_mutex);
 
     assert(size > 0);
     assert(allocationId != nullptr);
+#ifdef DEBUG
+    allocateCalls_++;
+#endif
     Uint64 alignedSize = alignSize(size);
 
     BlockHeader* block = findFreeBlock(alignedSize);
     if (!block) {
-        Uint64 newChunkSize = alignedSize + sizeof(BlockHeader);
+        // findFreeBlock only takes blocks from lists whose every block fits,
+        // so the new chunk has to hold the size rounded up to its list
+        Uint64 newChunkSize = roundUpToList(alignedSize) + sizeof(BlockHeader);
         if (newChunkSize < m_chunkSize) {
             newChunkSize = m_chunkSize;
         } else {
@@ -128,6 +131,10 @@ void* LargeMemoryAllocator::allocate(Uint64 size, const char* allocationId) {
         assert(block != nullptr);
     }
 
+    if (block->chunk->isEmpty) {
+        setChunkEmpty(block->chunk, false);
+    }
+
     if (block->size >= alignedSize + sizeof(BlockHeader) + MIN_BLOCK_SIZE) {
         splitBlock(block, alignedSize);
     }
@@ -137,16 +144,6 @@ void* LargeMemoryAllocator::allocate(Uint64 size, const char* allocationId) {
     m_usedMemory += block->size + sizeof(BlockHeader);
     m_allocationCount++;
 
-    if (m_freeList == block) {
-        m_freeList = block->next;
-    }
-    if (block->prev) {
-        block->prev->next = block->next;
-    }
-    if (block->next) {
-        block->next->prev = block->prev;
-    }
-
     void* ptr = (char*)block + sizeof(BlockHeader);
     SDL_UnlockMutex(m_mutex);
     return ptr;
@@ -155,7 +152,7 @@ void* LargeMemoryAllocator::allocate(Uint64 size, const char* allocationId) {
 void LargeMemoryAllocator::free(void* ptr) {
     assert(ptr != nullptr);
 
-    SDL_LockMutex(m_mutex);
+    lockMutexProfiled(m_mutex);
 
     BlockHeader* block = (BlockHeader*)((char*)ptr - sizeof(BlockHeader));
     assert(!block->isFree);
@@ -166,40 +163,22 @@ void LargeMemoryAllocator::free(void* ptr) {
     block->isFree = true;
     block->allocationId = nullptr;
 
-    // Set up temporary linkage for merge detection, but don't add to free list yet
-    block->next = nullptr;
-    block->prev = nullptr;
-
-    // Merge with adjacent blocks first - this may change which block we add to free list
+    // Merge with free neighbours, then list the result
     BlockHeader* finalBlock = mergeAdjacentBlocks(block);
+    insertFreeBlock(finalBlock);
 
-    // Always add the final block to the free list, removing it first if it's already there
-    // This handles the case where we merged with a block that was already in the free list
-    if (finalBlock != block) {
-        // We merged with a previous block - it should already be in the free list
-        // But let's verify and re-add to be safe
-        // First, try to remove it from the free list if it's there
-        if (finalBlock->prev) {
-            finalBlock->prev->next = finalBlock->next;
-        }
-        if (finalBlock->next) {
-            finalBlock->next->prev = finalBlock->prev;
-        }
-        if (m_freeList == finalBlock) {
-            m_freeList = finalBlock->next;
-        }
-    }
-
-    // Now add the final block to the front of the free list
-    finalBlock->next = m_freeList;
-    finalBlock->prev = nullptr;
-    if (m_freeList) {
-        m_freeList->prev = finalBlock;
+    // A block spanning its whole chunk means the chunk is empty
+    MemoryChunk* chunk = finalBlock->chunk;
+    if (finalBlock->size == chunk->size - sizeof(BlockHeader)) {
+        setChunkEmpty(chunk, true);
     }
-    m_freeList = finalBlock;
 
-    if (m_totalPoolSize > 0 && (float)m_usedMemory / m_totalPoolSize < SHRINK_THRESHOLD && m_totalPoolSize > m_chunkSize) {
-        removeEmptyChunks();
+    // Release empty chunks once usage drops well below the pool size,
+    // keeping at least one chunk to avoid constant allocation/deallocation
+    if ((float)m_usedMemory / m_totalPoolSize < SHRINK_THRESHOLD && m_totalPoolSize > m_chunkSize) {
+        while (m_emptyChunks && m_chunks->next) {
+            releaseChunk(m_emptyChunks);
+        }
     }
 
     SDL_UnlockMutex(m_mutex);
@@ -208,35 +187,20 @@ void LargeMemoryAllocator::free(void* ptr) {
 Uint64 LargeMemoryAllocator::defragment() {
     SDL_LockMutex(m_mutex);
 
+    // free() merges neighbours as it goes, so this only catches pairs left
+    // behind if that ever changes
     Uint64 mergedBlocks = 0;
     MemoryChunk* chunk = m_chunks;
     while (chunk) {
-        BlockHeader* current = (BlockHeader*)chunk->memory;
-        char* chunkEnd = chunk->memory + chunk->size;
-
-        while ((char*)current < chunkEnd) {
-            if (current->isFree) {
-                BlockHeader* next = (BlockHeader*)((char*)current + sizeof(BlockHeader) + current->size);
-                if ((char*)next < chunkEnd && next->isFree && next->chunk == chunk) {
-                    current->size += sizeof(BlockHeader) + next->size;
-
-                    if (next->prev) {
-                        next->prev->next = next->next;
-                    }
-                    if (next->next) {
-                        next->next->prev = next->prev;
-                    }
-                    if (m_freeList == next) {
-                        m_freeList = next->prev ? next->prev : next->next;
-                    }
-                    mergedBlocks++;
-                    continue;
-                }
-            }
-
-            BlockHeader* next = (BlockHeader*)((char*)current + sizeof(BlockHeader) + current->size);
-            if ((char*)next >= chunkEnd) {
-                break;
+        BlockHeader* current = chunk->firstBlock;
+        while (current) {
+            BlockHeader* next = nextPhysical(current);
+            if (current->isFree && next && next->isFree) {
+                removeFreeBlock(current);
+                current = mergeAdjacentBlocks(current);
+                insertFreeBlock(current);
+                mergedBlocks++;
+                continue;
             }
             current = next;
         }
@@ -247,60 +211,140 @@ Uint64 LargeMemoryAllocator::defragment() {
     return mergedBlocks;
 }
 
-void LargeMemoryAllocator::removeEmptyChunks() {
-    MemoryChunk** chunkPtr = &m_chunks;
-    while (*chunkPtr) {
-        MemoryChunk* chunk = *chunkPtr;
-        BlockHeader* block = (BlockHeader*)chunk->memory;
-
-        // Remove chunk if it's completely free
-        // Keep at least one chunk to avoid constant allocation/deallocation
-        bool isEmpty = (block->isFree &&
-                       block->size == chunk->size - sizeof(BlockHeader));
+void LargeMemoryAllocator::releaseChunk(MemoryChunk* chunk) {
+    assert(chunk->isEmpty);
+    removeFreeBlock(chunk->firstBlock);
+    setChunkEmpty(chunk, false);
 
-        // Only remove if not the last chunk
-        bool isLastChunk = (m_chunks == chunk && chunk->next == nullptr);
+    if (chunk->prev) {
+        chunk->prev->next = chunk->next;
+    } else {
+        m_chunks = chunk->next;
+    }
+    if (chunk->next) {
+        chunk->next->prev = chunk->prev;
+    }
 
-        if (isEmpty && !isLastChunk) {
-            if (block->prev) {
-                block->prev->next = block->next;
-            }
-            if (block->next) {
-                block->next->prev = block->prev;
-            }
-            if (m_freeList == block) {
-                m_freeList = block->next;
-            }
+    m_totalPoolSize -= chunk->size;
+    SDL_free(chunk->memory);
+    SDL_free(chunk);
+}
 
-            *chunkPtr = chunk->next;
-            m_totalPoolSize -= chunk->size;
-            SDL_free(chunk->memory);
-            SDL_free(chunk);
+void LargeMemoryAllocator::setChunkEmpty(MemoryChunk* chunk, bool isEmpty) {
+    assert(chunk->isEmpty != isEmpty);
+    chunk->isEmpty = isEmpty;
+    if (isEmpty) {
+        chunk->prevEmpty = nullptr;
+        chunk->nextEmpty = m_emptyChunks;
+        if (m_emptyChunks) {
+            m_emptyChunks->prevEmpty = chunk;
+        }
+        m_emptyChunks = chunk;
+    } else {
+        if (chunk->prevEmpty) {
+            chunk->prevEmpty->nextEmpty = chunk->nextEmpty;
         } else {
-            chunkPtr = &chunk->next;
+            m_emptyChunks = chunk->nextEmpty;
+        }
+        if (chunk->nextEmpty) {
+            chunk->nextEmpty->prevEmpty = chunk->prevEmpty;
         }
     }
 }
 
-LargeMemoryAllocator::BlockHeader* LargeMemoryAllocator::findFreeBlock(Uint64 size) {
-    BlockHeader* bestFit = nullptr;
-    Uint64 bestFitSize = SIZE_MAX;
-
-    BlockHeader* current = m_freeList;
-    while (current) {
-        if (current->isFree && current->size >= size) {
-            if (current->size < bestFitSize) {
-                bestFit = current;
-                bestFitSize = current->size;
-                if (bestFitSize == size) {
-                    break;
-                }
+void LargeMemoryAllocator::mappingInsert(Uint64 size, Uint32* fl, Uint32* sl) {
+    if (size < SMALL_BLOCK_SIZE) {
+        *fl = 0;
+        *sl = (Uint32)(size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+    } else {
+        Uint32 log2Size = 63 - __builtin_clzll(size);
+        assert(log2Size < FL_INDEX_MAX);
+        *fl = log2Size - (FL_INDEX_SHIFT - 1);
+        *sl = (Uint32)(size >> (log2Size - SL_INDEX_LOG2)) ^ SL_INDEX_COUNT;
+    }
+}
+
+Uint64 LargeMemoryAllocator::roundUpToList(Uint64 size) {
+    // Round up to the start of the next list, so any block in the list the
+    // result maps to is large enough
+    if (size >= SMALL_BLOCK_SIZE) {
+        Uint32 log2Size = 63 - __builtin_clzll(size);
+        Uint64 step = 1ull << (log2Size - SL_INDEX_LOG2);
+        size = (size + step - 1) & ~(step - 1);
+    }
+    return size;
+}
+
+void LargeMemoryAllocator::insertFreeBlock(BlockHeader* block) {
+    assert(block->isFree);
+    Uint32 fl, sl;
+    mappingInsert(block->size, &fl, &sl);
+
+    block->prev = nullptr;
+    block->next = m_freeLists[fl][sl];
+    if (block->next) {
+        block->next->prev = block;
+    }
+    m_freeLists[fl][sl] = block;
+    m_flBitmap |= 1ull << fl;
+    m_slBitmap[fl] |= 1u << sl;
+}
+
+void LargeMemoryAllocator::removeFreeBlock(BlockHeader* block) {
+    assert(block->isFree);
+    Uint32 fl, sl;
+    mappingInsert(block->size, &fl, &sl);
+
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        assert(m_freeLists[fl][sl] == block);
+        m_freeLists[fl][sl] = block->next;
+        if (!m_freeLists[fl][sl]) {
+            m_slBitmap[fl] &= ~(1u << sl);
+            if (!m_slBitmap[fl]) {
+                m_flBitmap &= ~(1ull << fl);
             }
         }
-        current = current->next;
     }
+    if (block->next) {
+        block->next->prev = block->prev;
+    }
+}
 
-    return bestFit;
+LargeMemoryAllocator::BlockHeader* LargeMemoryAllocator::nextPhysical(BlockHeader* block) const {
+    char* next = (char*)block + sizeof(BlockHeader) + block->size;
+    MemoryChunk* chunk = block->chunk;
+    return next < chunk->memory + chunk->size ? (BlockHeader*)next : nullptr;
+}
+
+LargeMemoryAllocator::BlockHeader* LargeMemoryAllocator::findFreeBlock(Uint64 size) {
+    Uint64 rounded = roundUpToList(size);
+    Uint32 log2Size = 63 - __builtin_clzll(rounded);
+    if (log2Size >= FL_INDEX_MAX) {
+        return nullptr;
+    }
+
+    Uint32 fl, sl;
+    mappingInsert(rounded, &fl, &sl);
+
+    // First non-empty list at or after (fl, sl): the rest of this first
+    // level, else the smallest list of the next non-empty first level
+    Uint32 slMap = m_slBitmap[fl] & (~0u << sl);
+    if (!slMap) {
+        Uint64 flMap = fl + 1 < FL_INDEX_COUNT ? m_flBitmap & (~0ull << (fl + 1)) : 0;
+        if (!flMap) {
+            return nullptr;
+        }
+        fl = __builtin_ctzll(flMap);
+        slMap = m_slBitmap[fl];
+    }
+    sl = __builtin_ctz(slMap);
+
+    BlockHeader* block = m_freeLists[fl][sl];
+    assert(block != nullptr && block->size >= size);
+    removeFreeBlock(block);
+    return block;
 }
 
 void LargeMemoryAllocator::splitBlock(BlockHeader* block, Uint64 size) {
@@ -312,66 +356,43 @@ void LargeMemoryAllocator::splitBlock(BlockHeader* block, Uint64 size) {
     newBlock->size = block->size - size - sizeof(BlockHeader);
     newBlock->isFree = true;
     newBlock->chunk = block->chunk;
-    newBlock->next = block->next;
-    newBlock->prev = block;
+    newBlock->prevPhysical = block;
     newBlock->allocationId = nullptr;
+    block->size = size;
 
-    if (block->next) {
-        block->next->prev = newBlock;
+    BlockHeader* after = nextPhysical(newBlock);
+    if (after) {
+        after->prevPhysical = newBlock;
     }
-    block->next = newBlock;
-    block->size = size;
+
+    // The block after was in use, as free neighbours are always merged
+    insertFreeBlock(newBlock);
 }
 
 LargeMemoryAllocator::BlockHeader* LargeMemoryAllocator::mergeAdjacentBlocks(BlockHeader* block) {
     assert(block != nullptr);
     assert(block->isFree);
 
-    MemoryChunk* chunk = block->chunk;
-    char* chunkEnd = chunk->memory + chunk->size;
-    BlockHeader* result = block;
-
-    // Merge with next block if it's free and adjacent
-    BlockHeader* next = (BlockHeader*)((char*)block + sizeof(BlockHeader) + block->size);
-    if ((char*)next < chunkEnd && next->isFree && next->chunk == chunk) {
+    // Absorb the next block if it's free
+    BlockHeader* next = nextPhysical(block);
+    if (next && next->isFree) {
+        removeFreeBlock(next);
         block->size += sizeof(BlockHeader) + next->size;
-
-        // Remove next block from free list
-        if (next->prev) {
-            next->prev->next = next->next;
-        }
-        if (next->next) {
-            next->next->prev = next->prev;
-        }
-        if (m_freeList == next) {
-            m_freeList = next->next;
-        }
     }
 
-    // Merge with previous block if it's free and adjacent
-    // Only need to check if we're not at the start of the chunk
-    if ((char*)block > chunk->memory) {
-        BlockHeader* current = (BlockHeader*)chunk->memory;
-        while ((char*)current < (char*)block) {
-            BlockHeader* nextBlock = (BlockHeader*)((char*)current + sizeof(BlockHeader) + current->size);
-
-            // Found the block immediately before us
-            if (nextBlock == block && current->isFree && current->chunk == chunk) {
-                current->size += sizeof(BlockHeader) + block->size;
-                // Return the previous block as the result since it absorbed our block
-                result = current;
-                break;
-            }
-
-            // Move to next block - add bounds check to prevent infinite loop
-            if ((char*)nextBlock >= chunkEnd || (char*)nextBlock <= (char*)current) {
-                break;
-            }
-            current = nextBlock;
-        }
+    // Let the previous block absorb this one if it's free
+    BlockHeader* prev = block->prevPhysical;
+    if (prev && prev->isFree) {
+        removeFreeBlock(prev);
+        prev->size += sizeof(BlockHeader) + block->size;
+        block = prev;
     }
 
-    return result;
+    BlockHeader* after = nextPhysical(block);
+    if (after) {
+        after->prevPhysical = block;
+    }
+    return block;
 }
 
 LargeMemoryAllocator::MemoryChunk* LargeMemoryAllocator::findChunkForPointer(void* ptr) const {
@@ -407,6 +428,13 @@ Uint64 LargeMemoryAllocator::getFreeMemory() const {
     return result;
 }
 
+Uint64 LargeMemoryAllocator::getAllocateCallCount() const {
+    SDL_LockMutex(m_mutex);
+    Uint64 result = allocateCalls_;
+    SDL_UnlockMutex(m_mutex);
+    return result;
+}
+
 LargeMemoryAllocator::ChunkInfo* LargeMemoryAllocator::getChunkInfo(Uint64* outChunkCount) const {
     SDL_LockMutex(m_mutex);
 
@@ -3,6 +3,14 @@
 #include "MemoryAllocator.h"
 #include <SDL3/SDL.h>
 
+// Large memory allocator for resource-sized buffers
+// - Two-level segregated fit (TLSF): free blocks are binned by power of two
+//   and then by one of SL_INDEX_COUNT linear steps within it, with a bitmap
+//   per level, so allocate and free take a bounded number of steps however
+//   fragmented the chunks are
+// - Freed blocks merge with their physical neighbours immediately
+// - Grows by chunks and releases empty ones when usage drops
+
 class LargeMemoryAllocator : public MemoryAllocator {
 public:
     LargeMemoryAllocator();
@@ -16,6 +24,8 @@ public:
     Uint64 getTotalMemory() const override;
     Uint64 getUsedMemory() const override;
     Uint64 getFreeMemory() const override;
+    // Every allocate() call so far
+    Uint64 getAllocateCallCount() const;
 
     // Debug visualization helpers
     struct ChunkInfo;
@@ -63,8 +73,9 @@ private:
     struct alignas(16) BlockHeader {
         Uint64 size;
         bool isFree;
-        BlockHeader* next;
-        BlockHeader* prev;
+        BlockHeader* next;          // Next free block in the same list (free blocks only)
+        BlockHeader* prev;          // Previous free block in the same list (free blocks only)
+        BlockHeader* prevPhysical;  // Block before this one in the chunk, nullptr for the first
         MemoryChunk* chunk;
         const char* allocationId;
     };
@@ -73,15 +84,32 @@ private:
         char* memory;
         Uint64 size;
         MemoryChunk* next;
+        MemoryChunk* prev;
         BlockHeader* firstBlock;
+        bool isEmpty;            // No allocations; linked into m_emptyChunks
+        MemoryChunk* nextEmpty;
+        MemoryChunk* prevEmpty;
     };
 
+    // Free list index: first level is the power of two of the size, second
+    // level splits it into SL_INDEX_COUNT equal ranges. Sizes below
+    // SMALL_BLOCK_SIZE all share first level 0 in 16 byte steps.
+    static const Uint32 SL_INDEX_LOG2 = 4;
+    static const Uint32 SL_INDEX_COUNT = 1 << SL_INDEX_LOG2;
+    static const Uint32 FL_INDEX_SHIFT = SL_INDEX_LOG2 + 4;
+    static const Uint32 FL_INDEX_MAX = 40;
+    static const Uint32 FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+    static const Uint64 SMALL_BLOCK_SIZE = 1ull << FL_INDEX_SHIFT;
+
     MemoryChunk* m_chunks;
+    MemoryChunk* m_emptyChunks;
     Uint64 m_chunkSize;
     Uint64 m_totalPoolSize;
     Uint64 m_usedMemory;
     Uint64 m_allocationCount;
-    BlockHeader* m_freeList;
+    BlockHeader* m_freeLists[FL_INDEX_COUNT][SL_INDEX_COUNT];
+    Uint64 m_flBitmap;                   // Bit f set when any list in m_freeLists[f] is non-empty
+    Uint32 m_slBitmap[FL_INDEX_COUNT];   // Bit s of entry f set when m_freeLists[f][s] is non-empty
     SDL_Mutex* m_mutex;
 
 #ifdef DEBUG
@@ -94,10 +122,18 @@ private:
     float lastSampleTime_;
 
     static constexpr float SAMPLE_INTERVAL = 0.1f; // Sample every 100ms
+
+    Uint64 allocateCalls_;
 #endif
 
     void addChunk(Uint64 size);
-    void removeEmptyChunks();
+    void releaseChunk(MemoryChunk* chunk);
+    void setChunkEmpty(MemoryChunk* chunk, bool isEmpty);
+    static void mappingInsert(Uint64 size, Uint32* fl, Uint32* sl);
+    static Uint64 roundUpToList(Uint64 size);
+    void insertFreeBlock(BlockHeader* block);
+    void removeFreeBlock(BlockHeader* block);
+    BlockHeader* nextPhysical(BlockHeader* block) const;
     BlockHeader* findFreeBlock(Uint64 size);
     void splitBlock(BlockHeader* block, Uint64 size);
     BlockHeader* mergeAdjacentBlocks(BlockHeader* block);
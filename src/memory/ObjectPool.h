@@ -0,0 +1,329 @@
+#pragma once
+
+#include "MemoryAllocator.h"
+#include <SDL3/SDL_stdinc.h>
+#include <cassert>
+#include <cstddef>
+#include <new>
+
+// Fixed-size allocator for many objects of one type
+// - Slots hold a single T. Larger requests, such as the element buffers of a
+//   Vector or HashTable using the pool as its allocator, are forwarded to the
+//   fallback allocator given at construction; without one they assert
+// - Objects live in slab pages of OBJECTS_PER_PAGE slots taken from the
+//   backing allocator, so neighbours share cache lines
+// - Each page keeps an intrusive free list threaded through its free slots
+//   and pages with a free slot are linked, so create and destroy take
+//   constant time
+// - Iterating the pool walks live objects page by page, in memory order
+// - One empty page is kept for reuse; further empty pages go back to the
+//   backing allocator
+// - Unsynchronised, unlike SmallMemoryAllocator: create(), destroy() and
+//   iteration must all happen under one lock the owner holds, or on one thread
+// - No STL dependencies
+
+template<typename T>
+class ObjectPool : public MemoryAllocator {
+    static_assert(alignof(T) <= alignof(void*), "ObjectPool slots are only pointer-aligned");
+
+public:
+    static const Uint32 OBJECTS_PER_PAGE = 64;  // One liveMask bit per slot
+
+private:
+    struct Page;
+
+    struct Slot {
+        Page* page;
+        union {
+            Slot* nextFree;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+    };
+
+    struct Page {
+        Page* prev;                 // All pages
+        Page* next;
+        Page* prevPartial;          // Pages with at least one free slot
+        Page* nextPartial;
+        Slot* freeList;
+        Uint64 liveMask;            // Bit i set while slot i is handed out
+        Uint32 liveCount;
+        Slot slots[OBJECTS_PER_PAGE];
+    };
+
+public:
+    ObjectPool(MemoryAllocator& backingAllocator, const char* allocationId,
+               MemoryAllocator* fallbackAllocator = nullptr)
+        : backingAllocator_(&backingAllocator)
+        , fallbackAllocator_(fallbackAllocator)
+        , allocationId_(allocationId)
+        , pages_(nullptr)
+        , partialPages_(nullptr)
+        , pageCount_(0)
+        , emptyPageCount_(0)
+        , liveCount_(0) {
+        assert(allocationId_ != nullptr);
+    }
+
+    // Objects still alive are not destroyed
+    ~ObjectPool() override {
+        assert(liveCount_ == 0);
+        while (pages_) {
+            Page* next = pages_->next;
+            backingAllocator_->free(pages_);
+            pages_ = next;
+        }
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    template<typename... Args>
+    T* create(Args&&... args) {
+        void* memory = allocate(sizeof(T), allocationId_);
+        assert(memory != nullptr);
+        return new (memory) T(static_cast<Args&&>(args)...);
+    }
+
+    void destroy(T* object) {
+        assert(object != nullptr);
+        object->~T();
+        free(object);
+    }
+
+    // Hands out one uninitialized slot, or forwards requests larger than T
+    void* allocate(Uint64 size, const char* allocationId) override {
+        if (size > sizeof(T)) {
+            return allocateFallback(size, allocationId);
+        }
+
+        if (!partialPages_) {
+            addPage();
+        }
+        Page* page = partialPages_;
+        Slot* slot = page->freeList;
+        assert(slot != nullptr);
+        page->freeList = slot->nextFree;
+        if (page->liveCount == 0) {
+            emptyPageCount_--;
+        }
+        page->liveCount++;
+        page->liveMask |= (Uint64)1 << (slot - page->slots);
+        if (!page->freeList) {
+            unlinkPartial(page);
+        }
+        liveCount_++;
+        return slot->storage;
+    }
+
+    void free(void* ptr) override {
+        if (!ptr) {
+            return;
+        }
+        Slot* slot = reinterpret_cast<Slot*>(static_cast<unsigned char*>(ptr) - offsetof(Slot, storage));
+        Page* page = slot->page;
+        if (!page) {
+            freeFallback(ptr);
+            return;
+        }
+        Uint64 bit = (Uint64)1 << (slot - page->slots);
+        assert(page->liveMask & bit);
+
+        if (!page->freeList) {
+            linkPartial(page);
+        }
+        slot->nextFree = page->freeList;
+        page->freeList = slot;
+        page->liveMask &= ~bit;
+        page->liveCount--;
+        liveCount_--;
+        if (page->liveCount == 0 && ++emptyPageCount_ > 1) {
+            releasePage(page);
+        }
+    }
+
+    // Releases the spare empty page, if any
+    // Returns number of pages released
+    Uint64 defragment() override {
+        Uint64 released = 0;
+        Page* page = pages_;
+        while (page && emptyPageCount_ > 0) {
+            Page* next = page->next;
+            if (page->liveCount == 0) {
+                releasePage(page);
+                released++;
+            }
+            page = next;
+        }
+        return released;
+    }
+
+    Uint64 size() const {
+        return liveCount_;
+    }
+
+    bool empty() const {
+        return liveCount_ == 0;
+    }
+
+#ifdef DEBUG
+    Uint64 getTotalMemory() const override {
+        return pageCount_ * sizeof(Page);
+    }
+
+    Uint64 getUsedMemory() const override {
+        return liveCount_ * sizeof(T);
+    }
+
+    Uint64 getFreeMemory() const override {
+        return (pageCount_ * OBJECTS_PER_PAGE - liveCount_) * sizeof(T);
+    }
+#endif
+
+    // Visits every live object. Only meaningful when all slots were handed
+    // out by create(). Destroying objects while iterating is not allowed.
+    class Iterator {
+    public:
+        explicit Iterator(Page* page)
+            : page_(page)
+            , mask_(page ? page->liveMask : 0) {
+            skipEmptyPages();
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return page_ != other.page_ || mask_ != other.mask_;
+        }
+
+        Iterator& operator++() {
+            assert(mask_ != 0);
+            mask_ &= mask_ - 1;
+            skipEmptyPages();
+            return *this;
+        }
+
+        T& operator*() const {
+            assert(mask_ != 0);
+            return *reinterpret_cast<T*>(page_->slots[__builtin_ctzll(mask_)].storage);
+        }
+
+        T* operator->() const {
+            return &**this;
+        }
+
+    private:
+        void skipEmptyPages() {
+            while (page_ && mask_ == 0) {
+                page_ = page_->next;
+                mask_ = page_ ? page_->liveMask : 0;
+            }
+        }
+
+        Page* page_;
+        Uint64 mask_;
+    };
+
+    Iterator begin() {
+        return Iterator(pages_);
+    }
+
+    Iterator end() {
+        return Iterator(nullptr);
+    }
+
+private:
+    // Fallback blocks carry a null page pointer where a slot keeps its page,
+    // so free() tells them apart without searching the pages
+    static const Uint64 FALLBACK_HEADER_SIZE = alignof(std::max_align_t);
+    static_assert(offsetof(Slot, storage) == sizeof(Page*), "Slot page pointer must sit right before storage");
+
+    void* allocateFallback(Uint64 size, const char* allocationId) {
+        assert(fallbackAllocator_ != nullptr && "ObjectPool request larger than its object needs a fallback allocator");
+        if (!fallbackAllocator_) {
+            return nullptr;
+        }
+        unsigned char* block = static_cast<unsigned char*>(fallbackAllocator_->allocate(size + FALLBACK_HEADER_SIZE, allocationId));
+        if (!block) {
+            return nullptr;
+        }
+        unsigned char* ptr = block + FALLBACK_HEADER_SIZE;
+        *reinterpret_cast<Page**>(ptr - sizeof(Page*)) = nullptr;
+        return ptr;
+    }
+
+    void freeFallback(void* ptr) {
+        assert(fallbackAllocator_ != nullptr);
+        fallbackAllocator_->free(static_cast<unsigned char*>(ptr) - FALLBACK_HEADER_SIZE);
+    }
+
+    void addPage() {
+        Page* page = static_cast<Page*>(backingAllocator_->allocate(sizeof(Page), allocationId_));
+        assert(page != nullptr);
+        page->prev = nullptr;
+        page->next = pages_;
+        if (pages_) {
+            pages_->prev = page;
+        }
+        pages_ = page;
+
+        // Thread the free list in address order so a fresh page fills front to back
+        page->freeList = &page->slots[0];
+        for (Uint32 i = 0; i < OBJECTS_PER_PAGE; i++) {
+            page->slots[i].page = page;
+            page->slots[i].nextFree = i + 1 < OBJECTS_PER_PAGE ? &page->slots[i + 1] : nullptr;
+        }
+        page->liveMask = 0;
+        page->liveCount = 0;
+        page->prevPartial = nullptr;
+        page->nextPartial = nullptr;
+        linkPartial(page);
+        pageCount_++;
+        emptyPageCount_++;
+    }
+
+    void releasePage(Page* page) {
+        assert(page->liveCount == 0);
+        unlinkPartial(page);
+        if (page->prev) {
+            page->prev->next = page->next;
+        } else {
+            pages_ = page->next;
+        }
+        if (page->next) {
+            page->next->prev = page->prev;
+        }
+        pageCount_--;
+        emptyPageCount_--;
+        backingAllocator_->free(page);
+    }
+
+    void linkPartial(Page* page) {
+        page->prevPartial = nullptr;
+        page->nextPartial = partialPages_;
+        if (partialPages_) {
+            partialPages_->prevPartial = page;
+        }
+        partialPages_ = page;
+    }
+
+    void unlinkPartial(Page* page) {
+        if (page->prevPartial) {
+            page->prevPartial->nextPartial = page->nextPartial;
+        } else {
+            partialPages_ = page->nextPartial;
+        }
+        if (page->nextPartial) {
+            page->nextPartial->prevPartial = page->prevPartial;
+        }
+        page->prevPartial = nullptr;
+        page->nextPartial = nullptr;
+    }
+
+    MemoryAllocator* backingAllocator_;
+    MemoryAllocator* fallbackAllocator_;  // Optional, serves requests larger than T
+    const char* allocationId_;  // Id of the page allocations
+    Page* pages_;
+    Page* partialPages_;
+    Uint64 pageCount_;
+    Uint64 emptyPageCount_;
+    Uint64 liveCount_;
+};
@@ -1,21 +1,27 @@
 #include "SmallMemoryAllocator.h"
 #include "../debug/ConsoleBuffer.h"
+#include "../debug/ThreadProfiler.h"
 #include <cassert>
 #include <SDL3/SDL_log.h>
 
 SmallMemoryAllocator::SmallMemoryAllocator()
     : firstPool_(nullptr)
     , lastPool_(nullptr)
+    , binMask_(0)
+    , caches_(nullptr)
     , allocationCount_(0)
     , totalCapacity_(0)
 {
     mutex_ = SDL_CreateMutex();
     assert(mutex_ != nullptr);
+    SDL_memset(bins_, 0, sizeof(bins_));
+    SDL_SetAtomicInt(&cacheTls_, 0);
 #ifdef DEBUG
     historyIndex_ = 0;
     historyCount_ = 0;
     lastSampleTime_ = 0.0f;
     SDL_memset(usageHistory_, 0, sizeof(usageHistory_));
+    SDL_SetAtomicInt(&allocateCalls_, 0);
 #endif
     // Note: Cannot log here as ConsoleBuffer doesn't exist yet
     // Create initial pool
@@ -23,6 +29,15 @@ SmallMemoryAllocator::SmallMemoryAllocator()
 }
 
 SmallMemoryAllocator::~SmallMemoryAllocator() {
+    // Worker threads have exited and released their caches by now; return
+    // whatever is left, which is this thread's
+    SDL_LockMutex(mutex_);
+    while (caches_) {
+        releaseThreadCache(caches_);
+    }
+    SDL_UnlockMutex(mutex_);
+    SDL_SetTLS(&cacheTls_, nullptr, nullptr);
+
     // Count pools
     Uint64 poolCount = 0;
     MemoryPool* pool = firstPool_;
@@ -62,14 +77,68 @@ SmallMemoryAllocator::~SmallMemoryAllocator() {
 }
 
 void* SmallMemoryAllocator::allocate(Uint64 size, const char* allocationId) {
-    SDL_LockMutex(mutex_);
-
     assert(size > 0);
     assert(allocationId != nullptr);
+#ifdef DEBUG
+    SDL_AddAtomicInt(&allocateCalls_, 1);
+#endif
 
     // Align size to 8 bytes for better cache performance
     Uint64 alignedSize = (size + 7) & ~7;
+    if (alignedSize < MIN_BLOCK_SIZE) {
+        alignedSize = MIN_BLOCK_SIZE;
+    }
+
+    BlockHeader* block = nullptr;
+    ThreadCache* cache = alignedSize <= EXACT_BIN_LIMIT ? threadCache() : nullptr;
+    if (cache) {
+        Magazine& magazine = cache->magazines[binIndex(alignedSize)];
+        if (magazine.count == 0) {
+            lockMutexProfiled(mutex_);
+            while (magazine.count < MAGAZINE_BATCH) {
+                magazine.blocks[magazine.count++] = allocateBlock(alignedSize, "SmallMemoryAllocator::ThreadCache");
+            }
+            SDL_UnlockMutex(mutex_);
+        }
+        block = magazine.blocks[--magazine.count];
+        block->allocationId = allocationId;
+    } else {
+        lockMutexProfiled(mutex_);
+        block = allocateBlock(alignedSize, allocationId);
+        SDL_UnlockMutex(mutex_);
+    }
+
+    // Return pointer after header
+    return (char*)block + sizeof(BlockHeader);
+}
+
+void SmallMemoryAllocator::free(void* ptr) {
+    if (!ptr) return;
+
+    // Get block header
+    BlockHeader* block = (BlockHeader*)((char*)ptr - sizeof(BlockHeader));
+    assert(!block->isFree);
+    assert(block->pool != nullptr);
+
+    ThreadCache* cache = block->size <= EXACT_BIN_LIMIT ? threadCache() : nullptr;
+    if (cache) {
+        Magazine& magazine = cache->magazines[binIndex(block->size)];
+        if (magazine.count == MAGAZINE_SIZE) {
+            lockMutexProfiled(mutex_);
+            flushMagazine(magazine, MAGAZINE_BATCH);
+            SDL_UnlockMutex(mutex_);
+        }
+        block->allocationId = "SmallMemoryAllocator::ThreadCache";
+        magazine.blocks[magazine.count++] = block;
+        return;
+    }
 
+    lockMutexProfiled(mutex_);
+    freeBlock(block);
+    SDL_UnlockMutex(mutex_);
+}
+
+SmallMemoryAllocator::BlockHeader* SmallMemoryAllocator::allocateBlock(Uint64 alignedSize, const char* allocationId) {
     // Try to find a free block in existing pools
     BlockHeader* block = findFreeBlock(alignedSize);
 
@@ -91,7 +160,7 @@ void* SmallMemoryAllocator::allocate(Uint64 size, const char* allocationId) {
             }
         }
 
-        MemoryPool* newPool = createPool(newPoolSize);
+        createPool(newPoolSize);
 
         // Try again in the new pool
         block = findFreeBlock(alignedSize);
@@ -106,63 +175,104 @@ void* SmallMemoryAllocator::allocate(Uint64 size, const char* allocationId) {
 
     // Split block if it's much larger than needed
     splitBlock(block, alignedSize);
-
-    // Return pointer after header
-    void* ptr = (char*)block + sizeof(BlockHeader);
-    SDL_UnlockMutex(mutex_);
-    return ptr;
+    return block;
 }
 
-void SmallMemoryAllocator::free(void* ptr) {
-    if (!ptr) return;
-
-    SDL_LockMutex(mutex_);
-
-    // Get block header
-    BlockHeader* block = (BlockHeader*)((char*)ptr - sizeof(BlockHeader));
-    assert(!block->isFree);
-    assert(block->pool != nullptr);
-
+void SmallMemoryAllocator::freeBlock(BlockHeader* block) {
     // Mark as free
+    MemoryPool* pool = block->pool;
     block->isFree = true;
     allocationCount_--;
-    block->pool->allocCount--;
+    pool->allocCount--;
 
-    // Coalesce adjacent free blocks in this pool
-    coalescePool(block->pool);
+    // Merge with free neighbours and bin the result
+    insertFreeBlock(coalesceBlock(block));
 
     // Remove empty pools
-    removeEmptyPools();
+    if (pool->allocCount == 0) {
+        removeEmptyPools();
+    }
+}
 
+SmallMemoryAllocator::ThreadCache* SmallMemoryAllocator::threadCache() {
+    ThreadCache* cache = (ThreadCache*)SDL_GetTLS(&cacheTls_);
+    if (cache) {
+        return cache;
+    }
+
+    cache = (ThreadCache*)SDL_malloc(sizeof(ThreadCache));
+    assert(cache != nullptr);
+    SDL_memset(cache, 0, sizeof(ThreadCache));
+    cache->owner = this;
+    if (!SDL_SetTLS(&cacheTls_, cache, destroyThreadCache)) {
+        SDL_free(cache);
+        return nullptr;
+    }
+
+    SDL_LockMutex(mutex_);
+    cache->next = caches_;
+    if (caches_) {
+        caches_->prev = cache;
+    }
+    caches_ = cache;
     SDL_UnlockMutex(mutex_);
+    return cache;
+}
+
+void SmallMemoryAllocator::flushMagazine(Magazine& magazine, Uint32 count) {
+    assert(count <= magazine.count);
+    for (Uint32 i = 0; i < count; i++) {
+        freeBlock(magazine.blocks[i]);
+    }
+    magazine.count -= count;
+    SDL_memmove(magazine.blocks, magazine.blocks + count, magazine.count * sizeof(BlockHeader*));
+}
+
+void SmallMemoryAllocator::releaseThreadCache(ThreadCache* cache) {
+    for (Uint64 i = 0; i < EXACT_BIN_COUNT; i++) {
+        flushMagazine(cache->magazines[i], cache->magazines[i].count);
+    }
+
+    if (cache->prev) {
+        cache->prev->next = cache->next;
+    } else {
+        caches_ = cache->next;
+    }
+    if (cache->next) {
+        cache->next->prev = cache->prev;
+    }
+    SDL_free(cache);
+}
+
+void SmallMemoryAllocator::destroyThreadCache(void* cache) {
+    SmallMemoryAllocator* owner = ((ThreadCache*)cache)->owner;
+    SDL_LockMutex(owner->mutex_);
+    owner->releaseThreadCache((ThreadCache*)cache);
+    SDL_UnlockMutex(owner->mutex_);
 }
 
 Uint64 SmallMemoryAllocator::defragment() {
+    ThreadCache* cache = (ThreadCache*)SDL_GetTLS(&cacheTls_);
+
     SDL_LockMutex(mutex_);
 
+    // Give this thread's cached blocks back so they can merge
+    if (cache) {
+        for (Uint64 i = 0; i < EXACT_BIN_COUNT; i++) {
+            flushMagazine(cache->magazines[i], cache->magazines[i].count);
+        }
+    }
+
     // Coalesce free blocks in each pool
     Uint64 totalCoalesced = 0;
     MemoryPool* pool = firstPool_;
     while (pool) {
         BlockHeader* current = pool->firstBlock;
         while (current && current->next) {
-            // Only coalesce within the same pool
-            if (current->isFree && current->next->isFree && current->next->pool == pool) {
-                BlockHeader* next = current->next;
-
-                // Expand current block
-                current->size += sizeof(BlockHeader) + next->size;
-                current->next = next->next;
-
-                if (next->next) {
-                    next->next->prev = current;
-                }
-
-                if (next == pool->lastBlock) {
-                    pool->lastBlock = current;
-                }
-
-                pool->used -= sizeof(BlockHeader);
+            if (current->isFree && current->next->isFree) {
+                removeFreeBlock(current);
+                current = coalesceBlock(current);
+                insertFreeBlock(current);
                 totalCoalesced++;
             } else {
                 current = current->next;
@@ -200,6 +310,7 @@ SmallMemoryAllocator::MemoryPool* SmallMemoryAllocator::createPool(Uint64 capaci
 
     pool->firstBlock = freeBlock;
     pool->lastBlock = freeBlock;
+    insertFreeBlock(freeBlock);
 
     // Add pool to list
     if (!firstPool_) {
@@ -224,6 +335,10 @@ void SmallMemoryAllocator::removeEmptyPools() {
 
         // Remove pool if it has no active allocations and it's not the only pool
         if (pool->allocCount == 0 && (firstPool_ != lastPool_)) {
+            // With no allocations left its blocks have merged into one
+            assert(pool->firstBlock == pool->lastBlock && pool->firstBlock->isFree);
+            removeFreeBlock(pool->firstBlock);
+
             // Unlink from list
             if (prev) {
                 prev->next = next;
@@ -246,54 +361,104 @@ void SmallMemoryAllocator::removeEmptyPools() {
     }
 }
 
-void SmallMemoryAllocator::coalescePool(MemoryPool* pool) {
-    if (!pool || !pool->firstBlock) return;
-
-    BlockHeader* current = pool->firstBlock;
+Uint64 SmallMemoryAllocator::binIndex(Uint64 size) {
+    assert(size >= MIN_BLOCK_SIZE && (size & 7) == 0);
+    if (size <= EXACT_BIN_LIMIT) {
+        return size / 8 - MIN_BLOCK_SIZE / 8;
+    }
+    // Power-of-two ranges above the exact bins, the first starting past
+    // EXACT_BIN_LIMIT and the last taking every size beyond
+    Uint64 log2Size = 63 - __builtin_clzll(size);
+    Uint64 bin = EXACT_BIN_COUNT + log2Size - 8;
+    return bin < NUM_BINS ? bin : NUM_BINS - 1;
+}
 
-    while (current && current->next) {
-        // Only coalesce within the same pool
-        if (current->isFree && current->next->isFree && current->next->pool == pool) {
-            BlockHeader* next = current->next;
+SmallMemoryAllocator::FreeLinks* SmallMemoryAllocator::freeLinks(BlockHeader* block) {
+    return (FreeLinks*)((char*)block + sizeof(BlockHeader));
+}
 
-            // Expand current block
-            current->size += sizeof(BlockHeader) + next->size;
-            current->next = next->next;
+void SmallMemoryAllocator::insertFreeBlock(BlockHeader* block) {
+    assert(block->isFree);
+    Uint64 bin = binIndex(block->size);
+    FreeLinks* links = freeLinks(block);
+    links->prevFree = nullptr;
+    links->nextFree = bins_[bin];
+    if (bins_[bin]) {
+        freeLinks(bins_[bin])->prevFree = block;
+    }
+    bins_[bin] = block;
+    binMask_ |= 1ull << bin;
+}
 
-            if (next->next) {
-                next->next->prev = current;
-            }
+void SmallMemoryAllocator::removeFreeBlock(BlockHeader* block) {
+    assert(block->isFree);
+    Uint64 bin = binIndex(block->size);
+    FreeLinks* links = freeLinks(block);
+    if (links->prevFree) {
+        freeLinks(links->prevFree)->nextFree = links->nextFree;
+    } else {
+        assert(bins_[bin] == block);
+        bins_[bin] = links->nextFree;
+        if (!bins_[bin]) {
+            binMask_ &= ~(1ull << bin);
+        }
+    }
+    if (links->nextFree) {
+        freeLinks(links->nextFree)->prevFree = links->prevFree;
+    }
+}
 
-            if (next == pool->lastBlock) {
-                pool->lastBlock = current;
-            }
+SmallMemoryAllocator::BlockHeader* SmallMemoryAllocator::coalesceBlock(BlockHeader* block) {
+    assert(block->isFree);
+    MemoryPool* pool = block->pool;
+
+    // Absorb the following block
+    BlockHeader* next = block->next;
+    if (next && next->isFree) {
+        removeFreeBlock(next);
+        block->size += sizeof(BlockHeader) + next->size;
+        block->next = next->next;
+        if (next->next) {
+            next->next->prev = block;
+        }
+        if (next == pool->lastBlock) {
+            pool->lastBlock = block;
+        }
+        pool->used -= sizeof(BlockHeader);
+    }
 
-            pool->used -= sizeof(BlockHeader);
-        } else {
-            current = current->next;
+    // Let the preceding block absorb this one
+    BlockHeader* prev = block->prev;
+    if (prev && prev->isFree) {
+        removeFreeBlock(prev);
+        prev->size += sizeof(BlockHeader) + block->size;
+        prev->next = block->next;
+        if (block->next) {
+            block->next->prev = prev;
         }
+        if (block == pool->lastBlock) {
+            pool->lastBlock = prev;
+        }
+        pool->used -= sizeof(BlockHeader);
+        block = prev;
     }
+    return block;
 }
 
 SmallMemoryAllocator::BlockHeader* SmallMemoryAllocator::findFreeBlock(Uint64 size) {
-    // Search all pools for a suitable free block
-    MemoryPool* pool = firstPool_;
-
-    while (pool) {
-        BlockHeader* current = pool->firstBlock;
-
-        // First-fit strategy within this pool
-        while (current) {
-            if (current->isFree && current->size >= size) {
-                return current;
-            }
-            current = current->next;
+    // Every block in an exact bin fits; in a range bin only the first is tried
+    Uint64 bin = binIndex(size);
+    BlockHeader* block = bins_[bin];
+    if (!block || block->size < size) {
+        // Any block in a larger bin fits, so take the first of the smallest one
+        Uint64 larger = bin + 1 < NUM_BINS ? binMask_ & (~0ull << (bin + 1)) : 0;
+        if (!larger) {
+            return nullptr;
         }
-
-        pool = pool->next;
+        block = bins_[__builtin_ctzll(larger)];
     }
-
-    return nullptr;
+    removeFreeBlock(block);
+    return block;
 }
 
 void SmallMemoryAllocator::splitBlock(BlockHeader* block, Uint64 size) {
@@ -304,7 +469,7 @@ void SmallMemoryAllocator::splitBlock(BlockHeader* block, Uint64 size) {
 
     // Only split if remaining space is worth creating a new block
     Uint64 remainingSize = block->size - size;
-    if (remainingSize >= sizeof(BlockHeader) + 8) {
+    if (remainingSize >= sizeof(BlockHeader) + MIN_BLOCK_SIZE) {
         MemoryPool* pool = block->pool;
 
         // Create new free block from the remainder
@@ -328,6 +493,9 @@ void SmallMemoryAllocator::splitBlock(BlockHeader* block, Uint64 size) {
         // Shrink current block
         block->size = size;
         // Note: pool->used doesn't change - we're just reorganizing existing space
+
+        // The block after was in use, as free neighbours are always merged
+        insertFreeBlock(newBlock);
     }
 }
 
@@ -361,6 +529,10 @@ Uint64 SmallMemoryAllocator::getAllocationCount() const {
     return result;
 }
 
+Uint32 SmallMemoryAllocator::getAllocateCallCount() const {
+    return (Uint32)SDL_GetAtomicInt(&allocateCalls_);
+}
+
 SmallMemoryAllocator::MemoryPoolInfo* SmallMemoryAllocator::getPoolInfo(Uint64* outPoolCount) const {
     SDL_LockMutex(mutex_);
 
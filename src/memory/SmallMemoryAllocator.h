@@ -6,7 +6,11 @@
 // Small memory allocator optimized for frequent small allocations
 // - Uses pooled memory for cache-friendly access
 // - Dynamically grows/shrinks by powers of 2
-// - Automatic defragmentation
+// - Free blocks are kept in size-class bins, so allocate and free take
+//   constant time however many blocks are live
+// - Freed blocks merge with free neighbours immediately
+// - Each thread keeps magazines of recently freed small blocks, so most
+//   allocations and frees never take the heap lock
 // - No STL dependencies
 
 class SmallMemoryAllocator : public MemoryAllocator {
@@ -21,7 +25,9 @@ public:
     // Free previously allocated memory
     void free(void* ptr) override;
 
-    // Defragment the allocator (coalesces adjacent free blocks)
+    // Defragment the allocator (returns the calling thread's cached blocks,
+    // coalesces adjacent free blocks and releases empty pools). free() already
+    // merges neighbours, so this rarely finds any.
     // Returns number of blocks coalesced
     Uint64 defragment() override;
 
@@ -31,6 +37,8 @@ public:
     Uint64 getUsedMemory() const override;
     Uint64 getFreeMemory() const override;
     Uint64 getAllocationCount() const;
+    // Every allocate() call so far, magazine hits included; wraps around
+    Uint32 getAllocateCallCount() const;
 
     // Debug visualization helpers
     struct MemoryPoolInfo;
@@ -88,6 +96,12 @@ private:
         const char* allocationId; // Identifier for tracking allocation source
     };
 
+    // Links of a free block in its bin, stored in the block's own payload
+    struct FreeLinks {
+        BlockHeader* nextFree;
+        BlockHeader* prevFree;
+    };
+
     // Memory pool structure - each pool is independent
     struct MemoryPool {
         char* memory;          // Pool memory
@@ -103,6 +117,40 @@ private:
     MemoryPool* firstPool_;
     MemoryPool* lastPool_;
 
+    // Free blocks by size class. Bins below EXACT_BIN_COUNT hold a single
+    // size each, 16 to EXACT_BIN_LIMIT bytes in 8 byte steps; each bin above
+    // holds a power-of-two range of sizes. Bit i of binMask_ is set when
+    // bins_[i] is not empty.
+    static const Uint64 NUM_BINS = 64;
+    static const Uint64 EXACT_BIN_LIMIT = 256;
+    static const Uint64 EXACT_BIN_COUNT = EXACT_BIN_LIMIT / 8 - 1;
+    BlockHeader* bins_[NUM_BINS];
+    Uint64 binMask_;
+
+    // Per-thread magazines, one per exact bin size. A thread allocates from
+    // and frees into its own magazines without locking, and refills or
+    // flushes them MAGAZINE_BATCH blocks at a time under mutex_. Cached
+    // blocks stay allocated as far as the heap is concerned. They belong to
+    // no thread, so a block freed on a thread other than the one that
+    // allocated it simply joins the freeing thread's magazine.
+    static const Uint32 MAGAZINE_SIZE = 32;
+    static const Uint32 MAGAZINE_BATCH = MAGAZINE_SIZE / 2;
+
+    struct Magazine {
+        Uint32 count;
+        BlockHeader* blocks[MAGAZINE_SIZE];
+    };
+
+    struct ThreadCache {
+        SmallMemoryAllocator* owner;
+        ThreadCache* next;     // Next cache of the same allocator
+        ThreadCache* prev;     // Previous cache of the same allocator
+        Magazine magazines[EXACT_BIN_COUNT];
+    };
+
+    SDL_TLSID cacheTls_;
+    ThreadCache* caches_;  // Every thread's cache, guarded by mutex_
+
     // Statistics
     Uint64 allocationCount_;
     Uint64 totalCapacity_;
@@ -120,24 +168,57 @@ private:
     float lastSampleTime_;
 
     static constexpr float SAMPLE_INTERVAL = 0.1f; // Sample every 100ms
+
+    // Counted without the mutex, since magazine hits never take it
+    mutable SDL_AtomicInt allocateCalls_;
 #endif
 
     // Minimum pool size (64KB)
     static const Uint64 MIN_POOL_SIZE = 64 * 1024;
 
+    // Smallest block payload, which has to hold its FreeLinks once freed
+    static const Uint64 MIN_BLOCK_SIZE = sizeof(FreeLinks);
+
     // Create a new pool with given capacity
     MemoryPool* createPool(Uint64 capacity);
 
+    // Allocate or free a block on the shared heap (caller must hold mutex_)
+    BlockHeader* allocateBlock(Uint64 alignedSize, const char* allocationId);
+    void freeBlock(BlockHeader* block);
+
+    // The calling thread's cache, created on first use. Returns nullptr if
+    // thread-local storage is unavailable, in which case callers go to the heap.
+    ThreadCache* threadCache();
+
+    // Return the oldest count blocks of a magazine to the heap (caller must
+    // hold mutex_)
+    void flushMagazine(Magazine& magazine, Uint32 count);
+
+    // Return every cached block and unlink the cache (caller must hold mutex_)
+    void releaseThreadCache(ThreadCache* cache);
+
+    // TLS destructor, run when a thread with a cache exits
+    static void destroyThreadCache(void* cache);
+
     // Remove empty pools
     void removeEmptyPools();
 
-    // Merge adjacent free blocks within a pool
-    void coalescePool(MemoryPool* pool);
+    // Bin index for a free block or request of the given (aligned) size
+    static Uint64 binIndex(Uint64 size);
+    static FreeLinks* freeLinks(BlockHeader* block);
+
+    // Add a free block to, or take it out of, its bin
+    void insertFreeBlock(BlockHeader* block);
+    void removeFreeBlock(BlockHeader* block);
+
+    // Merge a free block that is in no bin with its free neighbours, taking
+    // them out of their bins. Returns the merged block, also in no bin.
+    BlockHeader* coalesceBlock(BlockHeader* block);
 
-    // Find a free block that fits size across all pools
+    // Take a free block that fits size out of the bins, or return nullptr
     BlockHeader* findFreeBlock(Uint64 size);
 
-    // Split a block if it's larger than needed
+    // Split a block if it's larger than needed, binning the remainder
     void splitBlock(BlockHeader* block, Uint64 size);
 
     // Calculate used memory without locking (caller must hold mutex_)
@@ -4,6 +4,7 @@
 #include "../memory/SmallMemoryAllocator.h"
 #include "../core/Vector.h"
 #include "../core/TrigLookup.h"
+#include "../core/ResourceTypes.h"
 #include "../debug/ConsoleBuffer.h"
 #include "../debug/ThreadProfiler.h"
 #include <cassert>
@@ -32,6 +33,14 @@ static constexpr float MIN_FRAGMENT_LAYER_SIZE = 0.04f;  // Minimum layer size f
 // Minimum bounding box dimension for UV mapping (prevents division by zero)
 static constexpr float MIN_DIMENSION_FOR_UV_MAPPING = 0.0001f;
 
+// Copy an AtlasUV trim rect, or mark the whole image held when there is none
+static void copyAtlasTrim(float* dst, const float* trim) {
+    dst[0] = trim ? trim[0] : 0.0f;
+    dst[1] = trim ? trim[1] : 0.0f;
+    dst[2] = trim ? trim[2] : 1.0f;
+    dst[3] = trim ? trim[3] : 1.0f;
+}
+
 // Helper function to convert b2HexColor to RGBA floats
 static void hexColorToRGBA(b2HexColor hexColor, float& r, float& g, float& b, float& a) {
     r = ((hexColor >> 16) & 0xFF) / 255.0f;
@@ -63,6 +72,7 @@ Box2DPhysics::Box2DPhysics(MemoryAllocator* smallAllocator, MemoryAllocator* lar
       forceFields_(*smallAllocator, "Box2DPhysics::forceFields_"),
       radialForceFields_(*smallAllocator, "Box2DPhysics::radialForceFields_"),
       bodyTypes_(*smallAllocator, "Box2DPhysics::bodyTypes_"),
+      bodyTypePool_(*smallAllocator, "Box2DPhysics::bodyTypePool_"),
 #ifdef DEBUG
       debugLineVertices_(*largeAllocator, "Box2DPhysics::debugLineVertices_"),
       debugTriangleVertices_(*largeAllocator, "Box2DPhysics::debugTriangleVertices_"),
@@ -141,8 +151,7 @@ Box2DPhysics::~Box2DPhysics() {
     for (auto it = bodyTypes_.begin(); it != bodyTypes_.end(); ++it) {
         Vector<String>* vec = it.value();
         assert(vec != nullptr);
-        vec->~Vector();  // Call destructor to free internal data
-        stringAllocator_->free(vec);  // Free the Vector object itself
+        bodyTypePool_.destroy(vec);
     }
     bodyTypes_.clear();
 
@@ -453,8 +462,7 @@ void Box2DPhysics::destroyBody(int bodyId) {
     if (typeIt != nullptr) {
         assert(*typeIt != nullptr);
         Vector<String>* vec = *typeIt;
-        vec->~Vector();  // Call destructor
-        stringAllocator_->free(vec);  // Free through allocator
+        bodyTypePool_.destroy(vec);
         bodyTypes_.remove(bodyId);
     }
     consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE, "Box2DPhysics: Destroyed body %d, cleared body types", bodyId);
@@ -1114,6 +1122,8 @@ void Box2DPhysics::setBodyDestructible(int bodyId, float strength, float brittle
     props.atlasV0 = 0.0f;
     props.atlasU1 = 1.0f;
     props.atlasV1 = 1.0f;
+    props.atlasRotated = false;
+    copyAtlasTrim(props.atlasTrim, nullptr);
     props.atlasTextureId = textureId;
 
     // Default to no normal map atlas
@@ -1122,13 +1132,16 @@ void Box2DPhysics::setBodyDestructible(int bodyId, float strength, float brittle
     props.normalAtlasV0 = 0.0f;
     props.normalAtlasU1 = 1.0f;
     props.normalAtlasV1 = 1.0f;
+    props.normalAtlasRotated = false;
+    copyAtlasTrim(props.normalAtlasTrim, nullptr);
     props.atlasNormalMapId = normalMapId;
 
     destructibles_.insert(bodyId, props);
 }
 
 void Box2DPhysics::setBodyDestructibleAtlasUV(int bodyId, Uint64 atlasTextureId,
-                                               float u0, float v0, float u1, float v1) {
+                                               float u0, float v0, float u1, float v1, bool rotated,
+                                               const float* trim) {
     auto it = destructibles_.find(bodyId);
     if (it != nullptr) {
         it->usesAtlas = true;
@@ -1136,12 +1149,15 @@ void Box2DPhysics::setBodyDestructibleAtlasUV(int bodyId, Uint64 atlasTextureId,
         it->atlasV0 = v0;
         it->atlasU1 = u1;
         it->atlasV1 = v1;
+        it->atlasRotated = rotated;
+        copyAtlasTrim(it->atlasTrim, trim);
         it->atlasTextureId = atlasTextureId;
     }
 }
 
 void Box2DPhysics::setBodyDestructibleNormalMapAtlasUV(int bodyId, Uint64 atlasNormalMapId,
-                                                        float u0, float v0, float u1, float v1) {
+                                                        float u0, float v0, float u1, float v1, bool rotated,
+                                                        const float* trim) {
     auto it = destructibles_.find(bodyId);
     if (it != nullptr) {
         it->usesNormalMapAtlas = true;
@@ -1149,6 +1165,8 @@ void Box2DPhysics::setBodyDestructibleNormalMapAtlasUV(int bodyId, Uint64 atlasN
         it->normalAtlasV0 = v0;
         it->normalAtlasU1 = u1;
         it->normalAtlasV1 = v1;
+        it->normalAtlasRotated = rotated;
+        copyAtlasTrim(it->normalAtlasTrim, trim);
         it->atlasNormalMapId = atlasNormalMapId;
     }
 }
@@ -1250,9 +1268,12 @@ FragmentPolygon Box2DPhysics::createFragmentWithUVs(const DestructiblePolygon& p
         // Calculate texture UV
         float u, v;
         if (props.usesAtlas) {
-            // Map from local UV (0-1) to atlas UV range
-            u = props.atlasU0 + localU * (props.atlasU1 - props.atlasU0);
-            v = props.atlasV0 + localV * (props.atlasV1 - props.atlasV0);
+            // Map from local UV (0-1) to atlas UV range; outside a trimmed
+            // sprite's region the shader clamps onto its transparent margin
+            float ts, tt;
+            atlasTrimST(props.atlasTrim, localU, localV, ts, tt);
+            atlasImageUV(props.atlasU0, props.atlasV0, props.atlasU1, props.atlasV1, props.atlasRotated,
+                         ts, tt, u, v);
         } else {
             u = localU;
             v = localV;
@@ -1263,8 +1284,10 @@ FragmentPolygon Box2DPhysics::createFragmentWithUVs(const DestructiblePolygon& p
         // Calculate normal map UV (may be different atlas or no atlas)
         float nu, nv;
         if (props.usesNormalMapAtlas) {
-            nu = props.normalAtlasU0 + localU * (props.normalAtlasU1 - props.normalAtlasU0);
-            nv = props.normalAtlasV0 + localV * (props.normalAtlasV1 - props.normalAtlasV0);
+            float ts, tt;
+            atlasTrimST(props.normalAtlasTrim, localU, localV, ts, tt);
+            atlasImageUV(props.normalAtlasU0, props.normalAtlasV0, props.normalAtlasU1, props.normalAtlasV1,
+                         props.normalAtlasRotated, ts, tt, nu, nv);
         } else {
             nu = localU;
             nv = localV;
@@ -2050,13 +2073,15 @@ void Box2DPhysics::processFractures() {
                 if (props->usesAtlas) {
                     layerManager_->setLayerAtlasUV(layerId, props->atlasTextureId,
                                                     props->atlasU0, props->atlasV0,
-                                                    props->atlasU1, props->atlasV1);
+                                                    props->atlasU1, props->atlasV1, props->atlasRotated,
+                                                    props->atlasTrim);
                 }
                 // Set normal map atlas UV coordinates if using normal map atlas
                 if (props->usesNormalMapAtlas) {
                     layerManager_->setLayerNormalMapAtlasUV(layerId, props->atlasNormalMapId,
                                                              props->normalAtlasU0, props->normalAtlasV0,
-                                                             props->normalAtlasU1, props->normalAtlasV1);
+                                                             props->normalAtlasU1, props->normalAtlasV1,
+                                                             props->normalAtlasRotated, props->normalAtlasTrim);
                 }
 
                 // Apply polygon vertices and UV coordinates for texture clipping
@@ -2094,13 +2119,15 @@ void Box2DPhysics::processFractures() {
                 // Copy texture atlas info to new fragment
                 if (props->usesAtlas) {
                     setBodyDestructibleAtlasUV(fragBodyId, props->atlasTextureId,
-                                                props->atlasU0, props->atlasV0, props->atlasU1, props->atlasV1);
+                                                props->atlasU0, props->atlasV0, props->atlasU1, props->atlasV1,
+                                                props->atlasRotated, props->atlasTrim);
                 }
                 // Copy normal map atlas info to new fragment
                 if (props->usesNormalMapAtlas) {
                     setBodyDestructibleNormalMapAtlasUV(fragBodyId, props->atlasNormalMapId,
                                                          props->normalAtlasU0, props->normalAtlasV0,
-                                                         props->normalAtlasU1, props->normalAtlasV1);
+                                                         props->normalAtlasU1, props->normalAtlasV1,
+                                                         props->normalAtlasRotated, props->normalAtlasTrim);
                 }
 
                 // Set layer for fragment so it can be destroyed if fragment breaks
@@ -2261,8 +2288,7 @@ void Box2DPhysics::reset() {
     for (auto it = bodyTypes_.begin(); it != bodyTypes_.end(); ++it) {
         Vector<String>* vec = it.value();
         assert(vec != nullptr);
-        vec->~Vector();  // Call destructor to free internal data
-        stringAllocator_->free(vec);  // Free the Vector object itself
+        bodyTypePool_.destroy(vec);
     }
     bodyTypes_.clear();
 
@@ -2315,10 +2341,8 @@ void Box2DPhysics::addBodyType(int bodyId, const char* type) {
     consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE, "Box2DPhysics::addBodyType: bodyId=%d, type=%s", bodyId, type);
     Vector<String>** it = bodyTypes_.find(bodyId);
     if (it == nullptr) {
-        // Create new vector for this body - allocate through allocator using placement new
-        void* vectorMem = stringAllocator_->allocate(sizeof(Vector<String>), "Box2DPhysics::addBodyType::Vector");
-        assert(vectorMem != nullptr);
-        Vector<String>* types = new (vectorMem) Vector<String>(*stringAllocator_, "Box2DPhysics::addBodyType::data");
+        // Create new vector for this body
+        Vector<String>* types = bodyTypePool_.create(*stringAllocator_, "Box2DPhysics::addBodyType::data");
         String typeStr(type, stringAllocator_);
         types->push_back(typeStr);
         bodyTypes_.insertNew(bodyId, types);
@@ -2362,8 +2386,7 @@ void Box2DPhysics::removeBodyType(int bodyId, const char* type) {
         }
         if (types->empty()) {
             consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE, "Box2DPhysics::removeBodyType: vector empty, deleting");
-            types->~Vector();  // Call destructor
-            stringAllocator_->free(types);  // Free through allocator
+            bodyTypePool_.destroy(types);
             bodyTypes_.remove(bodyId);
         }
     }
@@ -2377,8 +2400,7 @@ void Box2DPhysics::clearBodyTypes(int bodyId) {
     if (it != nullptr) {
         assert(*it != nullptr);
         Vector<String>* vec = *it;
-        vec->~Vector();  // Call destructor
-        stringAllocator_->free(vec);  // Free through allocator
+        bodyTypePool_.destroy(vec);
         bodyTypes_.remove(bodyId);
         consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE, "Box2DPhysics::clearBodyTypes: deleted vector for bodyId %d", bodyId);
     }
@@ -6,6 +6,7 @@
 #include "../core/Vector.h"
 #include "../core/HashTable.h"
 #include "../memory/MemoryAllocator.h"
+#include "../memory/ObjectPool.h"
 
 #define LENGTH_UNITS_PER_METER 0.05f  // Define this smaller so box2d doesn't join polygon vertices
 
@@ -82,11 +83,15 @@ struct DestructibleProperties {
     bool usesAtlas;
     float atlasU0, atlasV0;  // Top-left UV in atlas for texture
     float atlasU1, atlasV1;  // Bottom-right UV in atlas for texture
+    bool atlasRotated;       // Texture stored turned clockwise in the atlas
+    float atlasTrim[4];      // Part of the texture the atlas region holds (AtlasUV::trim)
     Uint64 atlasTextureId;      // Atlas texture ID (if using atlas)
     // Atlas UV coordinates for normal map (separate, may be different)
     bool usesNormalMapAtlas;
     float normalAtlasU0, normalAtlasV0;  // Top-left UV in atlas for normal map
     float normalAtlasU1, normalAtlasV1;  // Bottom-right UV in atlas for normal map
+    bool normalAtlasRotated;             // Normal map stored turned clockwise in the atlas
+    float normalAtlasTrim[4];            // Part of the normal map the atlas region holds
     Uint64 atlasNormalMapId;    // Atlas normal map ID (if using atlas)
 };
 
@@ -205,13 +210,16 @@ public:
                              const float* vertices, int vertexCount,
                              Uint64 textureId, Uint64 normalMapId, int pipelineId);
 
-    // Set atlas UV coordinates for a destructible body's texture (call after setBodyDestructible)
+    // Set atlas UV coordinates for a destructible body's texture (call after setBodyDestructible);
+    // trim is AtlasUV::trim for a sprite trimmed by the packer, nullptr for the whole image
     void setBodyDestructibleAtlasUV(int bodyId, Uint64 atlasTextureId,
-                                     float u0, float v0, float u1, float v1);
+                                     float u0, float v0, float u1, float v1, bool rotated = false,
+                                     const float* trim = nullptr);
 
     // Set atlas UV coordinates for a destructible body's normal map (call after setBodyDestructible)
     void setBodyDestructibleNormalMapAtlasUV(int bodyId, Uint64 atlasNormalMapId,
-                                              float u0, float v0, float u1, float v1);
+                                              float u0, float v0, float u1, float v1, bool rotated = false,
+                                              const float* trim = nullptr);
 
     // Set root bounding box for a destructible fragment (for proper UV mapping in recursive fractures)
     void setBodyDestructibleRootBounds(int bodyId, float minX, float minY, float width, float height);
@@ -430,6 +438,7 @@ private:
 
     // Type system for object interactions
     HashTable<int, Vector<String>*> bodyTypes_;
+    ObjectPool<Vector<String>> bodyTypePool_;  // Owns the bodyTypes_ vectors; unsynchronised, only used under physicsMutex_
 
     // Memory allocator for string operations
     MemoryAllocator* stringAllocator_;
@@ -0,0 +1,151 @@
+#include "MappedFile.h"
+#include <cassert>
+
+#if defined(__x86_64__) && defined(__linux__) && !defined(ANDROID)
+#define MAPPED_FILE_SUPPORTED 1
+#endif
+
+#ifdef MAPPED_FILE_SUPPORTED
+
+// x86_64 Linux syscall numbers and flags (see my_exit in no_stl_shims.cpp)
+#define SYS_OPEN 2
+#define SYS_CLOSE 3
+#define SYS_LSEEK 8
+#define SYS_MMAP 9
+#define SYS_MUNMAP 11
+#define SYS_MADVISE 28
+
+#define MF_O_RDONLY 0
+#define MF_O_CLOEXEC 02000000
+#define MF_SEEK_END 2
+#define MF_PROT_READ 1
+#define MF_MAP_PRIVATE 2
+#define MF_MADV_RANDOM 1
+#define MF_MADV_WILLNEED 3
+#define MF_MADV_DONTNEED 4
+#define MF_PAGE_SIZE 4096ULL
+
+static long rawSyscall(long number, long a1, long a2, long a3, long a4 = 0, long a5 = 0, long a6 = 0) {
+    register long rax __asm__("rax") = number;
+    register long rdi __asm__("rdi") = a1;
+    register long rsi __asm__("rsi") = a2;
+    register long rdx __asm__("rdx") = a3;
+    register long r10 __asm__("r10") = a4;
+    register long r8 __asm__("r8") = a5;
+    register long r9 __asm__("r9") = a6;
+    __asm__ volatile ("syscall"
+                      : "+r"(rax)
+                      : "r"(rdi), "r"(rsi), "r"(rdx), "r"(r10), "r"(r8), "r"(r9)
+                      : "rcx", "r11", "memory");
+    return rax;
+}
+
+// Syscalls return -errno in [-4095, -1] on failure
+static bool syscallFailed(long result) {
+    return result < 0 && result >= -4095;
+}
+
+#else
+
+#define MF_MADV_RANDOM 1
+#define MF_MADV_WILLNEED 3
+#define MF_MADV_DONTNEED 4
+
+#endif
+
+MappedFile::MappedFile()
+    : m_data(nullptr)
+    , m_size(0)
+{
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::isSupported() {
+#ifdef MAPPED_FILE_SUPPORTED
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool MappedFile::open(const char* filename) {
+    assert(filename != nullptr);
+    assert(m_data == nullptr);
+#ifdef MAPPED_FILE_SUPPORTED
+    long fd = rawSyscall(SYS_OPEN, (long)filename, MF_O_RDONLY | MF_O_CLOEXEC, 0);
+    if (syscallFailed(fd)) {
+        return false;
+    }
+
+    long fileSize = rawSyscall(SYS_LSEEK, fd, 0, MF_SEEK_END);
+    if (syscallFailed(fileSize) || fileSize <= 0) {
+        rawSyscall(SYS_CLOSE, fd, 0, 0);
+        return false;
+    }
+
+    long addr = rawSyscall(SYS_MMAP, 0, fileSize, MF_PROT_READ, MF_MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    rawSyscall(SYS_CLOSE, fd, 0, 0);
+    if (syscallFailed(addr)) {
+        return false;
+    }
+
+    m_data = (char*)addr;
+    m_size = (Uint64)fileSize;
+    return true;
+#else
+    (void)filename;
+    return false;
+#endif
+}
+
+void MappedFile::close() {
+    if (!m_data) {
+        return;
+    }
+#ifdef MAPPED_FILE_SUPPORTED
+    rawSyscall(SYS_MUNMAP, (long)m_data, (long)m_size, 0);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+void MappedFile::adviseRandom(Uint64 offset, Uint64 length) {
+    advise(offset, length, MF_MADV_RANDOM);
+}
+
+void MappedFile::adviseWillNeed(Uint64 offset, Uint64 length) {
+    advise(offset, length, MF_MADV_WILLNEED);
+}
+
+void MappedFile::adviseDontNeed(Uint64 offset, Uint64 length) {
+    advise(offset, length, MF_MADV_DONTNEED);
+}
+
+void MappedFile::advise(Uint64 offset, Uint64 length, int advice) {
+    if (!m_data || length == 0 || offset >= m_size) {
+        return;
+    }
+#ifdef MAPPED_FILE_SUPPORTED
+    Uint64 end = offset + length;
+    if (end > m_size) {
+        end = m_size;
+    }
+    // madvise requires a page-aligned start
+    Uint64 start = offset & ~(MF_PAGE_SIZE - 1);
+    if (advice == MF_MADV_DONTNEED) {
+        // Only drop pages fully inside the range so neighbouring resources stay resident
+        start = (offset + MF_PAGE_SIZE - 1) & ~(MF_PAGE_SIZE - 1);
+        end &= ~(MF_PAGE_SIZE - 1);
+        if (end <= start) {
+            return;
+        }
+    }
+    rawSyscall(SYS_MADVISE, (long)(m_data + start), (long)(end - start), advice);
+#else
+    (void)advice;
+#endif
+}
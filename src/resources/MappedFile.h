@@ -0,0 +1,36 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+
+// Read-only memory mapping of a whole file.
+// Pages are faulted in by the kernel on first access instead of being copied
+// up front, so resident memory only grows with what is actually touched.
+//
+// Only desktop Linux on x86_64 maps files (raw syscalls, since the game is
+// linked without libc). Everywhere else open() returns false and callers
+// fall back to reading the file into memory.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    static bool isSupported();
+
+    bool open(const char* filename);
+    void close();
+
+    const char* data() const { return m_data; }
+    Uint64 size() const { return m_size; }
+    bool isOpen() const { return m_data != nullptr; }
+
+    // Access pattern hints for a byte range of the mapping (rounded out to pages)
+    void adviseRandom(Uint64 offset, Uint64 length);
+    void adviseWillNeed(Uint64 offset, Uint64 length);
+    void adviseDontNeed(Uint64 offset, Uint64 length);
+
+private:
+    void advise(Uint64 offset, Uint64 length, int advice);
+
+    char* m_data;
+    Uint64 m_size;
+};
@@ -1,22 +1,63 @@
 #include "resource.h"
 #include "../core/ResourceTypes.h"
 #include "../core/Vector.h"
+#include "../core/hash.h"
 #include "../debug/ConsoleBuffer.h"
 #include "../debug/ThreadProfiler.h"
 #include "../compress/Compress.h"
 #include <cassert>
 
-PakResource::PakResource(MemoryAllocator* allocator, ConsoleBuffer* consoleBuffer)
+// Offsets of merged overlay entries are tagged so they never collide with blob
+// offsets of the base pak (both are keys of m_decompressedData and m_blobLoads)
+#define PAK_OVERLAY_OFFSET_FLAG (1ULL << 63)
+
+PakResource::PakResource(MemoryAllocator* allocator, ConsoleBuffer* consoleBuffer, int workerCount)
     : m_pakData{nullptr, 0}
     , m_pakFileBuffer(*allocator, "PakResource::m_pakFileBuffer")
+    , m_loadMode(PAK_LOAD_MODE_MMAP)
     , m_decompressedData(*allocator, "PakResource::m_decompressedData")
-    , m_resourceIndex(*allocator, "PakResource::m_resourceIndex")
+    , m_entryPool(*allocator, "PakResource::m_entryPool")
+    , m_bufferPool(*allocator, "PakResource::m_bufferPool")
+    , m_blobResourcePool(*allocator, "PakResource::m_blobResourcePool")
+    , m_lruHead(nullptr)
+    , m_lruTail(nullptr)
+    , m_blobLoads(*allocator, "PakResource::m_blobLoads")
+    , m_blobWaiters(*allocator, "PakResource::m_blobWaiters")
+    , m_chunkedLoads(*allocator, "PakResource::m_chunkedLoads")
+    , m_baseIndex(nullptr)
+    , m_baseCount(0)
+    , m_sortedIndex(*allocator, "PakResource::m_sortedIndex")
+    , m_resourceIndex(nullptr)
+    , m_resourceCount(0)
+    , m_overlayIndex(*allocator, "PakResource::m_overlayIndex")
+    , m_overlayBuffer(*allocator, "PakResource::m_overlayBuffer")
     , m_loadedResourceData(*allocator, "PakResource::m_loadedResourceData")
     , m_resourceStates(*allocator, "PakResource::m_resourceStates")
-    , m_requestQueue(*allocator, "PakResource::m_requestQueue")
+    , m_immediateQueue(*allocator, "PakResource::m_immediateQueue")
+    , m_prefetchQueue(*allocator, "PakResource::m_prefetchQueue")
+    , m_backgroundQueue(*allocator, "PakResource::m_backgroundQueue")
+    , m_queuedPriorities(*allocator, "PakResource::m_queuedPriorities")
     , m_atlasUVCache(*allocator, "PakResource::m_atlasUVCache")
+    , m_hasAtlasUVTable(false)
+    , m_atlasUVIds(*allocator, "PakResource::m_atlasUVIds")
+    , m_atlasUVs(*allocator, "PakResource::m_atlasUVs")
+    , m_sceneManifests(*allocator, "PakResource::m_sceneManifests")
+    , m_spriteMeshes(*allocator, "PakResource::m_spriteMeshes")
+    , m_pinCounts(*allocator, "PakResource::m_pinCounts")
+    , m_blobPinCounts(*allocator, "PakResource::m_blobPinCounts")
+    , m_tickets(*allocator, "PakResource::m_tickets")
+    , m_nextTicket(RESOURCE_TICKET_INVALID)
+    , m_cacheBudget(0)
+    , m_cachedBytes(0)
+    , m_cacheHits(0)
+    , m_cacheMisses(0)
+    , m_cacheEvictions(0)
+    , m_cacheEvictedBytes(0)
     , m_requestCondition(nullptr)
-    , m_workerThread(nullptr)
+    , m_idleCondition(nullptr)
+    , m_loadedCondition(nullptr)
+    , m_workerCount(0)
+    , m_activeLoads(0)
     , m_workerRunning(true)
     , m_allocator(allocator)
     , m_consoleBuffer(consoleBuffer)
@@ -27,49 +68,112 @@ PakResource::PakResource(MemoryAllocator* allocator, ConsoleBuffer* consoleBuffe
     assert(m_mutex != nullptr);
     m_requestCondition = SDL_CreateCondition();
     assert(m_requestCondition != nullptr);
-    m_workerThread = SDL_CreateThread(resourceWorkerThread, "ResourceWorker", this);
-    assert(m_workerThread != nullptr);
+    m_idleCondition = SDL_CreateCondition();
+    assert(m_idleCondition != nullptr);
+    m_loadedCondition = SDL_CreateCondition();
+    assert(m_loadedCondition != nullptr);
+    SDL_SetAtomicInt(&m_nextWorkerIndex, 0);
+
+    // Default to one worker per core, leaving one for the main thread
+    if (workerCount <= 0) {
+        workerCount = SDL_GetNumLogicalCPUCores() - 1;
+    }
+    if (workerCount < 1) {
+        workerCount = 1;
+    }
+    if (workerCount > PAK_MAX_WORKER_THREADS) {
+        workerCount = PAK_MAX_WORKER_THREADS;
+    }
+    for (int i = 0; i < workerCount; i++) {
+        m_workerThreads[i] = SDL_CreateThread(resourceWorkerThread, "ResourceWorker", this);
+        assert(m_workerThreads[i] != nullptr);
+    }
+    m_workerCount = workerCount;
 }
 
 PakResource::~PakResource() {
     if (m_mutex && m_requestCondition) {
         SDL_LockMutex(m_mutex);
         m_workerRunning = false;
-        SDL_SignalCondition(m_requestCondition);
+        SDL_BroadcastCondition(m_requestCondition);
         SDL_UnlockMutex(m_mutex);
     }
 
-    if (m_workerThread) {
-        SDL_WaitThread(m_workerThread, nullptr);
-        m_workerThread = nullptr;
+    for (int i = 0; i < m_workerCount; i++) {
+        SDL_WaitThread(m_workerThreads[i], nullptr);
+        m_workerThreads[i] = nullptr;
     }
+    m_workerCount = 0;
 
     if (m_requestCondition) {
         SDL_DestroyCondition(m_requestCondition);
         m_requestCondition = nullptr;
     }
 
+    if (m_idleCondition) {
+        SDL_DestroyCondition(m_idleCondition);
+        m_idleCondition = nullptr;
+    }
+
+    if (m_loadedCondition) {
+        SDL_DestroyCondition(m_loadedCondition);
+        m_loadedCondition = nullptr;
+    }
+
+    // Tickets that never completed still own their id arrays
+    for (auto it = m_tickets.begin(); it != m_tickets.end(); ++it) {
+        m_allocator->free(it.value().ids);
+    }
+    m_tickets.clear();
+
     // Clean up decompressed data
     for (auto it = m_decompressedData.begin(); it != m_decompressedData.end(); ++it) {
-        Vector<char>* vec = it.value();
-        vec->~Vector<char>();
-        m_allocator->free(vec);
+        destroyEntryLocked(it.value());
     }
     m_decompressedData.clear();
-    m_resourceIndex.clear();
+    m_cachedBytes = 0;
+    m_baseIndex = nullptr;
+    m_baseCount = 0;
+    m_sortedIndex.clear();
+    m_resourceIndex = nullptr;
+    m_resourceCount = 0;
+    m_overlayIndex.clear();
+    m_overlayBuffer.clear();
     m_loadedResourceData.clear();
     m_resourceStates.clear();
-    m_requestQueue.clear();
+    clearRequestQueuesLocked();
     m_pakFileBuffer.clear();
+    m_mappedFile.close();
     m_pakData = {nullptr, 0};
     if (m_mutex) {
         SDL_DestroyMutex(m_mutex);
     }
 }
 
-bool PakResource::load(const char* filename) {
+bool PakResource::load(const char* filename, PakLoadMode mode) {
     if (m_pakData.data) return true; // already loaded
 
+    m_loadMode = mode;
+    if (m_loadMode == PAK_LOAD_MODE_MMAP) {
+        if (m_mappedFile.open(filename)) {
+            m_pakData = ResourceData{(char*)m_mappedFile.data(), m_mappedFile.size(), 0};
+
+            // Resources are fetched individually, so disable kernel readahead across the
+            // whole file and explicitly prefetch only the header and index
+            m_mappedFile.adviseRandom(0, m_pakData.size);
+            if (m_pakData.size >= sizeof(PakFileHeader)) {
+                PakFileHeader* header = (PakFileHeader*)m_pakData.data;
+                m_mappedFile.adviseWillNeed(0, sizeof(PakFileHeader) + (Uint64)header->numResources * sizeof(ResourcePtr));
+            }
+
+            SDL_LockMutex(m_mutex);
+            buildResourceIndexLocked();
+            SDL_UnlockMutex(m_mutex);
+            return true;
+        }
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_DEBUG, "Memory mapping unavailable for %s, reading into memory", filename);
+    }
+
     SDL_IOStream* file = SDL_IOFromFile(filename, "rb");
     if (!file) {
         return false;
@@ -102,280 +206,1497 @@ bool PakResource::load(const char* filename) {
 bool PakResource::reload(const char* filename) {
     SDL_LockMutex(m_mutex);
 
+    // Stop handing out work, then wait for in-flight decompressions that still
+    // read from the current pak data
+    clearRequestQueuesLocked();
+    while (m_activeLoads > 0) {
+        SDL_WaitCondition(m_idleCondition, m_mutex);
+    }
+
     clearResourceCacheLocked();
 
     if (m_pakData.data) {
         m_pakFileBuffer.clear();
+        m_mappedFile.close();
         m_pakData = {nullptr, 0};
     }
 
     SDL_UnlockMutex(m_mutex);
 
-    return load(filename);
+    return load(filename, m_loadMode);
+}
+
+bool PakResource::mountOverlay(const char* filename) {
+    // Overlays only hold what changed since the base pak was built, so they are
+    // always read into memory rather than mapped
+    SDL_IOStream* file = SDL_IOFromFile(filename, "rb");
+    if (!file) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_DEBUG, "No overlay pak at %s", filename);
+        return false;
+    }
+
+    Sint64 fileSize = SDL_GetIOSize(file);
+    Vector<char> buffer(*m_allocator, "PakResource::m_overlayBuffer");
+    if (fileSize > 0) {
+        buffer.resize((Uint64)fileSize);
+    }
+    Uint64 bytesRead = fileSize > 0 ? SDL_ReadIO(file, buffer.data(), (Uint64)fileSize) : 0;
+    SDL_CloseIO(file);
+
+    const PakFileHeader* header = (const PakFileHeader*)buffer.data();
+    if (fileSize <= 0 || bytesRead != (Uint64)fileSize || buffer.size() < sizeof(PakFileHeader) ||
+        SDL_memcmp(header->sig, "PAKO", 4) != 0 || header->version != VERSION_2_0 ||
+        buffer.size() < sizeof(PakFileHeader) + (Uint64)header->numResources * sizeof(ResourcePtr)) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Invalid overlay pak %s", filename);
+        return false;
+    }
+
+    const ResourcePtr* overlayPtrs = (const ResourcePtr*)(buffer.data() + sizeof(PakFileHeader));
+    Uint32 overlayCount = header->numResources;
+    for (Uint32 i = 0; i < overlayCount; i++) {
+        const ResourcePtr& ptr = overlayPtrs[i];
+        if ((i > 0 && overlayPtrs[i - 1].id >= ptr.id) || (ptr.offset & PAK_OVERLAY_OFFSET_FLAG) ||
+            ptr.offset + sizeof(CompressionHeader) > buffer.size()) {
+            m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Overlay pak %s has a malformed index", filename);
+            return false;
+        }
+    }
+
+    SDL_LockMutex(m_mutex);
+
+    if (!m_pakData.data || m_baseIndex == nullptr) {
+        SDL_UnlockMutex(m_mutex);
+        return false;
+    }
+    if (header->pad != basePakStampLocked()) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_WARN, "Overlay pak %s was built against a different pak", filename);
+        SDL_UnlockMutex(m_mutex);
+        return false;
+    }
+
+    // In-flight decompressions may read from the overlay being replaced. Queued
+    // requests stay queued: every id they name is still in the merged table.
+    while (m_activeLoads > 0) {
+        SDL_WaitCondition(m_idleCondition, m_mutex);
+    }
+    assert(m_blobLoads.empty() && m_blobWaiters.empty());
+
+    // Merge the base and overlay tables, both sorted by id. Overlay entries, and
+    // base entries that a previously mounted overlay had replaced, lose their data.
+    Vector<ResourcePtr> merged(*m_allocator, "PakResource::m_overlayIndex");
+    Vector<uint8_t> states(*m_allocator, "PakResource::m_resourceStates");
+    merged.reserve((Uint64)m_baseCount + overlayCount);
+    states.reserve((Uint64)m_baseCount + overlayCount);
+    Uint32 baseIndex = 0;
+    Uint32 overlayIndex = 0;
+    Uint32 invalidated = 0;
+    bool atlasChanged = false;
+    while (baseIndex < m_baseCount || overlayIndex < overlayCount) {
+        ResourcePtr ptr;
+        bool fromOverlay = overlayIndex < overlayCount &&
+                           (baseIndex == m_baseCount || overlayPtrs[overlayIndex].id <= m_baseIndex[baseIndex].id);
+        if (fromOverlay) {
+            ptr = overlayPtrs[overlayIndex++];
+            if (baseIndex < m_baseCount && m_baseIndex[baseIndex].id == ptr.id) {
+                baseIndex++;
+            }
+            const CompressionHeader* comp = (const CompressionHeader*)(buffer.data() + ptr.offset);
+            if (comp->type == RESOURCE_TYPE_IMAGE_ATLAS) {
+                atlasChanged = true;
+            }
+            ptr.offset |= PAK_OVERLAY_OFFSET_FLAG;
+        } else {
+            ptr = m_baseIndex[baseIndex++];
+        }
+
+        const ResourcePtr* current = findResourcePtrLocked(ptr.id);
+        uint8_t state = current ? m_resourceStates[(Uint64)(current - m_resourceIndex)] : (uint8_t)RESOURCE_NOT_REQUESTED;
+        if (fromOverlay || (current != nullptr && current->offset != ptr.offset)) {
+            invalidateResourceLocked(ptr.id);
+            if (state != RESOURCE_QUEUED) {
+                state = RESOURCE_NOT_REQUESTED;
+            }
+            invalidated++;
+        }
+        merged.push_back(ptr);
+        states.push_back(state);
+    }
+
+    // Resources that only the previous overlay had (since deleted from the sources)
+    // leave the table altogether
+    for (Uint32 i = 0; i < m_resourceCount; i++) {
+        const ResourcePtr& ptr = m_resourceIndex[i];
+        if (!(ptr.offset & PAK_OVERLAY_OFFSET_FLAG)) {
+            continue;
+        }
+        Uint32 lo = 0;
+        Uint32 hi = (Uint32)merged.size();
+        while (lo < hi) {
+            Uint32 mid = lo + (hi - lo) / 2;
+            if (merged[mid].id < ptr.id) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == merged.size() || merged[lo].id != ptr.id) {
+            invalidateResourceLocked(ptr.id);
+            m_queuedPriorities.remove(ptr.id);
+        }
+    }
+
+    // Release decompressed blobs nothing points at anymore: everything read from the
+    // previous overlay, and base blobs whose resources all moved to the overlay
+    HashTable<Uint64, Uint8> liveBlobs(*m_allocator, "PakResource::mountOverlay::liveBlobs");
+    for (Uint64 i = 0; i < merged.size(); i++) {
+        if (!(merged[i].offset & PAK_OVERLAY_OFFSET_FLAG) && m_decompressedData.contains(merged[i].offset)) {
+            liveBlobs.insert(merged[i].offset, 1);
+        }
+    }
+    Vector<Uint64> deadBlobs(*m_allocator, "PakResource::mountOverlay::deadBlobs");
+    for (auto it = m_decompressedData.begin(); it != m_decompressedData.end(); ++it) {
+        if (!liveBlobs.contains(it.key())) {
+            deadBlobs.push_back(it.key());
+        }
+    }
+    for (Uint64 i = 0; i < deadBlobs.size(); i++) {
+        DecompressedEntry* entry = *m_decompressedData.find(deadBlobs[i]);
+        m_cachedBytes -= entry->buffer->size();
+        m_decompressedData.remove(deadBlobs[i]);
+        destroyEntryLocked(entry);
+    }
+
+    // UV lookups of unchanged textures stay valid unless an atlas was repacked
+    if (atlasChanged) {
+        m_atlasUVCache.clear();
+    }
+
+    m_overlayBuffer = static_cast<Vector<char>&&>(buffer);
+    m_overlayIndex = static_cast<Vector<ResourcePtr>&&>(merged);
+    m_resourceStates = static_cast<Vector<uint8_t>&&>(states);
+    m_resourceIndex = m_overlayIndex.data();
+    m_resourceCount = (Uint32)m_overlayIndex.size();
+    rebuildBlobPinsLocked();
+    loadSceneManifestsLocked();
+    loadAtlasUVTableLocked();
+    loadSpriteMeshTableLocked();
+
+    m_consoleBuffer->log(SDL_LOG_PRIORITY_INFO, "Mounted overlay pak %s: %u resources, %u invalidated",
+                         filename, overlayCount, invalidated);
+    SDL_UnlockMutex(m_mutex);
+    return true;
+}
+
+Uint32 PakResource::basePakStampLocked() const {
+    // Hash the table as stored in the file; rebuilding the pak changes offsets or
+    // timestamps, which makes overlays built against the old one unmountable
+    const PakFileHeader* header = (const PakFileHeader*)m_pakData.data;
+    return (Uint32)hashBytes(m_pakData.data + sizeof(PakFileHeader), (Uint64)header->numResources * sizeof(ResourcePtr));
+}
+
+void PakResource::invalidateResourceLocked(Uint64 id) {
+    m_loadedResourceData.remove(id);
+    m_atlasUVCache.remove(id);
 }
 
 void PakResource::clearResourceCacheLocked() {
     for (auto it = m_decompressedData.begin(); it != m_decompressedData.end(); ++it) {
-        Vector<char>* vec = it.value();
-        vec->~Vector<char>();
-        m_allocator->free(vec);
+        destroyEntryLocked(it.value());
     }
     m_decompressedData.clear();
+    m_blobPinCounts.clear();
+    m_blobLoads.clear();
+    for (auto it = m_blobWaiters.begin(); it != m_blobWaiters.end(); ++it) {
+        BlobResource* waiter = it.value();
+        while (waiter != nullptr) {
+            BlobResource* next = waiter->next;
+            m_blobResourcePool.destroy(waiter);
+            waiter = next;
+        }
+    }
+    m_blobWaiters.clear();
+    m_cachedBytes = 0;
     m_loadedResourceData.clear();
     m_resourceStates.clear();
-    m_resourceIndex.clear();
-    m_requestQueue.clear();
+    m_baseIndex = nullptr;
+    m_baseCount = 0;
+    m_sortedIndex.clear();
+    m_resourceIndex = nullptr;
+    m_resourceCount = 0;
+    m_overlayIndex.clear();
+    m_overlayBuffer.clear();
+    clearRequestQueuesLocked();
     m_atlasUVCache.clear();
+    m_hasAtlasUVTable = false;
+    m_atlasUVIds.clear();
+    m_atlasUVs.clear();
+    m_sceneManifests.clear();
+    m_spriteMeshes.clear();
 }
 
 void PakResource::buildResourceIndexLocked() {
-    m_resourceIndex.clear();
+    m_baseIndex = nullptr;
+    m_baseCount = 0;
+    m_sortedIndex.clear();
+    m_resourceIndex = nullptr;
+    m_resourceCount = 0;
+    m_overlayIndex.clear();
+    m_overlayBuffer.clear();
     m_loadedResourceData.clear();
     m_resourceStates.clear();
-    m_requestQueue.clear();
+    clearRequestQueuesLocked();
 
     if (!m_pakData.data) {
         return;
     }
 
     PakFileHeader* header = (PakFileHeader*)m_pakData.data;
-    if (SDL_memcmp(header->sig, "PAKC", 4) != 0) {
+    if (m_pakData.size < sizeof(PakFileHeader) || SDL_memcmp(header->sig, "PAKC", 4) != 0) {
         m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Invalid pak file signature");
         return;
     }
+    if (header->version != VERSION_1_0 && header->version != VERSION_2_0) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Unsupported pak file version %u", header->version);
+        return;
+    }
+    if (m_pakData.size < sizeof(PakFileHeader) + (Uint64)header->numResources * sizeof(ResourcePtr)) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Pak file index is truncated");
+        return;
+    }
+
+    const ResourcePtr* ptrs = (const ResourcePtr*)(m_pakData.data + sizeof(PakFileHeader));
+    bool sorted = true;
+    if (header->version == VERSION_2_0) {
+        // One linear pass guards the binary search against a malformed file
+        for (Uint32 i = 1; i < header->numResources; i++) {
+            if (ptrs[i - 1].id >= ptrs[i].id) {
+                m_consoleBuffer->log(SDL_LOG_PRIORITY_WARN, "Pak v2 index is not sorted, sorting a copy");
+                sorted = false;
+                break;
+            }
+        }
+    } else {
+        sorted = false;
+    }
 
-    ResourcePtr* ptrs = (ResourcePtr*)(m_pakData.data + sizeof(PakFileHeader));
-    for (Uint32 i = 0; i < header->numResources; i++) {
-        m_resourceIndex.insert(ptrs[i].id, ptrs[i]);
-        m_resourceStates.insert(ptrs[i].id, RESOURCE_NOT_REQUESTED);
+    if (sorted) {
+        m_baseIndex = ptrs;
+    } else {
+        m_sortedIndex.resize(header->numResources);
+        SDL_memcpy(m_sortedIndex.data(), ptrs, (Uint64)header->numResources * sizeof(ResourcePtr));
+        m_sortedIndex.sort([](const ResourcePtr& a, const ResourcePtr& b) { return a.id < b.id; });
+        m_baseIndex = m_sortedIndex.data();
     }
+    m_baseCount = header->numResources;
+    m_resourceIndex = m_baseIndex;
+    m_resourceCount = m_baseCount;
+    m_resourceStates.resize(m_resourceCount, RESOURCE_NOT_REQUESTED);
+    rebuildBlobPinsLocked();
+
+    loadSceneManifestsLocked();
+    loadAtlasUVTableLocked();
+    loadSpriteMeshTableLocked();
 }
 
-bool PakResource::loadResourceDataLocked(Uint64 id, ResourceData& outData) {
-    ResourceData* loaded = m_loadedResourceData.find(id);
-    if (loaded != nullptr) {
-        outData = *loaded;
-        return true;
+const ResourcePtr* PakResource::findResourcePtrLocked(Uint64 id) const {
+    Uint32 lo = 0;
+    Uint32 hi = m_resourceCount;
+    while (lo < hi) {
+        Uint32 mid = lo + (hi - lo) / 2;
+        if (m_resourceIndex[mid].id < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == m_resourceCount || m_resourceIndex[lo].id != id) {
+        return nullptr;
     }
+    return &m_resourceIndex[lo];
+}
 
-    if (!m_pakData.data) {
-        return false;
+const CompressionHeader* PakResource::findCompressionHeaderLocked(const ResourcePtr* ptr) const {
+    if (ptr->offset & PAK_OVERLAY_OFFSET_FLAG) {
+        return (const CompressionHeader*)(m_overlayBuffer.data() + (ptr->offset & ~PAK_OVERLAY_OFFSET_FLAG));
     }
+    return (const CompressionHeader*)(m_pakData.data + ptr->offset);
+}
 
-    ResourcePtr* ptr = m_resourceIndex.find(id);
+uint8_t* PakResource::findResourceStateLocked(Uint64 id) {
+    const ResourcePtr* ptr = findResourcePtrLocked(id);
     if (ptr == nullptr) {
-        return false;
+        return nullptr;
     }
+    return &m_resourceStates[(Uint64)(ptr - m_resourceIndex)];
+}
 
-    CompressionHeader* comp = (CompressionHeader*)(m_pakData.data + ptr->offset);
-    char* compressedData = (char*)(comp + 1);
-
-    if (comp->compressionType == COMPRESSION_FLAGS_UNCOMPRESSED) {
-        outData = ResourceData{compressedData, comp->decompressedSize, comp->type};
-        m_loadedResourceData.insert(id, outData);
-        return true;
-    }
+void PakResource::loadSceneManifestsLocked() {
+    m_sceneManifests.clear();
 
-    if (comp->compressionType != COMPRESSION_FLAGS_CMPR) {
-        return false;
+    // Manifests are tiny and consulted on every scene push, so they are decoded
+    // up front rather than going through the worker queue
+    const ResourcePtr* ptr = findResourcePtrLocked(hashCString(SCENE_MANIFEST_PATH));
+    if (ptr == nullptr) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_DEBUG, "Pak has no scene manifests");
+        return;
     }
 
-    Vector<char>** cachedDataPtr = m_decompressedData.find(id);
-    if (cachedDataPtr != nullptr) {
-        outData = ResourceData{(char*)(*cachedDataPtr)->data(), comp->decompressedSize, comp->type};
-        m_loadedResourceData.insert(id, outData);
-        return true;
+    if (!decodeResourceLocked(ptr, m_sceneManifests)) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Failed to decompress scene manifests");
+        m_sceneManifests.clear();
+        return;
     }
 
-    void* vecMem = m_allocator->allocate(sizeof(Vector<char>), "PakResource::loadResourceDataLocked::Vector");
-    Vector<char>* decompressed = new (vecMem) Vector<char>(*m_allocator, "PakResource::loadResourceDataLocked::decompressed");
-    decompressed->resize(comp->decompressedSize);
-
-    size_t result = Compress::decompress(compressedData, comp->compressedSize, decompressed->data(), comp->decompressedSize);
-    if (result != (size_t)comp->decompressedSize) {
-        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "CMPR decompression failed for resource %llu", (unsigned long long)id);
-        decompressed->~Vector<char>();
-        m_allocator->free(vecMem);
-        return false;
+    const SceneManifestHeader* header = (const SceneManifestHeader*)m_sceneManifests.data();
+    if (m_sceneManifests.size() < sizeof(SceneManifestHeader) ||
+        m_sceneManifests.size() != sizeof(SceneManifestHeader) + (Uint64)header->numScenes * sizeof(SceneManifestEntry) +
+                                   (Uint64)header->numResourceIds * sizeof(Uint64)) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Scene manifest resource has an invalid size");
+        m_sceneManifests.clear();
     }
-
-    m_decompressedData.insertNew(id, decompressed);
-    outData = ResourceData{(char*)decompressed->data(), comp->decompressedSize, comp->type};
-    m_loadedResourceData.insert(id, outData);
-    return true;
 }
 
-int PakResource::resourceWorkerThread(void* data) {
-    PakResource* resource = (PakResource*)data;
-    assert(resource != nullptr);
+void PakResource::loadAtlasUVTableLocked() {
+    m_hasAtlasUVTable = false;
+    m_atlasUVIds.clear();
+    m_atlasUVs.clear();
 
-    ThreadProfiler& profiler = ThreadProfiler::instance();
-    profiler.registerThread("ResourceWorker");
+    const ResourcePtr* ptr = findResourcePtrLocked(hashCString(ATLAS_UV_TABLE_PATH));
+    if (ptr == nullptr) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_DEBUG, "Pak has no atlas UV table");
+        return;
+    }
 
-    while (true) {
-        profiler.updateThreadState(THREAD_STATE_WAITING);
-        SDL_LockMutex(resource->m_mutex);
+    Vector<char> table(*m_allocator, "PakResource::loadAtlasUVTableLocked::table");
+    if (!decodeResourceLocked(ptr, table)) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Failed to decompress atlas UV table");
+        return;
+    }
 
-        while (resource->m_workerRunning && resource->m_requestQueue.empty()) {
-            SDL_WaitCondition(resource->m_requestCondition, resource->m_mutex);
-        }
+    const AtlasUVTableHeader* header = (const AtlasUVTableHeader*)table.data();
+    if (table.size() < sizeof(AtlasUVTableHeader) ||
+        table.size() != sizeof(AtlasUVTableHeader) + (Uint64)header->numTextures * (sizeof(Uint64) + sizeof(AtlasUVTableEntry))) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Atlas UV table resource has an invalid size");
+        return;
+    }
 
-        if (!resource->m_workerRunning && resource->m_requestQueue.empty()) {
-            SDL_UnlockMutex(resource->m_mutex);
-            break;
+    const Uint64* ids = (const Uint64*)(header + 1);
+    const AtlasUVTableEntry* entries = (const AtlasUVTableEntry*)(ids + header->numTextures);
+    m_atlasUVIds.resize(header->numTextures);
+    m_atlasUVs.resize(header->numTextures);
+    for (Uint32 i = 0; i < header->numTextures; i++) {
+        m_atlasUVIds[i] = ids[i];
+        AtlasUV& uv = m_atlasUVs[i];
+        uv.atlasId = entries[i].atlasId;
+        uv.u0 = entries[i].u0;
+        uv.v0 = entries[i].v0;
+        uv.u1 = entries[i].u1;
+        uv.v1 = entries[i].v1;
+        uv.width = entries[i].width;
+        uv.height = entries[i].height;
+        uv.rotated = (entries[i].flags & ATLAS_UV_ROTATED) != 0;
+        uv.trim[0] = 0.0f;
+        uv.trim[1] = 0.0f;
+        uv.trim[2] = 1.0f;
+        uv.trim[3] = 1.0f;
+        if (uv.width > 0 && uv.height > 0) {
+            uv.trim[0] = (float)entries[i].trimX / uv.width;
+            uv.trim[1] = (float)entries[i].trimY / uv.height;
+            uv.trim[2] = (float)(entries[i].trimX + entries[i].trimWidth) / uv.width;
+            uv.trim[3] = (float)(entries[i].trimY + entries[i].trimHeight) / uv.height;
         }
-
-        Uint64 id = resource->m_requestQueue[0];
-        resource->m_requestQueue.erase(0);
-        resource->m_resourceStates.insert(id, RESOURCE_LOADING);
-
-        profiler.updateThreadState(THREAD_STATE_BUSY);
-        ResourceData outData{nullptr, 0, 0};
-        bool loaded = resource->loadResourceDataLocked(id, outData);
-        resource->m_resourceStates.insert(id, loaded ? RESOURCE_READY : RESOURCE_FAILED);
-        SDL_UnlockMutex(resource->m_mutex);
     }
-
-    return 0;
+    m_hasAtlasUVTable = true;
 }
 
-void PakResource::requestResourceAsync(Uint64 id) {
-    SDL_LockMutex(m_mutex);
+void PakResource::loadSpriteMeshTableLocked() {
+    m_spriteMeshes.clear();
 
-    if (!m_pakData.data) {
-        SDL_UnlockMutex(m_mutex);
+    // Only paks built with --trim-sprites have one
+    const ResourcePtr* ptr = findResourcePtrLocked(hashCString(SPRITE_MESH_TABLE_PATH));
+    if (ptr == nullptr) {
         return;
     }
 
-    if (!m_resourceIndex.contains(id)) {
-        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Resource %llu not found in pak", (unsigned long long)id);
-        SDL_UnlockMutex(m_mutex);
+    if (!decodeResourceLocked(ptr, m_spriteMeshes)) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Failed to decompress sprite mesh table");
+        m_spriteMeshes.clear();
         return;
     }
 
-    uint8_t* state = m_resourceStates.find(id);
-    uint8_t currentState = (state != nullptr) ? *state : RESOURCE_NOT_REQUESTED;
-    if (currentState == RESOURCE_READY || currentState == RESOURCE_LOADING || currentState == RESOURCE_QUEUED) {
-        SDL_UnlockMutex(m_mutex);
-        return;
+    const SpriteMeshTableHeader* header = (const SpriteMeshTableHeader*)m_spriteMeshes.data();
+    if (m_spriteMeshes.size() < sizeof(SpriteMeshTableHeader) ||
+        m_spriteMeshes.size() != sizeof(SpriteMeshTableHeader) +
+                                 (Uint64)header->numSprites * (sizeof(Uint64) + sizeof(SpriteMeshEntry))) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Sprite mesh table resource has an invalid size");
+        m_spriteMeshes.clear();
     }
+}
 
-    m_resourceStates.insert(id, RESOURCE_QUEUED);
-    m_requestQueue.push_back(id);
-    SDL_SignalCondition(m_requestCondition);
+bool PakResource::findDictionaryLocked(const char* stream, Uint32 streamSize, const char*& outDict, Uint32& outDictSize) const {
+    outDict = nullptr;
+    outDictSize = 0;
+    Uint64 dictId = Compress::dictionaryId(stream, streamSize);
+    if (dictId == 0) {
+        return true;
+    }
 
-    SDL_UnlockMutex(m_mutex);
+    const ResourcePtr* ptr = findResourcePtrLocked(dictId);
+    const CompressionHeader* comp = ptr != nullptr ? findCompressionHeaderLocked(ptr) : nullptr;
+    if (comp == nullptr || comp->compressionType != COMPRESSION_FLAGS_UNCOMPRESSED ||
+        comp->type != RESOURCE_TYPE_CMPR_DICTIONARY) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "CMPR dictionary %llu not found in pak", (unsigned long long)dictId);
+        return false;
+    }
+    outDict = (const char*)(comp + 1);
+    outDictSize = comp->decompressedSize;
+    return true;
 }
 
-void PakResource::preloadAllResourcesAsync() {
-    SDL_LockMutex(m_mutex);
+bool PakResource::decodeResourceLocked(const ResourcePtr* ptr, Vector<char>& outData) {
+    const CompressionHeader* comp = findCompressionHeaderLocked(ptr);
+    const char* payload = (const char*)(comp + 1);
+    outData.resize(comp->decompressedSize);
+    if (comp->compressionType == COMPRESSION_FLAGS_UNCOMPRESSED) {
+        SDL_memcpy(outData.data(), payload, comp->decompressedSize);
+        return true;
+    }
+    const char* dict = nullptr;
+    Uint32 dictSize = 0;
+    return comp->compressionType == COMPRESSION_FLAGS_CMPR &&
+           findDictionaryLocked(payload, comp->compressedSize, dict, dictSize) &&
+           Compress::decompressWithDict(payload, comp->compressedSize, dict, dictSize,
+                                        outData.data(), comp->decompressedSize) == comp->decompressedSize;
+}
 
-    for (auto it = m_resourceIndex.begin(); it != m_resourceIndex.end(); ++it) {
-        Uint64 id = it.key();
-        uint8_t* state = m_resourceStates.find(id);
-        uint8_t currentState = (state != nullptr) ? *state : RESOURCE_NOT_REQUESTED;
-        if (currentState == RESOURCE_READY || currentState == RESOURCE_LOADING || currentState == RESOURCE_QUEUED) {
-            continue;
+bool PakResource::findSceneManifestLocked(Uint64 sceneId, const Uint64*& outIds, Uint32& outCount) {
+    if (m_sceneManifests.empty()) {
+        return false;
+    }
+
+    const SceneManifestHeader* header = (const SceneManifestHeader*)m_sceneManifests.data();
+    const SceneManifestEntry* entries = (const SceneManifestEntry*)(header + 1);
+    const Uint64* ids = (const Uint64*)(entries + header->numScenes);
+
+    // Entries are sorted by scene id
+    Uint32 lo = 0;
+    Uint32 hi = header->numScenes;
+    while (lo < hi) {
+        Uint32 mid = lo + (hi - lo) / 2;
+        if (entries[mid].sceneId < sceneId) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
-        m_resourceStates.insert(id, RESOURCE_QUEUED);
-        m_requestQueue.push_back(id);
+    }
+    if (lo == header->numScenes || entries[lo].sceneId != sceneId) {
+        return false;
     }
 
-    SDL_SignalCondition(m_requestCondition);
-    SDL_UnlockMutex(m_mutex);
+    const SceneManifestEntry& entry = entries[lo];
+    if ((Uint64)entry.firstResource + entry.numResources > header->numResourceIds) {
+        return false;
+    }
+    outIds = ids + entry.firstResource;
+    outCount = entry.numResources;
+    return true;
 }
 
-bool PakResource::tryGetResource(Uint64 id, ResourceData& outData) {
-    outData = ResourceData{nullptr, 0, 0};
+bool PakResource::queueResourceLocked(Uint64 id, ResourcePriority priority) {
+    assert(priority < RESOURCE_PRIORITY_COUNT);
 
-    SDL_LockMutex(m_mutex);
+    uint8_t* state = findResourceStateLocked(id);
+    if (state == nullptr) {
+        return false;
+    }
+    uint8_t currentState = *state;
+    if (currentState == RESOURCE_READY || currentState == RESOURCE_LOADING) {
+        return false;
+    }
 
-    ResourceData* loaded = m_loadedResourceData.find(id);
-    if (loaded != nullptr) {
-        outData = *loaded;
-        SDL_UnlockMutex(m_mutex);
+    uint8_t priorityBit = (uint8_t)(1 << priority);
+    if (currentState == RESOURCE_QUEUED) {
+        uint8_t* priorities = m_queuedPriorities.find(id);
+        assert(priorities != nullptr);
+        if (*priorities & priorityBit) {
+            return false;
+        }
+        // Also queue at this class: a promotion if it is higher, and a fallback
+        // that survives cancellation of the other class otherwise
+        *priorities |= priorityBit;
+        requestQueueLocked(priority).push(id);
         return true;
     }
 
-    if (!m_resourceIndex.contains(id)) {
-        SDL_UnlockMutex(m_mutex);
-        return false;
-    }
+    *state = RESOURCE_QUEUED;
+    m_queuedPriorities.insert(id, priorityBit);
+    requestQueueLocked(priority).push(id);
 
-    uint8_t* state = m_resourceStates.find(id);
-    uint8_t currentState = (state != nullptr) ? *state : RESOURCE_NOT_REQUESTED;
+    // Start paging the resource in now so the worker doesn't stall on faults later
+    readAheadLocked(findResourcePtrLocked(id));
+    return true;
+}
 
-    if (currentState == RESOURCE_NOT_REQUESTED || currentState == RESOURCE_FAILED) {
-        m_resourceStates.insert(id, RESOURCE_QUEUED);
-        m_requestQueue.push_back(id);
-        SDL_SignalCondition(m_requestCondition);
+void PakResource::readAheadLocked(const ResourcePtr* ptr) {
+    if (m_mappedFile.isOpen() && !(ptr->offset & PAK_OVERLAY_OFFSET_FLAG)) {
+        const CompressionHeader* comp = findCompressionHeaderLocked(ptr);
+        Uint64 payloadSize = (comp->compressionType == COMPRESSION_FLAGS_UNCOMPRESSED) ? comp->decompressedSize : comp->compressedSize;
+        m_mappedFile.adviseWillNeed(ptr->offset, sizeof(CompressionHeader) + payloadSize);
     }
+}
 
-    SDL_UnlockMutex(m_mutex);
+bool PakResource::isUploadOnlyLocked(const ResourcePtr* ptr) const {
+    // Texture headers stay: atlas UV lookups read them on the CPU
+    const CompressionHeader* comp = findCompressionHeaderLocked(ptr);
+    return comp->type == RESOURCE_TYPE_IMAGE_ATLAS ||
+           (comp->type == RESOURCE_TYPE_IMAGE && comp->decompressedSize != sizeof(TextureHeader));
+}
+
+bool PakResource::queueBulkResourceLocked(Uint64 id, ResourcePriority priority) {
+    const ResourcePtr* ptr = findResourcePtrLocked(id);
+    if (ptr == nullptr) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Resource %llu not found in pak", (unsigned long long)id);
+        return false;
+    }
+    if (!isUploadOnlyLocked(ptr)) {
+        return queueResourceLocked(id, priority);
+    }
+    readAheadLocked(ptr);
     return false;
 }
 
-bool PakResource::areAllResourcesReady() {
-    SDL_LockMutex(m_mutex);
-    for (auto it = m_resourceIndex.begin(); it != m_resourceIndex.end(); ++it) {
-        uint8_t* state = m_resourceStates.find(it.key());
-        if (state == nullptr || *state != RESOURCE_READY) {
-            SDL_UnlockMutex(m_mutex);
-            return false;
+Uint32 PakResource::queueResourcesLocked(const Uint64* ids, Uint32 count, ResourcePriority priority) {
+    Uint32 queued = 0;
+    for (Uint32 i = 0; i < count; i++) {
+        if (findResourcePtrLocked(ids[i]) == nullptr) {
+            m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Resource %llu not found in pak", (unsigned long long)ids[i]);
+            continue;
+        }
+        if (queueResourceLocked(ids[i], priority)) {
+            queued++;
         }
     }
-    SDL_UnlockMutex(m_mutex);
-    return true;
+    return queued;
 }
 
-bool PakResource::hasResource(Uint64 id) {
-    SDL_LockMutex(m_mutex);
+bool PakResource::popRequestLocked(Uint64& outId) {
+    if (!hasQueuedRequestsLocked()) {
+        // Only stale entries can be left behind
+        clearRequestQueuesLocked();
+        return false;
+    }
 
-    bool exists = m_resourceIndex.contains(id);
-    SDL_UnlockMutex(m_mutex);
-    return exists;
+    for (int p = 0; p < RESOURCE_PRIORITY_COUNT; p++) {
+        Queue<Uint64>& queue = requestQueueLocked((ResourcePriority)p);
+        uint8_t priorityBit = (uint8_t)(1 << p);
+        while (!queue.empty()) {
+            Uint64 id = queue.front();
+            queue.pop();
+            uint8_t* priorities = m_queuedPriorities.find(id);
+            if (priorities != nullptr && (*priorities & priorityBit)) {
+                m_queuedPriorities.remove(id);
+                outId = id;
+                return true;
+            }
+        }
+    }
+    return false;
 }
 
-bool PakResource::tryGetAtlasUV(Uint64 textureId, AtlasUV& uv) {
-    SDL_LockMutex(m_mutex);
+Queue<Uint64>& PakResource::requestQueueLocked(ResourcePriority priority) {
+    switch (priority) {
+        case RESOURCE_PRIORITY_IMMEDIATE: return m_immediateQueue;
+        case RESOURCE_PRIORITY_PREFETCH:  return m_prefetchQueue;
+        default:                          return m_backgroundQueue;
+    }
+}
 
-    // Check cache first
-    AtlasUV* cachedUV = m_atlasUVCache.find(textureId);
-    if (cachedUV != nullptr) {
-        uv = *cachedUV;
-        SDL_UnlockMutex(m_mutex);
+void PakResource::clearRequestQueuesLocked() {
+    m_immediateQueue.clear();
+    m_prefetchQueue.clear();
+    m_backgroundQueue.clear();
+    m_queuedPriorities.clear();
+}
+
+bool PakResource::beginResourceLoadLocked(Uint64 id, ResourceData& outData, PendingDecompress& pending) {
+    pending.target = nullptr;
+    pending.waiting = false;
+
+    ResourceData* loaded = m_loadedResourceData.find(id);
+    if (loaded != nullptr) {
+        outData = *loaded;
         return true;
     }
 
-    SDL_UnlockMutex(m_mutex);
-
-    ResourceData resData;
-    if (!tryGetResource(textureId, resData)) {
+    if (!m_pakData.data) {
         return false;
     }
 
-    if (!resData.data || resData.size < sizeof(TextureHeader)) {
-        return false;  // Not a texture or not found
+    const ResourcePtr* ptr = findResourcePtrLocked(id);
+    if (ptr == nullptr) {
+        return false;
     }
 
-    // Check if this is a TextureHeader (atlas reference)
-    // Use sizeof() for size comparison to stay in sync with structure definition
-    if (resData.size == sizeof(TextureHeader)) {
-        TextureHeader* texHeader = (TextureHeader*)resData.data;
+    const CompressionHeader* comp = findCompressionHeaderLocked(ptr);
+    char* compressedData = (char*)(comp + 1);
 
-        uv.atlasId = texHeader->atlasId;
+    if (comp->compressionType == COMPRESSION_FLAGS_UNCOMPRESSED) {
+        outData = ResourceData{compressedData, comp->decompressedSize, comp->type};
+        m_loadedResourceData.insert(id, outData);
+        return true;
+    }
 
-        // UV coordinate layout in TextureHeader.coordinates[8]:
-        //   [0,1] = bottom-left  (u0, v_bottom)
-        //   [2,3] = bottom-right (u1, v_bottom)
-        //   [4,5] = top-right    (u1, v_top)
-        //   [6,7] = top-left     (u0, v_top)
-        // Extract bounds: u0 from index 0, u1 from index 2
-        //                 v_top from index 7, v_bottom from index 1
-        uv.u0 = texHeader->coordinates[0];  // left u (from bottom-left)
-        uv.u1 = texHeader->coordinates[2];  // right u (from bottom-right)
-        uv.v0 = texHeader->coordinates[7];  // top v (from top-left)
-        uv.v1 = texHeader->coordinates[1];  // bottom v (from bottom-left)
+    if (comp->compressionType != COMPRESSION_FLAGS_CMPR) {
+        return false;
+    }
+
+    DecompressedEntry** cachedEntry = m_decompressedData.find(ptr->offset);
+    if (cachedEntry != nullptr) {
+        outData = ResourceData{(char*)(*cachedEntry)->buffer->data(), comp->decompressedSize, comp->type};
+        m_loadedResourceData.insert(id, outData);
+        addBlobResourceLocked(*cachedEntry, id);
+        return true;
+    }
+
+    const char* dict = nullptr;
+    Uint32 dictSize = 0;
+    if (!findDictionaryLocked(compressedData, comp->compressedSize, dict, dictSize)) {
+        return false;
+    }
+
+    // A resource sharing this blob is being decompressed right now; its worker
+    // publishes this id as well when it finishes
+    if (m_blobLoads.contains(ptr->offset)) {
+        BlobResource* waiter = m_blobResourcePool.create();
+        waiter->id = id;
+        BlobResource** waiters = m_blobWaiters.find(ptr->offset);
+        if (waiters != nullptr) {
+            waiter->next = *waiters;
+            *waiters = waiter;
+        } else {
+            waiter->next = nullptr;
+            m_blobWaiters.insert(ptr->offset, waiter);
+        }
+        pending.waiting = true;
+        return false;
+    }
+    m_blobLoads.insert(ptr->offset, id);
+
+    m_cacheMisses++;
+
+    Vector<char>* decompressed = m_bufferPool.create(*m_allocator, "PakResource::beginResourceLoadLocked::decompressed");
+    decompressed->resize(comp->decompressedSize);
+
+    pending.id = id;
+    pending.blobOffset = ptr->offset;
+    pending.source = compressedData;
+    pending.sourceOffset = ptr->offset + sizeof(CompressionHeader);
+    pending.compressedSize = comp->compressedSize;
+    pending.decompressedSize = comp->decompressedSize;
+    pending.type = comp->type;
+    pending.dict = dict;
+    pending.dictSize = dictSize;
+    pending.target = decompressed;
+    return false;
+}
+
+bool PakResource::finishResourceLoadLocked(PendingDecompress& pending, bool decompressed, ResourceData& outData) {
+    assert(pending.target != nullptr);
+    m_blobLoads.remove(pending.blobOffset);
+
+    if (!decompressed) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "CMPR decompression failed for resource %llu", (unsigned long long)pending.id);
+        m_bufferPool.destroy(pending.target);
+        pending.target = nullptr;
+        resolveBlobWaitersLocked(pending.blobOffset, nullptr);
+        return false;
+    }
+
+    // The compressed bytes are no longer needed; let the kernel drop those pages
+    if (m_mappedFile.isOpen() && !(pending.sourceOffset & PAK_OVERLAY_OFFSET_FLAG)) {
+        m_mappedFile.adviseDontNeed(pending.sourceOffset, pending.compressedSize);
+    }
+
+    DecompressedEntry* entry = m_entryPool.create();
+    entry->buffer = pending.target;
+    entry->blobOffset = pending.blobOffset;
+    entry->resources = nullptr;
+    entry->lruPrev = nullptr;
+    entry->lruNext = nullptr;
+    entry->inLru = false;
+    if (!m_blobPinCounts.contains(pending.blobOffset)) {
+        linkLruLocked(entry);
+    }
+    m_decompressedData.insertNew(pending.blobOffset, entry);
+    m_cachedBytes += pending.decompressedSize;
+    outData = ResourceData{(char*)pending.target->data(), pending.decompressedSize, pending.type};
+    m_loadedResourceData.insert(pending.id, outData);
+    addBlobResourceLocked(entry, pending.id);
+    pending.target = nullptr;
+    resolveBlobWaitersLocked(pending.blobOffset, &outData);
+    return true;
+}
+
+void PakResource::startChunkedLoadLocked(const PendingDecompress& pending, Uint32 chunkCount) {
+    assert(pending.target != nullptr && chunkCount > 1);
+    void* mem = m_allocator->allocate(sizeof(ChunkedDecompress), "PakResource::ChunkedDecompress");
+    ChunkedDecompress* load = new (mem) ChunkedDecompress;
+    load->pending = pending;
+    load->chunkCount = chunkCount;
+    load->nextChunk = 0;
+    load->chunksLeft = chunkCount;
+    load->failed = false;
+    m_chunkedLoads.push_back(load);
+    // The source stays referenced until the last chunk is done
+    m_activeLoads++;
+    SDL_BroadcastCondition(m_requestCondition);
+}
+
+bool PakResource::claimChunkLocked(ChunkedDecompress*& outLoad, Uint32& outChunk) {
+    if (m_chunkedLoads.empty()) {
+        return false;
+    }
+    ChunkedDecompress* load = m_chunkedLoads[0];
+    outLoad = load;
+    outChunk = load->nextChunk++;
+    if (load->nextChunk == load->chunkCount) {
+        m_chunkedLoads.erase(0);
+    }
+    return true;
+}
+
+void PakResource::finishChunkLocked(ChunkedDecompress* load, bool decompressed) {
+    if (!decompressed) {
+        load->failed = true;
+    }
+    assert(load->chunksLeft > 0);
+    if (--load->chunksLeft > 0) {
+        return;
+    }
+
+    m_activeLoads--;
+    ResourceData outData;
+    bool loaded = finishResourceLoadLocked(load->pending, !load->failed, outData);
+    uint8_t* state = findResourceStateLocked(load->pending.id);
+    assert(state != nullptr);
+    *state = loaded ? RESOURCE_READY : RESOURCE_FAILED;
+    SDL_BroadcastCondition(m_loadedCondition);
+    if (m_activeLoads == 0) {
+        SDL_BroadcastCondition(m_idleCondition);
+    }
+
+    load->~ChunkedDecompress();
+    m_allocator->free(load);
+}
+
+void PakResource::resolveBlobWaitersLocked(Uint64 blobOffset, const ResourceData* data) {
+    BlobResource** waitersPtr = m_blobWaiters.find(blobOffset);
+    if (waitersPtr == nullptr) {
+        return;
+    }
+    BlobResource* waiter = *waitersPtr;
+    m_blobWaiters.remove(blobOffset);
+
+    DecompressedEntry** entry = data != nullptr ? m_decompressedData.find(blobOffset) : nullptr;
+    while (waiter != nullptr) {
+        BlobResource* next = waiter->next;
+        Uint64 id = waiter->id;
+        m_blobResourcePool.destroy(waiter);
+        waiter = next;
+
+        uint8_t* state = findResourceStateLocked(id);
+        assert(state != nullptr);
+        if (data != nullptr) {
+            m_loadedResourceData.insert(id, *data);
+            if (entry != nullptr) {
+                addBlobResourceLocked(*entry, id);
+            }
+            *state = RESOURCE_READY;
+        } else {
+            *state = RESOURCE_FAILED;
+        }
+    }
+}
+
+void PakResource::touchResourceLocked(Uint64 id) {
+    const ResourcePtr* ptr = findResourcePtrLocked(id);
+    if (ptr == nullptr) {
+        return;
+    }
+    DecompressedEntry** entry = m_decompressedData.find(ptr->offset);
+    if (entry != nullptr && (*entry)->inLru && *entry != m_lruHead) {
+        unlinkLruLocked(*entry);
+        linkLruLocked(*entry);
+    }
+}
+
+void PakResource::enforceCacheBudgetLocked() {
+    if (m_cacheBudget == 0) {
+        return;
+    }
+
+    // Pinned blobs are kept off the list, so the tail is always evictable. The
+    // most recently used entry stays even if it alone exceeds the budget, or a
+    // resource needed every frame would be decompressed every frame.
+    while (m_cachedBytes > m_cacheBudget && m_lruTail != nullptr && m_lruTail != m_lruHead) {
+        evictBlobLocked(m_lruTail);
+    }
+}
+
+void PakResource::evictBlobLocked(DecompressedEntry* entry) {
+    assert(entry->inLru);
+    Uint64 size = entry->buffer->size();
+
+    // Only the resources published from this blob point into its buffer. An
+    // overlay may have moved one of them to another blob since.
+    for (BlobResource* resource = entry->resources; resource != nullptr; resource = resource->next) {
+        const ResourcePtr* ptr = findResourcePtrLocked(resource->id);
+        if (ptr != nullptr && ptr->offset == entry->blobOffset && m_loadedResourceData.remove(resource->id)) {
+            m_resourceStates[(Uint64)(ptr - m_resourceIndex)] = RESOURCE_EVICTED;
+        }
+    }
+
+    m_decompressedData.remove(entry->blobOffset);
+    destroyEntryLocked(entry);
+
+    m_cachedBytes -= size;
+    m_cacheEvictions++;
+    m_cacheEvictedBytes += size;
+}
+
+void PakResource::destroyEntryLocked(DecompressedEntry* entry) {
+    if (entry->inLru) {
+        unlinkLruLocked(entry);
+    }
+    while (entry->resources != nullptr) {
+        BlobResource* next = entry->resources->next;
+        m_blobResourcePool.destroy(entry->resources);
+        entry->resources = next;
+    }
+    m_bufferPool.destroy(entry->buffer);
+    m_entryPool.destroy(entry);
+}
+
+void PakResource::addBlobResourceLocked(DecompressedEntry* entry, Uint64 id) {
+    // A blob is shared by a handful of deduplicated resources at most
+    for (BlobResource* resource = entry->resources; resource != nullptr; resource = resource->next) {
+        if (resource->id == id) {
+            return;
+        }
+    }
+    BlobResource* resource = m_blobResourcePool.create();
+    resource->id = id;
+    resource->next = entry->resources;
+    entry->resources = resource;
+}
+
+void PakResource::linkLruLocked(DecompressedEntry* entry) {
+    assert(!entry->inLru);
+    entry->lruPrev = nullptr;
+    entry->lruNext = m_lruHead;
+    if (m_lruHead != nullptr) {
+        m_lruHead->lruPrev = entry;
+    } else {
+        m_lruTail = entry;
+    }
+    m_lruHead = entry;
+    entry->inLru = true;
+}
+
+void PakResource::unlinkLruLocked(DecompressedEntry* entry) {
+    assert(entry->inLru);
+    if (entry->lruPrev != nullptr) {
+        entry->lruPrev->lruNext = entry->lruNext;
+    } else {
+        m_lruHead = entry->lruNext;
+    }
+    if (entry->lruNext != nullptr) {
+        entry->lruNext->lruPrev = entry->lruPrev;
+    } else {
+        m_lruTail = entry->lruPrev;
+    }
+    entry->lruPrev = nullptr;
+    entry->lruNext = nullptr;
+    entry->inLru = false;
+}
+
+void PakResource::pinBlobLocked(Uint64 blobOffset) {
+    Uint32* count = m_blobPinCounts.find(blobOffset);
+    if (count != nullptr) {
+        (*count)++;
+        return;
+    }
+    m_blobPinCounts.insert(blobOffset, 1);
+    DecompressedEntry** entry = m_decompressedData.find(blobOffset);
+    if (entry != nullptr && (*entry)->inLru) {
+        unlinkLruLocked(*entry);
+    }
+}
+
+void PakResource::unpinBlobLocked(Uint64 blobOffset) {
+    Uint32* count = m_blobPinCounts.find(blobOffset);
+    assert(count != nullptr && *count > 0);
+    if (count == nullptr || --(*count) > 0) {
+        return;
+    }
+    m_blobPinCounts.remove(blobOffset);
+    // Back on the list as the most recently used
+    DecompressedEntry** entry = m_decompressedData.find(blobOffset);
+    if (entry != nullptr && !(*entry)->inLru) {
+        linkLruLocked(*entry);
+    }
+}
+
+void PakResource::rebuildBlobPinsLocked() {
+    m_blobPinCounts.clear();
+    for (auto it = m_pinCounts.begin(); it != m_pinCounts.end(); ++it) {
+        const ResourcePtr* ptr = findResourcePtrLocked(it.key());
+        if (ptr == nullptr) {
+            continue;
+        }
+        Uint32* count = m_blobPinCounts.find(ptr->offset);
+        if (count != nullptr) {
+            *count += it.value();
+        } else {
+            m_blobPinCounts.insert(ptr->offset, it.value());
+        }
+    }
+
+    for (auto it = m_decompressedData.begin(); it != m_decompressedData.end(); ++it) {
+        DecompressedEntry* entry = it.value();
+        bool pinned = m_blobPinCounts.contains(entry->blobOffset);
+        if (pinned && entry->inLru) {
+            unlinkLruLocked(entry);
+        } else if (!pinned && !entry->inLru) {
+            linkLruLocked(entry);
+        }
+    }
+}
+
+int PakResource::resourceWorkerThread(void* data) {
+    PakResource* resource = (PakResource*)data;
+    assert(resource != nullptr);
+
+    char threadName[32];
+    SDL_snprintf(threadName, sizeof(threadName), "ResourceWorker%d", SDL_AddAtomicInt(&resource->m_nextWorkerIndex, 1));
+    ThreadProfiler& profiler = ThreadProfiler::instance();
+    profiler.registerThread(threadName);
+
+    while (true) {
+        profiler.updateThreadState(THREAD_STATE_WAITING);
+        SDL_LockMutex(resource->m_mutex);
+
+        while (resource->m_workerRunning && !resource->hasQueuedRequestsLocked() && resource->m_chunkedLoads.empty()) {
+            SDL_WaitCondition(resource->m_requestCondition, resource->m_mutex);
+        }
+
+        // Help finish blobs that are already being decoded before claiming new ones
+        ChunkedDecompress* chunkedLoad = nullptr;
+        Uint32 chunk = 0;
+        if (resource->claimChunkLocked(chunkedLoad, chunk)) {
+            profiler.updateThreadState(THREAD_STATE_BUSY);
+            SDL_UnlockMutex(resource->m_mutex);
+
+            const PendingDecompress& pending = chunkedLoad->pending;
+            size_t result = Compress::decompressChunk(pending.source, pending.compressedSize, chunk,
+                                                      pending.target->data(), pending.decompressedSize);
+
+            SDL_LockMutex(resource->m_mutex);
+            resource->finishChunkLocked(chunkedLoad, result != 0);
+            SDL_UnlockMutex(resource->m_mutex);
+            continue;
+        }
+
+        Uint64 id = 0;
+        if (!resource->popRequestLocked(id)) {
+            bool running = resource->m_workerRunning;
+            SDL_UnlockMutex(resource->m_mutex);
+            if (!running) {
+                break;
+            }
+            continue;
+        }
+
+        uint8_t* state = resource->findResourceStateLocked(id);
+        assert(state != nullptr);
+        *state = RESOURCE_LOADING;
+
+        profiler.updateThreadState(THREAD_STATE_BUSY);
+        ResourceData outData{nullptr, 0, 0};
+        PendingDecompress pending;
+        bool loaded = resource->beginResourceLoadLocked(id, outData, pending);
+        if (pending.waiting) {
+            // finishResourceLoadLocked() of the resource sharing the blob sets the final state
+            SDL_UnlockMutex(resource->m_mutex);
+            continue;
+        }
+        if (pending.target != nullptr) {
+            // Large blobs are split across every free worker, this one included
+            Uint32 chunkCount = Compress::chunkCount(pending.source, pending.compressedSize);
+            if (chunkCount > 1) {
+                resource->startChunkedLoadLocked(pending, chunkCount);
+                SDL_UnlockMutex(resource->m_mutex);
+                continue;
+            }
+
+            // Decompress without holding the lock so other workers and the main thread
+            // can keep going. reload() waits for m_activeLoads to drain before the pak
+            // data that pending.source points into is released.
+            resource->m_activeLoads++;
+            SDL_UnlockMutex(resource->m_mutex);
+
+            size_t result = Compress::decompressWithDict(pending.source, pending.compressedSize, pending.dict, pending.dictSize,
+                                                         pending.target->data(), pending.decompressedSize);
+
+            SDL_LockMutex(resource->m_mutex);
+            resource->m_activeLoads--;
+            loaded = resource->finishResourceLoadLocked(pending, result == (size_t)pending.decompressedSize, outData);
+            if (resource->m_activeLoads == 0) {
+                SDL_BroadcastCondition(resource->m_idleCondition);
+            }
+        }
+        // Still valid: the state array is only rebuilt once m_activeLoads has drained
+        *state = loaded ? RESOURCE_READY : RESOURCE_FAILED;
+        SDL_BroadcastCondition(resource->m_loadedCondition);
+        SDL_UnlockMutex(resource->m_mutex);
+    }
+
+    return 0;
+}
+
+void PakResource::requestResourceAsync(Uint64 id, ResourcePriority priority) {
+    SDL_LockMutex(m_mutex);
+
+    if (!m_pakData.data) {
+        SDL_UnlockMutex(m_mutex);
+        return;
+    }
+
+    if (findResourcePtrLocked(id) == nullptr) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Resource %llu not found in pak", (unsigned long long)id);
+        SDL_UnlockMutex(m_mutex);
+        return;
+    }
+
+    if (queueResourceLocked(id, priority)) {
+        SDL_SignalCondition(m_requestCondition);
+    }
+
+    SDL_UnlockMutex(m_mutex);
+}
+
+void PakResource::requestResourcesAsync(const Uint64* ids, Uint32 count, ResourcePriority priority) {
+    assert(ids != nullptr || count == 0);
+    SDL_LockMutex(m_mutex);
+
+    if (m_pakData.data && queueResourcesLocked(ids, count, priority) > 0) {
+        SDL_BroadcastCondition(m_requestCondition);
+    }
+
+    SDL_UnlockMutex(m_mutex);
+}
+
+bool PakResource::requestSceneResourcesAsync(Uint64 sceneId, ResourcePriority priority) {
+    SDL_LockMutex(m_mutex);
+
+    if (!m_pakData.data) {
+        SDL_UnlockMutex(m_mutex);
+        return false;
+    }
+
+    const Uint64* ids = &sceneId;
+    Uint32 count = 1;
+    bool found = findSceneManifestLocked(sceneId, ids, count);
+
+    Uint32 queued = 0;
+    for (Uint32 i = 0; i < count; i++) {
+        if (queueBulkResourceLocked(ids[i], priority)) {
+            queued++;
+        }
+    }
+    if (queued > 0) {
+        SDL_BroadcastCondition(m_requestCondition);
+    }
+    m_consoleBuffer->log(SDL_LOG_PRIORITY_VERBOSE, "Scene %llu: queued %u of %u manifest resources",
+                         (unsigned long long)sceneId, queued, count);
+
+    SDL_UnlockMutex(m_mutex);
+    return found;
+}
+
+void PakResource::preloadAllResourcesAsync() {
+    SDL_LockMutex(m_mutex);
+
+    for (Uint32 i = 0; i < m_resourceCount; i++) {
+        queueBulkResourceLocked(m_resourceIndex[i].id, RESOURCE_PRIORITY_BACKGROUND);
+    }
+
+    SDL_BroadcastCondition(m_requestCondition);
+    SDL_UnlockMutex(m_mutex);
+}
+
+bool PakResource::tryGetResource(Uint64 id, ResourceData& outData) {
+    outData = ResourceData{nullptr, 0, 0};
+
+    SDL_LockMutex(m_mutex);
+
+    ResourceData* loaded = m_loadedResourceData.find(id);
+    if (loaded != nullptr) {
+        outData = *loaded;
+        m_cacheHits++;
+        touchResourceLocked(id);
+        SDL_UnlockMutex(m_mutex);
+        return true;
+    }
+
+    if (findResourcePtrLocked(id) == nullptr) {
+        SDL_UnlockMutex(m_mutex);
+        return false;
+    }
+
+    // Queue (or promote) the request - the caller needs it now
+    if (queueResourceLocked(id, RESOURCE_PRIORITY_IMMEDIATE)) {
+        SDL_SignalCondition(m_requestCondition);
+    }
+
+    SDL_UnlockMutex(m_mutex);
+    return false;
+}
+
+bool PakResource::tryGetResources(const Uint64* ids, Uint32 count, ResourceData* outData, ResourcePriority priority) {
+    assert(ids != nullptr || count == 0);
+    assert(outData != nullptr || count == 0);
+
+    SDL_LockMutex(m_mutex);
+
+    bool allReady = true;
+    bool queued = false;
+    for (Uint32 i = 0; i < count; i++) {
+        ResourceData* loaded = m_loadedResourceData.find(ids[i]);
+        if (loaded != nullptr) {
+            outData[i] = *loaded;
+            m_cacheHits++;
+            touchResourceLocked(ids[i]);
+            continue;
+        }
+
+        outData[i] = ResourceData{nullptr, 0, 0};
+        allReady = false;
+        if (findResourcePtrLocked(ids[i]) == nullptr) {
+            m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Resource %llu not found in pak", (unsigned long long)ids[i]);
+            continue;
+        }
+        if (queueResourceLocked(ids[i], priority)) {
+            queued = true;
+        }
+    }
+
+    if (queued) {
+        SDL_BroadcastCondition(m_requestCondition);
+    }
+
+    SDL_UnlockMutex(m_mutex);
+    return allReady;
+}
+
+bool PakResource::getResource(Uint64 id, ResourceData& outData) {
+    return getResources(&id, 1, &outData);
+}
+
+bool PakResource::getResources(const Uint64* ids, Uint32 count, ResourceData* outData) {
+    if (tryGetResources(ids, count, outData)) {
+        return true;
+    }
+
+    // The data is only evicted by trimCache() on the main thread, so it is still
+    // cached once the ticket has completed and released its pins
+    ResourceTicket ticket = requestResourceTicket(ids, count);
+    if (!waitForResourceTicket(ticket)) {
+        return false;
+    }
+    return tryGetResources(ids, count, outData);
+}
+
+ResourceTicket PakResource::requestResourceTicket(const Uint64* ids, Uint32 count, ResourcePriority priority,
+                                                  ResourceTicketCallback callback, void* userData) {
+    assert(ids != nullptr || count == 0);
+
+    TicketEntry ticket;
+    ticket.ids = (Uint64*)m_allocator->allocate(sizeof(Uint64) * (count > 0 ? count : 1), "PakResource::TicketEntry::ids");
+    assert(ticket.ids != nullptr);
+    if (count > 0) {
+        SDL_memcpy(ticket.ids, ids, sizeof(Uint64) * count);
+    }
+    ticket.count = count;
+    ticket.priority = priority;
+    ticket.callback = callback;
+    ticket.userData = userData;
+
+    SDL_LockMutex(m_mutex);
+
+    if (++m_nextTicket == RESOURCE_TICKET_INVALID) {
+        ++m_nextTicket;
+    }
+    ResourceTicket handle = m_nextTicket;
+
+    for (Uint32 i = 0; i < count; i++) {
+        pinResourceLocked(ids[i]);
+    }
+    if (queueResourcesLocked(ids, count, priority) > 0) {
+        SDL_BroadcastCondition(m_requestCondition);
+    }
+    m_tickets.insertNew(handle, ticket);
+
+    SDL_UnlockMutex(m_mutex);
+    return handle;
+}
+
+bool PakResource::isTicketCompleteLocked(const TicketEntry& ticket, bool& outLoaded) {
+    outLoaded = true;
+    bool complete = true;
+    bool requeued = false;
+    for (Uint32 i = 0; i < ticket.count; i++) {
+        uint8_t* state = findResourceStateLocked(ticket.ids[i]);
+        if (state == nullptr || *state == RESOURCE_FAILED) {
+            outLoaded = false;
+            continue;
+        }
+        if (*state == RESOURCE_READY) {
+            continue;
+        }
+        complete = false;
+        if (queueResourceLocked(ticket.ids[i], ticket.priority)) {
+            requeued = true;
+        }
+    }
+    if (requeued) {
+        SDL_BroadcastCondition(m_requestCondition);
+    }
+    return complete;
+}
+
+void PakResource::completeTicket(TicketEntry& ticket, bool loaded) {
+    if (ticket.callback != nullptr) {
+        ticket.callback(loaded, ticket.userData);
+    }
+
+    SDL_LockMutex(m_mutex);
+    for (Uint32 i = 0; i < ticket.count; i++) {
+        unpinResourceLocked(ticket.ids[i]);
+    }
+    SDL_UnlockMutex(m_mutex);
+
+    m_allocator->free(ticket.ids);
+    ticket.ids = nullptr;
+}
+
+void PakResource::dispatchResourceTickets() {
+    // Callbacks may request more resources or tickets, so each one runs unlocked
+    while (true) {
+        SDL_LockMutex(m_mutex);
+        ResourceTicket completed = RESOURCE_TICKET_INVALID;
+        TicketEntry ticket;
+        bool loaded = false;
+        for (auto it = m_tickets.begin(); it != m_tickets.end(); ++it) {
+            if (isTicketCompleteLocked(it.value(), loaded)) {
+                completed = it.key();
+                ticket = it.value();
+                break;
+            }
+        }
+        if (completed != RESOURCE_TICKET_INVALID) {
+            m_tickets.remove(completed);
+        }
+        SDL_UnlockMutex(m_mutex);
+
+        if (completed == RESOURCE_TICKET_INVALID) {
+            return;
+        }
+        completeTicket(ticket, loaded);
+    }
+}
+
+bool PakResource::waitForResourceTicket(ResourceTicket ticket) {
+    SDL_LockMutex(m_mutex);
+
+    TicketEntry* entry = m_tickets.find(ticket);
+    if (entry == nullptr) {
+        // Unknown or already dispatched
+        SDL_UnlockMutex(m_mutex);
+        return false;
+    }
+
+    bool loaded = false;
+    while (!isTicketCompleteLocked(*entry, loaded)) {
+        SDL_WaitCondition(m_loadedCondition, m_mutex);
+        // Another thread may have dispatched it while we were waiting
+        entry = m_tickets.find(ticket);
+        if (entry == nullptr) {
+            SDL_UnlockMutex(m_mutex);
+            return false;
+        }
+    }
+    TicketEntry completed = *entry;
+    m_tickets.remove(ticket);
+
+    SDL_UnlockMutex(m_mutex);
+
+    completeTicket(completed, loaded);
+    return loaded;
+}
+
+void PakResource::cancelQueuedRequests(ResourcePriority priority) {
+    SDL_LockMutex(m_mutex);
+
+    Queue<Uint64>& queue = requestQueueLocked(priority);
+    uint8_t priorityBit = (uint8_t)(1 << priority);
+    Uint32 cancelled = 0;
+    for (Uint64 i = 0; i < queue.size(); i++) {
+        Uint64 id = queue[i];
+        uint8_t* priorities = m_queuedPriorities.find(id);
+        if (priorities == nullptr || !(*priorities & priorityBit)) {
+            continue;
+        }
+        *priorities &= (uint8_t)~priorityBit;
+        if (*priorities == 0) {
+            m_queuedPriorities.remove(id);
+            *findResourceStateLocked(id) = RESOURCE_NOT_REQUESTED;
+            cancelled++;
+        }
+    }
+    queue.clear();
+
+    if (cancelled > 0) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_DEBUG, "Cancelled %u queued resource requests", cancelled);
+    }
+
+    SDL_UnlockMutex(m_mutex);
+}
+
+bool PakResource::areAllResourcesReady() {
+    SDL_LockMutex(m_mutex);
+    for (Uint32 i = 0; i < m_resourceCount; i++) {
+        uint8_t state = m_resourceStates[i];
+        // Evicted resources finished loading once; the budget just didn't let them stay.
+        // Textures and atlases are not preloaded, the renderer loads them on first use.
+        if (state != RESOURCE_READY && state != RESOURCE_EVICTED &&
+            !(state == RESOURCE_NOT_REQUESTED && isUploadOnlyLocked(&m_resourceIndex[i]))) {
+            SDL_UnlockMutex(m_mutex);
+            return false;
+        }
+    }
+    SDL_UnlockMutex(m_mutex);
+    return true;
+}
+
+bool PakResource::hasResource(Uint64 id) {
+    SDL_LockMutex(m_mutex);
+
+    bool exists = findResourcePtrLocked(id) != nullptr;
+    SDL_UnlockMutex(m_mutex);
+    return exists;
+}
+
+Sint32 PakResource::findAtlasUVIndex(Uint64 textureId) const {
+    Uint32 lo = 0;
+    Uint32 hi = (Uint32)m_atlasUVIds.size();
+    while (lo < hi) {
+        Uint32 mid = lo + (hi - lo) / 2;
+        if (m_atlasUVIds[mid] < textureId) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == m_atlasUVIds.size() || m_atlasUVIds[lo] != textureId) {
+        return -1;
+    }
+    return (Sint32)lo;
+}
+
+bool PakResource::tryGetSpriteMesh(Uint64 textureId, SpriteMeshEntry& mesh) const {
+    if (m_spriteMeshes.empty()) {
+        return false;
+    }
+
+    const SpriteMeshTableHeader* header = (const SpriteMeshTableHeader*)m_spriteMeshes.data();
+    const Uint64* ids = (const Uint64*)(header + 1);
+    const SpriteMeshEntry* entries = (const SpriteMeshEntry*)(ids + header->numSprites);
+    Uint32 lo = 0;
+    Uint32 hi = header->numSprites;
+    while (lo < hi) {
+        Uint32 mid = lo + (hi - lo) / 2;
+        if (ids[mid] < textureId) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == header->numSprites || ids[lo] != textureId || entries[lo].numVertices > SPRITE_MESH_MAX_VERTICES) {
+        return false;
+    }
+    mesh = entries[lo];
+    return true;
+}
+
+bool PakResource::tryGetAtlasUV(Uint64 textureId, AtlasUV& uv) {
+    if (m_hasAtlasUVTable) {
+        Sint32 index = findAtlasUVIndex(textureId);
+        if (index < 0) {
+            return false;  // Standalone image or not a texture
+        }
+        uv = m_atlasUVs[(Uint64)index];
+        return true;
+    }
+
+    // Held throughout (it is recursive), so the texture and atlas data read
+    // below cannot be evicted underneath us by trimCache() on another thread
+    SDL_LockMutex(m_mutex);
+
+    // Check cache first
+    AtlasUV* cachedUV = m_atlasUVCache.find(textureId);
+    if (cachedUV != nullptr) {
+        uv = *cachedUV;
+        SDL_UnlockMutex(m_mutex);
+        return true;
+    }
+
+    ResourceData resData;
+    if (!tryGetResource(textureId, resData)) {
+        SDL_UnlockMutex(m_mutex);
+        return false;
+    }
+
+    if (!resData.data || resData.size < sizeof(TextureHeader)) {
+        SDL_UnlockMutex(m_mutex);
+        return false;  // Not a texture or not found
+    }
+
+    // Check if this is a TextureHeader (atlas reference)
+    // Use sizeof() for size comparison to stay in sync with structure definition
+    if (resData.size == sizeof(TextureHeader)) {
+        TextureHeader* texHeader = (TextureHeader*)resData.data;
+
+        uv.atlasId = texHeader->atlasId;
+
+        // UV coordinate layout in TextureHeader.coordinates[8], corners of the image:
+        //   [0,1] = bottom-left, [2,3] = bottom-right, [4,5] = top-right, [6,7] = top-left
+        // The bottom-left corner sits on the left and the top-right on the right
+        // of the atlas region. A rotated image (turned clockwise) has its
+        // bottom-left at the region's top and its top-left at the region's right.
+        const f32_t* c = texHeader->coordinates;
+        uv.rotated = c[0] != c[6];
+        uv.u0 = c[0];
+        uv.u1 = c[4];
+        uv.v0 = uv.rotated ? c[1] : c[5];
+        uv.v1 = uv.rotated ? c[5] : c[1];
+
+        // Texture headers carry no trim rect; packs with --trim-sprites also
+        // write the UV table, so this path only serves untrimmed ones
+        uv.trim[0] = 0.0f;
+        uv.trim[1] = 0.0f;
+        uv.trim[2] = 1.0f;
+        uv.trim[3] = 1.0f;
 
         // Initialize dimensions to 0 (will be set from atlas entry)
         uv.width = 0;
@@ -383,8 +1704,8 @@ bool PakResource::tryGetAtlasUV(Uint64 textureId, AtlasUV& uv) {
 
         // Get atlas to determine original dimensions
         ResourceData atlasData;
-        if (tryGetResource(texHeader->atlasId, atlasData)) {
-        if (atlasData.data && atlasData.size >= sizeof(AtlasHeader)) {
+        bool haveAtlas = tryGetResource(texHeader->atlasId, atlasData);
+        if (haveAtlas && atlasData.data && atlasData.size >= sizeof(AtlasHeader)) {
             AtlasHeader* atlasHeader = (AtlasHeader*)atlasData.data;
             AtlasEntry* entries = (AtlasEntry*)(atlasData.data + sizeof(AtlasHeader));
 
@@ -397,16 +1718,18 @@ bool PakResource::tryGetAtlasUV(Uint64 textureId, AtlasUV& uv) {
                 }
             }
         }
+
+        // Cache the result once the dimensions are known; the atlas may be
+        // loading or have been evicted from the resource cache
+        if (haveAtlas) {
+            m_atlasUVCache.insert(textureId, uv);
         }
 
-        // Cache the result
-        SDL_LockMutex(m_mutex);
-        m_atlasUVCache.insert(textureId, uv);
         SDL_UnlockMutex(m_mutex);
-
         return true;
     }
 
+    SDL_UnlockMutex(m_mutex);
     return false;  // Not an atlas reference (standalone image)
 }
 
@@ -426,10 +1749,175 @@ bool PakResource::tryGetAtlasData(Uint64 atlasId, ResourceData& outData) {
     return true;
 }
 
+bool PakResource::getResourceInfo(Uint64 id, Uint64& outSize, Uint32& outType) {
+    SDL_LockMutex(m_mutex);
+    const ResourcePtr* ptr = findResourcePtrLocked(id);
+    if (ptr != nullptr) {
+        const CompressionHeader* comp = findCompressionHeaderLocked(ptr);
+        outSize = comp->decompressedSize;
+        outType = comp->type;
+    }
+    SDL_UnlockMutex(m_mutex);
+    return ptr != nullptr;
+}
+
+bool PakResource::loadResourceInto(Uint64 id, void* dst, Uint64 dstCapacity) {
+    assert(dst != nullptr);
+    SDL_LockMutex(m_mutex);
+
+    const ResourcePtr* ptr = findResourcePtrLocked(id);
+    if (ptr == nullptr) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Resource %llu not found in pak", (unsigned long long)id);
+        SDL_UnlockMutex(m_mutex);
+        return false;
+    }
+    const CompressionHeader* comp = findCompressionHeaderLocked(ptr);
+    Uint32 decompressedSize = comp->decompressedSize;
+    if (decompressedSize > dstCapacity) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Resource %llu (%u bytes) does not fit in %llu bytes",
+                             (unsigned long long)id, decompressedSize, (unsigned long long)dstCapacity);
+        SDL_UnlockMutex(m_mutex);
+        return false;
+    }
+
+    DecompressedEntry** cached = m_decompressedData.find(ptr->offset);
+    if (cached != nullptr) {
+        SDL_memcpy(dst, (*cached)->buffer->data(), decompressedSize);
+        touchResourceLocked(id);
+        SDL_UnlockMutex(m_mutex);
+        return true;
+    }
+
+    const char* payload = (const char*)(comp + 1);
+    bool compressed = comp->compressionType != COMPRESSION_FLAGS_UNCOMPRESSED;
+    const char* dict = nullptr;
+    Uint32 dictSize = 0;
+    if (compressed && (comp->compressionType != COMPRESSION_FLAGS_CMPR ||
+                       !findDictionaryLocked(payload, comp->compressedSize, dict, dictSize))) {
+        SDL_UnlockMutex(m_mutex);
+        return false;
+    }
+    Uint32 compressedSize = comp->compressedSize;
+    Uint64 sourceOffset = ptr->offset + sizeof(CompressionHeader);
+
+    // Decode outside the lock like the workers do; the pak data stays in place
+    // until m_activeLoads drains
+    m_activeLoads++;
+    SDL_UnlockMutex(m_mutex);
+
+    bool loaded = true;
+    if (compressed) {
+        loaded = Compress::decompressWithDict(payload, compressedSize, dict, dictSize, dst, decompressedSize) == decompressedSize;
+    } else {
+        SDL_memcpy(dst, payload, decompressedSize);
+    }
+
+    SDL_LockMutex(m_mutex);
+    m_activeLoads--;
+    if (m_activeLoads == 0) {
+        SDL_BroadcastCondition(m_idleCondition);
+    }
+    if (!loaded) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "CMPR decompression failed for resource %llu", (unsigned long long)id);
+    } else if (compressed) {
+        m_cacheMisses++;
+        if (m_mappedFile.isOpen() && !(sourceOffset & PAK_OVERLAY_OFFSET_FLAG)) {
+            m_mappedFile.adviseDontNeed(sourceOffset, compressedSize);
+        }
+    }
+    SDL_UnlockMutex(m_mutex);
+    return loaded;
+}
+
 bool PakResource::isResourceReady(Uint64 id) {
     SDL_LockMutex(m_mutex);
-    uint8_t* state = m_resourceStates.find(id);
+    uint8_t* state = findResourceStateLocked(id);
     bool ready = (state != nullptr && *state == RESOURCE_READY);
     SDL_UnlockMutex(m_mutex);
     return ready;
-}
\ No newline at end of file
+}
+
+void PakResource::setCacheBudget(Uint64 bytes) {
+    SDL_LockMutex(m_mutex);
+    m_cacheBudget = bytes;
+    SDL_UnlockMutex(m_mutex);
+}
+
+void PakResource::trimCache() {
+    SDL_LockMutex(m_mutex);
+    enforceCacheBudgetLocked();
+    SDL_UnlockMutex(m_mutex);
+}
+
+void PakResource::pinResource(Uint64 id) {
+    SDL_LockMutex(m_mutex);
+    pinResourceLocked(id);
+    SDL_UnlockMutex(m_mutex);
+}
+
+void PakResource::unpinResource(Uint64 id) {
+    SDL_LockMutex(m_mutex);
+    unpinResourceLocked(id);
+    SDL_UnlockMutex(m_mutex);
+}
+
+void PakResource::pinSceneResources(Uint64 sceneId, Vector<Uint64>& outIds) {
+    SDL_LockMutex(m_mutex);
+
+    pinResourceLocked(sceneId);
+    outIds.push_back(sceneId);
+
+    const Uint64* ids = nullptr;
+    Uint32 count = 0;
+    if (findSceneManifestLocked(sceneId, ids, count)) {
+        for (Uint32 i = 0; i < count; i++) {
+            pinResourceLocked(ids[i]);
+            outIds.push_back(ids[i]);
+        }
+    }
+
+    SDL_UnlockMutex(m_mutex);
+}
+
+void PakResource::pinResourceLocked(Uint64 id) {
+    Uint32* count = m_pinCounts.find(id);
+    if (count != nullptr) {
+        (*count)++;
+    } else {
+        m_pinCounts.insert(id, 1);
+    }
+    const ResourcePtr* ptr = findResourcePtrLocked(id);
+    if (ptr != nullptr) {
+        pinBlobLocked(ptr->offset);
+    }
+}
+
+void PakResource::unpinResourceLocked(Uint64 id) {
+    Uint32* count = m_pinCounts.find(id);
+    assert(count != nullptr && *count > 0);
+    if (count != nullptr) {
+        (*count)--;
+        if (*count == 0) {
+            m_pinCounts.remove(id);
+        }
+        const ResourcePtr* ptr = findResourcePtrLocked(id);
+        if (ptr != nullptr) {
+            unpinBlobLocked(ptr->offset);
+        }
+    }
+}
+
+ResourceCacheStats PakResource::getCacheStats() {
+    SDL_LockMutex(m_mutex);
+    ResourceCacheStats stats;
+    stats.budgetBytes = m_cacheBudget;
+    stats.cachedBytes = m_cachedBytes;
+    stats.cachedCount = m_decompressedData.size();
+    stats.pinnedCount = m_pinCounts.size();
+    stats.hits = m_cacheHits;
+    stats.misses = m_cacheMisses;
+    stats.evictions = m_cacheEvictions;
+    stats.evictedBytes = m_cacheEvictedBytes;
+    SDL_UnlockMutex(m_mutex);
+    return stats;
+}
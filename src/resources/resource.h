@@ -3,7 +3,10 @@
 #include <SDL3/SDL.h>
 #include "../core/Vector.h"
 #include "../core/HashTable.h"
+#include "../core/Queue.h"
 #include "../core/ResourceTypes.h"
+#include "../memory/ObjectPool.h"
+#include "MappedFile.h"
 
 // Forward declarations
 class MemoryAllocator;
@@ -22,56 +25,325 @@ struct AtlasUV {
     float u1, v1;       // Top-right UV
     Uint16 width;     // Original image width
     Uint16 height;    // Original image height
+    bool rotated;     // Stored turned 90 degrees clockwise, see atlasImageUV()
+    float trim[4];    // Part of the image held by the region, s0, t0, s1, t1 (0, 0, 1, 1 untrimmed), see atlasTrimST()
+};
+
+// Decompressed resource cache counters (for the ImGui memory window)
+struct ResourceCacheStats {
+    Uint64 budgetBytes;    // 0 = unlimited
+    Uint64 cachedBytes;    // Decompressed bytes currently resident
+    Uint32 cachedCount;
+    Uint32 pinnedCount;
+    Uint64 hits;           // tryGetResource calls served from memory
+    Uint64 misses;         // Decompressions performed
+    Uint64 evictions;
+    Uint64 evictedBytes;
+};
+
+// Upper bound on decompression worker threads
+#define PAK_MAX_WORKER_THREADS 16
+
+// Request priority classes, served strictly in this order
+enum ResourcePriority : Uint8 {
+    RESOURCE_PRIORITY_IMMEDIATE = 0,   // Needed by the current frame
+    RESOURCE_PRIORITY_PREFETCH = 1,    // Needed by an upcoming scene
+    RESOURCE_PRIORITY_BACKGROUND = 2,  // Bulk preloading
+    RESOURCE_PRIORITY_COUNT = 3
+};
+
+// Handle for a requested resource set; RESOURCE_TICKET_INVALID is never issued
+typedef Uint32 ResourceTicket;
+#define RESOURCE_TICKET_INVALID 0
+
+// Ticket completion callback; loaded is false if any resource of the set failed
+typedef void (*ResourceTicketCallback)(bool loaded, void* userData);
+
+// How the pak file is brought into memory
+enum PakLoadMode : Uint8 {
+    PAK_LOAD_MODE_READ = 0,  // Read the whole file into a heap buffer
+    PAK_LOAD_MODE_MMAP = 1   // Map the file and fault pages in on demand (falls back to READ if unsupported)
 };
 
 class PakResource {
 public:
-    PakResource(MemoryAllocator* allocator, ConsoleBuffer* consoleBuffer);
+    // workerCount <= 0 sizes the decompression pool from the logical core count
+    PakResource(MemoryAllocator* allocator, ConsoleBuffer* consoleBuffer, int workerCount = 0);
     ~PakResource();
-    bool load(const char* filename);
+    bool load(const char* filename, PakLoadMode mode = PAK_LOAD_MODE_MMAP);
     bool reload(const char* filename);
+    // Mounts a packer --overlay pak over the loaded pak, replacing any overlay
+    // mounted before. Only resources whose data changed are invalidated; the rest
+    // of the cache stays warm. Returns false, leaving the current state untouched,
+    // if the overlay is missing, malformed or was built against a different pak.
+    bool mountOverlay(const char* filename);
+
+    // True when the pak is served from a file mapping rather than a heap copy
+    bool isMapped() const { return m_mappedFile.isOpen(); }
 
     // Async-only resource API
-    void requestResourceAsync(Uint64 id);
+    // Requesting an already queued id at a higher priority promotes it
+    void requestResourceAsync(Uint64 id, ResourcePriority priority = RESOURCE_PRIORITY_IMMEDIATE);
+    // Queues a batch of resources under one lock and wakes the workers once
+    void requestResourcesAsync(const Uint64* ids, Uint32 count, ResourcePriority priority = RESOURCE_PRIORITY_IMMEDIATE);
+    // Queues a scene script followed by every resource in its packer-generated
+    // manifest. Returns false (and queues only the script) when the pak has no
+    // manifest for the scene.
+    bool requestSceneResourcesAsync(Uint64 sceneId, ResourcePriority priority = RESOURCE_PRIORITY_IMMEDIATE);
     void preloadAllResourcesAsync();
+    // Queues missing resources at RESOURCE_PRIORITY_IMMEDIATE
     bool tryGetResource(Uint64 id, ResourceData& outData);
+    // Batch form of tryGetResource: fills outData[i] for every ready id under one
+    // lock and queues the rest. Returns true when all of them are ready.
+    bool tryGetResources(const Uint64* ids, Uint32 count, ResourceData* outData,
+                         ResourcePriority priority = RESOURCE_PRIORITY_IMMEDIATE);
+    // Blocking forms for loads that cannot be deferred, such as scene scripts and
+    // the shaders a scene builds its pipelines from. Wait on a ticket when the data
+    // is not cached; return false only if a resource is missing or fails to load.
+    bool getResource(Uint64 id, ResourceData& outData);
+    bool getResources(const Uint64* ids, Uint32 count, ResourceData* outData);
+
+    // Queues a set of resources and returns a ticket that completes once every one
+    // has loaded or failed. The set stays pinned until the ticket's callback has
+    // run, which happens on the thread calling dispatchResourceTickets() or
+    // waitForResourceTicket().
+    ResourceTicket requestResourceTicket(const Uint64* ids, Uint32 count,
+                                         ResourcePriority priority = RESOURCE_PRIORITY_IMMEDIATE,
+                                         ResourceTicketCallback callback = nullptr, void* userData = nullptr);
+    // Fires the callbacks of completed tickets; call once per frame on the main thread
+    void dispatchResourceTickets();
+    // Blocks until the ticket completes and fires its callback on the calling thread.
+    // Returns true if every resource loaded.
+    bool waitForResourceTicket(ResourceTicket ticket);
+    // Drop queued requests of one priority class that have not started loading.
+    // Ids also requested at another class stay queued there.
+    void cancelQueuedRequests(ResourcePriority priority);
     bool areAllResourcesReady();
 
     bool hasResource(Uint64 id);
 
-    // Non-blocking atlas helpers (return false when still loading/not atlas)
+    // Non-blocking atlas helpers (return false when still loading/not atlas).
+    // Served from the atlas UV table without locking when the pak has one.
     bool tryGetAtlasUV(Uint64 textureId, AtlasUV& uv);
 
+    // Packer-built UV table of every atlased texture, decoded when the pak loads.
+    // It only changes in load(), reload() and mountOverlay(), so it is read without
+    // locking. Returns -1 for textures that are not in an atlas (or if the pak has
+    // no table); the index stays valid until the pak is reloaded or overlaid.
+    Sint32 findAtlasUVIndex(Uint64 textureId) const;
+    const AtlasUV& getAtlasUV(Sint32 index) const { return m_atlasUVs[(Uint64)index]; }
+
+    // Trim rect and outline of a sprite trimmed by the packer, from the sprite
+    // mesh table, read without locking like the UV table. Returns false for
+    // untrimmed textures.
+    bool tryGetSpriteMesh(Uint64 textureId, SpriteMeshEntry& mesh) const;
+
     // Non-blocking atlas data access
     bool tryGetAtlasData(Uint64 atlasId, ResourceData& outData);
 
+    // Decompressed size and type of a resource, without loading it
+    bool getResourceInfo(Uint64 id, Uint64& outSize, Uint32& outType);
+    // Decompresses a resource on the calling thread straight into caller memory,
+    // such as a mapped staging buffer, or copies it there if it is cached. The
+    // cache is left alone, so data on its way to the GPU never gets a long-lived
+    // CPU copy. Returns false if the resource is missing, corrupt or does not fit.
+    bool loadResourceInto(Uint64 id, void* dst, Uint64 dstCapacity);
+
     bool isResourceReady(Uint64 id);
 
+    // Decompressed data is kept within this budget by evicting the least recently
+    // used resources; 0 disables eviction. Eviction only happens in trimCache(), so
+    // pointers returned by tryGetResource stay valid until its next call; keep a
+    // resource pinned to hold on to its data longer. Pins are refcounted and may be
+    // taken before the resource has loaded.
+    void setCacheBudget(Uint64 bytes);
+    // Evicts down to the cache budget; call once per frame on the main thread
+    void trimCache();
+    void pinResource(Uint64 id);
+    void unpinResource(Uint64 id);
+    // Pins a scene script and every resource in its manifest, appending their ids
+    // to outIds. Unpin exactly those ids later, since an overlay may change the
+    // manifest while the scene is live.
+    void pinSceneResources(Uint64 sceneId, Vector<Uint64>& outIds);
+    ResourceCacheStats getCacheStats();
+
 private:
     enum ResourceLoadState : uint8_t {
         RESOURCE_NOT_REQUESTED = 0,
         RESOURCE_QUEUED = 1,
         RESOURCE_LOADING = 2,
         RESOURCE_READY = 3,
-        RESOURCE_FAILED = 4
+        RESOURCE_FAILED = 4,
+        RESOURCE_EVICTED = 5   // Was ready, dropped from the cache; reloads on next request
+    };
+
+    // A resource id whose m_loadedResourceData points into a cached blob
+    struct BlobResource {
+        Uint64 id;
+        BlobResource* next;
+    };
+
+    // A decompressed CMPR blob, shared by every resource the packer deduplicated onto it
+    struct DecompressedEntry {
+        Vector<char>* buffer;
+        Uint64 blobOffset;
+        BlobResource* resources;     // Ids published from this blob, cleared on eviction
+        DecompressedEntry* lruPrev;  // Unpinned entries, most recently used first
+        DecompressedEntry* lruNext;
+        bool inLru;                  // False while a resource on the blob is pinned
+    };
+
+    struct TicketEntry {
+        Uint64* ids;
+        Uint32 count;
+        ResourcePriority priority;
+        ResourceTicketCallback callback;
+        void* userData;
+    };
+
+    // A CMPR resource claimed by a worker and decompressed outside m_mutex
+    struct PendingDecompress {
+        Uint64 id;
+        Uint64 blobOffset;         // Offset of the CompressionHeader; shared by deduplicated resources
+        bool waiting;              // Another worker is already decompressing this blob
+        const char* source;
+        Uint64 sourceOffset;
+        Uint32 compressedSize;
+        Uint32 decompressedSize;
+        Uint32 type;
+        const char* dict;          // Shared dictionary the stream was compressed with, if any
+        Uint32 dictSize;
+        Vector<char>* target;
+    };
+
+    // A chunked CMPR blob whose chunks are decoded by whichever workers are free;
+    // the worker that finishes the last chunk completes the load
+    struct ChunkedDecompress {
+        PendingDecompress pending;
+        Uint32 chunkCount;
+        Uint32 nextChunk;          // Next chunk to hand out
+        Uint32 chunksLeft;         // Chunks not decoded yet, including ones in flight
+        bool failed;
     };
 
     static int resourceWorkerThread(void* data);
-    bool loadResourceDataLocked(Uint64 id, ResourceData& outData);
+    // Returns true if the resource is available immediately. Otherwise, pending.target
+    // is set when the caller must decompress into it and call finishResourceLoadLocked(),
+    // and pending.waiting when the load completes with another resource sharing the blob.
+    bool beginResourceLoadLocked(Uint64 id, ResourceData& outData, PendingDecompress& pending);
+    bool finishResourceLoadLocked(PendingDecompress& pending, bool decompressed, ResourceData& outData);
+    // Publishes the chunks of a claimed multi-chunk blob to all workers
+    void startChunkedLoadLocked(const PendingDecompress& pending, Uint32 chunkCount);
+    bool claimChunkLocked(ChunkedDecompress*& outLoad, Uint32& outChunk);
+    void finishChunkLocked(ChunkedDecompress* load, bool decompressed);
     void clearResourceCacheLocked();
+    void touchResourceLocked(Uint64 id);
+    void enforceCacheBudgetLocked();
+    void evictBlobLocked(DecompressedEntry* entry);
+    // Frees the entry and its buffer; the caller removes it from m_decompressedData
+    void destroyEntryLocked(DecompressedEntry* entry);
+    void addBlobResourceLocked(DecompressedEntry* entry, Uint64 id);
+    void linkLruLocked(DecompressedEntry* entry);
+    void unlinkLruLocked(DecompressedEntry* entry);
+    void pinBlobLocked(Uint64 blobOffset);
+    void unpinBlobLocked(Uint64 blobOffset);
+    // Recomputes m_blobPinCounts from m_pinCounts after the id -> blob mapping changed
+    void rebuildBlobPinsLocked();
+    void resolveBlobWaitersLocked(Uint64 blobOffset, const ResourceData* data);
+    void pinResourceLocked(Uint64 id);
+    void unpinResourceLocked(Uint64 id);
+    // True once every id of the ticket is ready or failed; requeues ids that were
+    // cancelled or evicted in the meantime
+    bool isTicketCompleteLocked(const TicketEntry& ticket, bool& outLoaded);
+    // Called without m_mutex held, after the ticket was removed from m_tickets
+    void completeTicket(TicketEntry& ticket, bool loaded);
     void buildResourceIndexLocked();
+    const ResourcePtr* findResourcePtrLocked(Uint64 id) const;
+    const CompressionHeader* findCompressionHeaderLocked(const ResourcePtr* ptr) const;
+    // Resolves the shared dictionary a CMPR stream needs, if any. Dictionaries are
+    // stored uncompressed, so outDict points into the pak data.
+    bool findDictionaryLocked(const char* stream, Uint32 streamSize, const char*& outDict, Uint32& outDictSize) const;
+    Uint32 basePakStampLocked() const;
+    // Drops the cached data of a resource whose bytes are about to change
+    void invalidateResourceLocked(Uint64 id);
+    uint8_t* findResourceStateLocked(Uint64 id);
+    bool queueResourceLocked(Uint64 id, ResourcePriority priority);
+    // Preloading and scene manifests leave textures and atlases to the renderer,
+    // which loads them with loadResourceInto(); their pages are only read ahead
+    bool isUploadOnlyLocked(const ResourcePtr* ptr) const;
+    void readAheadLocked(const ResourcePtr* ptr);
+    bool queueBulkResourceLocked(Uint64 id, ResourcePriority priority);
+    Uint32 queueResourcesLocked(const Uint64* ids, Uint32 count, ResourcePriority priority);
+    // Decodes a small resource on the calling thread, bypassing the workers and the cache
+    bool decodeResourceLocked(const ResourcePtr* ptr, Vector<char>& outData);
+    void loadSceneManifestsLocked();
+    void loadAtlasUVTableLocked();
+    void loadSpriteMeshTableLocked();
+    bool findSceneManifestLocked(Uint64 sceneId, const Uint64*& outIds, Uint32& outCount);
+    bool popRequestLocked(Uint64& outId);
+    bool hasQueuedRequestsLocked() const { return !m_queuedPriorities.empty(); }
+    Queue<Uint64>& requestQueueLocked(ResourcePriority priority);
+    void clearRequestQueuesLocked();
 
     ResourceData m_pakData;
     Vector<char> m_pakFileBuffer;
-    HashTable<Uint64, Vector<char>*> m_decompressedData;
-    HashTable<Uint64, ResourcePtr> m_resourceIndex;
+    MappedFile m_mappedFile;
+    PakLoadMode m_loadMode;
+    // Keyed by blob offset so resources the packer deduplicated share one buffer
+    HashTable<Uint64, DecompressedEntry*> m_decompressedData;
+    // Pools are unsynchronised; like everything else here they are only used under m_mutex
+    ObjectPool<DecompressedEntry> m_entryPool;
+    ObjectPool<Vector<char>> m_bufferPool;     // Headers of the m_decompressedData buffers
+    ObjectPool<BlobResource> m_blobResourcePool;  // Nodes of the entry resource lists and m_blobWaiters
+    DecompressedEntry* m_lruHead;              // Least recently used unpinned entry is m_lruTail
+    DecompressedEntry* m_lruTail;
+    HashTable<Uint64, Uint64> m_blobLoads;     // Blob offset -> resource id decompressing it
+    HashTable<Uint64, BlobResource*> m_blobWaiters;   // Blob offset -> ids waiting on its decompression
+    Vector<ChunkedDecompress*> m_chunkedLoads;  // Chunked blobs with chunks left to hand out, oldest first
+    // Base resource table sorted by id: points into the pak data for v2 paks, or
+    // at m_sortedIndex for v1 paks whose table is in packing order
+    const ResourcePtr* m_baseIndex;
+    Uint32 m_baseCount;
+    Vector<ResourcePtr> m_sortedIndex;
+    // Table lookups go through: m_baseIndex, or m_overlayIndex while an overlay is mounted
+    const ResourcePtr* m_resourceIndex;
+    Uint32 m_resourceCount;
+    // Base table merged with the mounted overlay's; entries taken from the overlay
+    // carry PAK_OVERLAY_OFFSET_FLAG in their offset
+    Vector<ResourcePtr> m_overlayIndex;
+    Vector<char> m_overlayBuffer;
     HashTable<Uint64, ResourceData> m_loadedResourceData;
-    HashTable<Uint64, uint8_t> m_resourceStates;
-    Vector<Uint64> m_requestQueue;
-    HashTable<Uint64, AtlasUV> m_atlasUVCache;  // Cache of atlas UV lookups
+    Vector<uint8_t> m_resourceStates;   // ResourceLoadState per m_resourceIndex slot
+    Queue<Uint64> m_immediateQueue;
+    Queue<Uint64> m_prefetchQueue;
+    Queue<Uint64> m_backgroundQueue;
+    // Bitmask of priority classes each queued id was requested at. Queue entries
+    // whose class bit is no longer set (claimed, cancelled) are skipped when popped.
+    HashTable<Uint64, uint8_t> m_queuedPriorities;
+    HashTable<Uint64, AtlasUV> m_atlasUVCache;  // Cache of atlas UV lookups for paks without a UV table
+    bool m_hasAtlasUVTable;
+    Vector<Uint64> m_atlasUVIds;                // ATLAS_UV_TABLE_PATH texture ids, ascending
+    Vector<AtlasUV> m_atlasUVs;                 // Parallel to m_atlasUVIds
+    Vector<char> m_sceneManifests;              // Decompressed SCENE_MANIFEST_PATH resource, empty if absent
+    Vector<char> m_spriteMeshes;                // Decompressed SPRITE_MESH_TABLE_PATH resource, empty if absent
+    HashTable<Uint64, Uint32> m_pinCounts;
+    HashTable<Uint64, Uint32> m_blobPinCounts;  // Blob offset -> pins of the resources on it
+    HashTable<ResourceTicket, TicketEntry> m_tickets;
+    ResourceTicket m_nextTicket;
+    Uint64 m_cacheBudget;
+    Uint64 m_cachedBytes;
+    Uint64 m_cacheHits;
+    Uint64 m_cacheMisses;
+    Uint64 m_cacheEvictions;
+    Uint64 m_cacheEvictedBytes;
     SDL_Mutex* m_mutex;
     SDL_Condition* m_requestCondition;
-    SDL_Thread* m_workerThread;
+    SDL_Condition* m_idleCondition;      // Signalled when m_activeLoads drops to zero
+    SDL_Condition* m_loadedCondition;    // Broadcast whenever a resource finishes loading
+    SDL_Thread* m_workerThreads[PAK_MAX_WORKER_THREADS];
+    int m_workerCount;
+    int m_activeLoads;                   // Decompressions running outside m_mutex
+    SDL_AtomicInt m_nextWorkerIndex;
     bool m_workerRunning;
     MemoryAllocator* m_allocator;
     ConsoleBuffer* m_consoleBuffer;
@@ -225,25 +225,17 @@ const CharacterDef* DialogueManager::loadCharacter(Uint64 characterId) {
         for (int p = 0; p < def.numPortraits; p++) {
             SDL_strlcpy(def.portraits[p].tag, entries[p].tag, CHARACTER_MAX_TAG);
             Uint64 texId = hashCString(entries[p].resourcePath);
-            pakResource_->requestResourceAsync(texId);
             def.portraits[p].textureId = texId;
 
             // Upload the portrait texture to the GPU so the sprite pipeline can
             // render it.  Mirror what LuaInterface::loadTexture() does: handle
             // the atlas case (packer packs small images into atlases).
-            ResourceData texResData{nullptr, 0, 0};
-            if (pakResource_->tryGetResource(texId, texResData) && texResData.data) {
-                AtlasUV atlasUV;
-                if (pakResource_->tryGetAtlasUV(texId, atlasUV)) {
-                    // Atlas-packed: load the atlas image into the GPU.
-                    pakResource_->requestResourceAsync(atlasUV.atlasId);
-                    ResourceData atlasData{nullptr, 0, 0};
-                    if (pakResource_->tryGetResource(atlasUV.atlasId, atlasData) && atlasData.data) {
-                        renderer_->loadAtlasTexture(atlasUV.atlasId, atlasData);
-                    }
-                } else {
-                    renderer_->loadTexture(texId, texResData);
-                }
+            AtlasUV atlasUV;
+            if (pakResource_->tryGetAtlasUV(texId, atlasUV)) {
+                // Atlas-packed: load the atlas image into the GPU.
+                renderer_->loadAtlasTexture(atlasUV.atlasId, *pakResource_);
+            } else {
+                renderer_->loadTexture(texId, *pakResource_);
             }
         }
     }
@@ -556,7 +548,11 @@ void DialogueManager::showLine(int lineIndex, Uint64 sceneId) {
             AtlasUV atlasUV;
             if (pakResource_->tryGetAtlasUV(newTex, atlasUV)) {
                 layerManager_->setLayerAtlasUV(portraitLayerId_,
-                    atlasUV.atlasId, atlasUV.u0, atlasUV.v0, atlasUV.u1, atlasUV.v1);
+                    atlasUV.atlasId, atlasUV.u0, atlasUV.v0, atlasUV.u1, atlasUV.v1, atlasUV.rotated, atlasUV.trim);
+                SpriteMeshEntry mesh;
+                if (pakResource_->tryGetSpriteMesh(newTex, mesh) && mesh.numVertices >= 3) {
+                    layerManager_->setLayerOutline(portraitLayerId_, mesh.points, (int)mesh.numVertices);
+                }
             }
 
             layerManager_->setLayerPosition(portraitLayerId_, px, py);
@@ -14,11 +14,6 @@
 
 // MAX_WATER_POLYGON_VERTICES defined in WaterEffect.h
 
-static bool requestAndTryResource(PakResource& pakResource, Uint64 resourceId, ResourceData& outData) {
-    pakResource.requestResourceAsync(resourceId);
-    return pakResource.tryGetResource(resourceId, outData);
-}
-
 LuaInterface::LuaInterface(PakResource& pakResource, VulkanRenderer& renderer, MemoryAllocator* allocator,
                            Box2DPhysics* physics, SceneLayerManager* layerManager, AudioManager* audioManager,
                            ParticleSystemManager* particleManager, WaterEffectManager* waterEffectManager,
@@ -27,6 +22,7 @@ LuaInterface::LuaInterface(PakResource& pakResource, VulkanRenderer& renderer, M
     : pakResource_(pakResource), renderer_(renderer), sceneManager_(sceneManager), vibrationManager_(vibrationManager),
       pipelineIndex_(0), currentSceneId_(0),
       scenePipelines_(*allocator, "LuaInterface::scenePipelines"),
+      scenePinnedResources_(*allocator, "LuaInterface::scenePinnedResources"),
       waterFieldShaderMap_(*allocator, "LuaInterface::waterFieldShaderMap"),
       waterFieldLayerMap_(*allocator, "LuaInterface::waterFieldLayerMap"),
       particlePipelineCache_(*allocator, "LuaInterface::particlePipelineCache"),
@@ -100,6 +96,11 @@ LuaInterface::~LuaInterface() {
     }
     scenePipelines_.clear();
 
+    // Release the pak pins of scenes that were never cleaned up
+    while (!scenePinnedResources_.empty()) {
+        unpinSceneResources(scenePinnedResources_.begin().key());
+    }
+
     if (fontManager_) {
         fontManager_->~FontManager();
         stringAllocator_->free(fontManager_);
@@ -540,6 +541,15 @@ void LuaInterface::loadScene(Uint64 sceneId, const ResourceData& scriptData) {
 
 void LuaInterface::initScene(Uint64 sceneId) {
     currentSceneId_ = sceneId;
+
+    // Keep the scene's script and manifest resident for as long as it is live
+    if (scenePinnedResources_.find(sceneId) == nullptr) {
+        void* vectorMem = stringAllocator_->allocate(sizeof(Vector<Uint64>), "LuaInterface::initScene::Vector");
+        assert(vectorMem != nullptr);
+        Vector<Uint64>* pins = new (vectorMem) Vector<Uint64>(*stringAllocator_, "LuaInterface::initScene::pins");
+        pakResource_.pinSceneResources(sceneId, *pins);
+        scenePinnedResources_.insertNew(sceneId, pins);
+    }
     // Get the scene table from registry
     lua_pushinteger(luaState_, sceneId);
     lua_gettable(luaState_, LUA_REGISTRYINDEX);
@@ -927,12 +937,69 @@ void LuaInterface::cleanupScene(Uint64 sceneId) {
     // Clear particle pipeline cache since pipelines are destroyed
     particlePipelineCache_.clear();
 
+    // The pak may evict the scene's resources again
+    unpinSceneResources(sceneId);
+
     // Reset camera
     cameraOffsetX_ = 0.0f;
     cameraOffsetY_ = 0.0f;
     cameraZoom_ = 1.0f;
 }
 
+bool LuaInterface::getSceneResource(Uint64 resourceId, ResourceData& outData) {
+    if (!pakResource_.getResource(resourceId, outData)) {
+        return false;
+    }
+    pinSceneResource(resourceId);
+    return true;
+}
+
+bool LuaInterface::getSceneShaders(Uint64 vertId, Uint64 fragId, ResourceData& outVert, ResourceData& outFrag) {
+    // Fetches the pair under a single PakResource lock
+    Uint64 ids[2] = {vertId, fragId};
+    ResourceData data[2];
+    if (!pakResource_.getResources(ids, 2, data)) {
+        return false;
+    }
+    outVert = data[0];
+    outFrag = data[1];
+    pinSceneResource(vertId);
+    pinSceneResource(fragId);
+    return true;
+}
+
+void LuaInterface::pinSceneResource(Uint64 resourceId) {
+    // Only between initScene() and cleanupScene() of the current scene
+    Vector<Uint64>** pinsPtr = scenePinnedResources_.find(currentSceneId_);
+    if (pinsPtr == nullptr) {
+        return;
+    }
+    Vector<Uint64>* pins = *pinsPtr;
+    assert(pins != nullptr);
+    for (Uint64 pinnedId : *pins) {
+        if (pinnedId == resourceId) {
+            return;
+        }
+    }
+    pakResource_.pinResource(resourceId);
+    pins->push_back(resourceId);
+}
+
+void LuaInterface::unpinSceneResources(Uint64 sceneId) {
+    Vector<Uint64>** pinsPtr = scenePinnedResources_.find(sceneId);
+    if (pinsPtr == nullptr) {
+        return;
+    }
+    Vector<Uint64>* pins = *pinsPtr;
+    assert(pins != nullptr);
+    for (Uint64 pinnedId : *pins) {
+        pakResource_.unpinResource(pinnedId);
+    }
+    pins->~Vector();
+    stringAllocator_->free(pins);
+    scenePinnedResources_.remove(sceneId);
+}
+
 void LuaInterface::resumeScene(Uint64 sceneId) {
     currentSceneId_ = sceneId;
 
@@ -1344,12 +1411,11 @@ int LuaInterface::loadShaders(lua_State* L) {
     // Get shader data from pak file
     ResourceData vertShader{nullptr, 0, 0};
     ResourceData fragShader{nullptr, 0, 0};
-    bool haveVert = requestAndTryResource(interface->pakResource_, vertId, vertShader);
-    bool haveFrag = requestAndTryResource(interface->pakResource_, fragId, fragShader);
+    bool haveShaders = interface->getSceneShaders(vertId, fragId, vertShader, fragShader);
 
-    if (!haveVert || !haveFrag || vertShader.size == 0 || fragShader.size == 0) {
+    if (!haveShaders || vertShader.size == 0 || fragShader.size == 0) {
         interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Failed to load shader: %s or %s", vertFile, fragFile);
-        assert(false);
+        return 0;
     }
 
     // Check if this is a debug shader (check for filename, not full path)
@@ -2092,7 +2158,7 @@ int LuaInterface::b2SetBodyDestructible(lua_State* L) {
         interface->physics_->setBodyDestructibleAtlasUV(
             bodyId,
             atlasUV.atlasId,
-            atlasUV.u0, atlasUV.v0, atlasUV.u1, atlasUV.v1
+            atlasUV.u0, atlasUV.v0, atlasUV.u1, atlasUV.v1, atlasUV.rotated, atlasUV.trim
         );
     }
 
@@ -2103,7 +2169,8 @@ int LuaInterface::b2SetBodyDestructible(lua_State* L) {
             interface->physics_->setBodyDestructibleNormalMapAtlasUV(
                 bodyId,
                 normalAtlasUV.atlasId,
-                normalAtlasUV.u0, normalAtlasUV.v0, normalAtlasUV.u1, normalAtlasUV.v1
+                normalAtlasUV.u0, normalAtlasUV.v0, normalAtlasUV.u1, normalAtlasUV.v1, normalAtlasUV.rotated,
+                normalAtlasUV.trim
             );
         }
     }
@@ -2519,7 +2586,15 @@ int LuaInterface::createLayer(lua_State* L) {
 
     // Set atlas UV coordinates if applicable
     if (usesAtlas) {
-        interface->layerManager_->setLayerAtlasUV(layerId, atlasUV.atlasId, atlasUV.u0, atlasUV.v0, atlasUV.u1, atlasUV.v1);
+        interface->layerManager_->setLayerAtlasUV(layerId, atlasUV.atlasId, atlasUV.u0, atlasUV.v0, atlasUV.u1, atlasUV.v1,
+                                                  atlasUV.rotated, atlasUV.trim);
+
+        // Sprites the packer outlined are drawn as that polygon, skipping most
+        // of their transparent pixels
+        SpriteMeshEntry mesh;
+        if (interface->pakResource_.tryGetSpriteMesh(textureId, mesh) && mesh.numVertices >= 3) {
+            interface->layerManager_->setLayerOutline(layerId, mesh.points, (int)mesh.numVertices);
+        }
     }
 
     // Check if normal map uses atlas
@@ -2527,7 +2602,8 @@ int LuaInterface::createLayer(lua_State* L) {
         AtlasUV normalAtlasUV;
         if (interface->pakResource_.tryGetAtlasUV(normalMapId, normalAtlasUV)) {
             interface->layerManager_->setLayerNormalMapAtlasUV(layerId, normalAtlasUV.atlasId,
-                normalAtlasUV.u0, normalAtlasUV.v0, normalAtlasUV.u1, normalAtlasUV.v1);
+                normalAtlasUV.u0, normalAtlasUV.v0, normalAtlasUV.u1, normalAtlasUV.v1, normalAtlasUV.rotated,
+                normalAtlasUV.trim);
         }
     }
 
@@ -2798,29 +2874,17 @@ int LuaInterface::loadTexture(lua_State* L) {
 
     interface->consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE, "Loading texture: %s (id: %d)", filename, textureId);
 
-    // Load the texture from the pak file
-    ResourceData imageData{nullptr, 0, 0};
-    bool haveImage = requestAndTryResource(interface->pakResource_, textureId, imageData);
-    if (!haveImage || imageData.data == nullptr) {
-        interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Texture not found in pak file: %s", filename);
-        assert(false);
-    }
-
-    // Check if this is an atlas reference (TextureHeader) or a standalone image (ImageHeader)
+    // Check if this is an atlas reference (TextureHeader) or a standalone image (ImageHeader).
+    // Either way the pixels are decompressed straight into the renderer's staging buffer.
     AtlasUV atlasUV;
     if (interface->pakResource_.tryGetAtlasUV(textureId, atlasUV)) {
         // This is an atlas reference - load the atlas texture instead
         interface->consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE, "  -> Atlas reference (atlas id: %d, UV: %f,%f - %f,%f)", atlasUV.atlasId, atlasUV.u0, atlasUV.v0, atlasUV.u1, atlasUV.v1);
-        ResourceData atlasData{nullptr, 0, 0};
-        bool haveAtlas = requestAndTryResource(interface->pakResource_, atlasUV.atlasId, atlasData);
-        if (!haveAtlas || atlasData.data == nullptr) {
+        if (!interface->renderer_.loadAtlasTexture(atlasUV.atlasId, interface->pakResource_)) {
             interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Atlas not found in pak file for texture: %s", filename);
             assert(false);
         }
 
-        // Load the atlas texture (if not already loaded)
-        interface->renderer_.loadAtlasTexture(atlasUV.atlasId, atlasData);
-
         // For now, we use the atlas ID for rendering
         // The UV coordinates are stored in the atlas entry and will be used by SceneLayer
     } else {
@@ -2828,7 +2892,10 @@ int LuaInterface::loadTexture(lua_State* L) {
         if (interface->consoleBuffer_) {
             interface->consoleBuffer_->log(SDL_LOG_PRIORITY_TRACE, "  -> Standalone texture");
         }
-        interface->renderer_.loadTexture(textureId, imageData);
+        if (!interface->renderer_.loadTexture(textureId, interface->pakResource_)) {
+            interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Texture not found in pak file: %s", filename);
+            assert(false);
+        }
     }
 
     // Return the texture ID so it can be used in createLayer
@@ -2856,12 +2923,12 @@ int LuaInterface::loadTexturedShaders(lua_State* L) {
 
     ResourceData vertShader{nullptr, 0, 0};
     ResourceData fragShader{nullptr, 0, 0};
-    bool haveVert = requestAndTryResource(interface->pakResource_, vertId, vertShader);
-    bool haveFrag = requestAndTryResource(interface->pakResource_, fragId, fragShader);
-
-    assert(haveVert && haveFrag);
-    assert(vertShader.data != nullptr);
-    assert(fragShader.data != nullptr);
+    bool haveShaders = interface->getSceneShaders(vertId, fragId, vertShader, fragShader);
+    if (!haveShaders || vertShader.data == nullptr || fragShader.data == nullptr) {
+        interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Failed to load shader: %s or %s", vertShaderName, fragShaderName);
+        lua_pushinteger(L, -1);
+        return 1;
+    }
 
     int pipelineId = interface->pipelineIndex_++;
     interface->consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE, "LuaInterface::loadTexturedShaders: currentSceneId_=%d, zIndex=%d", interface->currentSceneId_, zIndex);
@@ -2908,12 +2975,12 @@ int LuaInterface::loadTexturedShadersEx(lua_State* L) {
 
     ResourceData vertShader{nullptr, 0, 0};
     ResourceData fragShader{nullptr, 0, 0};
-    bool haveVert = requestAndTryResource(interface->pakResource_, vertId, vertShader);
-    bool haveFrag = requestAndTryResource(interface->pakResource_, fragId, fragShader);
-
-    assert(haveVert && haveFrag);
-    assert(vertShader.data != nullptr);
-    assert(fragShader.data != nullptr);
+    bool haveShaders = interface->getSceneShaders(vertId, fragId, vertShader, fragShader);
+    if (!haveShaders || vertShader.data == nullptr || fragShader.data == nullptr) {
+        interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Failed to load shader: %s or %s", vertShaderName, fragShaderName);
+        lua_pushinteger(L, -1);
+        return 1;
+    }
 
     int pipelineId = interface->pipelineIndex_++;
     interface->consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE, "LuaInterface::loadTexturedShadersEx: currentSceneId_=%d, zIndex=%d", interface->currentSceneId_, zIndex);
@@ -2960,12 +3027,12 @@ int LuaInterface::loadTexturedShadersAdditive(lua_State* L) {
 
     ResourceData vertShader{nullptr, 0, 0};
     ResourceData fragShader{nullptr, 0, 0};
-    bool haveVert = requestAndTryResource(interface->pakResource_, vertId, vertShader);
-    bool haveFrag = requestAndTryResource(interface->pakResource_, fragId, fragShader);
-
-    assert(haveVert && haveFrag);
-    assert(vertShader.data != nullptr);
-    assert(fragShader.data != nullptr);
+    bool haveShaders = interface->getSceneShaders(vertId, fragId, vertShader, fragShader);
+    if (!haveShaders || vertShader.data == nullptr || fragShader.data == nullptr) {
+        interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Failed to load shader: %s or %s", vertShaderName, fragShaderName);
+        lua_pushinteger(L, -1);
+        return 1;
+    }
 
     int pipelineId = interface->pipelineIndex_++;
     interface->consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE, "LuaInterface::loadTexturedShadersAdditive: currentSceneId_=%d, zIndex=%d", interface->currentSceneId_, zIndex);
@@ -3012,12 +3079,12 @@ int LuaInterface::loadAnimTexturedShaders(lua_State* L) {
 
     ResourceData vertShader{nullptr, 0, 0};
     ResourceData fragShader{nullptr, 0, 0};
-    bool haveVert = requestAndTryResource(interface->pakResource_, vertId, vertShader);
-    bool haveFrag = requestAndTryResource(interface->pakResource_, fragId, fragShader);
-
-    assert(haveVert && haveFrag);
-    assert(vertShader.data != nullptr);
-    assert(fragShader.data != nullptr);
+    bool haveShaders = interface->getSceneShaders(vertId, fragId, vertShader, fragShader);
+    if (!haveShaders || vertShader.data == nullptr || fragShader.data == nullptr) {
+        interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Failed to load shader: %s or %s", vertShaderName, fragShaderName);
+        lua_pushinteger(L, -1);
+        return 1;
+    }
 
     int pipelineId = interface->pipelineIndex_++;
     interface->consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE, "LuaInterface::loadAnimTexturedShaders: currentSceneId_=%d, zIndex=%d", interface->currentSceneId_, zIndex);
@@ -3088,7 +3155,7 @@ int LuaInterface::audioLoadGla(lua_State* L) {
 
     // Load resource from pak
     ResourceData resourceData{nullptr, 0, 0};
-    bool haveResource = requestAndTryResource(interface->pakResource_, resourceId, resourceData);
+    bool haveResource = interface->getSceneResource(resourceId, resourceData);
     if (!haveResource || !resourceData.data || resourceData.size == 0) {
         interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Failed to load GLA resource: %s", resourceName);
         lua_pushinteger(L, -1);
@@ -3267,8 +3334,7 @@ int LuaInterface::audioLoadMusicTrack(lua_State* L) {
 
     // Load the MusicTrackHeader resource.
     ResourceData trackData{nullptr, 0, 0};
-    bool ok = requestAndTryResource(interface->pakResource_, trackResId, trackData);
-    assert(ok && trackData.data && trackData.size >= sizeof(MusicTrackHeader));
+    bool ok = interface->getSceneResource(trackResId, trackData);
     if (!ok || !trackData.data || trackData.size < sizeof(MusicTrackHeader)) {
         interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR,
             "audioLoadMusicTrack: failed to load track resource '%s'", resourceName);
@@ -3319,11 +3385,12 @@ int LuaInterface::audioLoadMusicTrack(lua_State* L) {
 
     // Load each unique layer's GLA data from the pak.
     MusicLayerInitData layerData[MAX_UNIQUE];
+    ResourceData layerResData[MAX_UNIQUE];
+    interface->pakResource_.tryGetResources(uniqueLayerIds, (Uint32)numUniqueIds, layerResData);
     for (int i = 0; i < numUniqueIds; i++) {
-        ResourceData resData{nullptr, 0, 0};
-        bool got = requestAndTryResource(interface->pakResource_, uniqueLayerIds[i], resData);
-        assert(got && resData.data && resData.size > 0);
-        if (!got || !resData.data || resData.size == 0) {
+        const ResourceData& resData = layerResData[i];
+        assert(resData.data && resData.size > 0);
+        if (!resData.data || resData.size == 0) {
             interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR,
                 "audioLoadMusicTrack: failed to load layer resource %llu",
                 (unsigned long long)uniqueLayerIds[i]);
@@ -3683,12 +3750,12 @@ int LuaInterface::loadParticleShaders(lua_State* L) {
         // Create new pipeline
         ResourceData vertShader{nullptr, 0, 0};
         ResourceData fragShader{nullptr, 0, 0};
-        bool haveVert = requestAndTryResource(interface->pakResource_, vertId, vertShader);
-        bool haveFrag = requestAndTryResource(interface->pakResource_, fragId, fragShader);
-
-        assert(haveVert && haveFrag);
-        assert(vertShader.data != nullptr);
-        assert(fragShader.data != nullptr);
+        bool haveShaders = interface->getSceneShaders(vertId, fragId, vertShader, fragShader);
+        if (!haveShaders || vertShader.data == nullptr || fragShader.data == nullptr) {
+            interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Failed to load particle shader: %s or %s", vertShaderName, fragShaderName);
+            lua_pushinteger(L, -1);
+            return 1;
+        }
 
         pipelineId = interface->pipelineIndex_++;
         interface->consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE, "LuaInterface::loadParticleShaders: currentSceneId_=%d, zIndex=%d", interface->currentSceneId_, zIndex);
@@ -4051,7 +4118,7 @@ int LuaInterface::loadParticleConfig(lua_State* L) {
 
     // Load the Lua file from the pak
     ResourceData scriptData{nullptr, 0, 0};
-    bool haveScript = requestAndTryResource(interface->pakResource_, resourceId, scriptData);
+    bool haveScript = interface->getSceneResource(resourceId, scriptData);
     if (!haveScript || !scriptData.data || scriptData.size == 0) {
         interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Failed to load particle config: %s", filename);
         lua_pushnil(L);
@@ -4103,7 +4170,7 @@ int LuaInterface::loadObject(lua_State* L) {
 
     // Load the Lua file from the pak
     ResourceData scriptData{nullptr, 0, 0};
-    bool haveScript = requestAndTryResource(interface->pakResource_, resourceId, scriptData);
+    bool haveScript = interface->getSceneResource(resourceId, scriptData);
     if (!haveScript || !scriptData.data || scriptData.size == 0) {
         interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Failed to load object: %s", filename);
         lua_pushnil(L);
@@ -4273,7 +4340,7 @@ int LuaInterface::createNode(lua_State* L) {
     Uint64 scriptId = hashCString(scriptPath.c_str());
     if (interface->pakResource_.hasResource(scriptId)) {
         ResourceData scriptData{nullptr, 0, 0};
-        bool haveScript = requestAndTryResource(interface->pakResource_, scriptId, scriptData);
+        bool haveScript = interface->getSceneResource(scriptId, scriptData);
         if (haveScript && scriptData.data && scriptData.size > 0) {
             if (luaL_loadbuffer(L, (char*)scriptData.data, scriptData.size, scriptPath.c_str()) == LUA_OK) {
                 if (lua_pcall(L, 0, 1, 0) == LUA_OK) {
@@ -4467,10 +4534,9 @@ void LuaInterface::setupWaterVisuals(int physicsForceFieldId, int waterFieldId,
 
     ResourceData vertShader{nullptr, 0, 0};
     ResourceData fragShader{nullptr, 0, 0};
-    bool haveVert = requestAndTryResource(pakResource_, vertId, vertShader);
-    bool haveFrag = requestAndTryResource(pakResource_, fragId, fragShader);
+    bool haveShaders = getSceneShaders(vertId, fragId, vertShader, fragShader);
 
-    if (!haveVert || !haveFrag || vertShader.data == nullptr || fragShader.data == nullptr) {
+    if (!haveShaders || vertShader.data == nullptr || fragShader.data == nullptr) {
 consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Failed to load water shaders");
         assert(false);
         return;
@@ -4495,11 +4561,7 @@ consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Failed to load water shaders");
     const char* placeholderTextureName = "res/textures/rock1.png";
     Uint64 placeholderTexId = hashCString(placeholderTextureName);
 
-    ResourceData texData{nullptr, 0, 0};
-    bool haveTexture = requestAndTryResource(pakResource_, placeholderTexId, texData);
-    if (haveTexture && texData.data != nullptr && texData.size > 0) {
-        renderer_.loadTexture(placeholderTexId, texData);
-    }
+    renderer_.loadTexture(placeholderTexId, pakResource_);
 
     // 4. Get reflection texture ID
     Uint64 reflectionTexId = 0;
@@ -4557,7 +4619,7 @@ consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "Failed to create water layer");
     bool usesAtlas = pakResource_.tryGetAtlasUV(placeholderTexId, atlasUV);
     if (usesAtlas) {
         layerManager_->setLayerAtlasUV(waterLayerId, atlasUV.atlasId,
-                                        atlasUV.u0, atlasUV.v0, atlasUV.u1, atlasUV.v1);
+                                        atlasUV.u0, atlasUV.v0, atlasUV.u1, atlasUV.v1, atlasUV.rotated, atlasUV.trim);
     }
 
     // 8. Set layer properties - use polygon rendering instead of quad
@@ -4915,13 +4977,9 @@ int LuaInterface::loadVectorShape(lua_State* L) {
     Uint64 vertId = hashCString(VECTOR_VERT);
     Uint64 fragId = hashCString(VECTOR_FRAG);
 
-    interface->pakResource_.requestResourceAsync(vertId);
-    interface->pakResource_.requestResourceAsync(fragId);
     ResourceData vertShader{nullptr, 0, 0};
     ResourceData fragShader{nullptr, 0, 0};
-    bool haveVert = interface->pakResource_.tryGetResource(vertId, vertShader);
-    bool haveFrag = interface->pakResource_.tryGetResource(fragId, fragShader);
-    if (haveVert && haveFrag) {
+    if (interface->getSceneShaders(vertId, fragId, vertShader, fragShader)) {
         interface->renderer_.createVectorPipeline(vertShader, fragShader);
     } else {
         interface->consoleBuffer_->log(SDL_LOG_PRIORITY_WARN,
@@ -4929,9 +4987,8 @@ int LuaInterface::loadVectorShape(lua_State* L) {
     }
 
     // Load the shape resource
-    interface->pakResource_.requestResourceAsync(shapeId);
     ResourceData shapeData{nullptr, 0, 0};
-    bool haveShape = interface->pakResource_.tryGetResource(shapeId, shapeData);
+    bool haveShape = interface->getSceneResource(shapeId, shapeData);
     if (!haveShape || shapeData.data == nullptr) {
         interface->consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR,
             "loadVectorShape: shape resource not found in pak: %s", shapePath);
@@ -5058,13 +5115,9 @@ int LuaInterface::loadFont(lua_State* L) {
     static const char* TEXT_FRAG = "res/shaders/text_fragment.spv";
     Uint64 textVertId = hashCString(TEXT_VERT);
     Uint64 textFragId = hashCString(TEXT_FRAG);
-    iface->pakResource_.requestResourceAsync(textVertId);
-    iface->pakResource_.requestResourceAsync(textFragId);
     ResourceData textVertShader{nullptr, 0, 0};
     ResourceData textFragShader{nullptr, 0, 0};
-    bool haveTextVert = iface->pakResource_.tryGetResource(textVertId, textVertShader);
-    bool haveTextFrag = iface->pakResource_.tryGetResource(textFragId, textFragShader);
-    if (haveTextVert && haveTextFrag) {
+    if (iface->getSceneShaders(textVertId, textFragId, textVertShader, textFragShader)) {
         iface->renderer_.createTextPipeline(textVertShader, textFragShader);
     } else {
         iface->consoleBuffer_->log(SDL_LOG_PRIORITY_WARN,
@@ -285,6 +285,13 @@ private:
 
     void registerFunctions();
 
+    // Blocking fetches for resources a scene builds from. While the scene is live
+    // they stay pinned, with its manifest, until cleanupScene() releases them.
+    bool getSceneResource(Uint64 resourceId, ResourceData& outData);
+    bool getSceneShaders(Uint64 vertId, Uint64 fragId, ResourceData& outVert, ResourceData& outFrag);
+    void pinSceneResource(Uint64 resourceId);
+    void unpinSceneResources(Uint64 sceneId);
+
     PakResource& pakResource_;
     VulkanRenderer& renderer_;
     lua_State* luaState_;
@@ -296,6 +303,7 @@ private:
     int pipelineIndex_;
     Uint64 currentSceneId_;
     HashTable<Uint64, Vector<IntPair>* > scenePipelines_; // pipelineId, zIndex
+    HashTable<Uint64, Vector<Uint64>* > scenePinnedResources_; // resource ids pinned in the pak
     Box2DPhysics* physics_;
     SceneLayerManager* layerManager_;
     AudioManager* audioManager_;
@@ -1,5 +1,6 @@
 #include "SceneLayer.h"
 #include "../core/TrigLookup.h"
+#include "../core/ResourceTypes.h"
 #include <SDL3/SDL.h>
 #include <cassert>
 
@@ -11,6 +12,14 @@ inline float abs_float(float x) {
     return x < 0.0f ? -x : x;
 }
 
+// Copy an AtlasUV trim rect, or mark the whole image held when there is none
+static void setTrim(LayerAtlasUV& uv, const float* trim) {
+    uv.trim[0] = trim ? trim[0] : 0.0f;
+    uv.trim[1] = trim ? trim[1] : 0.0f;
+    uv.trim[2] = trim ? trim[2] : 1.0f;
+    uv.trim[3] = trim ? trim[3] : 1.0f;
+}
+
 SceneLayerManager::SceneLayerManager(MemoryAllocator* smallAllocator, MemoryAllocator* largeAllocator, TrigLookup* trigLookup)
     : layers_(*largeAllocator, "SceneLayerManager::layers"), nextLayerId_(1), allocator_(smallAllocator), trigLookup_(trigLookup) {
     assert(trigLookup_ != nullptr);
@@ -55,12 +64,16 @@ int SceneLayerManager::createLayer(Uint64 textureId, float width, float height,
     layer.textureUV.u1 = 1.0f;
     layer.textureUV.v1 = 1.0f;
     layer.textureUV.isAtlas = false;
+    layer.textureUV.rotated = false;
+    setTrim(layer.textureUV, nullptr);
 
     layer.normalMapUV.u0 = 0.0f;
     layer.normalMapUV.v0 = 0.0f;
     layer.normalMapUV.u1 = 1.0f;
     layer.normalMapUV.v1 = 1.0f;
     layer.normalMapUV.isAtlas = false;
+    layer.normalMapUV.rotated = false;
+    setTrim(layer.normalMapUV, nullptr);
 
     // Default to quad rendering (no polygon)
     layer.polygonVertexCount = 0;
@@ -69,7 +82,9 @@ int SceneLayerManager::createLayer(Uint64 textureId, float width, float height,
         layer.polygonVertices[i] = 0.0f;
         layer.polygonUVs[i] = 0.0f;
         layer.polygonNormalUVs[i] = 0.0f;
+        layer.outlinePoints[i] = 0.0f;
     }
+    layer.outlinePointCount = 0;
 
     layer.cachedX = 0.0f;
     layer.cachedY = 0.0f;
@@ -142,7 +157,8 @@ void SceneLayerManager::setLayerEnabled(int layerId, bool enabled) {
     }
 }
 
-void SceneLayerManager::setLayerAtlasUV(int layerId, Uint64 atlasTextureId, float u0, float v0, float u1, float v1) {
+void SceneLayerManager::setLayerAtlasUV(int layerId, Uint64 atlasTextureId, float u0, float v0, float u1, float v1, bool rotated,
+                                        const float* trim) {
     SceneLayer* layer = layers_.find(layerId);
     if (layer != nullptr) {
         layer->atlasTextureId = atlasTextureId;
@@ -151,6 +167,8 @@ void SceneLayerManager::setLayerAtlasUV(int layerId, Uint64 atlasTextureId, floa
         layer->textureUV.u1 = u1;
         layer->textureUV.v1 = v1;
         layer->textureUV.isAtlas = true;
+        layer->textureUV.rotated = rotated;
+        setTrim(layer->textureUV, trim);
 
         // Update descriptor ID to use atlas texture
         if (layer->normalMapUV.isAtlas) {
@@ -163,7 +181,8 @@ void SceneLayerManager::setLayerAtlasUV(int layerId, Uint64 atlasTextureId, floa
     }
 }
 
-void SceneLayerManager::setLayerNormalMapAtlasUV(int layerId, Uint64 atlasNormalMapId, float u0, float v0, float u1, float v1) {
+void SceneLayerManager::setLayerNormalMapAtlasUV(int layerId, Uint64 atlasNormalMapId, float u0, float v0, float u1, float v1, bool rotated,
+                                                 const float* trim) {
     SceneLayer* layer = layers_.find(layerId);
     if (layer != nullptr) {
         layer->atlasNormalMapId = atlasNormalMapId;
@@ -172,6 +191,8 @@ void SceneLayerManager::setLayerNormalMapAtlasUV(int layerId, Uint64 atlasNormal
         layer->normalMapUV.u1 = u1;
         layer->normalMapUV.v1 = v1;
         layer->normalMapUV.isAtlas = true;
+        layer->normalMapUV.rotated = rotated;
+        setTrim(layer->normalMapUV, trim);
 
         // Update descriptor ID to use atlas textures
         Uint64 texId = layer->textureUV.isAtlas ? layer->atlasTextureId : layer->textureId;
@@ -192,6 +213,16 @@ void SceneLayerManager::setLayerPolygon(int layerId, const float* vertices, cons
     }
 }
 
+void SceneLayerManager::setLayerOutline(int layerId, const float* points, int pointCount) {
+    SceneLayer* layer = layers_.find(layerId);
+    if (layer != nullptr && (pointCount == 0 || (pointCount >= 3 && pointCount <= 8))) {
+        layer->outlinePointCount = pointCount;
+        for (int i = 0; i < pointCount * 2; ++i) {
+            layer->outlinePoints[i] = points[i];
+        }
+    }
+}
+
 void SceneLayerManager::updateLayerTransform(int layerId, float bodyX, float bodyY, float bodyAngle) {
     SceneLayer* layer = layers_.find(layerId);
     if (layer != nullptr) {
@@ -289,7 +320,8 @@ void SceneLayerManager::clear() {
     layers_.clear();
 }
 
-void SceneLayerManager::updateLayerVertices(Vector<SpriteBatch>& batches, float cameraX, float cameraY, float cameraZoom) {
+void SceneLayerManager::updateLayerVertices(Vector<SpriteBatch>& batches, float cameraX, float cameraY, float cameraZoom,
+                                            MemoryAllocator& scratchAllocator) {
     batches.clear();
 
     // Group layers by pipeline ID, descriptor ID, AND parallax depth
@@ -306,12 +338,12 @@ void SceneLayerManager::updateLayerVertices(Vector<SpriteBatch>& batches, float
                    abs_float(parallaxDepth - other.parallaxDepth) < PARALLAX_EPSILON;
         }
     };
-    HashTable<BatchKey, Uint64> batchMap(*allocator_, "updateLayerVertices::batchMap");
+    HashTable<BatchKey, Uint64> batchMap(scratchAllocator, "updateLayerVertices::batchMap");
 
     // Build a deterministic processing order for layers.
     // layers_ is a hash table, so direct iteration order can vary and cause
     // non-deterministic draw order for quads merged into the same batch.
-    Vector<int> sortedLayerIds(*allocator_, "updateLayerVertices::sortedLayerIds");
+    Vector<int> sortedLayerIds(scratchAllocator, "updateLayerVertices::sortedLayerIds");
     sortedLayerIds.reserve(layers_.size());
     for (auto it = layers_.begin(); it != layers_.end(); ++it) {
         sortedLayerIds.push_back(it.key());
@@ -472,19 +504,23 @@ void SceneLayerManager::updateLayerVertices(Vector<SpriteBatch>& batches, float
                 batch.indices.push_back(baseIndex + i + 1);
             }
         } else {
-            // Standard quad rendering
+            // Standard quad rendering, over the part of the image the packer
+            // kept (its trim rect) or its outline when it has one
             // Calculate half-extents with user-defined scale applied
             float hw = layer.width * 0.5f * layer.scaleX;
             float hh = layer.height * 0.5f * layer.scaleY;
 
-            // Create quad vertices (4 vertices for a sprite)
-            // Vertices in local space (before rotation)
-            float localVerts[4][2] = {
-                {-hw, -hh},  // Bottom-left
-                { hw, -hh},  // Bottom-right
-                { hw,  hh},  // Top-right
-                {-hw,  hh}   // Top-left
+            // Image-space points (s left->right, t top->bottom) of each vertex,
+            // counter-clockwise from the bottom-left for the quad
+            const float* trim = layer.textureUV.trim;
+            float quadST[8] = {
+                trim[0], trim[3],  // Bottom-left
+                trim[2], trim[3],  // Bottom-right
+                trim[2], trim[1],  // Top-right
+                trim[0], trim[1]   // Top-left
             };
+            const float* pointST = layer.outlinePointCount >= 3 ? layer.outlinePoints : quadST;
+            int pointCount = layer.outlinePointCount >= 3 ? layer.outlinePointCount : 4;
 
             // Get UV coordinates from layer (supports atlas or full texture)
             float u0 = layer.textureUV.u0;
@@ -492,52 +528,44 @@ void SceneLayerManager::updateLayerVertices(Vector<SpriteBatch>& batches, float
             float u1 = layer.textureUV.u1;
             float v1 = layer.textureUV.v1;
 
-            // Get normal map UV coordinates
-            float nu0 = layer.normalMapUV.u0;
-            float nv0 = layer.normalMapUV.v0;
-            float nu1 = layer.normalMapUV.u1;
-            float nv1 = layer.normalMapUV.v1;
-
-            float uvs[4][2];
-            if (layer.useLocalUV) {
-                // Use local 0..1 coordinates across quad (left->right, bottom->top)
-                uvs[0][0] = 0.0f; uvs[0][1] = 0.0f; // Bottom-left
-                uvs[1][0] = 1.0f; uvs[1][1] = 0.0f; // Bottom-right
-                uvs[2][0] = 1.0f; uvs[2][1] = 1.0f; // Top-right
-                uvs[3][0] = 0.0f; uvs[3][1] = 1.0f; // Top-left
-            } else {
-                // Texture coordinates using atlas UV or default 0-1
-                uvs[0][0] = u0; uvs[0][1] = v1;  // Bottom-left
-                uvs[1][0] = u1; uvs[1][1] = v1;  // Bottom-right
-                uvs[2][0] = u1; uvs[2][1] = v0;  // Top-right
-                uvs[3][0] = u0; uvs[3][1] = v0;  // Top-left
-            }
-
-            // Normal map texture coordinates
-            float nuvs[4][2] = {
-                {nu0, nv1},  // Bottom-left
-                {nu1, nv1},  // Bottom-right
-                {nu1, nv0},  // Top-right
-                {nu0, nv0}   // Top-left
-            };
+            for (int i = 0; i < pointCount; i++) {
+                float s = pointST[i * 2];
+                float t = pointST[i * 2 + 1];
 
-            for (int i = 0; i < 4; i++) {
-                // Apply offset
-                float lx = localVerts[i][0] + layer.offsetX;
-                float ly = localVerts[i][1] + layer.offsetY;
+                // Vertex in local space (before rotation), with offset
+                float lx = (s - 0.5f) * 2.0f * hw + layer.offsetX;
+                float ly = (0.5f - t) * 2.0f * hh + layer.offsetY;
 
                 // Rotate
                 float rx = lx * cosA - ly * sinA;
                 float ry = lx * sinA + ly * cosA;
 
+                float u, v;
+                if (layer.useLocalUV) {
+                    // Use local 0..1 coordinates across quad (left->right, bottom->top)
+                    u = s;
+                    v = 1.0f - t;
+                } else {
+                    // Texture coordinates using atlas UV or default 0-1, within the
+                    // trim rect and turned back for images the packer rotated
+                    float ts, tt;
+                    atlasTrimST(trim, s, t, ts, tt);
+                    atlasImageUV(u0, v0, u1, v1, layer.textureUV.rotated, ts, tt, u, v);
+                }
+                // Normal map texture coordinates, through its own trim rect
+                const LayerAtlasUV& nuv = layer.normalMapUV;
+                float ns, nt, nu, nv;
+                atlasTrimST(nuv.trim, s, t, ns, nt);
+                atlasImageUV(nuv.u0, nuv.v0, nuv.u1, nuv.v1, nuv.rotated, ns, nt, nu, nv);
+
                 // Translate to body position
                 SpriteVertex vert;
                 vert.x = centerX + rx;
                 vert.y = centerY + ry;
-                vert.u = uvs[i][0];
-                vert.v = uvs[i][1];
-                vert.nu = nuvs[i][0];
-                vert.nv = nuvs[i][1];
+                vert.u = u;
+                vert.v = v;
+                vert.nu = nu;
+                vert.nv = nv;
                 // Store UV bounds for atlas clamping (prevents MSAA bleeding)
                 vert.uvMinX = u0;
                 vert.uvMinY = v0;
@@ -547,14 +575,12 @@ void SceneLayerManager::updateLayerVertices(Vector<SpriteBatch>& batches, float
                 batch.vertices.push_back(vert);
             }
 
-            // Create indices for two triangles (quad)
-            batch.indices.push_back(baseIndex + 0);
-            batch.indices.push_back(baseIndex + 1);
-            batch.indices.push_back(baseIndex + 2);
-
-            batch.indices.push_back(baseIndex + 2);
-            batch.indices.push_back(baseIndex + 3);
-            batch.indices.push_back(baseIndex + 0);
+            // Triangle fan over the quad or the (convex) outline
+            for (int i = 1; i < pointCount - 1; i++) {
+                batch.indices.push_back(baseIndex + 0);
+                batch.indices.push_back(baseIndex + i);
+                batch.indices.push_back(baseIndex + i + 1);
+            }
         }
     }
 
@@ -66,6 +66,8 @@ struct ParticleInstance {
     float endR, endG, endB, endA;          // End color
     float lifeRatio;               // 0 = just born, 1 = about to die
     float uvMinX, uvMinY, uvMaxX, uvMaxY;  // UV bounds for atlas clamping
+    float imageMinX, imageMinY, imageMaxX, imageMaxY;  // UV rect of the whole image, past the
+                                                       // bounds for sprites trimmed by the packer
 };
 
 // Particle batch for a group of particles at a specific parallax depth
@@ -86,6 +88,8 @@ struct LayerAtlasUV {
     float u0, v0;       // Bottom-left UV
     float u1, v1;       // Top-right UV
     bool isAtlas;       // Whether this layer uses atlas coordinates
+    bool rotated;       // Atlas region holds the image turned clockwise (AtlasUV::rotated)
+    float trim[4];      // Part of the image the region holds (AtlasUV::trim)
 };
 
 // Scene layer that can be attached to a physics body
@@ -117,6 +121,11 @@ struct SceneLayer {
     float polygonNormalUVs[MAX_POLYGON_VERTEX_FLOATS]; // UV coordinates for each polygon vertex (normal map)
     int polygonVertexCount;     // 0 = use quad, > 0 = use polygon
 
+    // Packer outline of the sprite drawn in place of its quad, as image-space
+    // s, t pairs (SpriteMeshEntry::points); scaled with the layer like the quad
+    float outlinePoints[MAX_POLYGON_VERTEX_FLOATS];
+    int outlinePointCount;      // 0 = draw the quad over the texture's trim rect
+
     // Cached transform from physics
     float cachedX;
     float cachedY;
@@ -163,9 +172,17 @@ public:
     void setLayerOffset(int layerId, float offsetX, float offsetY);
     void setLayerEnabled(int layerId, bool enabled);
 
-    // Set atlas UV coordinates for a layer's texture
-    void setLayerAtlasUV(int layerId, Uint64 atlasTextureId, float u0, float v0, float u1, float v1);
-    void setLayerNormalMapAtlasUV(int layerId, Uint64 atlasNormalMapId, float u0, float v0, float u1, float v1);
+    // Set atlas UV coordinates for a layer's texture. trim is AtlasUV::trim of a
+    // sprite trimmed by the packer (nullptr for the whole image); the quad then
+    // only covers that part of the layer.
+    void setLayerAtlasUV(int layerId, Uint64 atlasTextureId, float u0, float v0, float u1, float v1, bool rotated = false,
+                         const float* trim = nullptr);
+    void setLayerNormalMapAtlasUV(int layerId, Uint64 atlasNormalMapId, float u0, float v0, float u1, float v1, bool rotated = false,
+                                  const float* trim = nullptr);
+
+    // Draw the layer as the packer's convex outline of its sprite (SpriteMeshEntry
+    // points, 3-8 of them) instead of a quad; pointCount 0 goes back to the quad
+    void setLayerOutline(int layerId, const float* points, int pointCount);
 
     // Set polygon vertices and UVs for fragment rendering (texture clipping)
     // vertices: array of x,y pairs in local coordinates
@@ -180,7 +197,7 @@ public:
     // Generate vertex data for all layers based on physics body positions
     // Groups sprites by texture for efficient batch rendering
     void updateLayerVertices(Vector<SpriteBatch>& batches) {
-        updateLayerVertices(batches, 0.0f, 0.0f, 1.0f);
+        updateLayerVertices(batches, 0.0f, 0.0f, 1.0f, *allocator_);
     }
 
     // Update a single layer's transform based on physics body
@@ -204,7 +221,9 @@ public:
     void setLayerColorCycle(int layerId, float r1, float g1, float b1, float a1, float r2, float g2, float b2, float a2, float cycleTime);
 
     // Update layer vertices with camera info for parallax calculation
-    void updateLayerVertices(Vector<SpriteBatch>& batches, float cameraX, float cameraY, float cameraZoom);
+    // scratchAllocator holds the call's temporary containers (a frame arena)
+    void updateLayerVertices(Vector<SpriteBatch>& batches, float cameraX, float cameraY, float cameraZoom,
+                             MemoryAllocator& scratchAllocator);
 
     // Clear all layers (for scene cleanup)
     void clear();
@@ -10,6 +10,7 @@
 #include "../animation/AnimationEngine.h"
 #include "../debug/ConsoleBuffer.h"
 #include "../debug/ThreadProfiler.h"
+#include "../memory/FrameArena.h"
 #include <SDL3/SDL.h>
 #include <cassert>
 
@@ -17,12 +18,15 @@
 static const float DEFAULT_FADE_OUT_TIME = 0.25f;  // 250ms fade-out
 static const float DEFAULT_FADE_IN_TIME = 0.25f;   // 250ms fade-in
 
-SceneManager::SceneManager(MemoryAllocator* allocator, PakResource& pakResource, VulkanRenderer& renderer,
+// Starting size of the render-prep worker's scratch arena; it grows to fit
+static const Uint64 RENDER_PREP_ARENA_SIZE = 64 * 1024;
+
+SceneManager::SceneManager(MemoryAllocator* allocator, MemoryAllocator* largeAllocator, MemoryAllocator* frameAllocator, PakResource& pakResource, VulkanRenderer& renderer,
                            Box2DPhysics* physics, SceneLayerManager* layerManager, AudioManager* audioManager,
                            ParticleSystemManager* particleManager, WaterEffectManager* waterEffectManager,
                            LuaInterface* luaInterface, ConsoleBuffer* consoleBuffer, TrigLookup* trigLookup,
                            AnimationEngine* animationEngine)
-    : allocator_(allocator), pakResource_(pakResource), renderer_(renderer), physics_(physics), layerManager_(layerManager),
+    : allocator_(allocator), frameAllocator_(frameAllocator), pakResource_(pakResource), renderer_(renderer), physics_(physics), layerManager_(layerManager),
       audioManager_(audioManager), particleManager_(particleManager), waterEffectManager_(waterEffectManager),
       luaInterface_(luaInterface), animationEngine_(animationEngine), sceneStack_(*allocator, "SceneManager::sceneStack_"),
       loadedScenes_(*allocator, "SceneManager::loadedScenes_"),
@@ -39,6 +43,8 @@ SceneManager::SceneManager(MemoryAllocator* allocator, PakResource& pakResource,
             queuedCameraX_(0.0f), queuedCameraY_(0.0f), queuedCameraZoom_(1.0f)
 {
     assert(allocator_ != nullptr);
+    assert(largeAllocator != nullptr);
+    assert(frameAllocator_ != nullptr);
     assert(physics_ != nullptr);
     assert(layerManager_ != nullptr);
     assert(audioManager_ != nullptr);
@@ -55,6 +61,8 @@ SceneManager::SceneManager(MemoryAllocator* allocator, PakResource& pakResource,
     new (renderPrepBuffers_[0]) RenderPrepOutput(*allocator_);
     renderPrepBuffers_[1] = (RenderPrepOutput*)allocator_->allocate(sizeof(RenderPrepOutput), "SceneManager::renderPrepBuffer1");
     new (renderPrepBuffers_[1]) RenderPrepOutput(*allocator_);
+    renderPrepArena_ = (FrameArena*)allocator_->allocate(sizeof(FrameArena), "SceneManager::renderPrepArena");
+    new (renderPrepArena_) FrameArena(largeAllocator, RENDER_PREP_ARENA_SIZE, "SceneManager::renderPrepArena::memory");
 
     renderPrepMutex_ = SDL_CreateMutex();
     renderPrepCondition_ = SDL_CreateCondition();
@@ -102,6 +110,11 @@ SceneManager::~SceneManager() {
         allocator_->free(renderPrepBuffers_[1]);
         renderPrepBuffers_[1] = nullptr;
     }
+    if (renderPrepArena_ != nullptr) {
+        renderPrepArena_->~FrameArena();
+        allocator_->free(renderPrepArena_);
+        renderPrepArena_ = nullptr;
+    }
 }
 
 int SceneManager::renderPrepWorkerThread(void* data) {
@@ -133,12 +146,16 @@ int SceneManager::renderPrepWorkerThread(void* data) {
 
         profiler.updateThreadState(THREAD_STATE_BUSY);
 
+        // Nothing from the previous job outlives it
+        sceneManager->renderPrepArena_->reset();
+
         RenderPrepOutput* output = sceneManager->renderPrepBuffers_[writeIndex];
         output->spriteBatches.clear();
         output->particleBatches.clear();
 
         SceneLayerManager& layerManager = sceneManager->luaInterface_->getSceneLayerManager();
-        layerManager.updateLayerVertices(output->spriteBatches, cameraX, cameraY, cameraZoom);
+        layerManager.updateLayerVertices(output->spriteBatches, cameraX, cameraY, cameraZoom,
+                                         *sceneManager->renderPrepArena_);
         sceneManager->buildParticleBatches(output->particleBatches);
 
         SDL_LockMutex(sceneManager->renderPrepMutex_);
@@ -187,14 +204,16 @@ void SceneManager::buildParticleBatches(Vector<ParticleBatch>& particleBatches)
         ParticleSystem* system = &particleManager.getSystems()[i];
         if (!system || system->liveParticleCount == 0) continue;
 
+        // Lock-free lookups in the pak's atlas UV table, once per texture variant
+        AtlasUV cachedAtlasUVs[8];
+        bool cachedAtlasUVValid[8] = {false, false, false, false, false, false, false, false};
+        for (int t = 0; t < system->config.textureCount && t < 8; ++t) {
+            cachedAtlasUVValid[t] = pakResource_.tryGetAtlasUV(system->config.textureIds[t], cachedAtlasUVs[t]);
+        }
+
         Uint64 textureId = 0;
         if (system->config.textureCount > 0) {
-            AtlasUV atlasUV;
-            if (pakResource_.tryGetAtlasUV(system->config.textureIds[0], atlasUV)) {
-                textureId = atlasUV.atlasId;
-            } else {
-                textureId = system->config.textureIds[0];
-            }
+            textureId = cachedAtlasUVValid[0] ? cachedAtlasUVs[0].atlasId : system->config.textureIds[0];
         }
 
         ParticleBatch batch(particleBatches.getAllocator());
@@ -202,21 +221,17 @@ void SceneManager::buildParticleBatches(Vector<ParticleBatch>& particleBatches)
         batch.pipelineId = system->pipelineId;
         batch.parallaxDepth = system->parallaxDepth;
 
-        AtlasUV cachedAtlasUVs[8];
-        bool cachedAtlasUVValid[8] = {false, false, false, false, false, false, false, false};
-        if (system->config.textureCount > 0) {
-            for (int t = 0; t < system->config.textureCount && t < 8; ++t) {
-                cachedAtlasUVValid[t] = pakResource_.tryGetAtlasUV(system->config.textureIds[t], cachedAtlasUVs[t]);
-            }
-        }
-
         for (int p = 0; p < system->liveParticleCount; ++p) {
             float x = system->posX[p];
             float y = system->posY[p];
             float size = system->size[p];
             float halfSize = size * 0.5f;
 
+            float lifeRatio = 1.0f - (system->lifetime[p] / system->totalLifetime[p]);
+            float rotZ = system->rotZ[p];
+
             float texU0 = 0.0f, texV0 = 0.0f, texU1 = 1.0f, texV1 = 1.0f;
+            float imageU0 = 0.0f, imageV0 = 0.0f, imageU1 = 1.0f, imageV1 = 1.0f;
             if (system->config.textureCount > 0) {
                 int texIdx = system->textureIndex[p];
                 if (texIdx >= 0 && texIdx < system->config.textureCount) {
@@ -226,13 +241,24 @@ void SceneManager::buildParticleBatches(Vector<ParticleBatch>& particleBatches)
                         texV0 = atlasUV.v0;
                         texU1 = atlasUV.u1;
                         texV1 = atlasUV.v1;
+                        // The quad spans the whole image, which for a sprite trimmed by
+                        // the packer reaches past its region onto the clamped transparent
+                        // margin. The region's top-left is the image's top-left, or its
+                        // bottom-left when rotated.
+                        float ts, tt;
+                        atlasTrimST(atlasUV.trim, 0.0f, atlasUV.rotated ? 1.0f : 0.0f, ts, tt);
+                        atlasImageUV(texU0, texV0, texU1, texV1, atlasUV.rotated, ts, tt, imageU0, imageV0);
+                        atlasTrimST(atlasUV.trim, 1.0f, atlasUV.rotated ? 0.0f : 1.0f, ts, tt);
+                        atlasImageUV(texU0, texV0, texU1, texV1, atlasUV.rotated, ts, tt, imageU1, imageV1);
+                        // Particle quads are square, so an image the packer turned
+                        // clockwise is turned back by rotating the quad instead
+                        if (atlasUV.rotated) {
+                            rotZ += SDL_PI_F * 0.5f;
+                        }
                     }
                 }
             }
 
-            float lifeRatio = 1.0f - (system->lifetime[p] / system->totalLifetime[p]);
-            float rotZ = system->rotZ[p];
-
             ParticleInstance instance;
             instance.x = x;
             instance.y = y;
@@ -251,6 +277,10 @@ void SceneManager::buildParticleBatches(Vector<ParticleBatch>& particleBatches)
             instance.uvMinY = texV0;
             instance.uvMaxX = texU1;
             instance.uvMaxY = texV1;
+            instance.imageMinX = imageU0;
+            instance.imageMinY = imageV0;
+            instance.imageMaxX = imageU1;
+            instance.imageMaxY = imageV1;
             batch.instances.push_back(instance);
         }
 
@@ -268,19 +298,25 @@ void SceneManager::pushScene(Uint64 sceneId) {
         transitionTimer_ = 0.0f;
         pendingSceneId_ = sceneId;
         pendingScenePush_ = true;
+        // Stream the next scene's script and manifest in while the current one fades out
+        pakResource_.requestSceneResourcesAsync(sceneId, RESOURCE_PRIORITY_PREFETCH);
         return;
     }
 
     // If no current scene or transition is completing, push immediately
     consoleBuffer_->log(SDL_LOG_PRIORITY_INFO, "SceneManager: Pushing scene %llu", (unsigned long long)sceneId);
 
+    // Queue everything the scene's manifest lists in one batch before its script runs
+    pakResource_.requestSceneResourcesAsync(sceneId);
+
     // Load the scene if not already loaded
     if (!loadedScenes_.contains(sceneId)) {
         consoleBuffer_->log(SDL_LOG_PRIORITY_DEBUG, "Loading scene %llu", (unsigned long long)sceneId);
-        pakResource_.requestResourceAsync(sceneId);
         ResourceData sceneScript{nullptr, 0, 0};
-        bool ready = pakResource_.tryGetResource(sceneId, sceneScript);
-        assert(ready);
+        if (!pakResource_.getResource(sceneId, sceneScript)) {
+            consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "SceneManager: Failed to load script of scene %llu", (unsigned long long)sceneId);
+            return;
+        }
         luaInterface_->loadScene(sceneId, sceneScript);
         loadedScenes_.insert(sceneId);
     } else {
@@ -309,6 +345,12 @@ void SceneManager::pushScene(Uint64 sceneId) {
 
 void SceneManager::popScene() {
     if (!sceneStack_.empty()) {
+        // Anything still being prefetched for upcoming scenes is no longer needed,
+        // unless it belongs to a push that completes before this pop does
+        if (!pendingScenePush_) {
+            pakResource_.cancelQueuedRequests(RESOURCE_PRIORITY_PREFETCH);
+        }
+
         // If we're not in a transition, start fade-out
         if (transitionState_ == TRANSITION_NONE) {
             consoleBuffer_->log(SDL_LOG_PRIORITY_DEBUG, "SceneManager: Starting fade-out transition for scene pop");
@@ -345,10 +387,12 @@ void SceneManager::reloadCurrentScene() {
         // Mark as not initialized so it will reinitialize
         initializedScenes_.erase(currentSceneId);
         // Reinitialize the scene
-        pakResource_.requestResourceAsync(currentSceneId);
+        pakResource_.requestSceneResourcesAsync(currentSceneId);
         ResourceData sceneScript{nullptr, 0, 0};
-        bool ready = pakResource_.tryGetResource(currentSceneId, sceneScript);
-        assert(ready);
+        if (!pakResource_.getResource(currentSceneId, sceneScript)) {
+            consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "SceneManager: Failed to load script of scene %llu", (unsigned long long)currentSceneId);
+            return;
+        }
         luaInterface_->loadScene(currentSceneId, sceneScript);
         luaInterface_->initScene(currentSceneId);
         luaInterface_->switchToScenePipeline(currentSceneId);
@@ -421,7 +465,7 @@ bool SceneManager::updateActiveScene(float deltaTime) {
 #ifdef DEBUG
         if (physics.isDebugDrawEnabled()) {
             const Vector<DebugVertex>& debugLineVerts = physics.getDebugLineVertices();
-            Vector<float> lineVertexData(*luaInterface_->getStringAllocator(), "SceneManager::render::lineVertexData");
+            Vector<float> lineVertexData(*frameAllocator_, "SceneManager::render::lineVertexData");
             lineVertexData.reserve(debugLineVerts.size() * 6);
             for (const auto& v : debugLineVerts) {
                 lineVertexData.push_back(v.x);
@@ -434,7 +478,7 @@ bool SceneManager::updateActiveScene(float deltaTime) {
             renderer_.setDebugLineDrawData(lineVertexData);
 
             const Vector<DebugVertex>& debugTriangleVerts = physics.getDebugTriangleVertices();
-            Vector<float> triangleVertexData(*luaInterface_->getStringAllocator(), "SceneManager::render::triangleVertexData");
+            Vector<float> triangleVertexData(*frameAllocator_, "SceneManager::render::triangleVertexData");
             triangleVertexData.reserve(debugTriangleVerts.size() * 6);
             for (Uint64 i = 0; i < debugTriangleVerts.size(); i += 3) {
                 // Reverse winding order: v0, v2, v1 instead of v0, v1, v2
@@ -466,7 +510,7 @@ bool SceneManager::updateActiveScene(float deltaTime) {
             renderer_.setDebugTriangleDrawData(triangleVertexData);
         } else {
             // Clear debug draw data
-            Vector<float> emptyData(*luaInterface_->getStringAllocator(), "SceneManager::render::emptyData");
+            Vector<float> emptyData(*frameAllocator_, "SceneManager::render::emptyData");
             renderer_.setDebugLineDrawData(emptyData);
             renderer_.setDebugTriangleDrawData(emptyData);
         }
@@ -491,19 +535,13 @@ void SceneManager::ensureFadePipelineReady() {
         return;
     }
 
-    pakResource_.requestResourceAsync(fadeVertShaderId_);
-    pakResource_.requestResourceAsync(fadeFragShaderId_);
-
-    ResourceData fadeVertShader{nullptr, 0, 0};
-    ResourceData fadeFragShader{nullptr, 0, 0};
-    bool haveFadeVert = pakResource_.tryGetResource(fadeVertShaderId_, fadeVertShader);
-    bool haveFadeFrag = pakResource_.tryGetResource(fadeFragShaderId_, fadeFragShader);
-
-    if (!haveFadeVert || !haveFadeFrag) {
+    Uint64 fadeShaderIds[2] = {fadeVertShaderId_, fadeFragShaderId_};
+    ResourceData fadeShaders[2];
+    if (!pakResource_.tryGetResources(fadeShaderIds, 2, fadeShaders)) {
         return;
     }
 
-    renderer_.createFadePipeline(fadeVertShader, fadeFragShader);
+    renderer_.createFadePipeline(fadeShaders[0], fadeShaders[1]);
     fadePipelineReady_ = true;
     consoleBuffer_->log(SDL_LOG_PRIORITY_TRACE, "SceneManager: Fade overlay pipeline ready");
 }
@@ -608,31 +646,40 @@ void SceneManager::updateTransition(float deltaTime) {
                 Uint64 sceneId = pendingSceneId_;
                 consoleBuffer_->log(SDL_LOG_PRIORITY_DEBUG, "SceneManager: Pushing scene %llu after fade-out", (unsigned long long)sceneId);
 
+                // Queue everything the scene's manifest lists in one batch before its script runs
+                pakResource_.requestSceneResourcesAsync(sceneId);
+
                 // Load the scene if not already loaded
+                bool loaded = true;
                 if (!loadedScenes_.contains(sceneId)) {
                     consoleBuffer_->log(SDL_LOG_PRIORITY_DEBUG, "Loading scene %llu", (unsigned long long)sceneId);
-                    pakResource_.requestResourceAsync(sceneId);
                     ResourceData sceneScript{nullptr, 0, 0};
-                    bool ready = pakResource_.tryGetResource(sceneId, sceneScript);
-                    assert(ready);
-                    luaInterface_->loadScene(sceneId, sceneScript);
-                    loadedScenes_.insert(sceneId);
+                    loaded = pakResource_.getResource(sceneId, sceneScript);
+                    if (loaded) {
+                        luaInterface_->loadScene(sceneId, sceneScript);
+                        loadedScenes_.insert(sceneId);
+                    } else {
+                        // Fade back in to the current scene instead
+                        consoleBuffer_->log(SDL_LOG_PRIORITY_ERROR, "SceneManager: Failed to load script of scene %llu", (unsigned long long)sceneId);
+                    }
                 } else {
                     consoleBuffer_->log(SDL_LOG_PRIORITY_VERBOSE, "Scene %llu already loaded (cache hit)", (unsigned long long)sceneId);
                 }
 
-                // Push scene onto stack
-                sceneStack_.push(sceneId);
+                if (loaded) {
+                    // Push scene onto stack
+                    sceneStack_.push(sceneId);
 
-                // Initialize the scene if not already initialized
-                if (!initializedScenes_.contains(sceneId)) {
-                    consoleBuffer_->log(SDL_LOG_PRIORITY_DEBUG, "Initializing scene %llu", (unsigned long long)sceneId);
-                    luaInterface_->initScene(sceneId);
-                    initializedScenes_.insert(sceneId);
-                }
+                    // Initialize the scene if not already initialized
+                    if (!initializedScenes_.contains(sceneId)) {
+                        consoleBuffer_->log(SDL_LOG_PRIORITY_DEBUG, "Initializing scene %llu", (unsigned long long)sceneId);
+                        luaInterface_->initScene(sceneId);
+                        initializedScenes_.insert(sceneId);
+                    }
 
-                // Set the pipelines for this scene
-                luaInterface_->switchToScenePipeline(sceneId);
+                    // Set the pipelines for this scene
+                    luaInterface_->switchToScenePipeline(sceneId);
+                }
 
                 pendingScenePush_ = false;
             }
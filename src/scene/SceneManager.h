@@ -18,10 +18,13 @@ class WaterEffectManager;
 class ConsoleBuffer;
 class TrigLookup;
 class AnimationEngine;
+class FrameArena;
 
 class SceneManager {
 public:
-    SceneManager(MemoryAllocator* allocator, PakResource& pakResource, VulkanRenderer& renderer,
+    // frameAllocator holds main-thread temporaries and is reset by the owner after each frame;
+    // largeAllocator backs the render-prep worker's scratch arena
+    SceneManager(MemoryAllocator* allocator, MemoryAllocator* largeAllocator, MemoryAllocator* frameAllocator, PakResource& pakResource, VulkanRenderer& renderer,
                  Box2DPhysics* physics, SceneLayerManager* layerManager, AudioManager* audioManager,
                  ParticleSystemManager* particleManager, WaterEffectManager* waterEffectManager,
                  LuaInterface* luaInterface, ConsoleBuffer* consoleBuffer, TrigLookup* trigLookup,
@@ -104,6 +107,7 @@ private:
     Uint64 pendingSceneId_;
     bool pendingScenePush_;
     MemoryAllocator* allocator_;
+    MemoryAllocator* frameAllocator_;
     PakResource& pakResource_;
     VulkanRenderer& renderer_;
     Box2DPhysics* physics_;
@@ -142,4 +146,5 @@ private:
     float queuedCameraY_;
     float queuedCameraZoom_;
     RenderPrepOutput* renderPrepBuffers_[2];
+    FrameArena* renderPrepArena_;  // Worker's temporaries, reset at the start of each job
 };
\ No newline at end of file
@@ -1311,10 +1311,10 @@ void VulkanPipeline::createParticlePipeline(Uint64 id, const ResourceData& vertS
 
     VkVertexInputBindingDescription bindingDescription{};
     bindingDescription.binding = 0;
-    bindingDescription.stride = sizeof(float) * 18;
+    bindingDescription.stride = sizeof(float) * 22;
     bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
 
-    VkVertexInputAttributeDescription attributeDescriptions[5]{};
+    VkVertexInputAttributeDescription attributeDescriptions[6]{};
 
     // Center position (x, y)
     attributeDescriptions[0].binding = 0;
@@ -1346,11 +1346,17 @@ void VulkanPipeline::createParticlePipeline(Uint64 id, const ResourceData& vertS
     attributeDescriptions[4].format = VK_FORMAT_R32G32B32A32_SFLOAT;
     attributeDescriptions[4].offset = sizeof(float) * 14;
 
+    // Image UV rect (u0, v0, u1, v1)
+    attributeDescriptions[5].binding = 0;
+    attributeDescriptions[5].location = 5;
+    attributeDescriptions[5].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    attributeDescriptions[5].offset = sizeof(float) * 18;
+
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     vertexInputInfo.vertexBindingDescriptionCount = 1;
     vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputInfo.vertexAttributeDescriptionCount = 5;
+    vertexInputInfo.vertexAttributeDescriptionCount = 6;
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions;
 
     VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
@@ -70,7 +70,8 @@ inline Uint32 clamp(Uint32 value, Uint32 min, Uint32 max) {
     return value;
 }
 
-VulkanRenderer::VulkanRenderer(MemoryAllocator* smallAllocator, MemoryAllocator* largeAllocator, ConsoleBuffer* consoleBuffer) :
+VulkanRenderer::VulkanRenderer(MemoryAllocator* smallAllocator, MemoryAllocator* largeAllocator, MemoryAllocator* frameAllocator,
+                               ConsoleBuffer* consoleBuffer) :
     m_bufferManager(),
     m_textureManager(smallAllocator, consoleBuffer),
     m_descriptorManager(smallAllocator),
@@ -142,6 +143,7 @@ VulkanRenderer::VulkanRenderer(MemoryAllocator* smallAllocator, MemoryAllocator*
     m_particleBatches(*smallAllocator, "VulkanRenderer::m_particleBatches"),
     m_allBatches(*smallAllocator, "VulkanRenderer::m_allBatches"),
     m_allocator(smallAllocator),
+    m_frameAllocator(frameAllocator),
     m_consoleBuffer(consoleBuffer)
 #ifdef DEBUG
     , m_imguiRenderCallback(nullptr)
@@ -1518,13 +1520,21 @@ void VulkanRenderer::createMsaaColorResources() {
 
 // Texture and pipeline delegation methods
 
-void VulkanRenderer::loadTexture(Uint64 textureId, const ResourceData& imageData) {
-    m_textureManager.loadTexture(textureId, imageData);
+bool VulkanRenderer::loadTexture(Uint64 textureId, PakResource& pakResource) {
+    // An atlased texture shares its atlas, which gets a descriptor set of its own
+    AtlasUV atlasUV;
+    if (pakResource.tryGetAtlasUV(textureId, atlasUV) && !loadAtlasTexture(atlasUV.atlasId, pakResource)) {
+        return false;
+    }
+    if (!m_textureManager.loadTexture(textureId, pakResource)) {
+        return false;
+    }
     // Create descriptor set for the texture
     VulkanTexture::TextureData texData;
     if (m_textureManager.getTexture(textureId, &texData)) {
         m_descriptorManager.createSingleTextureDescriptorSet(textureId, texData.imageView, texData.sampler);
     }
+    return true;
 }
 
 void VulkanRenderer::loadVectorShape(Uint64 shapeId, const ResourceData& shapeData) {
@@ -1824,13 +1834,16 @@ void VulkanRenderer::setActiveTextSceneId(Uint64 sceneId) {
     m_activeTextSceneId = sceneId;
 }
 
-void VulkanRenderer::loadAtlasTexture(Uint64 atlasId, const ResourceData& atlasData) {
-    m_textureManager.loadAtlasTexture(atlasId, atlasData);
+bool VulkanRenderer::loadAtlasTexture(Uint64 atlasId, PakResource& pakResource) {
+    if (!m_textureManager.loadAtlasTexture(atlasId, pakResource)) {
+        return false;
+    }
     // Create descriptor set for the atlas
     VulkanTexture::TextureData texData;
     if (m_textureManager.getTexture(atlasId, &texData)) {
         m_descriptorManager.createSingleTextureDescriptorSet(atlasId, texData.imageView, texData.sampler);
     }
+    return true;
 }
 
 void VulkanRenderer::createTexturedPipeline(Uint64 id, const ResourceData& vertShader, const ResourceData& fragShader, Uint32 numTextures) {
@@ -1936,7 +1949,7 @@ void VulkanRenderer::setSpriteDrawData(const Vector<float>& vertexData, const Ve
 
 void VulkanRenderer::setParticleDrawData(const Vector<float>& vertexData, const Vector<Uint16>& indices, Uint64 textureId) {
     vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
-    m_bufferManager.updateIndexedBuffer(m_particleBuffers[m_currentFrame], vertexData, indices, 18);
+    m_bufferManager.updateIndexedBuffer(m_particleBuffers[m_currentFrame], vertexData, indices, 22);
     m_particleTextureId = textureId;
 }
 
@@ -1946,8 +1959,8 @@ void VulkanRenderer::setSpriteBatches(const Vector<SpriteBatch>& batches) {
 
     m_spriteBatches.clear();
 
-    Vector<float> allVertexData(*m_allocator, "VulkanRenderer::generateSpriteBatches::allVertexData");
-    Vector<Uint16> allIndices(*m_allocator, "VulkanRenderer::generateSpriteBatches::allIndices");
+    Vector<float> allVertexData(*m_frameAllocator, "VulkanRenderer::generateSpriteBatches::allVertexData");
+    Vector<Uint16> allIndices(*m_frameAllocator, "VulkanRenderer::generateSpriteBatches::allIndices");
     Uint32 baseVertex = 0;
     Uint32 orderIndex = 0;
 
@@ -2022,8 +2035,8 @@ void VulkanRenderer::setParticleBatches(const Vector<ParticleBatch>& batches) {
 
     m_particleBatches.clear();
 
-    Vector<float> allVertexData(*m_allocator, "VulkanRenderer::generateParticleBatches::allVertexData");
-    Vector<Uint16> allIndices(*m_allocator, "VulkanRenderer::generateParticleBatches::allIndices");
+    Vector<float> allVertexData(*m_frameAllocator, "VulkanRenderer::generateParticleBatches::allVertexData");
+    Vector<Uint16> allIndices(*m_frameAllocator, "VulkanRenderer::generateParticleBatches::allIndices");
     Uint32 baseInstance = 0;
     // Start order index after sprite batches to preserve creation order
     Uint32 orderIndex = static_cast<Uint32>(m_spriteBatches.size());
@@ -2087,6 +2100,10 @@ void VulkanRenderer::setParticleBatches(const Vector<ParticleBatch>& batches) {
             allVertexData.push_back(instance.uvMinY);
             allVertexData.push_back(instance.uvMaxX);
             allVertexData.push_back(instance.uvMaxY);
+            allVertexData.push_back(instance.imageMinX);
+            allVertexData.push_back(instance.imageMinY);
+            allVertexData.push_back(instance.imageMaxX);
+            allVertexData.push_back(instance.imageMaxY);
         }
 
         baseInstance += drawData.instanceCount;
@@ -2100,7 +2117,7 @@ void VulkanRenderer::setParticleBatches(const Vector<ParticleBatch>& batches) {
     allIndices.push_back(3);
     allIndices.push_back(0);
 
-    m_bufferManager.updateIndexedBuffer(m_particleBuffers[m_currentFrame], allVertexData, allIndices, 18);
+    m_bufferManager.updateIndexedBuffer(m_particleBuffers[m_currentFrame], allVertexData, allIndices, 22);
     rebuildAllBatches();
 }
 
@@ -2587,7 +2604,7 @@ void VulkanRenderer::recordCommandBuffer(VkCommandBuffer commandBuffer, Uint32 i
             // Persistent layers (set-once, rendered every frame).
             // Draw in deterministic layer-id order so creation order is preserved
             // (e.g. text drop shadows created before glyphs always stay behind).
-            Vector<int> sortedVectorLayerIds(*m_allocator,
+            Vector<int> sortedVectorLayerIds(*m_frameAllocator,
                 "VulkanRenderer::recordCommandBuffer::sortedVectorLayerIds");
             sortedVectorLayerIds.reserve(m_vectorLayers.size());
             for (auto it = m_vectorLayers.begin(); it != m_vectorLayers.end(); ++it) {
@@ -2636,7 +2653,7 @@ void VulkanRenderer::recordCommandBuffer(VkCommandBuffer commandBuffer, Uint32 i
 
             // Draw text layers in ascending ID order to preserve creation order
             // (shadow layers always have lower IDs than their corresponding main layers).
-            Vector<int> sortedTextLayerIds(*m_allocator,
+            Vector<int> sortedTextLayerIds(*m_frameAllocator,
                 "VulkanRenderer::recordCommandBuffer::sortedTextLayerIds");
             sortedTextLayerIds.reserve(m_textLayers.size());
             for (auto it = m_textLayers.begin(); it != m_textLayers.end(); ++it) {
@@ -2710,7 +2727,7 @@ void VulkanRenderer::recordCommandBuffer(VkCommandBuffer commandBuffer, Uint32 i
         };
 
         // Create a Vector wrapper for the fade vertices
-        Vector<float> fadeVertexVector(*m_allocator, "VulkanRenderer::fadeOverlay");
+        Vector<float> fadeVertexVector(*m_frameAllocator, "VulkanRenderer::fadeOverlay");
         fadeVertexVector.reserve(FADE_TOTAL_FLOATS);
         for (int i = 0; i < FADE_TOTAL_FLOATS; ++i) {
             fadeVertexVector.push_back(fadeVertices[i]);
@@ -21,7 +21,9 @@ class ConsoleBuffer;
 
 class VulkanRenderer {
 public:
-    VulkanRenderer(MemoryAllocator* smallAllocator, MemoryAllocator* largeAllocator, ConsoleBuffer* consoleBuffer);
+    // frameAllocator holds per-frame temporaries and is reset by the owner after each frame
+    VulkanRenderer(MemoryAllocator* smallAllocator, MemoryAllocator* largeAllocator, MemoryAllocator* frameAllocator,
+                   ConsoleBuffer* consoleBuffer);
     ~VulkanRenderer();
 
     void initialize(SDL_Window* window, int preferredGpuIndex = -1, VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_FIFO_KHR);
@@ -49,8 +51,10 @@ public:
     void setSpriteBatches(const Vector<SpriteBatch>& batches);
     void setParticleBatches(const Vector<ParticleBatch>& batches);
     void setParticleDrawData(const Vector<float>& vertexData, const Vector<Uint16>& indices, Uint64 textureId = 0);
-    void loadTexture(Uint64 textureId, const ResourceData& imageData);
-    void loadAtlasTexture(Uint64 atlasId, const ResourceData& atlasData);
+    // Decompress straight from the pak into the texture staging buffer; false if
+    // the resource is missing or malformed
+    bool loadTexture(Uint64 textureId, PakResource& pakResource);
+    bool loadAtlasTexture(Uint64 atlasId, PakResource& pakResource);
     void loadVectorShape(Uint64 shapeId, const ResourceData& shapeData);
     void createDescriptorSetForTextures(Uint64 descriptorId, const Vector<Uint64>& textureIds);
     void setShaderParameters(int pipelineId, int paramCount, const float* params);
@@ -87,6 +91,8 @@ public:
     void updateWaterPolygonVertices(const float* vertices, int vertexCount);
     void createWaterDescriptorSet(Uint64 primaryTextureId, Uint64 reflectionTextureId);
     bool getTextureDimensions(Uint64 textureId, Uint32* width, Uint32* height) const;
+    // Leave out the largest mip levels of textures loaded from now on (see VulkanTexture::setMipSkip)
+    void setTextureMipSkip(Uint32 levels) { m_textureManager.setMipSkip(levels); }
     void setCameraTransform(float offsetX, float offsetY, float zoom);
     void setClearColor(float r, float g, float b, float a = 1.0f);
     void setFadeOverlay(float r, float g, float b, float alpha);
@@ -298,6 +304,7 @@ private:
 
     // Memory allocator
     MemoryAllocator* m_allocator;
+    MemoryAllocator* m_frameAllocator;  // Temporaries that die within the frame
 
     // Console buffer for logging (optional, may be nullptr)
     ConsoleBuffer* m_consoleBuffer;
@@ -30,12 +30,47 @@ static const char* vkResultToString(VkResult result) {
     }
 }
 
+// Resources are decompressed this far into the staging buffer. Their pixel data
+// then starts on a 16-byte boundary, as vkCmdCopyBufferToImage requires for the
+// 16-byte blocks of BC3 and ETC2.
+static const Uint64 STAGING_RESOURCE_OFFSET = 8;
+static_assert(sizeof(ImageHeader) == 8 && sizeof(AtlasHeader) == 8 && sizeof(AtlasEntry) % 16 == 0,
+              "STAGING_RESOURCE_OFFSET no longer aligns the pixel data");
+
+// Most mip levels an image can have: a full chain for the largest Uint16 size
+static const Uint32 MAX_TEXTURE_MIP_LEVELS = 16;
+
+// Maps an IMAGE_FORMAT_* value to its Vulkan format, or returns false if unsupported
+static bool toVulkanFormat(Uint16 format, VkFormat& outFormat, const char*& outName) {
+    if (format == IMAGE_FORMAT_BC1_DXT1) {
+        outFormat = VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        outName = "BC1/DXT1";
+    } else if (format == IMAGE_FORMAT_BC3_DXT5) {
+        outFormat = VK_FORMAT_BC3_UNORM_BLOCK;
+        outName = "BC3/DXT5";
+    } else if (format == IMAGE_FORMAT_ETC1) {
+        outFormat = VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+        outName = "ETC1";
+    } else if (format == IMAGE_FORMAT_ETC2) {
+        outFormat = VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+        outName = "ETC2";
+    } else {
+        return false;
+    }
+    return true;
+}
+
 VulkanTexture::VulkanTexture(MemoryAllocator* allocator, ConsoleBuffer* consoleBuffer) :
     m_device(VK_NULL_HANDLE),
     m_physicalDevice(VK_NULL_HANDLE),
     m_commandPool(VK_NULL_HANDLE),
     m_graphicsQueue(VK_NULL_HANDLE),
     m_initialized(false),
+    m_mipSkip(0),
+    m_stagingBuffer(VK_NULL_HANDLE),
+    m_stagingMemory(VK_NULL_HANDLE),
+    m_stagingData(nullptr),
+    m_stagingCapacity(0),
     m_textures(*allocator, "VulkanTexture::m_textures"),
     m_allocator(allocator),
     m_consoleBuffer(consoleBuffer)
@@ -63,6 +98,7 @@ void VulkanTexture::init(VkDevice device, VkPhysicalDevice physicalDevice, VkCom
 
 void VulkanTexture::cleanup() {
     destroyAllTextures();
+    destroyStaging();
     m_initialized = false;
 }
 
@@ -78,43 +114,25 @@ Uint32 VulkanTexture::findMemoryType(Uint32 typeFilter, VkMemoryPropertyFlags pr
     return 0;
 }
 
-void VulkanTexture::createTextureImage(Uint64 textureId, const void* imageData, Uint32 width, Uint32 height,
-                                       VkFormat format, Uint64 dataSize) {
-    m_consoleBuffer->log(SDL_LOG_PRIORITY_VERBOSE,
-        "[VulkanTexture] createTextureImage id=%llu size=%ux%u format=%d uploadBytes=%llu",
-        (unsigned long long)textureId,
-        width,
-        height,
-        (int)format,
-        (unsigned long long)dataSize);
-
-    // Check that the format is actually supported for optimal tiling
-    VkFormatProperties formatProps{};
-    vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &formatProps);
-    if (!(formatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
-        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR,
-            "[VulkanTexture] createTextureImage id=%llu: format %d not supported for optimal tiling (optimalTilingFeatures=0x%x) - skipping upload",
-            (unsigned long long)textureId, (int)format, (unsigned)formatProps.optimalTilingFeatures);
-        return;
+char* VulkanTexture::reserveStaging(Uint64 size) {
+    if (size <= m_stagingCapacity) {
+        return m_stagingData;
     }
-
-    // Create staging buffer
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
+    destroyStaging();
 
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size = dataSize;
+    bufferInfo.size = size;
     bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
     {
-        VkResult result = vkCreateBuffer(m_device, &bufferInfo, nullptr, &stagingBuffer);
+        VkResult result = vkCreateBuffer(m_device, &bufferInfo, nullptr, &m_stagingBuffer);
         assert(result == VK_SUCCESS);
     }
 
     VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(m_device, stagingBuffer, &memRequirements);
+    vkGetBufferMemoryRequirements(m_device, m_stagingBuffer, &memRequirements);
 
     VkMemoryAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
@@ -123,25 +141,119 @@ void VulkanTexture::createTextureImage(Uint64 textureId, const void* imageData,
                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
     {
-        VkResult result = vkAllocateMemory(m_device, &allocInfo, nullptr, &stagingBufferMemory);
+        VkResult result = vkAllocateMemory(m_device, &allocInfo, nullptr, &m_stagingMemory);
         assert(result == VK_SUCCESS);
     }
-    vkBindBufferMemory(m_device, stagingBuffer, stagingBufferMemory, 0);
+    vkBindBufferMemory(m_device, m_stagingBuffer, m_stagingMemory, 0);
 
-    // Copy image data to staging buffer
     void* data;
-    vkMapMemory(m_device, stagingBufferMemory, 0, dataSize, 0, &data);
-    SDL_memcpy(data, imageData, dataSize);
-    vkUnmapMemory(m_device, stagingBufferMemory);
+    {
+        VkResult result = vkMapMemory(m_device, m_stagingMemory, 0, VK_WHOLE_SIZE, 0, &data);
+        assert(result == VK_SUCCESS);
+    }
+    m_stagingData = (char*)data;
+    m_stagingCapacity = size;
+
+    m_consoleBuffer->log(SDL_LOG_PRIORITY_VERBOSE, "[VulkanTexture] staging buffer grown to %llu bytes",
+                         (unsigned long long)size);
+    return m_stagingData;
+}
+
+void VulkanTexture::destroyStaging() {
+    if (m_stagingBuffer == VK_NULL_HANDLE) {
+        return;
+    }
+    vkUnmapMemory(m_device, m_stagingMemory);
+    vkDestroyBuffer(m_device, m_stagingBuffer, nullptr);
+    vkFreeMemory(m_device, m_stagingMemory, nullptr);
+    m_stagingBuffer = VK_NULL_HANDLE;
+    m_stagingMemory = VK_NULL_HANDLE;
+    m_stagingData = nullptr;
+    m_stagingCapacity = 0;
+}
+
+void VulkanTexture::createTextureImage(Uint64 textureId, const void* imageData, Uint32 width, Uint32 height,
+                                       VkFormat format, Uint64 dataSize) {
+    SDL_memcpy(reserveStaging(dataSize), imageData, dataSize);
+    uploadStagedImage(textureId, 0, width, height, format, IMAGE_FORMAT_RAW_RGBA, 1, dataSize);
+}
+
+bool VulkanTexture::uploadStagedImage(Uint64 textureId, Uint64 stagingOffset, Uint32 width, Uint32 height,
+                                      VkFormat format, Uint16 imageFormat, Uint32 mipLevels, Uint64 dataSize) {
+    assert(stagingOffset + dataSize <= m_stagingCapacity);
+    if (mipLevels == 0) {
+        mipLevels = 1;
+    }
+    if (mipLevels > MAX_TEXTURE_MIP_LEVELS) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "[VulkanTexture] createTextureImage id=%llu: too many mip levels (%u)",
+                             (unsigned long long)textureId, mipLevels);
+        return false;
+    }
+
+    // Find each level in the staged data, one after another, and copy all but
+    // the skipped ones; the image is sized for the first level copied
+    Uint32 skip = SDL_min(m_mipSkip, mipLevels - 1);
+    VkBufferImageCopy regions[MAX_TEXTURE_MIP_LEVELS];
+    Uint64 levelOffset = 0;
+    Uint64 uploadBytes = 0;
+    for (Uint32 level = 0; level < mipLevels; level++) {
+        Uint32 levelWidth = SDL_max(1u, width >> level);
+        Uint32 levelHeight = SDL_max(1u, height >> level);
+        Uint64 levelSize = mipLevels == 1 ? dataSize : compressedImageLevelSize(imageFormat, levelWidth, levelHeight);
+        if (levelSize == 0 || levelOffset + levelSize > dataSize) {
+            m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR,
+                "[VulkanTexture] createTextureImage id=%llu: mip level %u overruns the %llu bytes of image data",
+                (unsigned long long)textureId, level, (unsigned long long)dataSize);
+            return false;
+        }
+        if (level >= skip) {
+            VkBufferImageCopy& region = regions[level - skip];
+            region = {};
+            region.bufferOffset = stagingOffset + levelOffset;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = level - skip;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = {0, 0, 0};
+            region.imageExtent = {levelWidth, levelHeight, 1};
+            uploadBytes += levelSize;
+        }
+        levelOffset += levelSize;
+    }
+    Uint32 levelCount = mipLevels - skip;
+    Uint32 imageWidth = regions[0].imageExtent.width;
+    Uint32 imageHeight = regions[0].imageExtent.height;
+
+    m_consoleBuffer->log(SDL_LOG_PRIORITY_VERBOSE,
+        "[VulkanTexture] createTextureImage id=%llu size=%ux%u format=%d mipLevels=%u (%u skipped) uploadBytes=%llu",
+        (unsigned long long)textureId,
+        imageWidth,
+        imageHeight,
+        (int)format,
+        levelCount,
+        skip,
+        (unsigned long long)uploadBytes);
+
+    // Check that the format is actually supported for optimal tiling
+    VkFormatProperties formatProps{};
+    vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &formatProps);
+    if (!(formatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR,
+            "[VulkanTexture] createTextureImage id=%llu: format %d not supported for optimal tiling (optimalTilingFeatures=0x%x) - skipping upload",
+            (unsigned long long)textureId, (int)format, (unsigned)formatProps.optimalTilingFeatures);
+        return false;
+    }
 
     // Create image
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageInfo.extent.width = width;
-    imageInfo.extent.height = height;
+    imageInfo.extent.width = imageWidth;
+    imageInfo.extent.height = imageHeight;
     imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = levelCount;
     imageInfo.arrayLayers = 1;
     imageInfo.format = format;
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
@@ -154,6 +266,7 @@ void VulkanTexture::createTextureImage(Uint64 textureId, const void* imageData,
     TextureData tex;
     tex.width = width;
     tex.height = height;
+    tex.mipLevels = levelCount;
     tex.isRenderTarget = false;
     {
         VkResult result = vkCreateImage(m_device, &imageInfo, nullptr, &tex.image);
@@ -212,7 +325,7 @@ void VulkanTexture::createTextureImage(Uint64 textureId, const void* imageData,
     barrier.image = tex.image;
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.levelCount = levelCount;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = 1;
     barrier.srcAccessMask = 0;
@@ -229,24 +342,15 @@ void VulkanTexture::createTextureImage(Uint64 textureId, const void* imageData,
                         0, nullptr,
                         1, &barrier);
 
-    // Copy buffer to image
-    VkBufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-    region.imageOffset = {0, 0, 0};
-    region.imageExtent = {width, height, 1};
-
-    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, tex.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    // Copy buffer to image, one region per mip level
+    vkCmdCopyBufferToImage(commandBuffer, m_stagingBuffer, tex.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           levelCount, regions);
     m_consoleBuffer->log(SDL_LOG_PRIORITY_VERBOSE,
-        "[VulkanTexture] vkCmdCopyBufferToImage texture=%llu extent=%ux%u",
+        "[VulkanTexture] vkCmdCopyBufferToImage texture=%llu extent=%ux%u levels=%u",
         (unsigned long long)textureId,
-        width,
-        height);
+        imageWidth,
+        imageHeight,
+        levelCount);
 
     // Transition to shader read
     barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
@@ -296,8 +400,6 @@ void VulkanTexture::createTextureImage(Uint64 textureId, const void* imageData,
     assert(waitIdleResult == VK_SUCCESS);
 
     vkFreeCommandBuffers(m_device, m_commandPool, 1, &commandBuffer);
-    vkDestroyBuffer(m_device, stagingBuffer, nullptr);
-    vkFreeMemory(m_device, stagingBufferMemory, nullptr);
 
     // Create image view
     VkImageViewCreateInfo viewInfo{};
@@ -307,7 +409,7 @@ void VulkanTexture::createTextureImage(Uint64 textureId, const void* imageData,
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.levelCount = levelCount;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
@@ -318,6 +420,7 @@ void VulkanTexture::createTextureImage(Uint64 textureId, const void* imageData,
 
     tex.sampler = VK_NULL_HANDLE; // Will be created by createTextureSampler
     m_textures.insert(textureId, tex);
+    return true;
 }
 
 void VulkanTexture::createTextureSampler(Uint64 textureId) {
@@ -337,10 +440,12 @@ void VulkanTexture::createTextureSampler(Uint64 textureId) {
     samplerInfo.unnormalizedCoordinates = VK_FALSE;
     samplerInfo.compareEnable = VK_FALSE;
     samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    // Trilinear filtering across the mip chain: as the camera zooms out, the
+    // screen-space UV derivatives grow and select the smaller levels
     samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
     samplerInfo.mipLodBias = 0.0f;
     samplerInfo.minLod = 0.0f;
-    samplerInfo.maxLod = 0.0f;
+    samplerInfo.maxLod = (float)(texPtr->mipLevels - 1);
 
     {
         VkResult result = vkCreateSampler(m_device, &samplerInfo, nullptr, &texPtr->sampler);
@@ -373,124 +478,126 @@ bool VulkanTexture::getTextureDimensions(Uint64 textureId, Uint32* width, Uint32
     return true;
 }
 
-void VulkanTexture::loadTexture(Uint64 textureId, const ResourceData& imageData) {
+bool VulkanTexture::loadTexture(Uint64 textureId, PakResource& pakResource) {
     // If texture already exists, skip reloading (textures don't change during hot-reload)
     if (m_textures.find(textureId) != nullptr) {
         m_consoleBuffer->log(SDL_LOG_PRIORITY_VERBOSE, "Texture %llu: already in GPU memory (cache hit)", (unsigned long long)textureId);
-        return;
+        return true;
     }
 
-    if (imageData.type != RESOURCE_TYPE_IMAGE) {
-        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Texture %llu: resource is not an image (type %d)", (unsigned long long)textureId, imageData.type);
+    Uint64 size;
+    Uint32 type;
+    if (!pakResource.getResourceInfo(textureId, size, type)) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Texture %llu: not found in pak", (unsigned long long)textureId);
+        return false;
+    }
+    if (type != RESOURCE_TYPE_IMAGE) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Texture %llu: resource is not an image (type %d)", (unsigned long long)textureId, type);
         assert(false && "Resource is not an image");
-        return;
+        return false;
     }
 
-    if (imageData.size == 40) {  // Atlas reference
-        // This is an atlas reference
-        const TextureHeader* texHeader = (const TextureHeader*)imageData.data;
-        Uint64 atlasId = texHeader->atlasId;
-        m_consoleBuffer->log(SDL_LOG_PRIORITY_VERBOSE, "Texture %llu: atlas reference (atlas id: %llu, UV: %f,%f - %f,%f)",
-                             (unsigned long long)textureId, (unsigned long long)atlasId,
-                             texHeader->coordinates[0], texHeader->coordinates[1],
-                             texHeader->coordinates[4], texHeader->coordinates[5]);
-        // Load the atlas if not already loaded
-        const TextureData* atlasTexPtr = m_textures.find(atlasId);
-        if (atlasTexPtr == nullptr) {
-            // Atlas not loaded, but we can't load it here without data
-            m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Atlas %llu not loaded for texture %llu", (unsigned long long)atlasId, (unsigned long long)textureId);
-            assert(false && "Atlas texture not loaded");
-            return;
+    if (size == sizeof(TextureHeader)) {
+        // Atlas reference: associate the texture ID with the atlas texture
+        TextureHeader texHeader;
+        if (!pakResource.loadResourceInto(textureId, &texHeader, sizeof(texHeader)) ||
+            !loadAtlasTexture(texHeader.atlasId, pakResource)) {
+            return false;
         }
-        // Associate the texture ID with the atlas texture
-        m_textures.insert(textureId, *atlasTexPtr);
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_VERBOSE, "Texture %llu: atlas reference (atlas id: %llu, UV: %f,%f - %f,%f)",
+                             (unsigned long long)textureId, (unsigned long long)texHeader.atlasId,
+                             texHeader.coordinates[0], texHeader.coordinates[1],
+                             texHeader.coordinates[4], texHeader.coordinates[5]);
+        TextureData atlasTex = *m_textures.find(texHeader.atlasId);
+        m_textures.insert(textureId, atlasTex);
         createTextureSampler(textureId);
-        return;
-    } else {
-        // Individual image
-        // Parse ImageHeader to get format, width, height
-        assert(imageData.size >= sizeof(ImageHeader));
-        const ImageHeader* header = (const ImageHeader*)imageData.data;
-        Uint32 width = header->width;
-        Uint32 height = header->height;
-        Uint16 format = header->format;
-
-        const char* compressedData = imageData.data + sizeof(ImageHeader);
-        Uint64 compressedSize = imageData.size - sizeof(ImageHeader);
-
-        // Map our format to Vulkan format
-        VkFormat vkFormat;
-        const char* formatStr;
-        if (format == IMAGE_FORMAT_BC1_DXT1) {
-            vkFormat = VK_FORMAT_BC1_RGB_UNORM_BLOCK;
-            formatStr = "BC1/DXT1";
-        } else if (format == IMAGE_FORMAT_BC3_DXT5) {
-            vkFormat = VK_FORMAT_BC3_UNORM_BLOCK;
-            formatStr = "BC3/DXT5";
-        } else if (format == IMAGE_FORMAT_ETC1) {
-            vkFormat = VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
-            formatStr = "ETC1";
-        } else if (format == IMAGE_FORMAT_ETC2) {
-            vkFormat = VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
-            formatStr = "ETC2";
-        } else {
-            m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Texture %llu: unsupported format %d", (unsigned long long)textureId, format);
-            assert(false && "Unsupported image format");
-            return;
-        }
+        return true;
+    }
 
-        m_consoleBuffer->log(SDL_LOG_PRIORITY_DEBUG, "Texture %llu: uploading to GPU (%dx%d, %s, %zu bytes)",
-                             (unsigned long long)textureId, width, height, formatStr, compressedSize);
-        createTextureImage(textureId, compressedData, width, height, vkFormat, compressedSize);
-        createTextureSampler(textureId);
+    // Individual image: decompress it into the staging buffer and parse the
+    // ImageHeader there; only the header is read back
+    if (size < sizeof(ImageHeader)) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Texture %llu: image resource too small (%llu bytes)",
+                             (unsigned long long)textureId, (unsigned long long)size);
+        return false;
+    }
+    char* staged = reserveStaging(STAGING_RESOURCE_OFFSET + size) + STAGING_RESOURCE_OFFSET;
+    if (!pakResource.loadResourceInto(textureId, staged, size)) {
+        return false;
+    }
+    ImageHeader header;
+    SDL_memcpy(&header, staged, sizeof(header));
+
+    VkFormat vkFormat;
+    const char* formatStr;
+    if (!toVulkanFormat(header.format, vkFormat, formatStr)) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Texture %llu: unsupported format %d", (unsigned long long)textureId, header.format);
+        assert(false && "Unsupported image format");
+        return false;
+    }
+
+    Uint64 compressedSize = size - sizeof(ImageHeader);
+    m_consoleBuffer->log(SDL_LOG_PRIORITY_DEBUG, "Texture %llu: uploading to GPU (%dx%d, %s, %d mip levels, %llu bytes)",
+                         (unsigned long long)textureId, header.width, header.height, formatStr,
+                         SDL_max(1, (int)header.mipLevels), (unsigned long long)compressedSize);
+    if (!uploadStagedImage(textureId, STAGING_RESOURCE_OFFSET + sizeof(ImageHeader), header.width, header.height,
+                           vkFormat, header.format, header.mipLevels, compressedSize)) {
+        return false;
     }
+    createTextureSampler(textureId);
+    return true;
 }
 
-void VulkanTexture::loadAtlasTexture(Uint64 atlasId, const ResourceData& atlasData) {
+bool VulkanTexture::loadAtlasTexture(Uint64 atlasId, PakResource& pakResource) {
     // If atlas texture already exists, skip reloading
     if (m_textures.find(atlasId) != nullptr) {
         m_consoleBuffer->log(SDL_LOG_PRIORITY_VERBOSE, "Atlas %llu: already in GPU memory (cache hit)", (unsigned long long)atlasId);
-        return;
+        return true;
+    }
+
+    Uint64 size;
+    Uint32 type;
+    if (!pakResource.getResourceInfo(atlasId, size, type) || type != RESOURCE_TYPE_IMAGE_ATLAS ||
+        size < sizeof(AtlasHeader)) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Atlas %llu: not found in pak", (unsigned long long)atlasId);
+        return false;
     }
 
-    // Parse AtlasHeader to get format, width, height
-    assert(atlasData.size >= sizeof(AtlasHeader));
-    const AtlasHeader* header = (const AtlasHeader*)atlasData.data;
-    Uint32 width = header->width;
-    Uint32 height = header->height;
-    Uint16 format = header->format;
-    Uint16 numEntries = header->numEntries;
+    // Decompress the atlas into the staging buffer and parse the AtlasHeader there;
+    // only the header is read back
+    char* staged = reserveStaging(STAGING_RESOURCE_OFFSET + size) + STAGING_RESOURCE_OFFSET;
+    if (!pakResource.loadResourceInto(atlasId, staged, size)) {
+        return false;
+    }
+    AtlasHeader header;
+    SDL_memcpy(&header, staged, sizeof(header));
 
     // Skip past header and entries to get to the compressed image data
-    Uint64 entriesSize = sizeof(AtlasEntry) * numEntries;
-    const char* compressedData = atlasData.data + sizeof(AtlasHeader) + entriesSize;
-    Uint64 compressedSize = atlasData.size - sizeof(AtlasHeader) - entriesSize;
+    Uint64 dataOffset = sizeof(AtlasHeader) + sizeof(AtlasEntry) * header.numEntries;
+    if (dataOffset > size) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Atlas %llu: %d entries overrun the resource",
+                             (unsigned long long)atlasId, header.numEntries);
+        return false;
+    }
 
-    // Map our format to Vulkan format
     VkFormat vkFormat;
     const char* formatStr;
-    if (format == IMAGE_FORMAT_BC1_DXT1) {
-        vkFormat = VK_FORMAT_BC1_RGB_UNORM_BLOCK;
-        formatStr = "BC1/DXT1";
-    } else if (format == IMAGE_FORMAT_BC3_DXT5) {
-        vkFormat = VK_FORMAT_BC3_UNORM_BLOCK;
-        formatStr = "BC3/DXT5";
-    } else if (format == IMAGE_FORMAT_ETC1) {
-        vkFormat = VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
-        formatStr = "ETC1";
-    } else if (format == IMAGE_FORMAT_ETC2) {
-        vkFormat = VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
-        formatStr = "ETC2";
-    } else {
-        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Atlas %llu: unsupported format %d", (unsigned long long)atlasId, format);
+    if (!toVulkanFormat(header.format, vkFormat, formatStr)) {
+        m_consoleBuffer->log(SDL_LOG_PRIORITY_ERROR, "Atlas %llu: unsupported format %d", (unsigned long long)atlasId, header.format);
         assert(false && "Unsupported atlas format");
-        return;
+        return false;
     }
 
-    m_consoleBuffer->log(SDL_LOG_PRIORITY_DEBUG, "Atlas %llu: uploading to GPU (%dx%d, %s, %d entries, %zu bytes)",
-                         (unsigned long long)atlasId, width, height, formatStr, numEntries, compressedSize);
-    createTextureImage(atlasId, compressedData, width, height, vkFormat, compressedSize);
+    Uint64 compressedSize = size - dataOffset;
+    m_consoleBuffer->log(SDL_LOG_PRIORITY_DEBUG, "Atlas %llu: uploading to GPU (%dx%d, %s, %d mip levels, %d entries, %llu bytes)",
+                         (unsigned long long)atlasId, header.width, header.height, formatStr,
+                         SDL_max(1, (int)header.mipLevels), header.numEntries, (unsigned long long)compressedSize);
+    if (!uploadStagedImage(atlasId, STAGING_RESOURCE_OFFSET + dataOffset, header.width, header.height,
+                           vkFormat, header.format, header.mipLevels, compressedSize)) {
+        return false;
+    }
     createTextureSampler(atlasId);
+    return true;
 }
 
 void VulkanTexture::destroyTexture(Uint64 textureId) {
@@ -558,6 +665,7 @@ void VulkanTexture::createRenderTargetTexture(Uint64 textureId, Uint32 width, Ui
     TextureData tex;
     tex.width = width;
     tex.height = height;
+    tex.mipLevels = 1;
     tex.isRenderTarget = true;
 
     // Create image that can be used as both color attachment and sampled texture
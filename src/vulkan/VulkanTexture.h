@@ -23,8 +23,9 @@ public:
         VkDeviceMemory memory;
         VkImageView imageView;
         VkSampler sampler;
-        Uint32 width;
+        Uint32 width;          // Full size of the texture, even with mip levels skipped
         Uint32 height;
+        Uint32 mipLevels;      // Mip levels in the image
         bool isRenderTarget;
     };
 
@@ -36,9 +37,17 @@ public:
     bool hasTexture(Uint64 textureId) const;
     bool getTextureDimensions(Uint64 textureId, Uint32* width, Uint32* height) const;
 
-    // Load texture from resource data (handles image header parsing)
-    void loadTexture(Uint64 textureId, const ResourceData& imageData);
-    void loadAtlasTexture(Uint64 atlasId, const ResourceData& atlasData);
+    // Load a texture or atlas straight from the pak (handles image header parsing).
+    // The resource is decompressed into the staging buffer, so no CPU copy of its
+    // pixels outlives the upload. A texture packed into an atlas shares the atlas
+    // image, which is loaded first. Return false if a resource is missing or malformed.
+    bool loadTexture(Uint64 textureId, PakResource& pakResource);
+    bool loadAtlasTexture(Uint64 atlasId, PakResource& pakResource);
+
+    // Leave out this many of the largest mip levels of textures loaded from now
+    // on, to save GPU memory on low-memory configs. The smallest level stored is
+    // always kept; textures without mip chains are unaffected.
+    void setMipSkip(Uint32 levels) { m_mipSkip = levels; }
 
     // Render target texture creation (for render-to-texture)
     void createRenderTargetTexture(Uint64 textureId, Uint32 width, Uint32 height, VkFormat format);
@@ -52,12 +61,28 @@ public:
 
 private:
     Uint32 findMemoryType(Uint32 typeFilter, VkMemoryPropertyFlags properties);
+    // Returns the mapped staging buffer, grown to hold at least size bytes
+    char* reserveStaging(Uint64 size);
+    void destroyStaging();
+    // Copies dataSize bytes at stagingOffset in the staging buffer into a new image.
+    // They hold mipLevels levels of the image in the pak's IMAGE_FORMAT_* format,
+    // the first m_mipSkip of which (leaving one at least) are not uploaded.
+    bool uploadStagedImage(Uint64 textureId, Uint64 stagingOffset, Uint32 width, Uint32 height,
+                           VkFormat format, Uint16 imageFormat, Uint32 mipLevels, Uint64 dataSize);
 
     VkDevice m_device;
     VkPhysicalDevice m_physicalDevice;
     VkCommandPool m_commandPool;
     VkQueue m_graphicsQueue;
     bool m_initialized;
+    Uint32 m_mipSkip;
+
+    // Host-visible upload buffer, mapped for as long as it exists. Every upload
+    // waits for the queue to go idle, so this one buffer serves all of them.
+    VkBuffer m_stagingBuffer;
+    VkDeviceMemory m_stagingMemory;
+    char* m_stagingData;
+    Uint64 m_stagingCapacity;
 
     HashTable<Uint64, TextureData> m_textures;
     MemoryAllocator* m_allocator;
@@ -0,0 +1,197 @@
+// Allocator latency benchmark.
+//
+// Usage: alloc_bench [pairs] [threads]
+//   Grows a SmallMemoryAllocator to a series of live-block populations and, at
+//   each one, times `pairs` (default 100000) rounds of freeing a random live
+//   block and allocating a new one in its place. Sizes follow the engine's mix
+//   of mostly small Vector, HashTable and String buffers with a tail of larger
+//   ones. The time per pair should not grow with the population.
+//
+//   Then runs the same churn on 1 to `threads` (default 6, one per engine
+//   thread) threads sharing one allocator, each over its own 4000 live
+//   blocks, with a fifth of the frees landing on blocks another thread
+//   allocated. Time per pair should stay near the single-thread figure
+//   instead of climbing as threads queue on the heap lock.
+//
+//   Finally churns a LargeMemoryAllocator with resource-sized blocks (1 KB to
+//   2 MB, log-uniform) at a series of live totals, timing pairs/10 rounds at
+//   each. Besides the mean and worst pair it prints how much chunk memory the
+//   allocator holds per live byte, which grows with fragmentation.
+
+#include "../src/memory/SmallMemoryAllocator.h"
+#include "../src/memory/LargeMemoryAllocator.h"
+#include <SDL3/SDL_stdinc.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static const Uint64 POPULATIONS[] = {1000, 4000, 16000, 64000, 256000};
+
+// Nine in ten requests are 8..256 bytes, the rest up to 4 KB
+static Uint64 randomSize(mt19937& rng) {
+    if (rng() % 10 != 0) {
+        return 8 + rng() % 249;
+    }
+    return 257 + rng() % 3840;
+}
+
+static const Uint64 LARGE_LIVE_MB[] = {16, 64, 256};
+
+// Log-uniform between 1 KB and 2 MB, 16 byte granular
+static Uint64 randomLargeSize(mt19937& rng) {
+    double log2Size = 10.0 + 11.0 * (rng() / (double)mt19937::max());
+    return ((Uint64)exp2(log2Size) + 15) & ~(Uint64)15;
+}
+
+static double nanosecondsSince(chrono::steady_clock::time_point start, Uint64 count) {
+    chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / (double)count;
+}
+
+// Allocate/free churn for one thread. Every fifth new block replaces one in
+// the neighbouring thread's set, so blocks regularly die on a thread other
+// than the one that allocated them.
+static void churn(SmallMemoryAllocator& allocator, vector<vector<void*>>& sets,
+                  vector<mutex>& setMutexes, Uint64 thread, Uint64 pairs) {
+    mt19937 rng(1234 + thread);
+    Uint64 neighbour = (thread + 1) % sets.size();
+    for (Uint64 i = 0; i < pairs; i++) {
+        Uint64 owner = (i % 5 == 4) ? neighbour : thread;
+        void* ptr = allocator.allocate(randomSize(rng), "alloc_bench");
+        void* victim;
+        {
+            lock_guard<mutex> lock(setMutexes[owner]);
+            vector<void*>& live = sets[owner];
+            Uint64 index = rng() % live.size();
+            victim = live[index];
+            live[index] = ptr;
+        }
+        allocator.free(victim);
+    }
+}
+
+static void benchLarge(Uint64 pairs) {
+    struct Block {
+        void* ptr;
+        Uint64 size;
+    };
+
+    LargeMemoryAllocator allocator;
+    mt19937 rng(1234);
+    vector<Block> live;
+    Uint64 liveBytes = 0;
+
+    cout << endl << setw(12) << "live MB" << setw(16) << "ns/pair" << setw(16) << "worst ns"
+         << setw(16) << "chunk MB" << setw(16) << "chunk/live" << endl;
+    for (Uint64 liveMb : LARGE_LIVE_MB) {
+        Uint64 target = liveMb << 20;
+        while (liveBytes < target) {
+            Uint64 size = randomLargeSize(rng);
+            live.push_back({allocator.allocate(size, "alloc_bench"), size});
+            liveBytes += size;
+        }
+
+        double worstNs = 0.0;
+        auto churnStart = chrono::steady_clock::now();
+        for (Uint64 i = 0; i < pairs; i++) {
+            auto pairStart = chrono::steady_clock::now();
+            Uint64 index = rng() % live.size();
+            allocator.free(live[index].ptr);
+            liveBytes -= live[index].size;
+            Uint64 size = randomLargeSize(rng);
+            live[index] = {allocator.allocate(size, "alloc_bench"), size};
+            liveBytes += size;
+            worstNs = max(worstNs, nanosecondsSince(pairStart, 1));
+        }
+        double pairNs = nanosecondsSince(churnStart, pairs);
+
+        double chunkMb = allocator.getTotalMemory() / (1024.0 * 1024.0);
+        double liveNowMb = liveBytes / (1024.0 * 1024.0);
+        cout << setw(12) << liveMb << fixed << setprecision(1) << setw(16) << pairNs << setw(16) << worstNs
+             << setw(16) << chunkMb << setprecision(2) << setw(16) << chunkMb / liveNowMb << defaultfloat << endl;
+    }
+
+    for (Block& block : live) {
+        allocator.free(block.ptr);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Uint64 pairs = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100000;
+    Uint64 maxThreads = argc > 2 ? strtoull(argv[2], nullptr, 10) : 6;
+    if (pairs == 0 || maxThreads == 0) {
+        cerr << "Usage: alloc_bench [pairs] [threads]" << endl;
+        return 1;
+    }
+
+    SmallMemoryAllocator allocator;
+    mt19937 rng(1234);
+    vector<void*> live;
+
+    cout << setw(12) << "live blocks" << setw(16) << "fill ns/alloc" << setw(16) << "ns/pair" << endl;
+    for (Uint64 population : POPULATIONS) {
+        Uint64 added = population - live.size();
+        auto fillStart = chrono::steady_clock::now();
+        while (live.size() < population) {
+            live.push_back(allocator.allocate(randomSize(rng), "alloc_bench"));
+        }
+        double fillNs = nanosecondsSince(fillStart, added);
+
+        auto churnStart = chrono::steady_clock::now();
+        for (Uint64 i = 0; i < pairs; i++) {
+            Uint64 index = rng() % live.size();
+            allocator.free(live[index]);
+            live[index] = allocator.allocate(randomSize(rng), "alloc_bench");
+        }
+        double pairNs = nanosecondsSince(churnStart, pairs);
+
+        cout << setw(12) << population << fixed << setprecision(1) << setw(16) << fillNs
+             << setw(16) << pairNs << defaultfloat << endl;
+    }
+
+    for (void* ptr : live) {
+        allocator.free(ptr);
+    }
+
+    cout << endl << setw(12) << "threads" << setw(16) << "ns/pair" << endl;
+    for (Uint64 threadCount = 1; threadCount <= maxThreads; threadCount++) {
+        vector<vector<void*>> sets(threadCount);
+        vector<mutex> setMutexes(threadCount);
+        for (Uint64 t = 0; t < threadCount; t++) {
+            for (Uint64 i = 0; i < 4000; i++) {
+                sets[t].push_back(allocator.allocate(randomSize(rng), "alloc_bench"));
+            }
+        }
+
+        auto start = chrono::steady_clock::now();
+        vector<thread> threads;
+        for (Uint64 t = 0; t < threadCount; t++) {
+            threads.emplace_back(churn, ref(allocator), ref(sets), ref(setMutexes), t, pairs);
+        }
+        for (thread& worker : threads) {
+            worker.join();
+        }
+        double pairNs = nanosecondsSince(start, pairs * threadCount);
+
+        cout << setw(12) << threadCount << fixed << setprecision(1) << setw(16) << pairNs
+             << defaultfloat << endl;
+
+        for (vector<void*>& set : sets) {
+            for (void* ptr : set) {
+                allocator.free(ptr);
+            }
+        }
+    }
+
+    benchLarge(pairs / 10);
+    return 0;
+}
@@ -0,0 +1,263 @@
+// CMPR throughput benchmark.
+//
+// Usage: compress_bench [path ...]
+//   Each path is a file, a directory (searched recursively) or a .pak file.
+//   Loose files are grouped by extension and compressed here; pak resources
+//   are grouped by resource type and their stored CMPR streams are decoded
+//   as-is, against the pak's dictionaries where they name one, which matches
+//   what the resource workers do at load time.
+//   With no arguments, benchmarks the files under res/.
+
+#include "../src/core/ResourceTypes.h"
+#include "../src/compress/Compress.h"
+#include <SDL3/SDL_stdinc.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Decode at least this many bytes per group so small groups still time reliably
+static const size_t MIN_BENCH_BYTES = 256ull * 1024 * 1024;
+static const int MAX_ITERATIONS = 1000;
+
+struct Sample {
+    vector<char> original;     // Empty for pak resources, which are only decoded
+    vector<char> compressed;   // CMPR stream
+    size_t originalSize;
+    const vector<char>* dictionary = nullptr; // For dictionary streams
+};
+
+// Dictionaries of the paks on the command line, by resource id
+static map<Uint64, vector<char>> dictionaries;
+
+struct Group {
+    vector<Sample> samples;
+    size_t originalBytes = 0;
+    size_t compressedBytes = 0;
+};
+
+static bool readFile(const string& filename, vector<char>& data) {
+    ifstream file(filename, ios::binary | ios::ate);
+    if (!file) return false;
+    data.resize((size_t)file.tellg());
+    file.seekg(0);
+    file.read(data.data(), data.size());
+    return (bool)file;
+}
+
+static bool addLooseFile(const string& filename, map<string, Group>& groups) {
+    Sample sample;
+    if (!readFile(filename, sample.original) || sample.original.empty()) {
+        return false;
+    }
+    sample.originalSize = sample.original.size();
+    sample.compressed.resize(Compress::maxSize(sample.originalSize));
+    size_t size = Compress::compress(sample.original.data(), sample.originalSize,
+                                     sample.compressed.data(), sample.compressed.size());
+    if (size == 0) {
+        cerr << "Failed to compress " << filename << endl;
+        return false;
+    }
+    sample.compressed.resize(size);
+
+    string ext = filesystem::path(filename).extension().string();
+    Group& group = groups[ext.empty() ? "(none)" : ext];
+    group.originalBytes += sample.originalSize;
+    group.compressedBytes += size;
+    group.samples.push_back(std::move(sample));
+    return true;
+}
+
+static bool addPakFile(const string& filename, map<string, Group>& groups) {
+    vector<char> pak;
+    if (!readFile(filename, pak) || pak.size() < sizeof(PakFileHeader)) {
+        cerr << "Failed to read " << filename << endl;
+        return false;
+    }
+    PakFileHeader header;
+    memcpy(&header, pak.data(), sizeof(header));
+    if (pak.size() < sizeof(PakFileHeader) + (size_t)header.numResources * sizeof(ResourcePtr)) {
+        cerr << filename << " has a truncated resource table" << endl;
+        return false;
+    }
+
+    // Deduplicated resources share a blob; decode each blob once
+    vector<Uint64> offsets;
+    for (Uint32 i = 0; i < header.numResources; i++) {
+        ResourcePtr ptr;
+        memcpy(&ptr, pak.data() + sizeof(PakFileHeader) + i * sizeof(ResourcePtr), sizeof(ptr));
+        offsets.push_back(ptr.offset);
+
+        CompressionHeader comp;
+        if (ptr.offset + sizeof(comp) <= pak.size()) {
+            memcpy(&comp, pak.data() + ptr.offset, sizeof(comp));
+            if (comp.type == RESOURCE_TYPE_CMPR_DICTIONARY && comp.compressionType == COMPRESSION_FLAGS_UNCOMPRESSED &&
+                ptr.offset + sizeof(comp) + comp.compressedSize <= pak.size()) {
+                const char* payload = pak.data() + ptr.offset + sizeof(comp);
+                dictionaries[ptr.id].assign(payload, payload + comp.compressedSize);
+            }
+        }
+    }
+    sort(offsets.begin(), offsets.end());
+    offsets.erase(unique(offsets.begin(), offsets.end()), offsets.end());
+
+    for (Uint64 offset : offsets) {
+        CompressionHeader comp;
+        if (offset + sizeof(comp) > pak.size()) {
+            cerr << filename << ": resource at " << offset << " is out of range" << endl;
+            return false;
+        }
+        memcpy(&comp, pak.data() + offset, sizeof(comp));
+        if (comp.compressionType != COMPRESSION_FLAGS_CMPR) {
+            continue;
+        }
+        if (offset + sizeof(comp) + comp.compressedSize > pak.size()) {
+            cerr << filename << ": resource at " << offset << " is truncated" << endl;
+            return false;
+        }
+        Sample sample;
+        const char* payload = pak.data() + offset + sizeof(comp);
+        sample.compressed.assign(payload, payload + comp.compressedSize);
+        sample.originalSize = comp.decompressedSize;
+        Uint64 dictId = Compress::dictionaryId(payload, comp.compressedSize);
+        if (dictId != 0) {
+            auto dictionary = dictionaries.find(dictId);
+            if (dictionary == dictionaries.end()) {
+                cerr << filename << ": resource at " << offset << " needs missing dictionary " << dictId << endl;
+                return false;
+            }
+            sample.dictionary = &dictionary->second;
+        }
+
+        Group& group = groups[string("pak ") + resourceTypeName(comp.type)];
+        group.originalBytes += sample.originalSize;
+        group.compressedBytes += comp.compressedSize;
+        group.samples.push_back(std::move(sample));
+    }
+    return true;
+}
+
+static size_t decompressSample(const Sample& sample, vector<char>& output) {
+    if (sample.dictionary != nullptr) {
+        return Compress::decompressWithDict(sample.compressed.data(), sample.compressed.size(),
+                                            sample.dictionary->data(), sample.dictionary->size(),
+                                            output.data(), output.size());
+    }
+    return Compress::decompress(sample.compressed.data(), sample.compressed.size(), output.data(), output.size());
+}
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> paths;
+    for (int i = 1; i < argc; i++) {
+        paths.push_back(argv[i]);
+    }
+    if (paths.empty()) {
+        paths.push_back("res");
+    }
+
+    map<string, Group> groups;
+    for (const string& path : paths) {
+        if (filesystem::is_directory(path)) {
+            vector<string> files;
+            for (const auto& entry : filesystem::recursive_directory_iterator(path)) {
+                if (entry.is_regular_file()) {
+                    files.push_back(entry.path().string());
+                }
+            }
+            sort(files.begin(), files.end());
+            for (const string& file : files) {
+                addLooseFile(file, groups);
+            }
+        } else if (filesystem::path(path).extension() == ".pak") {
+            if (!addPakFile(path, groups)) {
+                return 1;
+            }
+        } else if (!addLooseFile(path, groups)) {
+            cerr << "Skipping " << path << endl;
+        }
+    }
+
+    if (groups.empty()) {
+        cerr << "Usage: compress_bench [file | directory | file.pak] ..." << endl;
+        return 1;
+    }
+
+    cout << left << setw(22) << "type" << right << setw(7) << "files" << setw(12) << "MB"
+         << setw(9) << "ratio" << setw(14) << "comp MB/s" << setw(14) << "decomp MB/s" << endl;
+
+    vector<char> output;
+    size_t totalOriginal = 0;
+    double totalDecompressSeconds = 0.0;
+    size_t totalDecompressed = 0;
+    for (auto& [name, group] : groups) {
+        if (group.samples.empty() || group.originalBytes == 0) {
+            continue;
+        }
+
+        // Compression is only timed for loose files; pak streams were encoded by the packer
+        double compressMBs = 0.0;
+        bool haveOriginals = !group.samples[0].original.empty();
+        if (haveOriginals) {
+            vector<char> scratch;
+            auto start = chrono::steady_clock::now();
+            for (const Sample& sample : group.samples) {
+                scratch.resize(Compress::maxSize(sample.originalSize));
+                Compress::compress(sample.original.data(), sample.originalSize, scratch.data(), scratch.size());
+            }
+            compressMBs = group.originalBytes / 1e6 / secondsSince(start);
+        }
+
+        // Verify every stream round-trips before timing it
+        for (const Sample& sample : group.samples) {
+            output.resize(sample.originalSize);
+            size_t size = decompressSample(sample, output);
+            if (size != sample.originalSize ||
+                (haveOriginals && memcmp(output.data(), sample.original.data(), size) != 0)) {
+                cerr << "Round trip mismatch in group " << name << endl;
+                return 1;
+            }
+        }
+
+        int iterations = (int)min<size_t>(MAX_ITERATIONS, max<size_t>(1, MIN_BENCH_BYTES / group.originalBytes));
+        auto start = chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            for (const Sample& sample : group.samples) {
+                output.resize(sample.originalSize);
+                decompressSample(sample, output);
+            }
+        }
+        double seconds = secondsSince(start);
+        double decompressMBs = (double)group.originalBytes * iterations / 1e6 / seconds;
+
+        totalOriginal += group.originalBytes;
+        totalDecompressed += group.originalBytes * iterations;
+        totalDecompressSeconds += seconds;
+
+        cout << left << setw(22) << name << right << setw(7) << group.samples.size()
+             << setw(12) << fixed << setprecision(2) << group.originalBytes / 1e6
+             << setw(9) << setprecision(3) << (double)group.compressedBytes / group.originalBytes
+             << setw(14) << setprecision(1);
+        if (haveOriginals) {
+            cout << compressMBs;
+        } else {
+            cout << "-";
+        }
+        cout << setw(14) << decompressMBs << endl;
+    }
+
+    cout << "Total " << fixed << setprecision(2) << totalOriginal / 1e6 << " MB, decompression "
+         << setprecision(1) << totalDecompressed / 1e6 / totalDecompressSeconds << " MB/s" << endl;
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include <SDL3/SDL_stdinc.h>
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <vector>
 #include <sys/stat.h>
 #include <cstring>
@@ -10,6 +11,14 @@
 #include <cctype>
 #include <filesystem>
 #include <functional>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <queue>
+#include <atomic>
+#include <thread>
+#include <sstream>
+#include <chrono>
 #include <png.h>
 #include <squish.h>
 #include <cassert>
@@ -65,27 +74,43 @@ struct PNGImageData {
     string filename;
     Uint64 id;
     time_t mtime;
-    vector<uint8_t> imageData;  // RGBA data
+    Uint64 contentHash;         // Hash of the PNG file, for the build cache
+    bool loaded = false;        // Whether imageData holds the decoded pixels
+    vector<uint8_t> imageData;  // RGB or RGBA data, decoded on demand
     Uint32 width;
     Uint32 height;
     bool hasAlpha;
+    Uint32 trimX = 0;           // Part of the image packed into the atlas, see computeSpriteTrim()
+    Uint32 trimY = 0;
+    Uint32 trimWidth = 0;
+    Uint32 trimHeight = 0;
+    vector<float> hull;         // Outline as s, t pairs (SpriteMeshEntry::points), empty for none
+
+    bool trimmed() const {
+        return trimWidth != width || trimHeight != height;
+    }
 };
 
 // Rectangle for bin packing
 struct PackRect {
-    Uint32 width;
+    Uint32 width;       // Padded image size, before any rotation
     Uint32 height;
     Uint32 x;
     Uint32 y;
     Uint64 imageIndex;  // Index into PNGImageData array
     bool packed;
+    bool rotated;       // Placed turned 90 degrees, covering height x width
+
+    Uint32 packedWidth() const { return rotated ? height : width; }
+    Uint32 packedHeight() const { return rotated ? width : height; }
 };
 
-// Simple maxrects bin packing algorithm
+// Maxrects bin packing with the Best Short Side Fit heuristic (ties broken on
+// the long side), optionally trying each rectangle turned 90 degrees as well
 class MaxRectsBinPacker {
 public:
-    MaxRectsBinPacker(Uint32 binWidth, Uint32 binHeight)
-        : binWidth_(binWidth), binHeight_(binHeight) {
+    MaxRectsBinPacker(Uint32 binWidth, Uint32 binHeight, bool allowRotation)
+        : binWidth_(binWidth), binHeight_(binHeight), allowRotation_(allowRotation) {
         // Start with one free rect covering entire bin
         freeRects_.push_back({0, 0, binWidth, binHeight});
     }
@@ -93,19 +118,28 @@ public:
     // Try to pack a rectangle, returns true if successful
     bool pack(PackRect& rect) {
         int bestIndex = -1;
+        bool bestRotated = false;
         Uint32 bestShortSide = UINT32_MAX;
+        Uint32 bestLongSide = UINT32_MAX;
 
-        // Find best free rect using Best Short Side Fit heuristic
+        // Find best free rect and orientation
         for (Uint64 i = 0; i < freeRects_.size(); i++) {
-            FreeRect& freeRect = freeRects_[i];
-
-            if (rect.width <= freeRect.width && rect.height <= freeRect.height) {
-                Uint32 shortSide = min(freeRect.width - rect.width, freeRect.height - rect.height);
-                if (shortSide < bestShortSide) {
+            const FreeRect& freeRect = freeRects_[i];
+            for (int turn = 0; turn < (allowRotation_ ? 2 : 1); turn++) {
+                Uint32 width = turn ? rect.height : rect.width;
+                Uint32 height = turn ? rect.width : rect.height;
+                if (width > freeRect.width || height > freeRect.height) {
+                    continue;
+                }
+                Uint32 leftoverX = freeRect.width - width;
+                Uint32 leftoverY = freeRect.height - height;
+                Uint32 shortSide = min(leftoverX, leftoverY);
+                Uint32 longSide = max(leftoverX, leftoverY);
+                if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide)) {
                     bestShortSide = shortSide;
+                    bestLongSide = longSide;
                     bestIndex = (int)i;
-                    rect.x = freeRect.x;
-                    rect.y = freeRect.y;
+                    bestRotated = turn != 0;
                 }
             }
         }
@@ -114,8 +148,11 @@ public:
             return false;  // Couldn't fit
         }
 
+        rect.x = freeRects_[bestIndex].x;
+        rect.y = freeRects_[bestIndex].y;
+        rect.rotated = bestRotated;
         rect.packed = true;
-        splitFreeRect(bestIndex, rect);
+        splitFreeRects({rect.x, rect.y, rect.packedWidth(), rect.packedHeight()});
         return true;
     }
 
@@ -127,8 +164,9 @@ private:
     vector<FreeRect> freeRects_;
     Uint32 binWidth_;
     Uint32 binHeight_;
+    bool allowRotation_;
 
-    void splitFreeRect(int index, const PackRect& usedRect) {
+    void splitFreeRects(const FreeRect& usedRect) {
         // Process ALL free rectangles and split any that overlap with the used rectangle
         Uint64 numRects = freeRects_.size();
         for (Uint64 i = 0; i < numRects; i++) {
@@ -142,7 +180,7 @@ private:
         pruneFreeRects();
     }
 
-    bool splitSingleFreeRectByUsedRect(Uint64 index, const PackRect& usedRect) {
+    bool splitSingleFreeRectByUsedRect(Uint64 index, const FreeRect& usedRect) {
         FreeRect freeRect = freeRects_[index];
 
         // Check if used rectangle intersects with this free rectangle
@@ -221,6 +259,7 @@ struct TextureAtlas {
     Uint32 width;
     Uint32 height;
     bool hasAlpha;
+    Uint32 mipLevels;           // Levels of its mip chain, base image included
     vector<uint8_t> imageData;  // RGBA atlas image
     vector<AtlasEntry> entries;
     vector<Uint64> packedImageIndices;  // Indices of images packed into this atlas
@@ -240,10 +279,37 @@ bool loadFile(const string& filename, vector<char>& data, time_t& mtime) {
     return true;
 }
 
-void compressData(const vector<char>& input, vector<char>& output, Uint32& compressionType) {
-    size_t maxCompressedSize = Compress::maxSize(input.size());
+// Per resource type sizes for the --high-compression report
+struct CompressionStats {
+    Uint32 count = 0;
+    Uint64 originalBytes = 0;
+    Uint64 fastBytes = 0;   // Stored size at Compress::LEVEL_FAST
+    Uint64 storedBytes = 0;
+
+    void add(const CompressionStats& other) {
+        count += other.count;
+        originalBytes += other.originalBytes;
+        fastBytes += other.fastBytes;
+        storedBytes += other.storedBytes;
+    }
+};
+
+// Returns the CMPR stream size in output, or 0 if compression failed
+static size_t compressStream(const vector<char>& input, vector<char>& output, Compress::Level level) {
+    // Resources spanning several chunks are stored as chunked streams so the
+    // engine can decode their chunks on all of its workers at once
+    bool chunked = input.size() > Compress::DEFAULT_CHUNK_SIZE;
+    size_t maxCompressedSize = chunked ? Compress::maxSizeChunked(input.size()) : Compress::maxSize(input.size());
     output.resize(maxCompressedSize);
-    size_t compressedSize = Compress::compress(input.data(), input.size(), output.data(), maxCompressedSize);
+    return chunked
+        ? Compress::compressChunked(input.data(), input.size(), output.data(), maxCompressedSize,
+                                    Compress::DEFAULT_CHUNK_SIZE, level)
+        : Compress::compress(input.data(), input.size(), output.data(), maxCompressedSize, level);
+}
+
+void compressData(const vector<char>& input, vector<char>& output, Uint32& compressionType,
+                  Compress::Level level = Compress::LEVEL_FAST, CompressionStats* stats = nullptr) {
+    size_t compressedSize = compressStream(input, output, level);
     if (compressedSize > 0 && compressedSize < input.size()) {
         output.resize((size_t)compressedSize);
         compressionType = COMPRESSION_FLAGS_CMPR;
@@ -252,8 +318,192 @@ void compressData(const vector<char>& input, vector<char>& output, Uint32& compr
         output = input;
         compressionType = COMPRESSION_FLAGS_UNCOMPRESSED;
     }
+
+    if (stats != nullptr) {
+        vector<char> fast;
+        size_t fastSize = compressStream(input, fast, Compress::LEVEL_FAST);
+        stats->count++;
+        stats->originalBytes += input.size();
+        stats->fastBytes += (fastSize > 0 && fastSize < input.size()) ? fastSize : input.size();
+        stats->storedBytes += output.size();
+    }
+}
+
+// Runs task(i) for every i in [0, count) on up to jobs threads. Each task must
+// only write to its own slot (file, log, stats), so the pak comes out the same
+// whatever the thread count and scheduling.
+static void parallelFor(Uint64 count, unsigned jobs, const function<void(Uint64)>& task) {
+    unsigned threads = (unsigned)min<Uint64>(jobs, count);
+    if (threads <= 1) {
+        for (Uint64 i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+    atomic<Uint64> next{0};
+    auto worker = [&]() {
+        for (Uint64 i = next++; i < count; i = next++) {
+            task(i);
+        }
+    };
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (thread& t : pool) {
+        t.join();
+    }
+}
+
+// ============================================================================
+// Build cache
+// Processed resources are kept in a directory next to the pak, keyed by a hash
+// of their input bytes and the options they were processed with, so a rebuild
+// only redoes work whose inputs changed; a file that was touched but not edited
+// costs one hash. Entries unused for BUILD_CACHE_MAX_AGE_DAYS are pruned.
+// ============================================================================
+
+// Bump whenever a packer change alters the output for the same input
+static const Uint32 BUILD_CACHE_VERSION = 2;
+static const int BUILD_CACHE_MAX_AGE_DAYS = 30;
+
+// Cache entries that are not a resource of their own type
+enum BuildCacheKind : Uint32 {
+    BUILD_CACHE_IMAGE_INFO = 0x10000,   // CachedImageInfo of a PNG
+    BUILD_CACHE_STANDALONE_IMAGE,       // ImageHeader resource of a PNG too large for an atlas
+    BUILD_CACHE_ATLAS_REVIEW,           // Cache key of the atlas last saved by --output-atlases
+    BUILD_CACHE_DICTIONARY,             // Dictionary trained from a set of samples
+    BUILD_CACHE_DICTIONARY_STREAM,      // A resource compressed with and without a dictionary
+};
+
+struct BuildCacheEntryHeader {
+    char sig[4];            // "PKCE"
+    Uint32 version;
+    Uint64 key;
+    Uint32 compressionType;
+    Uint32 dataSize;
+    Uint32 storedSize;      // 0 when the stored bytes are the data itself
+    Uint32 pad;
+};
+
+struct CachedImageInfo {
+    Uint32 width;
+    Uint32 height;
+    Uint32 hasAlpha;
+    Uint32 trimX;
+    Uint32 trimY;
+    Uint32 trimWidth;
+    Uint32 trimHeight;
+    Uint32 numHullVertices;
+    float hull[SPRITE_MESH_MAX_VERTICES * 2];
+};
+
+// Folds what a resource is processed as, and with which options, into the hash of its input
+static Uint64 buildCacheKey(Uint64 contentHash, Uint64 resourceId, Uint32 kind, Uint32 options) {
+    Uint64 fields[4] = {BUILD_CACHE_VERSION, resourceId, kind, options};
+    return hashBytes((const char*)fields, sizeof(fields), contentHash);
 }
 
+struct BuildCache {
+    string dir;  // Empty when the cache is disabled
+
+    bool enabled() const {
+        return !dir.empty();
+    }
+
+    string entryPath(Uint64 key) const {
+        char name[17];
+        snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+        return dir + "/" + name;
+    }
+
+    // Reads the processed data and stored (compressed) bytes of an entry. Safe
+    // to call from the worker threads.
+    bool load(Uint64 key, vector<char>& data, vector<char>& stored, Uint32& compressionType) const {
+        if (!enabled()) {
+            return false;
+        }
+        string path = entryPath(key);
+        ifstream file(path, ios::binary);
+        BuildCacheEntryHeader header;
+        if (!file.read((char*)&header, sizeof(header)) || memcmp(header.sig, "PKCE", 4) != 0 ||
+            header.version != BUILD_CACHE_VERSION || header.key != key) {
+            return false;
+        }
+        data.resize(header.dataSize);
+        stored.resize(header.storedSize);
+        if (!file.read(data.data(), data.size()) || !file.read(stored.data(), stored.size())) {
+            return false;
+        }
+        if (header.storedSize == 0) {
+            stored = data;
+        }
+        compressionType = header.compressionType;
+
+        // Entries in use are kept from being pruned
+        error_code ec;
+        filesystem::last_write_time(path, filesystem::file_time_type::clock::now(), ec);
+        return true;
+    }
+
+    // Writes an entry through a temporary file, so a build that is interrupted or
+    // races another on the same key never leaves a partial entry behind
+    void store(Uint64 key, const vector<char>& data, const vector<char>& stored, Uint32 compressionType) const {
+        if (!enabled()) {
+            return;
+        }
+        BuildCacheEntryHeader header = {};
+        memcpy(header.sig, "PKCE", 4);
+        header.version = BUILD_CACHE_VERSION;
+        header.key = key;
+        header.compressionType = compressionType;
+        header.dataSize = (Uint32)data.size();
+        header.storedSize = stored == data ? 0 : (Uint32)stored.size();
+
+        string path = entryPath(key);
+        string tempPath = path + "." + to_string(hash<thread::id>()(this_thread::get_id())) + ".tmp";
+        {
+            ofstream file(tempPath, ios::binary | ios::trunc);
+            file.write((const char*)&header, sizeof(header));
+            file.write(data.data(), data.size());
+            if (header.storedSize != 0) {
+                file.write(stored.data(), stored.size());
+            }
+            if (!file) {
+                cerr << "Warning: failed to write build cache entry " << tempPath << endl;
+                file.close();
+                error_code ec;
+                filesystem::remove(tempPath, ec);
+                return;
+            }
+        }
+        error_code ec;
+        filesystem::rename(tempPath, path, ec);
+        if (ec) {
+            filesystem::remove(tempPath, ec);
+        }
+    }
+
+    void prune() const {
+        if (!enabled()) {
+            return;
+        }
+        auto cutoff = filesystem::file_time_type::clock::now() - chrono::hours(24 * BUILD_CACHE_MAX_AGE_DAYS);
+        Uint64 pruned = 0;
+        error_code ec;
+        for (const auto& entry : filesystem::directory_iterator(dir, ec)) {
+            error_code entryEc;
+            if (entry.is_regular_file(entryEc) && entry.last_write_time(entryEc) < cutoff && !entryEc) {
+                pruned += filesystem::remove(entry.path(), entryEc) ? 1 : 0;
+            }
+        }
+        if (pruned > 0) {
+            cout << "Pruned " << pruned << " stale build cache entries" << endl;
+        }
+    }
+};
+
 // ============================================================================
 // IMA ADPCM encoder (for WAV -> GLA conversion)
 // Produces data in the AL_EXT_IMA4 block format:
@@ -572,9 +822,9 @@ Uint32 getFileType(const string& filename, bool isAtlas = false) {
     return RESOURCE_TYPE_UNKNOWN;
 }
 
-// Round up to next multiple of 4 for block alignment
-static Uint32 alignTo4(Uint32 val) {
-    return (val + 3) & ~3;
+// Round up to the next multiple of a power of two, such as 4 for block alignment
+static Uint32 alignToPow2(Uint32 val, Uint32 alignment) {
+    return (val + alignment - 1) & ~(alignment - 1);
 }
 
 #ifdef ENABLE_ETC
@@ -940,8 +1190,8 @@ void compressImage(const vector<uint8_t>& imageData, vector<char>& compressed, U
     if (useETC) {
 #ifdef ENABLE_ETC
         // ETC requires dimensions to be multiples of 4; pad if necessary
-        Uint32 paddedW = alignTo4(width);
-        Uint32 paddedH = alignTo4(height);
+        Uint32 paddedW = alignToPow2(width, 4);
+        Uint32 paddedH = alignToPow2(height, 4);
         if (paddedW != width || paddedH != height) {
             vector<uint8_t> padded(paddedW * paddedH * 4, 0);
             for (Uint32 y = 0; y < height; y++) {
@@ -979,8 +1229,89 @@ void compressImage(const vector<uint8_t>& imageData, vector<char>& compressed, U
     squish::CompressImage(imageData.data(), width, height, compressed.data(), flags);
 }
 
-// Compress image data from raw format (RGB or RGBA)
-void compressImageRaw(const vector<uint8_t>& imageData, vector<char>& compressed, Uint32 width, Uint32 height, bool hasAlpha, Uint16& format, bool useETC) {
+// Mip chains. --mip-levels N stores every texture with up to N levels, the base
+// image included, each level half the size of the one before and compressed on
+// its own, one after another behind the image's header.
+
+// Most mip levels --mip-levels accepts. Atlas entries are padded and aligned for
+// the smallest level (see atlasEntryAlignment), and at this count the alignment
+// reaches the smallest atlas size.
+static const Uint32 MAX_MIP_LEVELS = 5;
+
+// Levels of a chain of at most maxLevels for a width x height image, which ends
+// early at 1x1
+static Uint32 mipLevelCount(Uint32 width, Uint32 height, Uint32 maxLevels) {
+    Uint32 levels = 1;
+    while (levels < maxLevels && ((width >> levels) > 0 || (height >> levels) > 0)) {
+        levels++;
+    }
+    return levels;
+}
+
+// Halve an RGBA image with a 2x2 box filter. Colour is weighted by alpha, so
+// transparent texels do not darken the edges of sprites; odd last rows and
+// columns are folded into the one before.
+static void downsampleMip(const vector<uint8_t>& src, Uint32 width, Uint32 height,
+                          vector<uint8_t>& dst, Uint32& outWidth, Uint32& outHeight) {
+    outWidth = max(1u, width / 2);
+    outHeight = max(1u, height / 2);
+    dst.resize(outWidth * outHeight * 4);
+    for (Uint32 y = 0; y < outHeight; y++) {
+        Uint32 y0 = min(y * 2, height - 1);
+        Uint32 y1 = min(y * 2 + 1, height - 1);
+        for (Uint32 x = 0; x < outWidth; x++) {
+            Uint32 x0 = min(x * 2, width - 1);
+            Uint32 x1 = min(x * 2 + 1, width - 1);
+            const uint8_t* texels[4] = {
+                &src[(y0 * width + x0) * 4], &src[(y0 * width + x1) * 4],
+                &src[(y1 * width + x0) * 4], &src[(y1 * width + x1) * 4],
+            };
+            Uint32 alpha = 0;
+            Uint32 weighted[3] = {0, 0, 0};
+            Uint32 plain[3] = {0, 0, 0};
+            for (const uint8_t* texel : texels) {
+                alpha += texel[3];
+                for (int c = 0; c < 3; c++) {
+                    weighted[c] += texel[c] * texel[3];
+                    plain[c] += texel[c];
+                }
+            }
+            uint8_t* out = &dst[(y * outWidth + x) * 4];
+            for (int c = 0; c < 3; c++) {
+                out[c] = (uint8_t)(alpha > 0 ? (weighted[c] + alpha / 2) / alpha : (plain[c] + 2) / 4);
+            }
+            out[3] = (uint8_t)((alpha + 2) / 4);
+        }
+    }
+}
+
+// Compress an RGBA image and the next levels - 1 levels of its mip chain
+// (levels from mipLevelCount), appending each level to compressed in turn
+void compressImageMipChain(const vector<uint8_t>& imageData, vector<char>& compressed, Uint32 width, Uint32 height,
+                           bool hasAlpha, Uint16& format, bool useETC, Uint32 levels) {
+    compressImage(imageData, compressed, width, height, hasAlpha, format, useETC);
+    assert(compressed.size() == compressedImageLevelSize(format, width, height));
+    vector<uint8_t> level;
+    vector<uint8_t> next;
+    const vector<uint8_t>* source = &imageData;
+    for (Uint32 i = 1; i < levels; i++) {
+        Uint32 nextWidth, nextHeight;
+        downsampleMip(*source, width, height, next, nextWidth, nextHeight);
+        level.swap(next);
+        source = &level;
+        width = nextWidth;
+        height = nextHeight;
+
+        vector<char> compressedLevel;
+        compressImage(level, compressedLevel, width, height, hasAlpha, format, useETC);
+        assert(compressedLevel.size() == compressedImageLevelSize(format, width, height));
+        compressed.insert(compressed.end(), compressedLevel.begin(), compressedLevel.end());
+    }
+}
+
+// Compress image data from raw format (RGB or RGBA), with a mip chain of levels
+// levels (from mipLevelCount)
+void compressImageRaw(const vector<uint8_t>& imageData, vector<char>& compressed, Uint32 width, Uint32 height, bool hasAlpha, Uint16& format, bool useETC, Uint32 levels) {
     assert(width > 0 && height > 0);
     int bytesPerPixel = hasAlpha ? 4 : 3;
     assert(imageData.size() == width * height * bytesPerPixel);
@@ -995,15 +1326,233 @@ void compressImageRaw(const vector<uint8_t>& imageData, vector<char>& compressed
             rgbaData[i * 4 + 2] = imageData[i * 3 + 2];  // B
             rgbaData[i * 4 + 3] = 255;                   // A (fully opaque)
         }
-        compressImage(rgbaData, compressed, width, height, false, format, useETC);
+        compressImageMipChain(rgbaData, compressed, width, height, false, format, useETC, levels);
     } else {
-        compressImage(imageData, compressed, width, height, true, format, useETC);
+        compressImageMipChain(imageData, compressed, width, height, true, format, useETC, levels);
+    }
+}
+
+// Sprite trimming. With --trim-sprites only the bounding box of an image's
+// non-transparent pixels, plus a one pixel transparent margin, is packed; with
+// --sprite-hulls the packer also fits a convex outline around those pixels for
+// the runtime to draw instead of the trim rect.
+
+// Share of the trim rect an outline has to stay under to be worth its extra vertices
+static const double SPRITE_HULL_MAX_COVERAGE = 0.85;
+
+struct HullPoint {
+    double x;
+    double y;
+};
+
+static double hullCross(const HullPoint& o, const HullPoint& a, const HullPoint& b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+static double hullArea(const vector<HullPoint>& hull) {
+    double area = 0.0;
+    for (Uint64 i = 0; i < hull.size(); i++) {
+        const HullPoint& a = hull[i];
+        const HullPoint& b = hull[(i + 1) % hull.size()];
+        area += a.x * b.y - b.x * a.y;
+    }
+    return area * 0.5;
+}
+
+// Convex hull of points (monotone chain), counter-clockwise, without collinear points
+static vector<HullPoint> convexHull(vector<HullPoint> points) {
+    sort(points.begin(), points.end(), [](const HullPoint& a, const HullPoint& b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+    if (points.size() < 3) {
+        return points;
+    }
+    vector<HullPoint> hull(points.size() * 2);
+    Uint64 k = 0;
+    for (Uint64 i = 0; i < points.size(); i++) {
+        while (k >= 2 && hullCross(hull[k - 2], hull[k - 1], points[i]) <= 0.0) k--;
+        hull[k++] = points[i];
+    }
+    for (Uint64 i = points.size() - 1, lower = k + 1; i > 0; i--) {
+        while (k >= lower && hullCross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0.0) k--;
+        hull[k++] = points[i - 1];
+    }
+    hull.resize(k - 1);
+    return hull;
+}
+
+// Cuts a convex counter-clockwise polygon down to maxVertices without uncovering
+// any of it: the edge whose neighbours meet closest outside it, within the box
+// minX..maxX x minY..maxY, is replaced by their meeting point. Returns false if
+// no edge can be removed that way before reaching maxVertices.
+static bool reduceHull(vector<HullPoint>& hull, Uint32 maxVertices,
+                       double minX, double minY, double maxX, double maxY) {
+    const double EPSILON = 1e-9;
+    while (hull.size() > maxVertices) {
+        Uint64 n = hull.size();
+        Uint64 bestEdge = n;
+        double bestArea = 0.0;
+        HullPoint bestPoint = {0.0, 0.0};
+        for (Uint64 i = 0; i < n; i++) {
+            const HullPoint& prev = hull[(i + n - 1) % n];
+            const HullPoint& a = hull[i];
+            const HullPoint& b = hull[(i + 1) % n];
+            const HullPoint& next = hull[(i + 2) % n];
+            // Extend prev->a forwards and next->b backwards until they meet
+            double d1x = a.x - prev.x, d1y = a.y - prev.y;
+            double d2x = next.x - b.x, d2y = next.y - b.y;
+            double ex = b.x - a.x, ey = b.y - a.y;
+            double denom = d1x * d2y - d1y * d2x;
+            if (denom <= EPSILON) {
+                continue;  // Parallel or diverging, they never meet outside the edge
+            }
+            double along = (ex * d2y - ey * d2x) / denom;
+            double back = (d1x * ey - d1y * ex) / denom;
+            if (along < 0.0 || back < 0.0) {
+                continue;
+            }
+            HullPoint meet = {a.x + along * d1x, a.y + along * d1y};
+            if (meet.x < minX - EPSILON || meet.x > maxX + EPSILON ||
+                meet.y < minY - EPSILON || meet.y > maxY + EPSILON) {
+                continue;
+            }
+            double area = 0.5 * abs(hullCross(a, b, meet));
+            if (bestEdge == n || area < bestArea) {
+                bestEdge = i;
+                bestArea = area;
+                bestPoint = meet;
+            }
+        }
+        if (bestEdge == n) {
+            return false;
+        }
+        hull[bestEdge] = bestPoint;
+        hull.erase(hull.begin() + (bestEdge + 1) % n);
+    }
+    return true;
+}
+
+// Sets the trim rect of a decoded image, and its outline when hulls are on.
+// Images without alpha, fully transparent ones and ones with nothing to trim
+// keep their full size.
+static void computeSpriteTrim(PNGImageData& img, bool trim, bool hulls) {
+    img.trimX = 0;
+    img.trimY = 0;
+    img.trimWidth = img.width;
+    img.trimHeight = img.height;
+    img.hull.clear();
+    if (!trim || !img.hasAlpha) {
+        return;
+    }
+
+    // Leftmost and rightmost visible pixel of every row
+    const uint8_t* pixels = img.imageData.data();
+    vector<Sint64> rowMin(img.height, -1);
+    vector<Sint64> rowMax(img.height, -1);
+    Uint32 minX = img.width, minY = img.height, maxX = 0, maxY = 0;
+    for (Uint32 y = 0; y < img.height; y++) {
+        for (Uint32 x = 0; x < img.width; x++) {
+            if (pixels[(y * img.width + x) * 4 + 3] == 0) {
+                continue;
+            }
+            if (rowMin[y] < 0) {
+                rowMin[y] = x;
+            }
+            rowMax[y] = x;
+        }
+        if (rowMin[y] >= 0) {
+            minX = min(minX, (Uint32)rowMin[y]);
+            maxX = max(maxX, (Uint32)rowMax[y]);
+            minY = min(minY, y);
+            maxY = y;
+        }
+    }
+    if (minX > maxX) {
+        return;
+    }
+
+    // The margin keeps shader UV clamping at the region's edge transparent
+    img.trimX = minX > 0 ? minX - 1 : 0;
+    img.trimY = minY > 0 ? minY - 1 : 0;
+    img.trimWidth = min(maxX + 2, img.width) - img.trimX;
+    img.trimHeight = min(maxY + 2, img.height) - img.trimY;
+    if (!hulls) {
+        return;
+    }
+
+    // Outline of the texel squares grown by half a texel, which bilinear
+    // filtering still reads, in pixel units with y up
+    double boxMinX = img.trimX, boxMaxX = img.trimX + img.trimWidth;
+    double boxMinY = -(double)(img.trimY + img.trimHeight), boxMaxY = -(double)img.trimY;
+    vector<HullPoint> points;
+    for (Uint32 y = 0; y < img.height; y++) {
+        if (rowMin[y] < 0) {
+            continue;
+        }
+        double left = max(boxMinX, rowMin[y] - 0.5);
+        double right = min(boxMaxX, rowMax[y] + 1.5);
+        double top = min(boxMaxY, -(y - 0.5));
+        double bottom = max(boxMinY, -(y + 1.5));
+        points.push_back({left, top});
+        points.push_back({left, bottom});
+        points.push_back({right, top});
+        points.push_back({right, bottom});
+    }
+    vector<HullPoint> hull = convexHull(points);
+    if (hull.size() < 3 || !reduceHull(hull, SPRITE_MESH_MAX_VERTICES, boxMinX, boxMinY, boxMaxX, boxMaxY) ||
+        hullArea(hull) >= SPRITE_HULL_MAX_COVERAGE * img.trimWidth * img.trimHeight) {
+        return;
+    }
+    for (const HullPoint& point : hull) {
+        img.hull.push_back((float)(point.x / img.width));
+        img.hull.push_back((float)(-point.y / img.height));
+    }
+}
+
+// Duplicated edge texels around each atlas entry: enough for one texel at the
+// smallest mip level, so filtering there does not reach the neighbours
+static Uint32 atlasEdgePadding(Uint32 mipLevels) {
+    return 1u << (mipLevels - 1);
+}
+
+// Padded atlas entries are sized, and so placed, in multiples of this, which
+// keeps them on whole compression blocks at every mip level and stops the box
+// filter mixing neighbours into a level
+static Uint32 atlasEntryAlignment(Uint32 mipLevels) {
+    return 4u << (mipLevels - 1);
+}
+
+// Packs rects[indices] in order into one binWidth x binHeight atlas and returns
+// the indices that fit; with requireAll it gives up at the first that does not.
+// Positions and rotation are written to rects only on success.
+static vector<Uint64> packAtlasBin(vector<PackRect>& rects, const vector<Uint64>& indices,
+                                   Uint32 binWidth, Uint32 binHeight, bool allowRotation, bool requireAll) {
+    MaxRectsBinPacker packer(binWidth, binHeight, allowRotation);
+    vector<PackRect> placed;
+    vector<Uint64> packed;
+    for (Uint64 i : indices) {
+        PackRect testRect = rects[i];
+        if (packer.pack(testRect)) {
+            placed.push_back(testRect);
+            packed.push_back(i);
+        } else if (requireAll) {
+            return {};
+        }
     }
+    for (Uint64 i = 0; i < packed.size(); i++) {
+        rects[packed[i]] = placed[i];
+    }
+    return packed;
 }
 
-// Pack multiple PNG images into texture atlases
+// Pack multiple PNG images into texture atlases. Only image sizes are used, so
+// the layout is known before any pixels are decoded; composeAtlas() fills them in.
+// Each atlas is the smallest power-of-two size that takes every image still to
+// be packed, or a full maxAtlasSize one holding as many as fit.
+// Entries are padded and aligned for a mip chain of mipLevels levels.
 // Returns the number of atlases created
-Uint64 packImagesIntoAtlases(vector<PNGImageData>& images, vector<TextureAtlas>& atlases, Uint32 maxAtlasSize) {
+Uint64 packImagesIntoAtlases(const vector<PNGImageData>& images, vector<TextureAtlas>& atlases,
+                             Uint32 maxAtlasSize, bool allowRotation, Uint32 mipLevels) {
     if (images.empty()) return 0;
 
     // Sort all images by area (descending) for better bin packing
@@ -1013,44 +1562,55 @@ Uint64 packImagesIntoAtlases(vector<PNGImageData>& images, vector<TextureAtlas>&
         sortedIndices[i] = i;
     }
     sort(sortedIndices.begin(), sortedIndices.end(), [&images](Uint64 a, Uint64 b) {
-        Uint32 areaA = images[a].width * images[a].height;
-        Uint32 areaB = images[b].width * images[b].height;
+        Uint32 areaA = images[a].trimWidth * images[a].trimHeight;
+        Uint32 areaB = images[b].trimWidth * images[b].trimHeight;
         return areaA > areaB;
     });
 
     // Prepare rectangles for all images
-    // Add 2 pixels (1 on each side) for edge padding to prevent texture bleeding
-    const Uint32 EDGE_PADDING = 1;
+    // Add edge padding on each side to prevent texture bleeding
+    const Uint32 edgePadding = atlasEdgePadding(mipLevels);
+    const Uint32 alignment = atlasEntryAlignment(mipLevels);
     vector<PackRect> rects;
     rects.reserve(images.size());
     for (Uint64 idx : sortedIndices) {
         PackRect rect;
-        // Add 2 pixels for edge padding (1 on each side), then align to 4 pixels for DXT block boundaries
-        rect.width = alignTo4(images[idx].width + EDGE_PADDING * 2);
-        rect.height = alignTo4(images[idx].height + EDGE_PADDING * 2);
+        // Add the edge padding on both sides, then align for DXT block boundaries
+        rect.width = alignToPow2(images[idx].trimWidth + edgePadding * 2, alignment);
+        rect.height = alignToPow2(images[idx].trimHeight + edgePadding * 2, alignment);
+        rect.x = 0;
+        rect.y = 0;
         rect.imageIndex = idx;
         rect.packed = false;
+        rect.rotated = false;
         rects.push_back(rect);
     }
 
-    // Calculate total area needed (with some padding for inefficiency)
-    Uint64 totalArea = 0;
-    Uint32 maxImageW = 0, maxImageH = 0;
-    for (const auto& rect : rects) {
-        totalArea += (Uint64)rect.width * rect.height;
-        maxImageW = max(maxImageW, rect.width);
-        maxImageH = max(maxImageH, rect.height);
+    // Candidate atlas sizes, smallest area first and squarer shapes before
+    // 2:1 ones of the same area
+    const Uint32 MIN_ATLAS_SIZE = 64;
+    vector<Uint32> sides;
+    for (Uint32 side = MIN_ATLAS_SIZE; side < maxAtlasSize; side *= 2) {
+        sides.push_back(side);
     }
-
-    // Start with atlas size that can fit all images (estimate with 30% overhead)
-    Uint32 estimatedSize = (Uint32)sqrt((double)totalArea * 1.3);
-    Uint32 atlasWidth = 256;
-    Uint32 atlasHeight = 256;
-    while (atlasWidth < estimatedSize && atlasWidth < maxAtlasSize) atlasWidth *= 2;
-    while (atlasHeight < estimatedSize && atlasHeight < maxAtlasSize) atlasHeight *= 2;
-    // Ensure atlas is at least as large as the biggest image
-    while (atlasWidth < maxImageW && atlasWidth < maxAtlasSize) atlasWidth *= 2;
-    while (atlasHeight < maxImageH && atlasHeight < maxAtlasSize) atlasHeight *= 2;
+    sides.push_back(maxAtlasSize);
+    vector<pair<Uint32, Uint32>> atlasSizes;
+    for (Uint32 w : sides) {
+        for (Uint32 h : sides) {
+            if (w <= h * 2 && h <= w * 2) {
+                atlasSizes.push_back({w, h});
+            }
+        }
+    }
+    sort(atlasSizes.begin(), atlasSizes.end(), [](const pair<Uint32, Uint32>& a, const pair<Uint32, Uint32>& b) {
+        Uint64 areaA = (Uint64)a.first * a.second;
+        Uint64 areaB = (Uint64)b.first * b.second;
+        if (areaA != areaB) return areaA < areaB;
+        Uint32 skewA = max(a.first, a.second) - min(a.first, a.second);
+        Uint32 skewB = max(b.first, b.second) - min(b.first, b.second);
+        if (skewA != skewB) return skewA < skewB;
+        return a.first > b.first;
+    });
 
     // Try to pack all images into atlases
     while (true) {
@@ -1063,40 +1623,50 @@ Uint64 packImagesIntoAtlases(vector<PNGImageData>& images, vector<TextureAtlas>&
         }
         if (unpacked.empty()) break;
 
-        // Try progressively larger atlas sizes until we can pack at least one image
-        Uint32 tryWidth = atlasWidth;
-        Uint32 tryHeight = atlasHeight;
-        bool success = false;
-        vector<Uint64> packedInThisAtlas;
-
-        while (!success && tryWidth <= maxAtlasSize && tryHeight <= maxAtlasSize) {
-            MaxRectsBinPacker packer(tryWidth, tryHeight);
-            packedInThisAtlas.clear();
-
-            // Try to pack all unpacked images into this atlas
-            for (Uint64 i : unpacked) {
-                PackRect testRect = rects[i];
-                if (packer.pack(testRect)) {
-                    rects[i] = testRect;  // Update with packed position
-                    packedInThisAtlas.push_back(i);
+        // Smallest atlas that takes all of the given rects, skipping sizes
+        // without the area or the sides for them
+        Uint32 atlasWidth = 0;
+        Uint32 atlasHeight = 0;
+        auto packSmallest = [&](const vector<Uint64>& indices) {
+            Uint64 area = 0;
+            Uint32 minWidth = 0;
+            Uint32 minHeight = 0;
+            for (Uint64 i : indices) {
+                area += (Uint64)rects[i].width * rects[i].height;
+                if (allowRotation) {
+                    minWidth = max(minWidth, min(rects[i].width, rects[i].height));
+                    minHeight = minWidth;
+                } else {
+                    minWidth = max(minWidth, rects[i].width);
+                    minHeight = max(minHeight, rects[i].height);
                 }
             }
-
-            if (!packedInThisAtlas.empty()) {
-                success = true;
-            } else {
-                // Grow atlas - prefer square-ish shapes
-                if (tryWidth <= tryHeight && tryWidth * 2 <= maxAtlasSize) {
-                    tryWidth *= 2;
-                } else if (tryHeight * 2 <= maxAtlasSize) {
-                    tryHeight *= 2;
-                } else {
-                    break;  // Can't grow further
+            for (const auto& size : atlasSizes) {
+                if ((Uint64)size.first * size.second < area || size.first < minWidth || size.second < minHeight) {
+                    continue;
                 }
+                vector<Uint64> packed = packAtlasBin(rects, indices, size.first, size.second, allowRotation, true);
+                if (!packed.empty()) {
+                    atlasWidth = size.first;
+                    atlasHeight = size.second;
+                    return packed;
+                }
+            }
+            return vector<Uint64>();
+        };
+        vector<Uint64> packedInThisAtlas = packSmallest(unpacked);
+        if (packedInThisAtlas.empty()) {
+            // Not all of them fit: fill a full-size atlas and go round again,
+            // shrinking it if what went in fits a smaller one
+            atlasWidth = maxAtlasSize;
+            atlasHeight = maxAtlasSize;
+            packedInThisAtlas = packAtlasBin(rects, unpacked, atlasWidth, atlasHeight, allowRotation, false);
+            if (!packedInThisAtlas.empty()) {
+                packSmallest(packedInThisAtlas);
             }
         }
 
-        if (!success) {
+        if (packedInThisAtlas.empty()) {
             // Images too large for atlas - mark remaining as standalone
             for (Uint64 i : unpacked) {
                 rects[i].packed = true;  // Mark to avoid infinite loop
@@ -1119,105 +1689,33 @@ Uint64 packImagesIntoAtlases(vector<PNGImageData>& images, vector<TextureAtlas>&
             atlasContentHash ^= images[rects[i].imageIndex].id;
             atlasContentHash = (atlasContentHash << 7) | (atlasContentHash >> 57);
         }
-        atlasContentHash ^= ((Uint64)tryWidth << 32) | tryHeight;
+        atlasContentHash ^= ((Uint64)atlasWidth << 32) | atlasHeight;
         atlasContentHash ^= atlasHasAlpha ? 0xFFFFFFFF : 0;
 
         // Create the atlas
         TextureAtlas atlas;
         atlas.atlasId = atlasContentHash;
-        atlas.width = tryWidth;
-        atlas.height = tryHeight;
+        atlas.width = atlasWidth;
+        atlas.height = atlasHeight;
         atlas.hasAlpha = atlasHasAlpha;
-        atlas.imageData.resize(tryWidth * tryHeight * 4);
-        // Initialize to hot pink (255, 0, 255, 255)
-        for (Uint64 i = 0; i < atlas.imageData.size(); i += 4) {
-            atlas.imageData[i] = 255;     // R
-            atlas.imageData[i + 1] = 0;   // G
-            atlas.imageData[i + 2] = 255; // B
-            atlas.imageData[i + 3] = 255; // A
-        }
+        atlas.mipLevels = mipLevelCount(atlasWidth, atlasHeight, mipLevels);
 
-        // Copy packed images into atlas with edge padding
-        const Uint32 EDGE_PADDING = 1;
+        // Entries point to the actual content, offset by the edge padding
         for (Uint64 i : packedInThisAtlas) {
             PackRect& rect = rects[i];
-            PNGImageData& img = images[rect.imageIndex];
-
-            // Convert source image to RGBA if needed
-            vector<uint8_t> rgbaSource;
-            const uint8_t* srcData;
-            if (img.hasAlpha) {
-                srcData = img.imageData.data();
-            } else {
-                rgbaSource.resize(img.width * img.height * 4);
-                for (Uint32 p = 0; p < img.width * img.height; p++) {
-                    rgbaSource[p * 4 + 0] = img.imageData[p * 3 + 0];
-                    rgbaSource[p * 4 + 1] = img.imageData[p * 3 + 1];
-                    rgbaSource[p * 4 + 2] = img.imageData[p * 3 + 2];
-                    rgbaSource[p * 4 + 3] = 255;
-                }
-                srcData = rgbaSource.data();
-            }
-
-            // Helper lambda to copy a pixel from source to atlas
-            auto copyPixel = [&](Uint32 srcX, Uint32 srcY, Uint32 dstX, Uint32 dstY) {
-                // Clamp source coordinates to valid range
-                srcX = min(srcX, img.width - 1);
-                srcY = min(srcY, img.height - 1);
-                Uint32 srcIdx = (srcY * img.width + srcX) * 4;
-                Uint32 dstIdx = (dstY * tryWidth + dstX) * 4;
-                atlas.imageData[dstIdx + 0] = srcData[srcIdx + 0];
-                atlas.imageData[dstIdx + 1] = srcData[srcIdx + 1];
-                atlas.imageData[dstIdx + 2] = srcData[srcIdx + 2];
-                atlas.imageData[dstIdx + 3] = srcData[srcIdx + 3];
-            };
-
-            // The actual image content starts at (rect.x + EDGE_PADDING, rect.y + EDGE_PADDING)
-            Uint32 contentX = rect.x + EDGE_PADDING;
-            Uint32 contentY = rect.y + EDGE_PADDING;
-
-            // Copy main image content
-            for (Uint32 y = 0; y < img.height; y++) {
-                for (Uint32 x = 0; x < img.width; x++) {
-                    copyPixel(x, y, contentX + x, contentY + y);
-                }
-            }
-
-            // Duplicate edge pixels for padding (prevents texture bleeding)
-            // Top edge padding (duplicate first row)
-            for (Uint32 x = 0; x < img.width; x++) {
-                copyPixel(x, 0, contentX + x, contentY - 1);
-            }
-            // Bottom edge padding (duplicate last row)
-            for (Uint32 x = 0; x < img.width; x++) {
-                copyPixel(x, img.height - 1, contentX + x, contentY + img.height);
-            }
-            // Left edge padding (duplicate first column)
-            for (Uint32 y = 0; y < img.height; y++) {
-                copyPixel(0, y, contentX - 1, contentY + y);
-            }
-            // Right edge padding (duplicate last column)
-            for (Uint32 y = 0; y < img.height; y++) {
-                copyPixel(img.width - 1, y, contentX + img.width, contentY + y);
-            }
-            // Corner padding (duplicate corner pixels)
-            copyPixel(0, 0, contentX - 1, contentY - 1);  // Top-left
-            copyPixel(img.width - 1, 0, contentX + img.width, contentY - 1);  // Top-right
-            copyPixel(0, img.height - 1, contentX - 1, contentY + img.height);  // Bottom-left
-            copyPixel(img.width - 1, img.height - 1, contentX + img.width, contentY + img.height);  // Bottom-right
+            const PNGImageData& img = images[rect.imageIndex];
 
-            // Create atlas entry - point to actual content (offset by EDGE_PADDING)
             AtlasEntry entry;
             entry.originalId = img.id;
-            entry.x = (Uint16)contentX;
-            entry.y = (Uint16)contentY;
-            entry.width = (Uint16)img.width;
-            entry.height = (Uint16)img.height;
+            entry.x = (Uint16)(rect.x + edgePadding);
+            entry.y = (Uint16)(rect.y + edgePadding);
+            entry.width = (Uint16)img.trimWidth;
+            entry.height = (Uint16)img.trimHeight;
+            if (rect.rotated) {
+                entry.x |= ATLAS_ENTRY_ROTATED;
+            }
             atlas.entries.push_back(entry);
             atlas.packedImageIndices.push_back(rect.imageIndex);
-
-            // Mark as packed
-            rect.packed = true;
         }
 
         atlases.push_back(std::move(atlas));
@@ -1226,21 +1724,89 @@ Uint64 packImagesIntoAtlases(vector<PNGImageData>& images, vector<TextureAtlas>&
     return atlases.size();
 }
 
+// Fill the atlas pixels from its decoded member images, with edge padding
+void composeAtlas(TextureAtlas& atlas, const vector<PNGImageData>& images) {
+    const Uint32 edgePadding = atlasEdgePadding(atlas.mipLevels);
+    const Uint32 alignment = atlasEntryAlignment(atlas.mipLevels);
+    atlas.imageData.resize(atlas.width * atlas.height * 4);
+    // Initialize to hot pink (255, 0, 255, 255)
+    for (Uint64 i = 0; i < atlas.imageData.size(); i += 4) {
+        atlas.imageData[i] = 255;     // R
+        atlas.imageData[i + 1] = 0;   // G
+        atlas.imageData[i + 2] = 255; // B
+        atlas.imageData[i + 3] = 255; // A
+    }
+
+    for (Uint64 e = 0; e < atlas.entries.size(); e++) {
+        const AtlasEntry& entry = atlas.entries[e];
+        const PNGImageData& img = images[atlas.packedImageIndices[e]];
+        assert(img.loaded);
+
+        // Convert source image to RGBA if needed
+        vector<uint8_t> rgbaSource;
+        const uint8_t* srcData;
+        if (img.hasAlpha) {
+            srcData = img.imageData.data();
+        } else {
+            rgbaSource.resize(img.width * img.height * 4);
+            for (Uint32 p = 0; p < img.width * img.height; p++) {
+                rgbaSource[p * 4 + 0] = img.imageData[p * 3 + 0];
+                rgbaSource[p * 4 + 1] = img.imageData[p * 3 + 1];
+                rgbaSource[p * 4 + 2] = img.imageData[p * 3 + 2];
+                rgbaSource[p * 4 + 3] = 255;
+            }
+            srcData = rgbaSource.data();
+        }
+
+        // The image's region in the atlas, holding its trim rect, turned
+        // clockwise for rotated entries
+        bool rotated = (entry.x & ATLAS_ENTRY_ROTATED) != 0;
+        Uint32 contentX = entry.x & ATLAS_ENTRY_X_MASK;
+        Uint32 contentY = entry.y;
+        Uint32 contentWidth = rotated ? entry.height : entry.width;
+        Uint32 contentHeight = rotated ? entry.width : entry.height;
+        assert(contentX >= edgePadding && contentY >= edgePadding);
+        assert((contentX - edgePadding) % alignment == 0 && (contentY - edgePadding) % alignment == 0);
+
+        // Copy the content and fill the rest of its packed rect, the edge padding
+        // and alignment slack, with duplicated edge pixels. This prevents texture
+        // bleeding at every mip level; border texels clamp to the edge.
+        Sint64 rectWidth = alignToPow2(contentWidth + edgePadding * 2, alignment);
+        Sint64 rectHeight = alignToPow2(contentHeight + edgePadding * 2, alignment);
+        for (Sint64 y = -(Sint64)edgePadding; y < rectHeight - edgePadding; y++) {
+            for (Sint64 x = -(Sint64)edgePadding; x < rectWidth - edgePadding; x++) {
+                Uint32 localX = (Uint32)max<Sint64>(0, min<Sint64>(x, contentWidth - 1));
+                Uint32 localY = (Uint32)max<Sint64>(0, min<Sint64>(y, contentHeight - 1));
+                Uint32 srcX = img.trimX + (rotated ? localY : localX);
+                Uint32 srcY = img.trimY + (rotated ? entry.height - 1 - localX : localY);
+                Uint32 srcIdx = (srcY * img.width + srcX) * 4;
+                Uint32 dstIdx = (Uint32)(((contentY + y) * atlas.width + contentX + x) * 4);
+                atlas.imageData[dstIdx + 0] = srcData[srcIdx + 0];
+                atlas.imageData[dstIdx + 1] = srcData[srcIdx + 1];
+                atlas.imageData[dstIdx + 2] = srcData[srcIdx + 2];
+                atlas.imageData[dstIdx + 3] = srcData[srcIdx + 3];
+            }
+        }
+    }
+}
+
 // Process atlas: compress and create output data with AtlasHeader
 bool processAtlas(TextureAtlas& atlas, vector<char>& output, bool useETC) {
     assert(atlas.width > 0 && atlas.height > 0);
     assert(atlas.imageData.size() == atlas.width * atlas.height * 4);
 
-    // Compress the atlas image data
+    // Compress the atlas image data and its mip chain
     vector<char> compressedImage;
     Uint16 format;
-    compressImage(atlas.imageData, compressedImage, atlas.width, atlas.height, atlas.hasAlpha, format, useETC);
+    compressImageMipChain(atlas.imageData, compressedImage, atlas.width, atlas.height, atlas.hasAlpha, format,
+                          useETC, atlas.mipLevels);
 
     assert(compressedImage.size() > 0);
 
     // Create AtlasHeader
     AtlasHeader header;
-    header.format = format;
+    header.format = (Uint8)format;
+    header.mipLevels = (Uint8)atlas.mipLevels;
     header.width = (Uint16)atlas.width;
     header.height = (Uint16)atlas.height;
     header.numEntries = (Uint16)atlas.entries.size();
@@ -1261,8 +1827,20 @@ bool processAtlas(TextureAtlas& atlas, vector<char>& output, bool useETC) {
     return true;
 }
 
-// Process PNG file: load, compress, and prepend ImageHeader
-bool processPNGFile(const string& filename, vector<char>& output, bool useETC) {
+// Atlases are cached by their layout and the content of every member image
+static Uint64 atlasCacheKey(const TextureAtlas& atlas, const vector<PNGImageData>& images, Uint32 options) {
+    Uint64 hash = hashBytes((const char*)atlas.entries.data(), atlas.entries.size() * sizeof(AtlasEntry));
+    for (Uint64 index : atlas.packedImageIndices) {
+        hash = hashBytes((const char*)&images[index].contentHash, sizeof(Uint64), hash);
+    }
+    Uint32 shape[3] = {atlas.width, atlas.height, atlas.hasAlpha ? 1u : 0u};
+    hash = hashBytes((const char*)shape, sizeof(shape), hash);
+    return buildCacheKey(hash, atlas.atlasId, RESOURCE_TYPE_IMAGE_ATLAS, options);
+}
+
+// Process PNG file: load, compress with a mip chain of up to mipLevels levels,
+// and prepend ImageHeader
+bool processPNGFile(const string& filename, vector<char>& output, bool useETC, Uint32 mipLevels) {
     vector<uint8_t> imageData;
     Uint32 width, height;
     bool hasAlpha;
@@ -1278,7 +1856,8 @@ bool processPNGFile(const string& filename, vector<char>& output, bool useETC) {
     // Compress the image data
     vector<char> compressedImage;
     Uint16 format;
-    compressImageRaw(imageData, compressedImage, width, height, hasAlpha, format, useETC);
+    Uint32 levels = mipLevelCount(width, height, mipLevels);
+    compressImageRaw(imageData, compressedImage, width, height, hasAlpha, format, useETC, levels);
 
     assert(compressedImage.size() > 0);
 
@@ -1287,7 +1866,7 @@ bool processPNGFile(const string& filename, vector<char>& output, bool useETC) {
     header.format = format;
     header.width = width;
     header.height = height;
-    header.pad = 0;
+    header.mipLevels = (Uint16)levels;
 
     // Combine header and compressed data
     output.resize(sizeof(ImageHeader) + compressedImage.size());
@@ -1399,7 +1978,7 @@ static bool processSvgToVectorShape(const string& filename, vector<char>& output
     // Pass 2: collect contours and their raw cubic Bézier segments.
     struct Contour {
         vector<SdfSegment> segments;
-        float area;     // shoelace signed area in normalised Y-up coords
+        float area = 0.0f; // shoelace signed area in normalised Y-up coords
         Sint32 winding; // +1 outer, -1 hole
     };
     vector<Contour> allContours;
@@ -1802,57 +2381,845 @@ bool processCharacterFile(const string& filename, vector<char>& output) {
 }
 
 
-int main(int argc, char* argv[]) {
-
+// ============================================================================
+// Scene manifests: the resource closure of every scene script under res/scenes/
+// ============================================================================
 
-    if (argc < 3) {
-        cerr << "Usage: packer <output.pak> <file1> <file2> ... [--output-atlases] [--max-atlas-size N] [--etc]" << endl;
-        cerr << "  --output-atlases: Save texture atlases as PNG files in build/ folder for review" << endl;
-        cerr << "  --max-atlas-size N: Maximum atlas texture dimension (default: " << DEFAULT_ATLAS_MAX_SIZE << ")" << endl;
-        cerr << "  --etc: Use ETC1/ETC2 texture compression instead of BC1/BC3 (DXT)" << endl;
-        return 1;
+// Collect the string literals of a Lua script or JSON data file. Lua comments
+// are skipped so commented-out references don't pull resources in.
+static void collectStringLiterals(const string& filename, vector<string>& literals) {
+    ifstream f(filename, ios::binary);
+    if (!f) {
+        return;
     }
-
-    string output;
-    vector<string> inputFiles;
-    bool outputAtlases = false;
-    Uint32 maxAtlasSize = DEFAULT_ATLAS_MAX_SIZE;
-    bool useETC = false;
-
-    // Parse arguments
-    for (int i = 1; i < argc; ++i) {
-        string arg = argv[i];
-        if (arg == "--output-atlases") {
-            outputAtlases = true;
-        } else if (arg == "--max-atlas-size" && i + 1 < argc) {
-            maxAtlasSize = (Uint32)stoul(argv[++i]);
-        } else if (arg == "--etc") {
-#ifdef ENABLE_ETC
-            useETC = true;
-#else
-            cerr << "ETC compression not supported in this build" << endl;
-            return 1;
-#endif
-        } else if (output.empty()) {
-            output = arg;
+    string text((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
+    bool isLua = filesystem::path(filename).extension() == ".lua";
+
+    Uint64 i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (isLua && c == '-' && i + 1 < text.size() && text[i + 1] == '-') {
+            Uint64 end;
+            if (text.compare(i + 2, 2, "[[") == 0) {
+                end = text.find("]]", i + 4);
+                end = (end == string::npos) ? text.size() : end + 2;
+            } else {
+                end = text.find('\n', i);
+                end = (end == string::npos) ? text.size() : end + 1;
+            }
+            i = end;
+        } else if (c == '"' || (isLua && c == '\'')) {
+            string literal;
+            for (i++; i < text.size() && text[i] != c; i++) {
+                if (text[i] == '\\' && i + 1 < text.size()) {
+                    i++;
+                }
+                literal += text[i];
+            }
+            i++;
+            literals.push_back(literal);
         } else {
-            inputFiles.push_back(arg);
+            i++;
         }
     }
+}
 
-    if (output.empty() || inputFiles.empty()) {
-        cerr << "Usage: packer <output.pak> <file1> <file2> ... [--output-atlases] [--max-atlas-size N] [--etc]" << endl;
-        cerr << "  --output-atlases: Save texture atlases as PNG files in build/ folder for review" << endl;
-        cerr << "  --max-atlas-size N: Maximum atlas texture dimension (default: " << DEFAULT_ATLAS_MAX_SIZE << ")" << endl;
-        cerr << "  --etc: Use ETC1/ETC2 texture compression instead of BC1/BC3 (DXT)" << endl;
-        return 1;
+// Decompressed payload of a file that has been through the processing loop
+static bool getProcessedData(const FileInfo& file, vector<char>& data) {
+    if (!file.data.empty()) {
+        data = file.data;
+        return true;
     }
+    if (file.compressionType == COMPRESSION_FLAGS_UNCOMPRESSED) {
+        data = file.compressedData;
+        return true;
+    }
+    data.resize(file.decompressedSize);
+    return Compress::decompress(file.compressedData.data(), file.compressedData.size(),
+                                data.data(), data.size()) == file.decompressedSize;
+}
 
-    vector<FileInfo> files;
-    vector<PNGImageData> pngImages;  // For atlas packing
+static bool isSceneScript(const string& relativePath) {
+    return relativePath.compare(0, 11, "res/scenes/") == 0 &&
+           filesystem::path(relativePath).extension() == ".lua";
+}
 
-    // Collect all files and identify PNG images
-    for (const string& filename : inputFiles) {
+// Build the scene manifest resource. A scene's closure is every packed resource
+// named by a string literal in its script, followed transitively through the
+// Lua scripts and JSON data (.loop, .dlg, .chr) it references. Textures add the
+// atlas they were packed into. References to other scene scripts (pushScene)
+// are not followed; those scenes get their own entries.
+bool generateSceneManifests(const vector<FileInfo>& files, vector<char>& output) {
+    unordered_map<Uint64, Uint64> fileIndex;
+    for (Uint64 i = 0; i < files.size(); i++) {
+        fileIndex[files[i].id] = i;
+    }
+
+    vector<SceneManifestEntry> entries;
+    vector<Uint64> resourceIds;
+    for (const FileInfo& scene : files) {
+        if (!isSceneScript(getRelativePath(scene.filename))) {
+            continue;
+        }
+
+        SceneManifestEntry entry;
+        entry.sceneId = scene.id;
+        entry.firstResource = (Uint32)resourceIds.size();
+
+        unordered_set<Uint64> visited = {scene.id};
+        vector<Uint64> pending = {scene.id};
+        resourceIds.push_back(scene.id);
+        while (!pending.empty()) {
+            const FileInfo& file = files[fileIndex[pending.back()]];
+            pending.pop_back();
+
+            Uint32 type = getFileType(file.filename);
+            vector<Uint64> references;
+            if (type == RESOURCE_TYPE_IMAGE) {
+                vector<char> data;
+                if (!getProcessedData(file, data)) {
+                    cerr << "Failed to read texture data for " << file.filename << endl;
+                    return false;
+                }
+                // Standalone images carry an ImageHeader instead and have no atlas
+                if (data.size() == sizeof(TextureHeader)) {
+                    TextureHeader header;
+                    memcpy(&header, data.data(), sizeof(header));
+                    references.push_back(header.atlasId);
+                }
+            } else if (type == RESOURCE_TYPE_LUA || type == RESOURCE_TYPE_MUSIC_TRACK ||
+                       type == RESOURCE_TYPE_DIALOGUE || type == RESOURCE_TYPE_CHARACTER) {
+                vector<string> literals;
+                collectStringLiterals(file.filename, literals);
+                for (const string& literal : literals) {
+                    if (literal.compare(0, 4, "res/") == 0 && !isSceneScript(literal)) {
+                        references.push_back(hashCString(literal.c_str()));
+                    }
+                }
+            }
+
+            for (Uint64 id : references) {
+                if (fileIndex.count(id) == 0 || !visited.insert(id).second) {
+                    continue;
+                }
+                resourceIds.push_back(id);
+                pending.push_back(id);
+            }
+        }
+
+        entry.numResources = (Uint32)resourceIds.size() - entry.firstResource;
+        entries.push_back(entry);
+        cout << "Scene " << scene.filename << " manifest: " << entry.numResources << " resources" << endl;
+    }
+
+    sort(entries.begin(), entries.end(), [](const SceneManifestEntry& a, const SceneManifestEntry& b) {
+        return a.sceneId < b.sceneId;
+    });
+
+    SceneManifestHeader header;
+    header.numScenes = (Uint32)entries.size();
+    header.numResourceIds = (Uint32)resourceIds.size();
+    output.resize(sizeof(header) + entries.size() * sizeof(SceneManifestEntry) + resourceIds.size() * sizeof(Uint64));
+    char* ptr = output.data();
+    memcpy(ptr, &header, sizeof(header));
+    ptr += sizeof(header);
+    if (!entries.empty()) {
+        memcpy(ptr, entries.data(), entries.size() * sizeof(SceneManifestEntry));
+        ptr += entries.size() * sizeof(SceneManifestEntry);
+    }
+    if (!resourceIds.empty()) {
+        memcpy(ptr, resourceIds.data(), resourceIds.size() * sizeof(Uint64));
+    }
+    return true;
+}
+
+// Build the sprite mesh table resource from the atlased images that were trimmed
+// or given an outline
+void generateSpriteMeshTable(const vector<PNGImageData>& images, const vector<char>& atlased, vector<char>& output) {
+    vector<pair<Uint64, SpriteMeshEntry>> sprites;
+    Uint64 hulls = 0;
+    for (Uint64 i = 0; i < images.size(); i++) {
+        const PNGImageData& img = images[i];
+        if (!atlased[i] || (!img.trimmed() && img.hull.empty())) {
+            continue;
+        }
+        SpriteMeshEntry entry = {};
+        entry.width = (Uint16)img.width;
+        entry.height = (Uint16)img.height;
+        entry.trimX = (Uint16)img.trimX;
+        entry.trimY = (Uint16)img.trimY;
+        entry.trimWidth = (Uint16)img.trimWidth;
+        entry.trimHeight = (Uint16)img.trimHeight;
+        entry.numVertices = (Uint32)img.hull.size() / 2;
+        copy(img.hull.begin(), img.hull.end(), entry.points);
+        sprites.push_back({img.id, entry});
+        hulls += entry.numVertices > 0 ? 1 : 0;
+    }
+
+    sort(sprites.begin(), sprites.end(), [](const pair<Uint64, SpriteMeshEntry>& a, const pair<Uint64, SpriteMeshEntry>& b) {
+        return a.first < b.first;
+    });
+
+    SpriteMeshTableHeader header;
+    header.numSprites = (Uint32)sprites.size();
+    header.pad = 0;
+    output.resize(sizeof(header) + sprites.size() * (sizeof(Uint64) + sizeof(SpriteMeshEntry)));
+    char* ptr = output.data();
+    memcpy(ptr, &header, sizeof(header));
+    ptr += sizeof(header);
+    for (const auto& sprite : sprites) {
+        memcpy(ptr, &sprite.first, sizeof(Uint64));
+        ptr += sizeof(Uint64);
+    }
+    for (const auto& sprite : sprites) {
+        memcpy(ptr, &sprite.second, sizeof(SpriteMeshEntry));
+        ptr += sizeof(SpriteMeshEntry);
+    }
+    cout << "Sprite mesh table: " << sprites.size() << " trimmed sprites, " << hulls << " with outlines" << endl;
+}
+
+// Build the atlas UV table resource from the processed texture headers, the
+// atlas entry lists and the sprite mesh table, so the runtime can answer UV
+// queries without any of them
+bool generateAtlasUVTable(const vector<FileInfo>& files, vector<char>& output) {
+    // Atlas entries, keyed by (atlas id, texture id)
+    map<pair<Uint64, Uint64>, AtlasEntry> atlasEntries;
+    for (const FileInfo& file : files) {
+        if (file.filename.find("_atlas_") != 0) {
+            continue;
+        }
+        vector<char> data;
+        if (!getProcessedData(file, data) || data.size() < sizeof(AtlasHeader)) {
+            cerr << "Failed to read atlas data for " << file.filename << endl;
+            return false;
+        }
+        AtlasHeader header;
+        memcpy(&header, data.data(), sizeof(header));
+        if (data.size() < sizeof(AtlasHeader) + header.numEntries * sizeof(AtlasEntry)) {
+            cerr << "Atlas " << file.filename << " has a truncated entry list" << endl;
+            return false;
+        }
+        for (Uint16 i = 0; i < header.numEntries; i++) {
+            AtlasEntry entry;
+            memcpy(&entry, data.data() + sizeof(AtlasHeader) + i * sizeof(AtlasEntry), sizeof(entry));
+            atlasEntries[{file.id, entry.originalId}] = entry;
+        }
+    }
+
+    // Original size and trim rect of trimmed images
+    map<Uint64, SpriteMeshEntry> sprites;
+    for (const FileInfo& file : files) {
+        if (file.filename != "_sprite_mesh_table") {
+            continue;
+        }
+        vector<char> data;
+        if (!getProcessedData(file, data) || data.size() < sizeof(SpriteMeshTableHeader)) {
+            cerr << "Failed to read the sprite mesh table" << endl;
+            return false;
+        }
+        SpriteMeshTableHeader header;
+        memcpy(&header, data.data(), sizeof(header));
+        if (data.size() != sizeof(header) + header.numSprites * (sizeof(Uint64) + sizeof(SpriteMeshEntry))) {
+            cerr << "Sprite mesh table has an invalid size" << endl;
+            return false;
+        }
+        for (Uint32 i = 0; i < header.numSprites; i++) {
+            Uint64 id;
+            SpriteMeshEntry entry;
+            memcpy(&id, data.data() + sizeof(header) + i * sizeof(Uint64), sizeof(id));
+            memcpy(&entry, data.data() + sizeof(header) + header.numSprites * sizeof(Uint64) + i * sizeof(SpriteMeshEntry),
+                   sizeof(entry));
+            sprites[id] = entry;
+        }
+    }
+
+    vector<pair<Uint64, AtlasUVTableEntry>> textures;
+    for (const FileInfo& file : files) {
+        if (getFileType(file.filename) != RESOURCE_TYPE_IMAGE) {
+            continue;
+        }
+        vector<char> data;
+        if (!getProcessedData(file, data)) {
+            cerr << "Failed to read texture data for " << file.filename << endl;
+            return false;
+        }
+        // Standalone images carry an ImageHeader instead and have no atlas
+        if (data.size() != sizeof(TextureHeader)) {
+            continue;
+        }
+        TextureHeader header;
+        memcpy(&header, data.data(), sizeof(header));
+
+        AtlasUVTableEntry entry = {};
+        entry.atlasId = header.atlasId;
+        auto atlasEntry = atlasEntries.find({header.atlasId, file.id});
+        if (atlasEntry != atlasEntries.end()) {
+            entry.width = atlasEntry->second.width;
+            entry.height = atlasEntry->second.height;
+            entry.trimWidth = entry.width;
+            entry.trimHeight = entry.height;
+            entry.flags = (atlasEntry->second.x & ATLAS_ENTRY_ROTATED) ? ATLAS_UV_ROTATED : 0;
+        }
+        auto sprite = sprites.find(file.id);
+        if (sprite != sprites.end()) {
+            entry.width = sprite->second.width;
+            entry.height = sprite->second.height;
+            entry.trimX = sprite->second.trimX;
+            entry.trimY = sprite->second.trimY;
+            entry.trimWidth = sprite->second.trimWidth;
+            entry.trimHeight = sprite->second.trimHeight;
+            if (entry.trimWidth != entry.width || entry.trimHeight != entry.height) {
+                entry.flags |= ATLAS_UV_TRIMMED;
+            }
+        }
+        // The region's left u is on the image's bottom-left corner and its right
+        // u on the top-right one; which v is on top depends on the rotation
+        bool rotated = (entry.flags & ATLAS_UV_ROTATED) != 0;
+        entry.u0 = header.coordinates[0];
+        entry.u1 = header.coordinates[4];
+        entry.v0 = rotated ? header.coordinates[1] : header.coordinates[5];
+        entry.v1 = rotated ? header.coordinates[5] : header.coordinates[1];
+        textures.push_back({file.id, entry});
+    }
+
+    sort(textures.begin(), textures.end(), [](const pair<Uint64, AtlasUVTableEntry>& a, const pair<Uint64, AtlasUVTableEntry>& b) {
+        return a.first < b.first;
+    });
+
+    AtlasUVTableHeader header;
+    header.numTextures = (Uint32)textures.size();
+    header.pad = 0;
+    output.resize(sizeof(header) + textures.size() * (sizeof(Uint64) + sizeof(AtlasUVTableEntry)));
+    char* ptr = output.data();
+    memcpy(ptr, &header, sizeof(header));
+    ptr += sizeof(header);
+    for (const auto& texture : textures) {
+        memcpy(ptr, &texture.first, sizeof(Uint64));
+        ptr += sizeof(Uint64);
+    }
+    for (const auto& texture : textures) {
+        memcpy(ptr, &texture.second, sizeof(AtlasUVTableEntry));
+        ptr += sizeof(AtlasUVTableEntry);
+    }
+    cout << "Atlas UV table: " << textures.size() << " textures" << endl;
+    return true;
+}
+
+
+// ============================================================================
+// Shared CMPR dictionaries
+// Small resources of one type (scripts, dialogue, texture headers) repeat the
+// same keywords and structures, but each is too short to find much of it in
+// its own history. A dictionary trained on all of them is stored once per
+// type, and each resource is compressed against it where that is smaller.
+// ============================================================================
+
+// Only resources up to this size are compressed against a dictionary
+static const size_t DICT_MAX_RESOURCE_SIZE = 64 * 1024;
+// Types with fewer small resources than this get no dictionary
+static const size_t DICT_MIN_SAMPLES = 8;
+static const size_t DICT_MAX_SIZE = 32 * 1024;
+// A dictionary is trained to at most this fraction of its samples' total size
+static const size_t DICT_SAMPLE_DIVISOR = 16;
+// The trainer picks segments of this size, starting every DICT_SEGMENT_STEP bytes
+static const size_t DICT_SEGMENT_SIZE = 64;
+static const size_t DICT_SEGMENT_STEP = 16;
+static const size_t DICT_GRAM = 8;
+
+static string dictionaryFilename(Uint32 type) {
+    return "_dict_" + to_string(type);
+}
+
+static Uint64 dictionaryResourceId(Uint32 type) {
+    return hashCString(("res/cmpr_dict_" + to_string(type) + ".bin").c_str());
+}
+
+static Uint64 loadGram(const char* p) {
+    Uint64 gram;
+    memcpy(&gram, p, sizeof(gram));
+    return gram;
+}
+
+// Builds a dictionary of up to maxSize bytes from segments of the samples.
+// A segment is worth the number of other samples that share each of its
+// 8-byte sequences; once one is taken, the sequences it covers are worth
+// nothing to the rest. The most valuable segments go last, where the
+// encoder reaches them with the shortest offsets.
+static vector<char> trainDictionary(const vector<const vector<char>*>& samples, size_t maxSize) {
+    unordered_map<Uint64, Uint32> frequency; // Samples containing each sequence
+    vector<Uint64> grams;
+    for (const vector<char>* sample : samples) {
+        grams.clear();
+        for (size_t i = 0; i + DICT_GRAM <= sample->size(); i++) {
+            grams.push_back(loadGram(sample->data() + i));
+        }
+        sort(grams.begin(), grams.end());
+        grams.erase(unique(grams.begin(), grams.end()), grams.end());
+        for (Uint64 gram : grams) {
+            frequency[gram]++;
+        }
+    }
+
+    struct Segment {
+        const char* data;
+        size_t size;
+    };
+    vector<Segment> segments;
+    for (const vector<char>* sample : samples) {
+        for (size_t begin = 0; begin + DICT_GRAM <= sample->size(); begin += DICT_SEGMENT_STEP) {
+            segments.push_back({sample->data() + begin, min(DICT_SEGMENT_SIZE, sample->size() - begin)});
+        }
+    }
+
+    auto score = [&](const Segment& segment) {
+        grams.clear();
+        for (size_t i = 0; i + DICT_GRAM <= segment.size; i++) {
+            grams.push_back(loadGram(segment.data + i));
+        }
+        sort(grams.begin(), grams.end());
+        grams.erase(unique(grams.begin(), grams.end()), grams.end());
+        Uint64 value = 0;
+        for (Uint64 gram : grams) {
+            Uint32 count = frequency[gram];
+            value += count > 1 ? count - 1 : 0;
+        }
+        return value;
+    };
+
+    // Scores only fall as segments are taken, so a stale score is an upper
+    // bound and is re-checked when it reaches the top. Earlier segments win ties.
+    priority_queue<pair<Uint64, Uint64>> queue;
+    for (Uint64 i = 0; i < segments.size(); i++) {
+        Uint64 value = score(segments[i]);
+        if (value > 0) {
+            queue.push({value, segments.size() - i});
+        }
+    }
+
+    vector<Segment> chosen;
+    size_t size = 0;
+    while (!queue.empty() && size < maxSize) {
+        auto [value, rank] = queue.top();
+        queue.pop();
+        Segment segment = segments[segments.size() - rank];
+        Uint64 current = score(segment);
+        if (current == 0) {
+            continue;
+        }
+        if (current < value && !queue.empty() && current < queue.top().first) {
+            queue.push({current, rank});
+            continue;
+        }
+        segment.size = min(segment.size, maxSize - size);
+        chosen.push_back(segment);
+        size += segment.size;
+        for (size_t i = 0; i + DICT_GRAM <= segment.size; i++) {
+            frequency[loadGram(segment.data + i)] = 0;
+        }
+    }
+
+    vector<char> dictionary;
+    dictionary.reserve(size);
+    for (auto it = chosen.rbegin(); it != chosen.rend(); ++it) {
+        dictionary.insert(dictionary.end(), it->data, it->data + it->size);
+    }
+    return dictionary;
+}
+
+// Compresses input against dictionary as a dictionary stream.
+// Returns false if that is no smaller than plainSize.
+static bool compressWithDictionary(const vector<char>& input, const vector<char>& dictionary, Uint64 dictId,
+                                   Compress::Level level, size_t plainSize, vector<char>& output) {
+    vector<char> buffer(dictionary);
+    buffer.insert(buffer.end(), input.begin(), input.end());
+    output.resize(Compress::maxSizeWithDict(input.size()));
+    size_t size = Compress::compressWithDict(buffer.data() + dictionary.size(), input.size(), dictionary.size(),
+                                             dictId, output.data(), output.size(), level);
+    if (size == 0 || size >= plainSize) {
+        return false;
+    }
+    output.resize(size);
+    return true;
+}
+
+// Resources copied from the base pak may be dictionary streams. Decodes them
+// into data, since the dictionaries are retrained for the new pak.
+static bool decodeDictionaryStreams(vector<FileInfo>& files, const map<Uint64, vector<char>>& dictionaries) {
+    for (FileInfo& file : files) {
+        if (!file.data.empty() || file.compressionType != COMPRESSION_FLAGS_CMPR) {
+            continue;
+        }
+        Uint64 dictId = Compress::dictionaryId(file.compressedData.data(), file.compressedData.size());
+        if (dictId == 0) {
+            continue;
+        }
+        auto dictionary = dictionaries.find(dictId);
+        if (dictionary == dictionaries.end()) {
+            cerr << "Missing dictionary " << dictId << " for " << file.filename << endl;
+            return false;
+        }
+        file.data.resize(file.decompressedSize);
+        if (Compress::decompressWithDict(file.compressedData.data(), file.compressedData.size(),
+                                         dictionary->second.data(), dictionary->second.size(),
+                                         file.data.data(), file.data.size()) != file.decompressedSize) {
+            cerr << "Failed to decode " << file.filename << " with its dictionary" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Trains a dictionary per resource type from its small resources and
+// recompresses them against it, keeping it only where it saves more than it
+// costs. The dictionaries are appended to files.
+static bool buildDictionaries(vector<FileInfo>& files, Compress::Level level, unsigned jobs, const BuildCache& cache) {
+    map<Uint32, vector<Uint64>> candidates;
+    for (Uint64 i = 0; i < files.size(); i++) {
+        const FileInfo& file = files[i];
+        if (file.filename[0] != '_' && file.decompressedSize > 0 && file.decompressedSize <= DICT_MAX_RESOURCE_SIZE) {
+            candidates[getFileType(file.filename)].push_back(i);
+        }
+    }
+
+    vector<FileInfo> dictionaries;
+    for (const auto& [type, indices] : candidates) {
+        if (indices.size() < DICT_MIN_SAMPLES) {
+            continue;
+        }
+        vector<vector<char>> data(indices.size());
+        vector<const vector<char>*> samples;
+        size_t sampleBytes = 0;
+        for (Uint64 i = 0; i < indices.size(); i++) {
+            if (!getProcessedData(files[indices[i]], data[i])) {
+                cerr << "Failed to read data for " << files[indices[i]].filename << endl;
+                return false;
+            }
+            samples.push_back(&data[i]);
+            sampleBytes += data[i].size();
+        }
+
+        // Training dominates a rebuild, so dictionaries are cached by their samples
+        size_t dictSize = min(DICT_MAX_SIZE, sampleBytes / DICT_SAMPLE_DIVISOR);
+        Uint64 samplesHash = hashBytes((const char*)&dictSize, sizeof(dictSize));
+        for (const vector<char>& sample : data) {
+            Uint64 size = sample.size();
+            samplesHash = hashBytes((const char*)&size, sizeof(size), samplesHash);
+            samplesHash = hashBytes(sample.data(), sample.size(), samplesHash);
+        }
+        Uint64 dictKey = buildCacheKey(samplesHash, type, BUILD_CACHE_DICTIONARY, 0);
+        vector<char> dictionary;
+        vector<char> stored;
+        Uint32 storedType;
+        if (!cache.load(dictKey, dictionary, stored, storedType)) {
+            dictionary = trainDictionary(samples, dictSize);
+            cache.store(dictKey, dictionary, {}, COMPRESSION_FLAGS_UNCOMPRESSED);
+        }
+        if (dictionary.empty()) {
+            continue;
+        }
+
+        Uint64 dictId = dictionaryResourceId(type);
+        Uint64 dictHash = hashBytes(dictionary.data(), dictionary.size());
+        vector<vector<char>> plain(indices.size());
+        vector<Uint32> plainTypes(indices.size());
+        vector<vector<char>> withDict(indices.size());
+        parallelFor(indices.size(), jobs, [&](Uint64 i) {
+            Uint64 key = buildCacheKey(hashBytes((const char*)&dictHash, sizeof(dictHash), hashBytes(data[i].data(), data[i].size())),
+                                       dictId, BUILD_CACHE_DICTIONARY_STREAM, (Uint32)level);
+            if (cache.load(key, withDict[i], plain[i], plainTypes[i])) {
+                return;
+            }
+            compressData(data[i], plain[i], plainTypes[i], level);
+            if (!compressWithDictionary(data[i], dictionary, dictId, level, plain[i].size(), withDict[i])) {
+                withDict[i].clear();
+            }
+            cache.store(key, withDict[i], plain[i], plainTypes[i]);
+        });
+        size_t plainBytes = 0;
+        size_t dictBytes = 0;
+        for (Uint64 i = 0; i < indices.size(); i++) {
+            plainBytes += plain[i].size();
+            dictBytes += withDict[i].empty() ? plain[i].size() : withDict[i].size();
+        }
+
+        // The dictionary is stored as a resource of its own
+        size_t cost = dictionary.size() + sizeof(CompressionHeader) + sizeof(ResourcePtr);
+        bool useDictionary = dictBytes + cost < plainBytes;
+        cout << "Dictionary for " << resourceTypeName(type) << ": " << dictionary.size() << " bytes, "
+             << indices.size() << " resources " << plainBytes << " -> " << dictBytes << " bytes"
+             << (useDictionary ? "" : ", not worth storing") << endl;
+
+        // Resources copied from the base pak may still be dictionary streams, so
+        // every candidate is rewritten either way
+        for (Uint64 i = 0; i < indices.size(); i++) {
+            FileInfo& file = files[indices[i]];
+            if (useDictionary && !withDict[i].empty()) {
+                file.compressedData = std::move(withDict[i]);
+                file.compressionType = COMPRESSION_FLAGS_CMPR;
+            } else {
+                file.compressedData = std::move(plain[i]);
+                file.compressionType = plainTypes[i];
+            }
+        }
+        if (useDictionary) {
+            FileInfo dictFile;
+            dictFile.filename = dictionaryFilename(type);
+            dictFile.id = dictId;
+            dictFile.mtime = 0;
+            dictFile.changed = true;
+            dictFile.offset = 0;
+            dictFile.decompressedSize = dictionary.size();
+            dictFile.compressionType = COMPRESSION_FLAGS_UNCOMPRESSED;
+            dictFile.compressedData = std::move(dictionary);
+            dictionaries.push_back(std::move(dictFile));
+        }
+    }
+
+    for (FileInfo& dictFile : dictionaries) {
+        files.push_back(std::move(dictFile));
+    }
+    return true;
+}
+
+// An overlay keeps the base pak's dictionaries, so changed resources are
+// compressed against those where that is smaller
+static void applyBaseDictionaries(vector<FileInfo>& files, const map<Uint64, vector<char>>& dictionaries,
+                                  Compress::Level level, unsigned jobs) {
+    parallelFor(files.size(), jobs, [&](Uint64 i) {
+        FileInfo& file = files[i];
+        if (!file.changed || file.filename[0] == '_' || file.data.empty() || file.data.size() > DICT_MAX_RESOURCE_SIZE) {
+            return;
+        }
+        Uint64 dictId = dictionaryResourceId(getFileType(file.filename));
+        auto dictionary = dictionaries.find(dictId);
+        vector<char> output;
+        if (dictionary != dictionaries.end() &&
+            compressWithDictionary(file.data, dictionary->second, dictId, level, file.compressedData.size(), output)) {
+            file.compressedData = std::move(output);
+            file.compressionType = COMPRESSION_FLAGS_CMPR;
+        }
+    });
+}
+
+// Writes files (sorted by id) as a v2 pak with the given signature and header pad
+static bool writePakFile(const string& output, const char* sig, Uint32 pad, const vector<FileInfo>& files) {
+    // Write output pak file to a temporary path and rename it into place once complete.
+    // The game memory-maps res.pak, so rewriting it in place during a hot reload would
+    // change pages underneath the running process.
+    string tempOutput = output + ".tmp";
+    ofstream out(tempOutput, ios::binary);
+    PakFileHeader header;
+    memcpy(header.sig, sig, 4);
+    header.version = VERSION_2_0;
+    header.numResources = files.size();
+    header.pad = pad;
+    out.write((char*)&header, sizeof(header));
+
+    // Resources whose processed output is byte-identical (shader variants, copied
+    // sprites, repeated scripts) are stored once and their ResourcePtrs share the blob
+    vector<Uint32> fileTypes(files.size());
+    vector<Uint64> blobOffsets(files.size());
+    vector<bool> writesBlob(files.size(), false);
+    unordered_multimap<Uint64, Uint64> blobsByHash;
+    Uint64 offset = sizeof(header) + sizeof(ResourcePtr) * files.size();
+    Uint64 dedupedCount = 0;
+    Uint64 dedupedBytes = 0;
+    for (Uint64 i = 0; i < files.size(); i++) {
+        const FileInfo& file = files[i];
+        if (file.filename.find("_atlas_") == 0) {
+            fileTypes[i] = RESOURCE_TYPE_IMAGE_ATLAS;
+        } else if (file.filename == "_trig_table") {
+            fileTypes[i] = RESOURCE_TYPE_TRIG_TABLE;
+        } else if (file.filename == "_scene_manifests") {
+            fileTypes[i] = RESOURCE_TYPE_SCENE_MANIFEST;
+        } else if (file.filename == "_uv_table") {
+            fileTypes[i] = RESOURCE_TYPE_ATLAS_UV_TABLE;
+        } else if (file.filename == "_sprite_mesh_table") {
+            fileTypes[i] = RESOURCE_TYPE_SPRITE_MESH_TABLE;
+        } else if (file.filename.find("_dict_") == 0) {
+            fileTypes[i] = RESOURCE_TYPE_CMPR_DICTIONARY;
+        } else {
+            // Image files are now texture headers referencing atlases
+            fileTypes[i] = getFileType(file.filename);
+        }
+
+        Uint64 hash = hashBytes(file.compressedData.data(), file.compressedData.size());
+        bool duplicate = false;
+        auto range = blobsByHash.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            const FileInfo& other = files[it->second];
+            if (fileTypes[it->second] == fileTypes[i] && other.compressionType == file.compressionType &&
+                other.decompressedSize == file.decompressedSize && other.compressedData == file.compressedData) {
+                blobOffsets[i] = blobOffsets[it->second];
+                duplicate = true;
+                dedupedCount++;
+                dedupedBytes += sizeof(CompressionHeader) + file.compressedData.size();
+                cout << "File " << file.filename << " is identical to " << other.filename << ", sharing its data" << endl;
+                break;
+            }
+        }
+        if (!duplicate) {
+            blobsByHash.emplace(hash, i);
+            blobOffsets[i] = offset;
+            writesBlob[i] = true;
+            offset += sizeof(CompressionHeader) + file.compressedData.size();
+        }
+    }
+
+    for (Uint64 i = 0; i < files.size(); i++) {
+        ResourcePtr ptr = {files[i].id, blobOffsets[i], (Uint64)files[i].mtime};
+        out.write((char*)&ptr, sizeof(ptr));
+    }
+
+    for (Uint64 i = 0; i < files.size(); i++) {
+        if (!writesBlob[i]) {
+            continue;
+        }
+        const FileInfo& file = files[i];
+        CompressionHeader comp = {file.compressionType, (Uint32)file.compressedData.size(),
+                                  file.decompressedSize, fileTypes[i]};
+        out.write((char*)&comp, sizeof(comp));
+        out.write(file.compressedData.data(), file.compressedData.size());
+    }
+
+    if (dedupedCount > 0) {
+        cout << "Deduplicated " << dedupedCount << " resources, saving " << dedupedBytes << " bytes" << endl;
+    }
+
+    out.close();
+    if (!out) {
+        cerr << "Error writing " << tempOutput << endl;
+        return false;
+    }
+    error_code ec;
+    filesystem::rename(tempOutput, output, ec);
+    if (ec) {
+        cerr << "Error renaming " << tempOutput << " to " << output << ": " << ec.message() << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+
+    if (argc < 3) {
+        cerr << "Usage: packer <output.pak> <file1> <file2> ... [--output-atlases] [--max-atlas-size N] [--allow-rotation] [--trim-sprites] [--sprite-hulls] [--mip-levels N] [--etc] [--overlay FILE] [--high-compression] [--jobs N] [--cache DIR | --no-cache]" << endl;
+        cerr << "  --output-atlases: Save texture atlases as PNG files in build/ folder for review" << endl;
+        cerr << "  --max-atlas-size N: Maximum atlas texture dimension (default: " << DEFAULT_ATLAS_MAX_SIZE << ")" << endl;
+        cerr << "  --allow-rotation: Let the atlas packer turn images 90 degrees for denser atlases" << endl;
+        cerr << "  --trim-sprites: Pack only the non-transparent part of each image" << endl;
+        cerr << "  --sprite-hulls: Trim, and store a convex outline of up to " << SPRITE_MESH_MAX_VERTICES
+             << " vertices per sprite to draw instead of its rect" << endl;
+        cerr << "  --mip-levels N: Store textures with mip chains of up to N levels, 1 to " << MAX_MIP_LEVELS
+             << " (default: 1, no mipmaps)" << endl;
+        cerr << "  --etc: Use ETC1/ETC2 texture compression instead of BC1/BC3 (DXT)" << endl;
+        cerr << "  --overlay FILE: Leave output untouched and write the resources that differ from it to FILE" << endl;
+        cerr << "  --high-compression: Slower CMPR encoding for a smaller pak; reports the gain per resource type" << endl;
+        cerr << "  --jobs N: Worker threads for image, audio and compression work (default: one per core)" << endl;
+        cerr << "  --cache DIR: Build cache of processed resources (default: <output.pak>.cache)" << endl;
+        cerr << "  --no-cache: Process every changed resource from scratch" << endl;
+        return 1;
+    }
+
+    string output;
+    vector<string> inputFiles;
+    bool outputAtlases = false;
+    Uint32 maxAtlasSize = DEFAULT_ATLAS_MAX_SIZE;
+    bool allowRotation = false;
+    bool trimSprites = false;
+    bool spriteHulls = false;
+    Uint32 mipLevels = 1;
+    bool useETC = false;
+    string overlayOutput;
+    Compress::Level compressionLevel = Compress::LEVEL_FAST;
+    unsigned jobs = max(1u, thread::hardware_concurrency());
+    string cacheDir;
+    bool useCache = true;
+
+    // Parse arguments
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--output-atlases") {
+            outputAtlases = true;
+        } else if (arg == "--max-atlas-size" && i + 1 < argc) {
+            maxAtlasSize = (Uint32)stoul(argv[++i]);
+        } else if (arg == "--allow-rotation") {
+            allowRotation = true;
+        } else if (arg == "--trim-sprites") {
+            trimSprites = true;
+        } else if (arg == "--sprite-hulls") {
+            trimSprites = true;
+            spriteHulls = true;
+        } else if (arg == "--mip-levels" && i + 1 < argc) {
+            mipLevels = (Uint32)stoul(argv[++i]);
+        } else if (arg == "--overlay" && i + 1 < argc) {
+            overlayOutput = argv[++i];
+        } else if (arg == "--high-compression") {
+            compressionLevel = Compress::LEVEL_HIGH;
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            jobs = max(1u, (unsigned)stoul(argv[++i]));
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (arg == "--no-cache") {
+            useCache = false;
+        } else if (arg == "--etc") {
+#ifdef ENABLE_ETC
+            useETC = true;
+#else
+            cerr << "ETC compression not supported in this build" << endl;
+            return 1;
+#endif
+        } else if (output.empty()) {
+            output = arg;
+        } else {
+            inputFiles.push_back(arg);
+        }
+    }
+
+    if (output.empty() || inputFiles.empty()) {
+        cerr << "Usage: packer <output.pak> <file1> <file2> ... [--output-atlases] [--max-atlas-size N] [--allow-rotation] [--trim-sprites] [--sprite-hulls] [--mip-levels N] [--etc] [--overlay FILE] [--high-compression] [--jobs N] [--cache DIR | --no-cache]" << endl;
+        cerr << "  --output-atlases: Save texture atlases as PNG files in build/ folder for review" << endl;
+        cerr << "  --max-atlas-size N: Maximum atlas texture dimension (default: " << DEFAULT_ATLAS_MAX_SIZE << ")" << endl;
+        cerr << "  --allow-rotation: Let the atlas packer turn images 90 degrees for denser atlases" << endl;
+        cerr << "  --trim-sprites: Pack only the non-transparent part of each image" << endl;
+        cerr << "  --sprite-hulls: Trim, and store a convex outline of up to " << SPRITE_MESH_MAX_VERTICES
+             << " vertices per sprite to draw instead of its rect" << endl;
+        cerr << "  --mip-levels N: Store textures with mip chains of up to N levels, 1 to " << MAX_MIP_LEVELS
+             << " (default: 1, no mipmaps)" << endl;
+        cerr << "  --etc: Use ETC1/ETC2 texture compression instead of BC1/BC3 (DXT)" << endl;
+        cerr << "  --overlay FILE: Leave output untouched and write the resources that differ from it to FILE" << endl;
+        cerr << "  --high-compression: Slower CMPR encoding for a smaller pak; reports the gain per resource type" << endl;
+        cerr << "  --jobs N: Worker threads for image, audio and compression work (default: one per core)" << endl;
+        cerr << "  --cache DIR: Build cache of processed resources (default: <output.pak>.cache)" << endl;
+        cerr << "  --no-cache: Process every changed resource from scratch" << endl;
+        return 1;
+    }
+    if (maxAtlasSize == 0 || maxAtlasSize > ATLAS_ENTRY_X_MASK + 1) {
+        cerr << "--max-atlas-size must be between 1 and " << ATLAS_ENTRY_X_MASK + 1 << endl;
+        return 1;
+    }
+    if (mipLevels == 0 || mipLevels > MAX_MIP_LEVELS) {
+        cerr << "--mip-levels must be between 1 and " << MAX_MIP_LEVELS << endl;
+        return 1;
+    }
+
+    BuildCache cache;
+    if (useCache) {
+        cache.dir = cacheDir.empty() ? output + ".cache" : cacheDir;
+        error_code ec;
+        filesystem::create_directories(cache.dir, ec);
+        if (ec) {
+            cerr << "Warning: cannot create build cache " << cache.dir << ": " << ec.message() << endl;
+            cache.dir.clear();
+        }
+    }
+
+    vector<FileInfo> files;
+    vector<PNGImageData> pngImages;  // For atlas packing
+
+    // Collect all files and identify PNG images
+    for (const string& filename : inputFiles) {
         // Skip directories
         if (!filesystem::is_regular_file(filename)) {
             continue;
@@ -1867,7 +3234,10 @@ int main(int argc, char* argv[]) {
         else if (idPath.size() > 8 && idPath.substr(idPath.size() - 8) == ".chr.json")
             idPath = idPath.substr(0, idPath.size() - 5); // -> ".chr"
         Uint64 id = hashCString(idPath.c_str());
-        files.push_back({filename, id});
+        // Every resource records its source mtime, which the next run compares
+        struct stat st;
+        time_t mtime = stat(filename.c_str(), &st) == 0 ? st.st_mtime : 0;
+        files.push_back({filename, id, mtime});
         cout << "Adding file: " << filename << " with ID " << id << endl;
     }
 
@@ -1877,11 +3247,13 @@ int main(int argc, char* argv[]) {
     bool anyOtherChanged = false;
 
     vector<ResourcePtr> existingPtrs;
+    bool haveBasePak = false;
     ifstream pakFile(output, ios::binary);
     if (pakFile) {
         PakFileHeader header;
         pakFile.read((char*)&header, sizeof(header));
         if (pakFile && memcmp(header.sig, "PAKC", 4) == 0) {
+            haveBasePak = true;
             existingPtrs.resize(header.numResources);
             pakFile.read((char*)existingPtrs.data(), sizeof(ResourcePtr) * header.numResources);
 
@@ -1929,7 +3301,13 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    if (!anyPNGChanged && !anyOtherChanged) {
+    if (!overlayOutput.empty() && !haveBasePak) {
+        cout << "No pak file to overlay, building " << output << " instead" << endl;
+        overlayOutput.clear();
+    }
+
+    // An overlay is always rewritten, even if empty, to retire the previous one
+    if (!anyPNGChanged && !anyOtherChanged && overlayOutput.empty()) {
         cout << "Pak file is up to date" << endl;
         return 0;
     }
@@ -1937,6 +3315,28 @@ int main(int argc, char* argv[]) {
     // Rebuild
     cout << "Building pak file" << endl;
 
+    // Dictionaries of the base pak, to decode the dictionary streams copied from it
+    map<Uint64, vector<char>> baseDictionaries;
+    for (const auto& ptr : existingPtrs) {
+        pakFile.clear();
+        pakFile.seekg(ptr.offset);
+        CompressionHeader comp;
+        pakFile.read((char*)&comp, sizeof(comp));
+        if (pakFile && comp.type == RESOURCE_TYPE_CMPR_DICTIONARY && comp.compressionType == COMPRESSION_FLAGS_UNCOMPRESSED) {
+            vector<char>& dictionary = baseDictionaries[ptr.id];
+            dictionary.resize(comp.decompressedSize);
+            pakFile.read(dictionary.data(), dictionary.size());
+        }
+    }
+
+    // Only gathered with --high-compression, which measures the fast level alongside.
+    // Parallel stages gather stats per resource and merge them afterwards.
+    map<Uint32, CompressionStats> compressionStats;
+    bool gatherStats = compressionLevel == Compress::LEVEL_HIGH;
+    auto statsFor = [&](Uint32 type) -> CompressionStats* {
+        return gatherStats ? &compressionStats[type] : nullptr;
+    };
+
     // Check if trig table needs to be generated (only when pak doesn't exist)
     bool needTrigTable = !pakFile.is_open();
     bool hasTrigTable = false;
@@ -1954,8 +3354,9 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    // If PNG files haven't changed, we need to preserve existing atlas files from the pak
-    if (!anyPNGChanged && pakFile) {
+    // Preserve the trig table from the pak, and the existing atlas files too if
+    // PNG files haven't changed
+    if (pakFile) {
         // Load existing atlas files from pak
         pakFile.seekg(sizeof(PakFileHeader));
         vector<ResourcePtr> ptrs(existingPtrs.size());
@@ -1967,7 +3368,7 @@ int main(int argc, char* argv[]) {
             CompressionHeader comp;
             pakFile.read((char*)&comp, sizeof(comp));
 
-            if (comp.type == RESOURCE_TYPE_IMAGE_ATLAS) {
+            if (comp.type == RESOURCE_TYPE_IMAGE_ATLAS && !anyPNGChanged) {
                 // This is an atlas file, add it to our files list
                 FileInfo atlasFile;
                 atlasFile.filename = "_atlas_" + to_string(files.size());
@@ -2002,6 +3403,22 @@ int main(int argc, char* argv[]) {
                 cout << "Preserving existing trig lookup table with ID " << trigFile.id << endl;
                 files.push_back(std::move(trigFile));
                 hasTrigTable = true;
+            } else if (comp.type == RESOURCE_TYPE_SPRITE_MESH_TABLE && !anyPNGChanged) {
+                // Trim rects of the preserved atlases, needed for the UV table
+                FileInfo meshFile;
+                meshFile.filename = "_sprite_mesh_table";
+                meshFile.id = existingPtrs[i].id;
+                meshFile.mtime = existingPtrs[i].lastModified;
+                meshFile.changed = false;
+                meshFile.offset = existingPtrs[i].offset;
+
+                meshFile.compressedData.resize(comp.compressedSize);
+                pakFile.read(meshFile.compressedData.data(), comp.compressedSize);
+                meshFile.compressionType = comp.compressionType;
+                meshFile.decompressedSize = comp.decompressedSize;
+
+                cout << "Preserving existing sprite mesh table" << endl;
+                files.push_back(std::move(meshFile));
             }
         }
     }
@@ -2012,7 +3429,7 @@ int main(int argc, char* argv[]) {
         FileInfo trigFile;
         trigFile.filename = "_trig_table";
         trigFile.id = hashCString("res/trig_table.bin");
-        trigFile.mtime = time(nullptr);
+        trigFile.mtime = 0;
         trigFile.changed = true;
 
         if (!generateTrigTable(trigFile.data)) {
@@ -2020,7 +3437,8 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
-        compressData(trigFile.data, trigFile.compressedData, trigFile.compressionType);
+        compressData(trigFile.data, trigFile.compressedData, trigFile.compressionType,
+                     compressionLevel, statsFor(RESOURCE_TYPE_TRIG_TABLE));
         trigFile.decompressedSize = trigFile.data.size();
         cout << "Trig table size " << trigFile.decompressedSize
              << " compressed " << trigFile.compressedData.size() << endl;
@@ -2043,40 +3461,166 @@ int main(int argc, char* argv[]) {
                     imgData.mtime = st.st_mtime;
                     file.mtime = st.st_mtime;
                 }
+                pngImages.push_back(std::move(imgData));
+            }
+        }
 
-                if (!loadPNG(file.filename, imgData.imageData, imgData.width, imgData.height, imgData.hasAlpha)) {
-                    cerr << "Failed to load PNG file " << file.filename << endl;
-                    return 1;
+        // Atlas layout only needs image sizes and trim rects. With the build cache
+        // they are looked up by content, and only the images of atlases to rebuild
+        // get decoded.
+        Uint32 trimOptions = (trimSprites ? 1u : 0u) | (spriteHulls ? 2u : 0u);
+        Uint32 imageOptions = (Uint32)compressionLevel | (useETC ? 0x100u : 0u) | (trimSprites ? 0x200u : 0u) |
+                              (mipLevels << 12);
+        vector<char> pngReady(pngImages.size(), 0);
+        parallelFor(pngImages.size(), jobs, [&](Uint64 i) {
+            PNGImageData& img = pngImages[i];
+            if (!cache.enabled()) {
+                img.loaded = loadPNG(img.filename, img.imageData, img.width, img.height, img.hasAlpha);
+                if (img.loaded) {
+                    computeSpriteTrim(img, trimSprites, spriteHulls);
                 }
-                pngImages.push_back(std::move(imgData));
+                pngReady[i] = img.loaded;
+                return;
+            }
+
+            vector<char> bytes;
+            time_t mtime;
+            if (!loadFile(img.filename, bytes, mtime)) {
+                return;
+            }
+            img.contentHash = hashBytes(bytes.data(), bytes.size());
+            Uint64 key = buildCacheKey(img.contentHash, 0, BUILD_CACHE_IMAGE_INFO, trimOptions);
+            vector<char> data;
+            vector<char> stored;
+            Uint32 compressionType;
+            CachedImageInfo info;
+            if (cache.load(key, data, stored, compressionType) && data.size() == sizeof(info)) {
+                memcpy(&info, data.data(), sizeof(info));
+                img.width = info.width;
+                img.height = info.height;
+                img.hasAlpha = info.hasAlpha != 0;
+                img.trimX = info.trimX;
+                img.trimY = info.trimY;
+                img.trimWidth = info.trimWidth;
+                img.trimHeight = info.trimHeight;
+                img.hull.assign(info.hull, info.hull + info.numHullVertices * 2);
+                pngReady[i] = 1;
+                return;
+            }
+            if (!loadPNG(img.filename, img.imageData, img.width, img.height, img.hasAlpha)) {
+                return;
+            }
+            img.loaded = true;
+            computeSpriteTrim(img, trimSprites, spriteHulls);
+            info = {};
+            info.width = img.width;
+            info.height = img.height;
+            info.hasAlpha = img.hasAlpha ? 1u : 0u;
+            info.trimX = img.trimX;
+            info.trimY = img.trimY;
+            info.trimWidth = img.trimWidth;
+            info.trimHeight = img.trimHeight;
+            info.numHullVertices = (Uint32)img.hull.size() / 2;
+            copy(img.hull.begin(), img.hull.end(), info.hull);
+            data.assign((const char*)&info, (const char*)&info + sizeof(info));
+            cache.store(key, data, {}, COMPRESSION_FLAGS_UNCOMPRESSED);
+            pngReady[i] = 1;
+        });
+        for (Uint64 i = 0; i < pngImages.size(); i++) {
+            if (!pngReady[i]) {
+                cerr << "Failed to load PNG file " << pngImages[i].filename << endl;
+                return 1;
             }
         }
 
+        // Texels each image keeps in the atlas, and the area its quad or outline
+        // covers when drawn, against the untrimmed images
+        if (trimSprites) {
+            Uint64 trimmedCount = 0;
+            Uint64 outlineCount = 0;
+            Uint64 imageTexels = 0;
+            Uint64 keptTexels = 0;
+            double drawnTexels = 0.0;
+            for (const PNGImageData& img : pngImages) {
+                imageTexels += (Uint64)img.width * img.height;
+                keptTexels += (Uint64)img.trimWidth * img.trimHeight;
+                trimmedCount += img.trimmed() ? 1 : 0;
+                if (img.hull.empty()) {
+                    drawnTexels += (double)img.trimWidth * img.trimHeight;
+                    continue;
+                }
+                double area = 0.0;
+                for (Uint64 v = 0; v < img.hull.size(); v += 2) {
+                    Uint64 next = (v + 2) % img.hull.size();
+                    area += img.hull[v] * img.hull[next + 1] - img.hull[next] * img.hull[v + 1];
+                }
+                drawnTexels += abs(area) * 0.5 * img.width * img.height;
+                outlineCount++;
+            }
+            if (imageTexels > 0) {
+                cout << "Trimmed " << trimmedCount << " of " << pngImages.size() << " images to "
+                     << fixed << setprecision(1) << 100.0 * keptTexels / imageTexels << "% of their texels, "
+                     << outlineCount << " outlined; drawn area " << 100.0 * drawnTexels / imageTexels << "%"
+                     << defaultfloat << endl;
+            }
+        }
+
+        // Decodes an image whose size came from the cache, or drops its pixels once used
+        auto decodeImage = [](PNGImageData& img) {
+            if (img.loaded) {
+                return true;
+            }
+            Uint32 width, height;
+            bool hasAlpha;
+            if (!loadPNG(img.filename, img.imageData, width, height, hasAlpha) ||
+                width != img.width || height != img.height || hasAlpha != img.hasAlpha) {
+                cerr << "Failed to load PNG file " << img.filename << " (changed during the build?)" << endl;
+                return false;
+            }
+            img.loaded = true;
+            return true;
+        };
+        auto releaseImage = [](PNGImageData& img) {
+            vector<uint8_t>().swap(img.imageData);
+            img.loaded = false;
+        };
+
         // Pack images into atlases
         vector<TextureAtlas> atlases;
-        Uint64 numAtlases = packImagesIntoAtlases(pngImages, atlases, maxAtlasSize);
+        Uint64 numAtlases = packImagesIntoAtlases(pngImages, atlases, maxAtlasSize, allowRotation, mipLevels);
         cout << "Created " << numAtlases << " texture atlas(es)" << endl;
 
-        // Print atlas info
+        // Print atlas info, with the share of each atlas covered by image texels
+        Uint64 totalImageTexels = 0;
+        Uint64 totalAtlasTexels = 0;
         for (Uint64 i = 0; i < atlases.size(); i++) {
             const char* fmtName = useETC
                 ? (atlases[i].hasAlpha ? "RGBA/ETC2" : "RGB/ETC1")
                 : (atlases[i].hasAlpha ? "RGBA/BC3"  : "RGB/BC1");
+            Uint64 imageTexels = 0;
+            Uint32 rotated = 0;
+            for (const AtlasEntry& entry : atlases[i].entries) {
+                imageTexels += (Uint64)entry.width * entry.height;
+                rotated += (entry.x & ATLAS_ENTRY_ROTATED) ? 1 : 0;
+            }
+            Uint64 atlasTexels = (Uint64)atlases[i].width * atlases[i].height;
+            totalImageTexels += imageTexels;
+            totalAtlasTexels += atlasTexels;
             cout << "  Atlas " << i << ": " << atlases[i].width << "x" << atlases[i].height
-                 << " (" << atlases[i].entries.size() << " images, "
-                 << fmtName << ")" << endl;
-        }
-
-        // Save atlases as PNG files if requested
-        if (outputAtlases) {
-            for (Uint64 i = 0; i < atlases.size(); i++) {
-                string atlasFilename = "atlas_" + to_string(i) + ".png";
-                if (savePNG(atlasFilename, atlases[i].imageData, atlases[i].width, atlases[i].height)) {
-                    cout << "Saved atlas " << i << " as " << atlasFilename << endl;
-                } else {
-                    cerr << "Failed to save atlas " << i << " as " << atlasFilename << endl;
-                }
+                 << " (" << atlases[i].entries.size() << " images";
+            if (rotated > 0) {
+                cout << ", " << rotated << " rotated";
             }
+            if (atlases[i].mipLevels > 1) {
+                cout << ", " << atlases[i].mipLevels << " mip levels";
+            }
+            cout << ", " << fmtName << ", " << fixed << setprecision(1)
+                 << 100.0 * imageTexels / atlasTexels << "% occupied)" << defaultfloat << endl;
+        }
+        if (totalAtlasTexels > 0) {
+            cout << "Atlas occupancy: " << totalImageTexels << " of " << totalAtlasTexels << " texels ("
+                 << fixed << setprecision(1) << 100.0 * totalImageTexels / totalAtlasTexels << "%)"
+                 << defaultfloat << endl;
         }
 
         // Process atlases and update file data for images
@@ -2101,68 +3645,91 @@ int main(int argc, char* argv[]) {
             }
         }
 
-        // For each image file, either create a TextureHeader (if packed) or ImageHeader (if standalone)
-        for (Uint64 i = 0; i < pngImages.size(); i++) {
+        // For each image file, either create a TextureHeader (if packed) or ImageHeader (if standalone).
+        // Every image writes only its own file, so standalone images are encoded in parallel.
+        vector<CompressionStats> imageStats(pngImages.size());
+        vector<char> imageFailed(pngImages.size(), 0);
+        parallelFor(pngImages.size(), jobs, [&](Uint64 i) {
             PNGImageData& img = pngImages[i];
             AtlasInfo& atlasInfo = imageToAtlas[i];
 
             if (!atlasInfo.isPacked) {
-                // Image was too large for atlas - store as standalone ImageHeader
-                cout << "Image " << img.filename << " too large for atlas, storing standalone" << endl;
+                // Image was too large for atlas - store as standalone ImageHeader,
+                // compressed here so the cache can hold the finished resource
+                FileInfo* file = nullptr;
+                for (auto& candidate : files) {
+                    if (candidate.id == img.id) {
+                        file = &candidate;
+                        break;
+                    }
+                }
+                assert(file != nullptr);
+                file->changed = true;
+
+                Uint64 key = buildCacheKey(img.contentHash, img.id, BUILD_CACHE_STANDALONE_IMAGE, imageOptions);
+                if (cache.load(key, file->data, file->compressedData, file->compressionType)) {
+                    return;
+                }
+                if (!decodeImage(img)) {
+                    imageFailed[i] = 1;
+                    return;
+                }
 
                 vector<char> compressedImage;
                 Uint16 format;
-                compressImageRaw(img.imageData, compressedImage, img.width, img.height, img.hasAlpha, format, useETC);
+                Uint32 levels = mipLevelCount(img.width, img.height, mipLevels);
+                compressImageRaw(img.imageData, compressedImage, img.width, img.height, img.hasAlpha, format, useETC,
+                                 levels);
+                releaseImage(img);
 
                 // Create ImageHeader
                 ImageHeader header;
                 header.format = format;
                 header.width = img.width;
                 header.height = img.height;
-                header.pad = 0;
-
-                // Find corresponding file and set its data
-                for (auto& file : files) {
-                    if (file.id == img.id) {
-                        file.data.resize(sizeof(ImageHeader) + compressedImage.size());
-                        memcpy(file.data.data(), &header, sizeof(ImageHeader));
-                        memcpy(file.data.data() + sizeof(ImageHeader), compressedImage.data(), compressedImage.size());
-                        file.changed = true;
-                        break;
-                    }
-                }
-                continue;
+                header.mipLevels = (Uint16)levels;
+
+                file->data.resize(sizeof(ImageHeader) + compressedImage.size());
+                memcpy(file->data.data(), &header, sizeof(ImageHeader));
+                memcpy(file->data.data() + sizeof(ImageHeader), compressedImage.data(), compressedImage.size());
+                compressData(file->data, file->compressedData, file->compressionType,
+                             compressionLevel, gatherStats ? &imageStats[i] : nullptr);
+                cache.store(key, file->data, file->compressedData, file->compressionType);
+                return;
             }
 
             TextureAtlas& atlas = atlases[atlasInfo.atlasIndex];
             AtlasEntry& entry = atlasInfo.entry;
 
-            // Calculate UV coordinates
+            // Calculate UV coordinates of the image's atlas region
             // u0,v0 = top-left corner in texture space (V increases downward in image)
             // u1,v1 = bottom-right corner in texture space
-            float u0 = (float)entry.x / atlas.width;
+            // A rotated image is stored turned clockwise, height x width texels
+            bool rotated = (entry.x & ATLAS_ENTRY_ROTATED) != 0;
+            Uint32 x = entry.x & ATLAS_ENTRY_X_MASK;
+            float u0 = (float)x / atlas.width;
             float v0 = (float)entry.y / atlas.height;
-            float u1 = (float)(entry.x + entry.width) / atlas.width;
-            float v1 = (float)(entry.y + entry.height) / atlas.height;
+            float u1 = (float)(x + (rotated ? entry.height : entry.width)) / atlas.width;
+            float v1 = (float)(entry.y + (rotated ? entry.width : entry.height)) / atlas.height;
 
             // Create TextureHeader
-            // UV coordinate layout in coordinates[8] array:
-            //   [0,1] = bottom-left  (u0, v1)
-            //   [2,3] = bottom-right (u1, v1)
-            //   [4,5] = top-right    (u1, v0)
-            //   [6,7] = top-left     (u0, v0)
+            // UV coordinate layout in coordinates[8] array, corners of the image:
+            //   [0,1] = bottom-left  (u0, v1), rotated (u0, v0)
+            //   [2,3] = bottom-right (u1, v1), rotated (u0, v1)
+            //   [4,5] = top-right    (u1, v0), rotated (u1, v1)
+            //   [6,7] = top-left     (u0, v0), rotated (u1, v0)
             // Note: v is stored with bottom having v1 (higher value) because
             // image Y increases downward but GPU texture V typically increases upward
             TextureHeader texHeader;
             texHeader.atlasId = atlas.atlasId;
-            texHeader.coordinates[0] = u0;  // bottom-left u
-            texHeader.coordinates[1] = v1;  // bottom-left v
-            texHeader.coordinates[2] = u1;  // bottom-right u
-            texHeader.coordinates[3] = v1;  // bottom-right v
-            texHeader.coordinates[4] = u1;  // top-right u
-            texHeader.coordinates[5] = v0;  // top-right v
-            texHeader.coordinates[6] = u0;  // top-left u
-            texHeader.coordinates[7] = v0;  // top-left v
+            texHeader.coordinates[0] = u0;                 // bottom-left u
+            texHeader.coordinates[1] = rotated ? v0 : v1;  // bottom-left v
+            texHeader.coordinates[2] = rotated ? u0 : u1;  // bottom-right u
+            texHeader.coordinates[3] = v1;                 // bottom-right v
+            texHeader.coordinates[4] = u1;                 // top-right u
+            texHeader.coordinates[5] = rotated ? v1 : v0;  // top-right v
+            texHeader.coordinates[6] = rotated ? u1 : u0;  // top-left u
+            texHeader.coordinates[7] = v0;                 // top-left v
 
             // Find corresponding file and set its data
             for (auto& file : files) {
@@ -2173,155 +3740,384 @@ int main(int argc, char* argv[]) {
                     break;
                 }
             }
+        });
+        for (Uint64 i = 0; i < pngImages.size(); i++) {
+            if (imageFailed[i]) {
+                return 1;
+            }
+            if (!imageToAtlas[i].isPacked) {
+                cout << "Image " << pngImages[i].filename << " too large for atlas, storing standalone" << endl;
+            }
+            if (imageStats[i].count > 0) {
+                compressionStats[RESOURCE_TYPE_IMAGE].add(imageStats[i]);
+            }
         }
 
-        // Now add atlas files as new resources
-        for (Uint64 i = 0; i < atlases.size(); i++) {
+        if (trimSprites) {
+            vector<char> atlased(pngImages.size());
+            for (Uint64 i = 0; i < pngImages.size(); i++) {
+                atlased[i] = imageToAtlas[i].isPacked ? 1 : 0;
+            }
+            FileInfo meshFile;
+            meshFile.filename = "_sprite_mesh_table";
+            meshFile.id = hashCString(SPRITE_MESH_TABLE_PATH);
+            meshFile.mtime = 0;
+            meshFile.changed = true;
+            meshFile.offset = 0;
+            generateSpriteMeshTable(pngImages, atlased, meshFile.data);
+            compressData(meshFile.data, meshFile.compressedData, meshFile.compressionType,
+                         compressionLevel, statsFor(RESOURCE_TYPE_SPRITE_MESH_TABLE));
+            meshFile.decompressedSize = meshFile.data.size();
+            files.push_back(std::move(meshFile));
+        }
+
+        // Now add atlas files as new resources. Only atlases missing from the build
+        // cache, or due for an --output-atlases review image, are composed.
+        vector<FileInfo> atlasFiles(atlases.size());
+        vector<CompressionStats> atlasStats(atlases.size());
+        vector<string> atlasLogs(atlases.size());
+        vector<char> atlasProcessed(atlases.size(), 0);
+        parallelFor(atlases.size(), jobs, [&](Uint64 i) {
             TextureAtlas& atlas = atlases[i];
-            FileInfo atlasFile;
+            FileInfo& atlasFile = atlasFiles[i];
             atlasFile.filename = "_atlas_" + to_string(i);
             atlasFile.id = atlas.atlasId;
-            atlasFile.mtime = time(nullptr);  // Current time
+            atlasFile.mtime = 0;  // Generated, so no source timestamp
             atlasFile.changed = true;
+            atlasFile.offset = 0;
+
+            Uint64 key = atlasCacheKey(atlas, pngImages, imageOptions);
+            bool cached = cache.load(key, atlasFile.data, atlasFile.compressedData, atlasFile.compressionType);
+
+            // Review images are rewritten when the atlas saved under their name differs
+            string reviewFilename = "atlas_" + to_string(i) + ".png";
+            Uint64 reviewKey = buildCacheKey(hashCString(filesystem::absolute(reviewFilename).string().c_str()),
+                                             0, BUILD_CACHE_ATLAS_REVIEW, 0);
+            bool saveReview = false;
+            if (outputAtlases) {
+                vector<char> reviewed;
+                vector<char> stored;
+                Uint32 compressionType;
+                saveReview = !cached || !filesystem::exists(reviewFilename) ||
+                             !cache.load(reviewKey, reviewed, stored, compressionType) ||
+                             reviewed.size() != sizeof(key) || memcmp(reviewed.data(), &key, sizeof(key)) != 0;
+            }
 
-            if (!processAtlas(atlas, atlasFile.data, useETC)) {
+            ostringstream log;
+            if (!cached || saveReview) {
+                for (Uint64 imgIdx : atlas.packedImageIndices) {
+                    if (!decodeImage(pngImages[imgIdx])) {
+                        return;
+                    }
+                }
+                composeAtlas(atlas, pngImages);
+                for (Uint64 imgIdx : atlas.packedImageIndices) {
+                    releaseImage(pngImages[imgIdx]);
+                }
+            }
+            if (saveReview) {
+                if (savePNG(reviewFilename, atlas.imageData, atlas.width, atlas.height)) {
+                    log << "Saved atlas " << i << " as " << reviewFilename << endl;
+                    vector<char> reviewed((const char*)&key, (const char*)&key + sizeof(key));
+                    cache.store(reviewKey, reviewed, {}, COMPRESSION_FLAGS_UNCOMPRESSED);
+                } else {
+                    cerr << "Failed to save atlas " << i << " as " << reviewFilename << endl;
+                }
+            }
+            if (!cached) {
+                if (!processAtlas(atlas, atlasFile.data, useETC)) {
+                    return;
+                }
+                compressData(atlasFile.data, atlasFile.compressedData, atlasFile.compressionType,
+                             compressionLevel, gatherStats ? &atlasStats[i] : nullptr);
+                cache.store(key, atlasFile.data, atlasFile.compressedData, atlasFile.compressionType);
+            }
+            vector<uint8_t>().swap(atlas.imageData);
+            atlasFile.decompressedSize = atlasFile.data.size();
+            log << "Atlas " << i << " size " << atlasFile.decompressedSize
+                << " compressed " << atlasFile.compressedData.size() << (cached ? " (cached)" : "");
+            atlasLogs[i] = log.str();
+            atlasProcessed[i] = 1;
+        });
+        for (Uint64 i = 0; i < atlasFiles.size(); i++) {
+            if (!atlasProcessed[i]) {
                 cerr << "Failed to process atlas " << i << endl;
                 return 1;
             }
+            cout << atlasLogs[i] << endl;
+            if (atlasStats[i].count > 0) {
+                compressionStats[RESOURCE_TYPE_IMAGE_ATLAS].add(atlasStats[i]);
+            }
+            files.push_back(std::move(atlasFiles[i]));
+        }
+    }
 
-            compressData(atlasFile.data, atlasFile.compressedData, atlasFile.compressionType);
-            atlasFile.decompressedSize = atlasFile.data.size();
-            cout << "Atlas " << i << " size " << atlasFile.decompressedSize
-                 << " compressed " << atlasFile.compressedData.size() << endl;
-
-            files.push_back(std::move(atlasFile));
+    // Process non-image files. Resources kept from the pak are read here in
+    // order; everything else is processed on the workers, each writing its own
+    // file, log and stats slot, so output and logs do not depend on scheduling.
+    auto readsCachedData = [&](const FileInfo& file) {
+        if (getFileType(file.filename) == RESOURCE_TYPE_IMAGE) {
+            return !anyPNGChanged;
+        }
+        return !file.changed && file.filename.find("_atlas_") != 0 && file.filename != "_trig_table" &&
+               file.filename != "_sprite_mesh_table";
+    };
+    vector<string> fileLogs(files.size());
+    for (Uint64 i = 0; i < files.size(); i++) {
+        FileInfo& file = files[i];
+        if (!readsCachedData(file)) {
+            continue;
+        }
+        pakFile.seekg(file.offset);
+        CompressionHeader comp;
+        pakFile.read((char*)&comp, sizeof(comp));
+        file.compressedData.resize(comp.compressedSize);
+        pakFile.read(file.compressedData.data(), comp.compressedSize);
+        file.compressionType = comp.compressionType;
+        file.decompressedSize = comp.decompressedSize;
+        if (getFileType(file.filename) == RESOURCE_TYPE_IMAGE) {
+            fileLogs[i] = "File " + file.filename + " (atlas reference) unchanged, using cached data";
+        } else {
+            fileLogs[i] = "File " + file.filename + " unchanged, using cached data";
         }
     }
 
-    // Process non-image files
-    for (auto& file : files) {
+    vector<CompressionStats> fileStats(files.size());
+    vector<char> fileFailed(files.size(), 0);
+    parallelFor(files.size(), jobs, [&](Uint64 i) {
+        FileInfo& file = files[i];
         Uint32 fileType = getFileType(file.filename);
-
-        if (fileType == RESOURCE_TYPE_IMAGE) {
-            if (anyPNGChanged) {
-                // Data was already set during atlas packing
-                if (file.data.empty()) {
-                    // This shouldn't happen, but handle gracefully
-                    cerr << "Warning: Empty data for image " << file.filename << endl;
-                }
-                compressData(file.data, file.compressedData, file.compressionType);
-                file.decompressedSize = file.data.size();
-                cout << "File " << file.filename << " (atlas reference) size " << file.decompressedSize
-                     << " compressed " << file.compressedData.size() << endl;
-            } else {
-                // No PNG changed, load from existing pak file
-                pakFile.seekg(file.offset);
-                CompressionHeader comp;
-                pakFile.read((char*)&comp, sizeof(comp));
-                file.compressedData.resize(comp.compressedSize);
-                pakFile.read(file.compressedData.data(), comp.compressedSize);
-                file.compressionType = comp.compressionType;
-                file.decompressedSize = comp.decompressedSize;
-                cout << "File " << file.filename << " (atlas reference) unchanged, using cached data" << endl;
+        ostringstream log;
+
+        if (readsCachedData(file)) {
+            return;
+        } else if (fileType == RESOURCE_TYPE_IMAGE) {
+            // Data was already set during atlas packing
+            if (file.data.empty()) {
+                // This shouldn't happen, but handle gracefully
+                cerr << "Warning: Empty data for image " << file.filename << endl;
+            }
+            // Standalone images were compressed with their pixels
+            if (file.compressedData.empty()) {
+                compressData(file.data, file.compressedData, file.compressionType,
+                             compressionLevel, gatherStats ? &fileStats[i] : nullptr);
             }
+            file.decompressedSize = file.data.size();
+            log << "File " << file.filename << " (atlas reference) size " << file.decompressedSize
+                << " compressed " << file.compressedData.size();
         } else if (file.filename.find("_atlas_") == 0) {
             // Atlas file, already processed
-            continue;
-        } else if (file.filename == "_trig_table") {
-            // Trig table, already processed
-            continue;
-        } else if (file.changed) {
-            // Standard file processing
-            Uint32 ft = getFileType(file.filename);
-            if (ft == RESOURCE_TYPE_MUSIC_TRACK) {
+            return;
+        } else if (file.filename == "_trig_table" || file.filename == "_sprite_mesh_table") {
+            // Trig table or sprite mesh table, already processed
+            return;
+        } else {
+            // Standard file processing, unless the build cache has this exact input
+            vector<char> input;
+            Uint64 key = 0;
+            if (cache.enabled()) {
+                if (!loadFile(file.filename, input, file.mtime)) {
+                    cerr << "Failed to load " << file.filename << endl;
+                    fileFailed[i] = 1;
+                    return;
+                }
+                key = buildCacheKey(hashBytes(input.data(), input.size()), file.id, fileType, (Uint32)compressionLevel);
+                if (cache.load(key, file.data, file.compressedData, file.compressionType)) {
+                    file.decompressedSize = file.data.size();
+                    fileLogs[i] = "File " + file.filename + " unchanged content, using build cache";
+                    return;
+                }
+            }
+
+            bool processed;
+            if (fileType == RESOURCE_TYPE_MUSIC_TRACK) {
                 // .loop JSON -> binary MusicTrackHeader
-                if (!processLoopFile(file.filename, file.data)) {
+                processed = processLoopFile(file.filename, file.data);
+                if (!processed) {
                     cerr << "Failed to process loop file " << file.filename << endl;
-                    return 1;
                 }
-            } else if (ft == RESOURCE_TYPE_DIALOGUE) {
+            } else if (fileType == RESOURCE_TYPE_DIALOGUE) {
                 // .dlg.json or .dlg -> binary dialogue resource
-                if (!processDialogueFile(file.filename, file.data)) {
+                processed = processDialogueFile(file.filename, file.data);
+                if (!processed) {
                     cerr << "Failed to process dialogue file " << file.filename << endl;
-                    return 1;
                 }
-            } else if (ft == RESOURCE_TYPE_CHARACTER) {
+            } else if (fileType == RESOURCE_TYPE_CHARACTER) {
                 // .chr.json or .chr -> binary character definition resource
-                if (!processCharacterFile(file.filename, file.data)) {
+                processed = processCharacterFile(file.filename, file.data);
+                if (!processed) {
                     cerr << "Failed to process character file " << file.filename << endl;
-                    return 1;
                 }
-            } else if (ft == RESOURCE_TYPE_SOUND) {
+            } else if (fileType == RESOURCE_TYPE_SOUND) {
                 // .wav -> GLA (IMA ADPCM) encoded sound resource
-                if (!processWavToGla(file.filename, file.data)) {
+                processed = processWavToGla(file.filename, file.data);
+                if (!processed) {
                     cerr << "Failed to encode WAV file " << file.filename << endl;
-                    return 1;
                 }
-            } else if (ft == RESOURCE_TYPE_VECTOR_SHAPE) {
+            } else if (fileType == RESOURCE_TYPE_VECTOR_SHAPE) {
                 // .svg -> SdfShapeHeader + SdfContourHeader[] + SdfSegment[]
-                if (!processSvgToVectorShape(file.filename, file.data)) {
+                processed = processSvgToVectorShape(file.filename, file.data);
+                if (!processed) {
                     cerr << "Failed to process SVG file " << file.filename << endl;
-                    return 1;
                 }
+            } else if (cache.enabled()) {
+                file.data = std::move(input);
+                processed = true;
             } else {
-                if (!loadFile(file.filename, file.data, file.mtime)) {
+                processed = loadFile(file.filename, file.data, file.mtime);
+                if (!processed) {
                     cerr << "Failed to load " << file.filename << endl;
-                    return 1;
                 }
             }
-            compressData(file.data, file.compressedData, file.compressionType);
+            if (!processed) {
+                fileFailed[i] = 1;
+                return;
+            }
+            compressData(file.data, file.compressedData, file.compressionType,
+                         compressionLevel, gatherStats ? &fileStats[i] : nullptr);
+            cache.store(key, file.data, file.compressedData, file.compressionType);
             file.decompressedSize = file.data.size();
-            cout << "File " << file.filename << " original " << file.decompressedSize
-                 << " compressed " << file.compressedData.size()
-                 << " type " << fileType << endl;
-        } else {
-            // Load from existing pak
-            pakFile.seekg(file.offset);
-            CompressionHeader comp;
-            pakFile.read((char*)&comp, sizeof(comp));
-            file.compressedData.resize(comp.compressedSize);
-            pakFile.read(file.compressedData.data(), comp.compressedSize);
-            file.compressionType = comp.compressionType;
-            file.decompressedSize = comp.decompressedSize;
-            cout << "File " << file.filename << " unchanged, using cached data" << endl;
+            log << "File " << file.filename << " original " << file.decompressedSize
+                << " compressed " << file.compressedData.size()
+                << " type " << fileType;
+        }
+        fileLogs[i] = log.str();
+    });
+
+    for (Uint64 i = 0; i < files.size(); i++) {
+        if (fileFailed[i]) {
+            return 1;
+        }
+        if (!fileLogs[i].empty()) {
+            cout << fileLogs[i] << endl;
+        }
+        if (fileStats[i].count > 0) {
+            compressionStats[getFileType(files[i].filename)].add(fileStats[i]);
         }
     }
 
-    // Write output pak file
-    ofstream out(output, ios::binary);
-    PakFileHeader header;
-    memcpy(header.sig, "PAKC", 4);
-    header.version = VERSION_1_0;
-    header.numResources = files.size();
-    header.pad = 0;
-    out.write((char*)&header, sizeof(header));
+    if (!decodeDictionaryStreams(files, baseDictionaries)) {
+        return 1;
+    }
 
-    Uint64 offset = sizeof(header) + sizeof(ResourcePtr) * files.size();
-    for (auto& file : files) {
-        ResourcePtr ptr = {file.id, offset, (Uint64)file.mtime};
-        out.write((char*)&ptr, sizeof(ptr));
-        offset += sizeof(CompressionHeader) + file.compressedData.size();
+    // The atlas UV table and scene manifests depend on the processed texture headers,
+    // so they are always regenerated last
+    FileInfo uvTableFile;
+    uvTableFile.filename = "_uv_table";
+    uvTableFile.id = hashCString(ATLAS_UV_TABLE_PATH);
+    uvTableFile.mtime = 0;
+    uvTableFile.changed = true;
+    if (!generateAtlasUVTable(files, uvTableFile.data)) {
+        cerr << "Failed to generate atlas UV table" << endl;
+        return 1;
+    }
+    compressData(uvTableFile.data, uvTableFile.compressedData, uvTableFile.compressionType,
+                 compressionLevel, statsFor(RESOURCE_TYPE_ATLAS_UV_TABLE));
+    uvTableFile.decompressedSize = uvTableFile.data.size();
+    files.push_back(std::move(uvTableFile));
+
+    FileInfo manifestFile;
+    manifestFile.filename = "_scene_manifests";
+    manifestFile.id = hashCString(SCENE_MANIFEST_PATH);
+    manifestFile.mtime = 0;
+    manifestFile.changed = true;
+    if (!generateSceneManifests(files, manifestFile.data)) {
+        cerr << "Failed to generate scene manifests" << endl;
+        return 1;
+    }
+    compressData(manifestFile.data, manifestFile.compressedData, manifestFile.compressionType,
+                 compressionLevel, statsFor(RESOURCE_TYPE_SCENE_MANIFEST));
+    manifestFile.decompressedSize = manifestFile.data.size();
+    files.push_back(std::move(manifestFile));
+
+    // An overlay cannot replace the dictionaries the base pak's resources were compressed with
+    if (overlayOutput.empty()) {
+        if (!buildDictionaries(files, compressionLevel, jobs, cache)) {
+            return 1;
+        }
+    } else {
+        applyBaseDictionaries(files, baseDictionaries, compressionLevel, jobs);
     }
 
-    for (auto& file : files) {
-        // Determine file type
-        Uint32 fileType;
-        if (file.filename.find("_atlas_") == 0) {
-            fileType = RESOURCE_TYPE_IMAGE_ATLAS;
-        } else if (file.filename == "_trig_table") {
-            fileType = RESOURCE_TYPE_TRIG_TABLE;
-        } else {
-            Uint32 origType = getFileType(file.filename);
-            // Image files are now texture headers referencing atlases
-            fileType = origType;
+    if (!compressionStats.empty()) {
+        auto printStats = [](const char* name, const CompressionStats& stats) {
+            double gain = stats.fastBytes > 0 ? 100.0 * ((double)stats.fastBytes - stats.storedBytes) / stats.fastBytes : 0.0;
+            cout << "  " << left << setw(16) << name << right << setw(5) << stats.count << " files "
+                 << setw(11) << stats.originalBytes << " -> fast " << setw(11) << stats.fastBytes
+                 << ", high " << setw(11) << stats.storedBytes
+                 << " (" << fixed << setprecision(1) << gain << "% smaller)" << endl;
+        };
+        cout << "High compression gain over the fast encoder (resources packed in this run):" << endl;
+        CompressionStats total;
+        for (const auto& [type, stats] : compressionStats) {
+            printStats(resourceTypeName(type), stats);
+            total.add(stats);
         }
+        printStats("total", total);
+    }
 
-        CompressionHeader comp = {file.compressionType, (Uint32)file.compressedData.size(),
-                                  file.decompressedSize, fileType};
-        out.write((char*)&comp, sizeof(comp));
-        out.write(file.compressedData.data(), file.compressedData.size());
+    // v2 paks store the resource table sorted by id so the runtime can binary-search
+    // it in place instead of hashing every entry at load time
+    sort(files.begin(), files.end(), [](const FileInfo& a, const FileInfo& b) {
+        return a.id < b.id;
+    });
+    for (Uint64 i = 1; i < files.size(); i++) {
+        if (files[i - 1].id == files[i].id) {
+            cerr << "Duplicate resource ID " << files[i].id << ": " << files[i - 1].filename
+                 << " and " << files[i].filename << endl;
+            return 1;
+        }
+    }
+
+    if (!overlayOutput.empty()) {
+        // Keep only what differs from the base pak. Unchanged files were copied
+        // from it verbatim; changed ones may still have produced identical bytes.
+        unordered_map<Uint64, Uint64> baseOffsets;
+        for (const auto& ptr : existingPtrs) {
+            baseOffsets[ptr.id] = ptr.offset;
+        }
+        vector<FileInfo> overlayFiles;
+        for (auto& file : files) {
+            if (!file.changed && file.offset != 0) {
+                continue;
+            }
+            auto base = baseOffsets.find(file.id);
+            if (base != baseOffsets.end()) {
+                pakFile.clear();
+                pakFile.seekg(base->second);
+                CompressionHeader comp;
+                pakFile.read((char*)&comp, sizeof(comp));
+                if (pakFile && comp.compressionType == file.compressionType &&
+                    comp.decompressedSize == file.decompressedSize &&
+                    comp.compressedSize == file.compressedData.size()) {
+                    vector<char> baseData(comp.compressedSize);
+                    pakFile.read(baseData.data(), comp.compressedSize);
+                    if (pakFile && baseData == file.compressedData) {
+                        continue;
+                    }
+                }
+            }
+            cout << "Overlaying " << file.filename << endl;
+            overlayFiles.push_back(std::move(file));
+        }
+        pakFile.close();
+
+        // Tie the overlay to this exact base so the game refuses it once res.pak is rebuilt
+        Uint32 baseStamp = (Uint32)hashBytes((const char*)existingPtrs.data(), sizeof(ResourcePtr) * existingPtrs.size());
+        if (!writePakFile(overlayOutput, "PAKO", baseStamp, overlayFiles)) {
+            return 1;
+        }
+        cout << "Overlay pak created with " << overlayFiles.size() << " resources" << endl;
+        cache.prune();
+        return 0;
+    }
+
+    pakFile.close();
+    if (!writePakFile(output, "PAKC", 0, files)) {
+        return 1;
     }
 
     cout << "Pak file created with " << files.size() << " resources" << endl;
+    cache.prune();
     return 0;
 }